@@ -0,0 +1,251 @@
+// Test dekodera miniatur DC (main/src/esp32cam/jpeg_dc.cpp) na JPEG-ach z JpegStripeEncoder:
+// poprawne obrazy (skala szarości i 4:2:0, z interwałem restartu) dają średnie bloków 8x8,
+// a ucięte, z przekłamanymi bitami i ze spreparowanymi tablicami Huffmana są odrzucane albo
+// dekodowane bez wyjścia poza bufory. Budowany z ASan i UBSan (HOST_SANITIZE), które
+// zgłaszają błędy pamięci i niezdefiniowane zachowanie zamiast ich przeoczenia.
+
+#include "src/esp32cam/jpeg_dc.hpp"
+#include "src/esp32cam/jpeg_encoder.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+using esp32cam::detail::JpegDcDecoder;
+using esp32cam::detail::JpegStripeEncoder;
+
+static int failures = 0;
+
+#define CHECK(cond)                                                   \
+  do                                                                  \
+  {                                                                   \
+    if (!(cond))                                                      \
+    {                                                                 \
+      fprintf(stderr, "%s:%d: CHECK(%s)\n", __FILE__, __LINE__, #cond); \
+      failures++;                                                     \
+    }                                                                 \
+  } while (0)
+
+// powtarzalny generator dla przekłamań
+static uint32_t lcgState = 12345;
+static uint32_t nextRandom()
+{
+  lcgState = lcgState * 1664525 + 1013904223;
+  return lcgState >> 8;
+}
+
+struct TestImage
+{
+  int width;
+  int height;
+  JpegStripeEncoder::PixelFormat format;
+  std::vector<uint8_t> pixels;
+  std::vector<uint8_t> jpeg;
+};
+
+// gradient z szachownicą w blokach 8x8, opcjonalnie z szumem - szum daje długie kody Huffmana
+// i serie zer (ZRL), których gładki obraz nie ma
+static uint8_t lumaAt(int x, int y, int noise)
+{
+  int v = 40 + x * 120 / 160 + y * 60 / 120 + (((x / 8) + (y / 8)) & 1) * 20;
+  if (noise && (x * 7 + y * 13) % 5 == 0)
+    v += (int)(nextRandom() % (2 * noise + 1)) - noise;
+  return v < 0 ? 0 : v > 255 ? 255 : v;
+}
+
+static TestImage makeImage(int width, int height, JpegStripeEncoder::PixelFormat format, int noise = 0)
+{
+  TestImage img = {width, height, format, {}, {}};
+  int bpp = format == JpegStripeEncoder::GRAYSCALE ? 1 : 3;
+  img.pixels.resize(width * height * bpp);
+  for (int y = 0; y < height; y++)
+  {
+    for (int x = 0; x < width; x++)
+    {
+      uint8_t l = lumaAt(x, y, noise);
+      uint8_t *p = &img.pixels[(y * width + x) * bpp];
+      for (int c = 0; c < bpp; c++)
+        p[c] = l; // szary kolor - luminancja równa składowym RGB
+    }
+  }
+
+  img.jpeg.resize(width * height * bpp + 4096);
+  JpegStripeEncoder encoder;
+  size_t len = 0;
+  if (encoder.begin(img.pixels.data(), width, height, format, 90, img.jpeg.data(), img.jpeg.size(), 2))
+  {
+    bool ok = true;
+    for (int i = 0; i < encoder.countStripes(); i++)
+      ok = encoder.encodeStripe(i) && ok;
+    if (ok)
+      len = encoder.finish();
+  }
+  img.jpeg.resize(len);
+  return img;
+}
+
+// pozycja znacznika (FF xx) w nagłówkach, -1 gdy go nie ma
+static long findMarker(const std::vector<uint8_t> &jpeg, uint8_t marker)
+{
+  for (size_t i = 2; i + 4 <= jpeg.size();)
+  {
+    if (jpeg[i] != 0xFF)
+      return -1;
+    if (jpeg[i + 1] == marker)
+      return i;
+    if (jpeg[i + 1] == 0xDA)
+      return -1;
+    i += 2 + ((jpeg[i + 2] << 8) | jpeg[i + 3]);
+  }
+  return -1;
+}
+
+static bool decode(JpegDcDecoder &decoder, const std::vector<uint8_t> &jpeg, std::vector<uint8_t> &out,
+                   int &width, int &height)
+{
+  return decoder.decode(jpeg.data(), jpeg.size(), out.data(), out.size(), width, height);
+}
+
+static void testValid(JpegDcDecoder &decoder, const TestImage &img)
+{
+  CHECK(!img.jpeg.empty());
+  std::vector<uint8_t> out(((img.width + 7) / 8) * ((img.height + 7) / 8));
+  int width = 0;
+  int height = 0;
+  CHECK(decode(decoder, img.jpeg, out, width, height));
+  CHECK(width == (img.width + 7) / 8);
+  CHECK(height == (img.height + 7) / 8);
+
+  int bpp = img.format == JpegStripeEncoder::GRAYSCALE ? 1 : 3;
+  int worst = 0;
+  for (int by = 0; by < img.height / 8; by++)
+  {
+    for (int bx = 0; bx < img.width / 8; bx++)
+    {
+      int sum = 0;
+      for (int y = 0; y < 8; y++)
+        for (int x = 0; x < 8; x++)
+          sum += img.pixels[((by * 8 + y) * img.width + bx * 8 + x) * bpp];
+      int diff = abs(out[by * width + bx] - sum / 64);
+      worst = diff > worst ? diff : worst;
+    }
+  }
+  // kwantyzacja DC przy jakości 90 i zaokrąglenia konwersji kolorów
+  CHECK(worst <= 4);
+}
+
+static void testTruncated(JpegDcDecoder &decoder, const TestImage &img)
+{
+  std::vector<uint8_t> out(((img.width + 7) / 8) * ((img.height + 7) / 8));
+  for (size_t len = 0; len < img.jpeg.size(); len++)
+  {
+    // kopia dokładnej długości, żeby ASan wykrył odczyt za końcem danych
+    std::vector<uint8_t> cut(img.jpeg.begin(), img.jpeg.begin() + len);
+    int width;
+    int height;
+    decoder.decode(cut.data(), cut.size(), out.data(), out.size(), width, height);
+  }
+}
+
+static void testBitFlips(JpegDcDecoder &decoder, const TestImage &img, int rounds)
+{
+  std::vector<uint8_t> out(((img.width + 7) / 8) * ((img.height + 7) / 8));
+  for (int round = 0; round < rounds; round++)
+  {
+    std::vector<uint8_t> jpeg = img.jpeg;
+    int flips = 1 + nextRandom() % 8;
+    for (int i = 0; i < flips; i++)
+    {
+      // połowa przekłamań w nagłówkach (tablice, wymiary), reszta w całym pliku
+      size_t limit = (i & 1) ? jpeg.size() : std::min<size_t>(jpeg.size(), 700);
+      jpeg[nextRandom() % limit] ^= 1 << (nextRandom() % 8);
+    }
+    int width;
+    int height;
+    decode(decoder, jpeg, out, width, height);
+  }
+}
+
+// DHT z większą liczbą kodów danej długości, niż ta długość mieści
+static void testOversubscribedHuffman(JpegDcDecoder &decoder, const TestImage &img)
+{
+  std::vector<uint8_t> jpeg = img.jpeg;
+  long dht = findMarker(jpeg, 0xC4);
+  CHECK(dht > 0);
+  if (dht <= 0)
+    return;
+
+  // pierwsza tablica segmentu: 12 symboli DC, wszystkie jako kody 1-bitowe
+  uint8_t *counts = &jpeg[dht + 5];
+  int total = 0;
+  for (int i = 0; i < 16; i++)
+  {
+    total += counts[i];
+    counts[i] = 0;
+  }
+  counts[0] = total;
+
+  std::vector<uint8_t> out(((img.width + 7) / 8) * ((img.height + 7) / 8));
+  int width;
+  int height;
+  CHECK(!decode(decoder, jpeg, out, width, height));
+}
+
+// skan odwołuje się do tablicy Huffmana, której żaden DHT nie zdefiniował
+static void testUndefinedHuffman(JpegDcDecoder &decoder, const TestImage &img)
+{
+  std::vector<uint8_t> jpeg = img.jpeg;
+  long sos = -1;
+  for (size_t i = 2; i + 4 <= jpeg.size(); i += 2 + ((jpeg[i + 2] << 8) | jpeg[i + 3]))
+  {
+    if (jpeg[i + 1] == 0xDA)
+    {
+      sos = i;
+      break;
+    }
+  }
+  CHECK(sos > 0);
+  if (sos <= 0)
+    return;
+
+  std::vector<uint8_t> out(((img.width + 7) / 8) * ((img.height + 7) / 8));
+  int width;
+  int height;
+  jpeg[sos + 6] = 0x33; // luminancja: tablice DC 3 i AC 3
+  CHECK(!decode(decoder, jpeg, out, width, height));
+
+  // ten sam dekoder po odrzuconym pliku dekoduje poprawny
+  CHECK(decode(decoder, img.jpeg, out, width, height));
+}
+
+int main()
+{
+  std::unique_ptr<JpegDcDecoder> decoder(new JpegDcDecoder);
+
+  const TestImage images[] = {
+      makeImage(160, 120, JpegStripeEncoder::GRAYSCALE),
+      makeImage(160, 120, JpegStripeEncoder::RGB888),
+      makeImage(100, 75, JpegStripeEncoder::RGB888), // wymiary niepodzielne przez MCU
+      makeImage(160, 120, JpegStripeEncoder::GRAYSCALE, 60),
+      makeImage(160, 120, JpegStripeEncoder::RGB888, 60),
+  };
+
+  for (const TestImage &img : images)
+  {
+    testValid(*decoder, img);
+    testTruncated(*decoder, img);
+    testBitFlips(*decoder, img, 3000);
+    testOversubscribedHuffman(*decoder, img);
+    testUndefinedHuffman(*decoder, img);
+  }
+
+  if (failures)
+  {
+    fprintf(stderr, "%d niespełnionych warunków\n", failures);
+    return 1;
+  }
+  printf("jpeg_dc_test: OK\n");
+  return 0;
+}
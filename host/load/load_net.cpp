@@ -0,0 +1,316 @@
+#include "load_net.h"
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+LoadConnection::~LoadConnection()
+{
+  close();
+}
+
+bool LoadConnection::open(const std::string &host, int port, int timeoutMs, std::string &error)
+{
+  close();
+  m_buffer.clear();
+
+  addrinfo hints = {};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo *addresses = NULL;
+  std::string service = std::to_string(port);
+  int result = getaddrinfo(host.c_str(), service.c_str(), &hints, &addresses);
+  if (result != 0)
+  {
+    error = host + ": " + gai_strerror(result);
+    return false;
+  }
+
+  error = host + ":" + service + ": brak połączenia";
+  for (addrinfo *address = addresses; address && m_fd < 0; address = address->ai_next)
+  {
+    int fd = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+    if (fd < 0)
+      continue;
+    // limit czasu nawiązania połączenia, potem odbiór i tak czeka przez poll()
+    timeval timeout = {timeoutMs / 1000, (timeoutMs % 1000) * 1000};
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    if (connect(fd, address->ai_addr, address->ai_addrlen) == 0)
+    {
+      int one = 1;
+      setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+      m_fd = fd;
+    }
+    else
+    {
+      error = host + ":" + service + ": " + strerror(errno);
+      ::close(fd);
+    }
+  }
+  freeaddrinfo(addresses);
+  if (m_fd >= 0)
+    error.clear();
+  return m_fd >= 0;
+}
+
+void LoadConnection::close()
+{
+  if (m_fd >= 0)
+    ::close(m_fd);
+  m_fd = -1;
+}
+
+bool LoadConnection::sendAll(const void *data, size_t length)
+{
+  const char *p = static_cast<const char *>(data);
+  while (m_fd >= 0 && length > 0)
+  {
+    ssize_t sent = ::send(m_fd, p, length, MSG_NOSIGNAL);
+    if (sent < 0 && errno == EINTR)
+      continue;
+    if (sent <= 0)
+      return false;
+    p += sent;
+    length -= sent;
+  }
+  return m_fd >= 0;
+}
+
+bool LoadConnection::fill(int timeoutMs)
+{
+  m_timedOut = false;
+  if (m_fd < 0)
+    return false;
+
+  pollfd entry = {m_fd, POLLIN, 0};
+  int ready = poll(&entry, 1, timeoutMs < 0 ? 0 : timeoutMs);
+  if (ready == 0 || (ready < 0 && errno == EINTR))
+  {
+    m_timedOut = true;
+    return false;
+  }
+  if (ready < 0)
+    return false;
+
+  char chunk[65536];
+  ssize_t received = recv(m_fd, chunk, sizeof(chunk), 0);
+  if (received <= 0)
+    return false;
+  m_buffer.append(chunk, received);
+  return true;
+}
+
+void splitHostPort(const std::string &address, int defaultPort, std::string &host, int &port)
+{
+  size_t colon = address.rfind(':');
+  if (colon == std::string::npos)
+  {
+    host = address;
+    port = defaultPort;
+    return;
+  }
+  host = address.substr(0, colon);
+  port = atoi(address.c_str() + colon + 1);
+}
+
+bool readHttpHead(LoadConnection &connection, int timeoutMs, int &status, std::string &head)
+{
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+  std::string &buffer = connection.buffer();
+  size_t end;
+  while ((end = buffer.find("\r\n\r\n")) == std::string::npos)
+  {
+    int left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+    if (left <= 0 || !connection.fill(left))
+      return false;
+  }
+  head = buffer.substr(0, end);
+  buffer.erase(0, end + 4);
+
+  // "HTTP/1.1 200 OK"
+  size_t space = head.find(' ');
+  status = space == std::string::npos ? 0 : atoi(head.c_str() + space + 1);
+  return status > 0;
+}
+
+int httpGet(const std::string &host, int port, const std::string &path, int timeoutMs, std::string &body)
+{
+  LoadConnection connection;
+  std::string error;
+  if (!connection.open(host, port, timeoutMs, error))
+    return -1;
+
+  std::string request = "GET " + path + " HTTP/1.1\r\nHost: " + host + "\r\nConnection: close\r\n\r\n";
+  int status;
+  std::string head;
+  if (!connection.sendAll(request.data(), request.size()) || !readHttpHead(connection, timeoutMs, status, head))
+    return -1;
+
+  // WebServer zamyka połączenie po odpowiedzi; Content-Length kończy odczyt wcześniej, jeśli jest
+  long length = -1;
+  for (size_t line = head.find("\r\n"); line != std::string::npos; line = head.find("\r\n", line + 2))
+  {
+    if (strncasecmp(head.c_str() + line + 2, "Content-Length:", 15) == 0)
+      length = atol(head.c_str() + line + 17);
+  }
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+  while (length < 0 || (long)connection.buffer().size() < length)
+  {
+    int left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+    if (left <= 0 || !connection.fill(left))
+    {
+      if (length >= 0 || connection.timedOut())
+        return -1;
+      break;
+    }
+  }
+  body = connection.buffer();
+  if (length >= 0)
+    body.resize(length);
+  return status;
+}
+
+bool LoadWebSocket::open(const std::string &host, int port, int timeoutMs, std::string &error)
+{
+  if (!m_connection.open(host, port, timeoutMs, error))
+    return false;
+
+  std::random_device random;
+  m_maskState = random() | 1;
+
+  // klucz nie musi być tajny - serwer odsyła jego skrót, którego tu nie sprawdzamy
+  static const char base64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  std::string key;
+  for (int i = 0; i < 21; i++)
+    key += base64[random() % 64];
+  key += "A==";
+
+  std::string request = "GET / HTTP/1.1\r\nHost: " + host + ":" + std::to_string(port) +
+                        "\r\nUpgrade: websocket\r\nConnection: Upgrade\r\nSec-WebSocket-Key: " + key +
+                        "\r\nSec-WebSocket-Version: 13\r\n\r\n";
+  int status;
+  std::string head;
+  if (!m_connection.sendAll(request.data(), request.size()) ||
+      !readHttpHead(m_connection, timeoutMs, status, head))
+  {
+    error = "brak odpowiedzi na otwarcie WebSocket";
+    m_connection.close();
+    return false;
+  }
+  if (status != 101)
+  {
+    error = "odmowa połączenia WebSocket: " + head.substr(0, head.find("\r\n"));
+    m_connection.close();
+    return false;
+  }
+  return true;
+}
+
+void LoadWebSocket::close()
+{
+  send(WS_OP_CLOSE, NULL, 0);
+  m_connection.close();
+}
+
+bool LoadWebSocket::send(WsOpcode opcode, const void *data, size_t length)
+{
+  uint8_t frame[14];
+  size_t head = 0;
+  frame[head++] = 0x80 | opcode;
+  if (length < 126)
+    frame[head++] = 0x80 | length;
+  else if (length < 65536)
+  {
+    frame[head++] = 0x80 | 126;
+    frame[head++] = length >> 8;
+    frame[head++] = length & 0xFF;
+  }
+  else
+  {
+    frame[head++] = 0x80 | 127;
+    for (int shift = 56; shift >= 0; shift -= 8)
+      frame[head++] = (uint64_t)length >> shift;
+  }
+
+  // xorshift - maska ma tylko uniemożliwić przewidzenie bajtów przez pośredników
+  m_maskState ^= m_maskState << 13;
+  m_maskState ^= m_maskState >> 17;
+  m_maskState ^= m_maskState << 5;
+  uint8_t *mask = frame + head;
+  memcpy(mask, &m_maskState, 4);
+  head += 4;
+
+  std::string message(reinterpret_cast<const char *>(frame), head);
+  const uint8_t *bytes = static_cast<const uint8_t *>(data);
+  for (size_t i = 0; i < length; i++)
+    message += (char)(bytes[i] ^ mask[i % 4]);
+  return m_connection.sendAll(message.data(), message.size());
+}
+
+bool LoadWebSocket::takeFrame(uint8_t &opcode, std::string &payload)
+{
+  const std::string &buffer = m_connection.buffer();
+  if (buffer.size() < 2)
+    return false;
+  const uint8_t *p = reinterpret_cast<const uint8_t *>(buffer.data());
+  uint64_t length = p[1] & 0x7F;
+  size_t start = 2;
+  if (length == 126)
+  {
+    if (buffer.size() < 4)
+      return false;
+    length = (p[2] << 8) | p[3];
+    start = 4;
+  }
+  else if (length == 127)
+  {
+    if (buffer.size() < 10)
+      return false;
+    length = 0;
+    for (int i = 0; i < 8; i++)
+      length = (length << 8) | p[2 + i];
+    start = 10;
+  }
+  if (buffer.size() - start < length)
+    return false;
+
+  opcode = p[0] & 0x0F;
+  payload.assign(buffer, start, length);
+  m_connection.buffer().erase(0, start + length);
+  return true;
+}
+
+WsReceive LoadWebSocket::receive(int timeoutMs, WsOpcode &opcode, std::string &payload)
+{
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+  for (;;)
+  {
+    uint8_t frameOpcode;
+    if (!takeFrame(frameOpcode, payload))
+    {
+      int left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+      if (m_connection.fill(left))
+        continue;
+      return m_connection.timedOut() ? WS_TIMEOUT : WS_CLOSED;
+    }
+
+    if (frameOpcode == WS_OP_PING)
+      send(WS_OP_PONG, payload.data(), payload.size());
+    else if (frameOpcode == WS_OP_CLOSE)
+      return WS_CLOSED;
+    else if (frameOpcode == WS_OP_TEXT || frameOpcode == WS_OP_BINARY)
+    {
+      opcode = static_cast<WsOpcode>(frameOpcode);
+      return WS_MESSAGE;
+    }
+  }
+}
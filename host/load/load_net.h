@@ -0,0 +1,81 @@
+#ifndef LOAD_NET_H
+#define LOAD_NET_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Połączenie TCP klienta testu obciążeniowego: gniazdo blokujące, odbiór do bufora z limitem
+// czasu przez poll(), bez Nagle'a (komendy sterowania są małe i mierzone co do milisekundy).
+class LoadConnection
+{
+public:
+  LoadConnection() = default;
+  ~LoadConnection();
+
+  LoadConnection(const LoadConnection &) = delete;
+  LoadConnection &operator=(const LoadConnection &) = delete;
+
+  bool open(const std::string &host, int port, int timeoutMs, std::string &error);
+  void close();
+  bool sendAll(const void *data, size_t length);
+
+  // dopisuje do bufora to, co nadeszło w timeoutMs; false - limit czasu (timedOut()) albo koniec połączenia
+  bool fill(int timeoutMs);
+  bool timedOut() const { return m_timedOut; }
+
+  std::string &buffer() { return m_buffer; }
+
+private:
+  int m_fd = -1;
+  bool m_timedOut = false;
+  std::string m_buffer;
+};
+
+// "adres[:port]" - port domyślny, gdy go nie podano
+void splitHostPort(const std::string &address, int defaultPort, std::string &host, int &port);
+
+// Nagłówki odpowiedzi HTTP z bufora połączenia (do pustej linii, usuwane z bufora)
+bool readHttpHead(LoadConnection &connection, int timeoutMs, int &status, std::string &head);
+
+// GET z ciałem odpowiedzi; kod statusu albo -1 przy błędzie połączenia
+int httpGet(const std::string &host, int port, const std::string &path, int timeoutMs, std::string &body);
+
+enum WsOpcode
+{
+  WS_OP_TEXT = 0x1,
+  WS_OP_BINARY = 0x2,
+  WS_OP_CLOSE = 0x8,
+  WS_OP_PING = 0x9,
+  WS_OP_PONG = 0xA
+};
+
+enum WsReceive
+{
+  WS_MESSAGE,
+  WS_TIMEOUT,
+  WS_CLOSED
+};
+
+// Klient WebSocket (RFC 6455): ramki od klienta maskowane, ping serwera dostaje pong od razu,
+// wiadomości pofragmentowanych serwer pojazdu nie wysyła
+class LoadWebSocket
+{
+public:
+  bool open(const std::string &host, int port, int timeoutMs, std::string &error);
+  void close();
+
+  bool send(WsOpcode opcode, const void *data, size_t length);
+  bool sendText(const std::string &text) { return send(WS_OP_TEXT, text.data(), text.size()); }
+
+  // następna wiadomość tekstowa albo binarna; niepełna ramka czeka w buforze na kolejne wywołanie
+  WsReceive receive(int timeoutMs, WsOpcode &opcode, std::string &payload);
+
+private:
+  bool takeFrame(uint8_t &opcode, std::string &payload);
+
+  LoadConnection m_connection;
+  uint32_t m_maskState = 0x9E3779B9;
+};
+
+#endif // LOAD_NET_H
@@ -0,0 +1,591 @@
+// Test obciążeniowy pojazdu: równoległe sterowanie WebSocket, strumienie MJPEG i odpytywanie REST.
+//
+// Klienci (każdy w osobnym wątku):
+//   sterujący JSON (--controllers) - {"command":"ml_unsubscribe"} ze stałą częstotliwością; RTT to
+//       czas do "ml_unsubscribed", odpowiedzi adresowanej tylko do nadawcy - bez ruchu pojazdu
+//   sterujący binarni (--binary-controllers) - 8-bajtowa ramka WS_BIN_ECHO (main/api_handler.h),
+//       RTT do potwierdzenia "CACK" z tym samym id
+//   widzowie (--viewers) - odczyt /stream, klatki/s i przepływność na widza
+//   odpytujący (--pollers) - GET /api/status ze stałą częstotliwością, czas odpowiedzi
+//
+// Komendy idą w stałym tempie niezależnie od odpowiedzi (wolny serwer nie zmniejsza obciążenia);
+// bez odpowiedzi w --timeout liczą się jako utracone. Sterujący odbierają też zdarzenia
+// sensor_data i ping; opóźnienie telemetrii jest liczone względem najszybciej dostarczonego
+// zdarzenia klienta (zegary hosta i pojazdu nie są zsynchronizowane).
+//
+// Przed testem licznik /api/load jest zerowany, po teście jego odczyt daje czas obsługi każdej
+// klasy żądań po stronie pojazdu. Podsumowanie JSON trafia na stdout albo do --json, czytelne
+// na stderr. Serwer WebSocket pojazdu przyjmuje najwyżej 5 klientów.
+//
+// Użycie:
+//   vehicle_load [--host 192.168.4.1] [--ws-port 82] [--controllers 2] [--binary-controllers 0]
+//                [--rate 10] [--viewers 1] [--pollers 1] [--poll-rate 2] [--duration 30]
+//                [--timeout 2] [--json wynik.json]
+
+#include "load_net.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+// binarna komenda sterowania i potwierdzenie - format z main/api_handler.h
+#define WS_BIN_COMMAND_SIZE 8
+#define WS_BIN_ACK_SIZE 8
+#define WS_BIN_ECHO 0
+#define WS_BIN_OK 0
+
+#define HTTP_PORT 80
+
+struct Options
+{
+  std::string host = "192.168.4.1";
+  int wsPort = 82;
+  int controllers = 2;
+  int binaryControllers = 0;
+  double rate = 10;
+  int viewers = 1;
+  int pollers = 1;
+  double pollRate = 2;
+  double duration = 30;
+  double timeout = 2;
+  const char *json = "-";
+};
+
+struct Controller
+{
+  bool binary = false;
+  std::vector<double> rtt;                         // ms
+  std::vector<std::pair<double, double>> telemetry; // odbiór ms, znacznik pojazdu ms
+  uint32_t sent = 0;
+  uint32_t timeouts = 0;
+  uint32_t rejected = 0; // potwierdzenia binarne ze statusem innym niż WS_BIN_OK
+  std::string error;
+};
+
+struct Viewer
+{
+  uint32_t frames = 0;
+  uint64_t bytes = 0;
+  double elapsed = 0;
+  std::string error;
+};
+
+struct Poller
+{
+  std::vector<double> latency; // ms
+  uint32_t errors = 0;
+};
+
+struct Distribution
+{
+  size_t count;
+  double p50, p90, p99, max;
+};
+
+static double nowMs()
+{
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static Distribution distribution(std::vector<double> values)
+{
+  Distribution result = {values.size(), 0, 0, 0, 0};
+  if (values.empty())
+    return result;
+  std::sort(values.begin(), values.end());
+  auto percentile = [&](double p)
+  {
+    return values[std::min(values.size() - 1, (size_t)std::lround(p / 100.0 * (values.size() - 1)))];
+  };
+  result.p50 = percentile(50);
+  result.p90 = percentile(90);
+  result.p99 = percentile(99);
+  result.max = values.back();
+  return result;
+}
+
+// liczba za "klucz": w tekście JSON od pozycji from; NAN, gdy jej nie ma
+static double jsonNumber(const std::string &text, const char *key, size_t from = 0)
+{
+  std::string pattern = std::string("\"") + key + "\":";
+  size_t at = text.find(pattern, from);
+  if (at == std::string::npos)
+    return NAN;
+  const char *start = text.c_str() + at + pattern.size();
+  char *end;
+  double value = strtod(start, &end);
+  return end == start ? NAN : value;
+}
+
+// obiekt za "klucz" (z nawiasami) - dosłownie, do przeniesienia do podsumowania
+static std::string jsonObject(const std::string &text, const char *key)
+{
+  std::string pattern = std::string("\"") + key + "\":{";
+  size_t start = text.find(pattern);
+  if (start == std::string::npos)
+    return "";
+  start += pattern.size() - 1;
+  int depth = 0;
+  bool quoted = false;
+  for (size_t i = start; i < text.size(); i++)
+  {
+    char c = text[i];
+    if (quoted)
+      quoted = !(c == '"' && text[i - 1] != '\\');
+    else if (c == '"')
+      quoted = true;
+    else if (c == '{')
+      depth++;
+    else if (c == '}' && --depth == 0)
+      return text.substr(start, i - start + 1);
+  }
+  return "";
+}
+
+static std::string jsonString(const std::string &text)
+{
+  std::string out = "\"";
+  for (char c : text)
+  {
+    if (c == '"' || c == '\\')
+      out += '\\';
+    if ((unsigned char)c < 0x20)
+      out += ' ';
+    else
+      out += c;
+  }
+  return out + "\"";
+}
+
+static void runController(const Options &options, Controller &controller, const std::atomic<bool> &stop)
+{
+  // --host może mieć port HTTP; WebSocket działa na osobnym porcie --ws-port
+  std::string host;
+  int httpPort;
+  splitHostPort(options.host, HTTP_PORT, host, httpPort);
+  LoadWebSocket ws;
+  if (!ws.open(host, options.wsPort, options.timeout * 1000, controller.error))
+    return;
+
+  double period = 1000.0 / options.rate;
+  double timeout = options.timeout * 1000;
+  double nextSend = nowMs();
+  uint16_t nextId = 1;
+  std::deque<double> pendingJson;           // odpowiedzi JSON przychodzą w kolejności komend
+  std::map<uint16_t, double> pendingBinary; // id -> czas wysłania
+
+  while (!stop)
+  {
+    double now = nowMs();
+    while (!pendingJson.empty() && now - pendingJson.front() > timeout)
+    {
+      pendingJson.pop_front();
+      controller.timeouts++;
+    }
+    for (auto it = pendingBinary.begin(); it != pendingBinary.end();)
+    {
+      if (now - it->second > timeout)
+      {
+        it = pendingBinary.erase(it);
+        controller.timeouts++;
+      }
+      else
+        ++it;
+    }
+
+    if (now >= nextSend)
+    {
+      bool sent;
+      if (controller.binary)
+      {
+        uint16_t id = nextId++;
+        uint8_t frame[WS_BIN_COMMAND_SIZE] = {WS_BIN_ECHO, 0, (uint8_t)(id & 0xFF), (uint8_t)(id >> 8)};
+        sent = ws.send(WS_OP_BINARY, frame, sizeof(frame));
+        pendingBinary[id] = now;
+      }
+      else
+      {
+        sent = ws.sendText("{\"command\":\"ml_unsubscribe\"}");
+        pendingJson.push_back(now);
+      }
+      if (!sent)
+      {
+        controller.error = "wysyłka komendy nieudana";
+        break;
+      }
+      controller.sent++;
+      nextSend = std::max(nextSend + period, now - period);
+    }
+
+    WsOpcode opcode;
+    std::string payload;
+    WsReceive status = ws.receive(std::max(1, (int)(nextSend - nowMs())), opcode, payload);
+    if (status == WS_TIMEOUT)
+      continue;
+    if (status == WS_CLOSED)
+    {
+      controller.error = "serwer zamknął połączenie";
+      break;
+    }
+    double received = nowMs();
+
+    if (opcode == WS_OP_BINARY)
+    {
+      if (payload.size() != WS_BIN_ACK_SIZE || payload.compare(0, 4, "CACK") != 0)
+        continue;
+      const uint8_t *ack = reinterpret_cast<const uint8_t *>(payload.data());
+      auto it = pendingBinary.find(ack[6] | (ack[7] << 8));
+      if (it == pendingBinary.end())
+        continue;
+      controller.rtt.push_back(received - it->second);
+      pendingBinary.erase(it);
+      if (ack[5] != WS_BIN_OK)
+        controller.rejected++;
+      continue;
+    }
+
+    if (payload.find("\"status\":\"ml_unsubscribed\"") != std::string::npos)
+    {
+      if (!pendingJson.empty())
+      {
+        controller.rtt.push_back(received - pendingJson.front());
+        pendingJson.pop_front();
+      }
+    }
+    else if (payload.find("\"event\":\"ping\"") != std::string::npos)
+    {
+      double t = jsonNumber(payload, "t");
+      if (!std::isnan(t))
+      {
+        ws.sendText("{\"command\":\"pong\",\"t\":" + std::to_string((unsigned long)t) + "}");
+        controller.telemetry.push_back({received, t});
+      }
+    }
+    else if (payload.find("\"event\":\"sensor_data\"") != std::string::npos)
+    {
+      double timestamp = jsonNumber(payload, "timestamp");
+      if (!std::isnan(timestamp))
+        controller.telemetry.push_back({received, timestamp});
+    }
+  }
+  ws.close();
+}
+
+static void runViewer(const Options &options, Viewer &viewer, const std::atomic<bool> &stop)
+{
+  std::string host;
+  int port;
+  splitHostPort(options.host, HTTP_PORT, host, port);
+  LoadConnection connection;
+  std::string request = "GET /stream HTTP/1.1\r\nHost: " + host + "\r\n\r\n";
+  int status;
+  std::string head;
+  if (!connection.open(host, port, 10000, viewer.error) || !connection.sendAll(request.data(), request.size()) ||
+      !readHttpHead(connection, 10000, status, head))
+  {
+    if (viewer.error.empty())
+      viewer.error = "brak odpowiedzi /stream";
+    return;
+  }
+  if (status != 200)
+  {
+    viewer.error = "/stream: HTTP " + std::to_string(status);
+    return;
+  }
+
+  double start = nowMs();
+  std::string &buffer = connection.buffer();
+  long remaining = 0; // bajty bieżącej klatki jeszcze do pominięcia
+  while (!stop)
+  {
+    if (remaining > 0)
+    {
+      long take = std::min<long>(remaining, buffer.size());
+      buffer.erase(0, take);
+      remaining -= take;
+      if (remaining == 0)
+        viewer.frames++;
+      if (!buffer.empty())
+        continue;
+    }
+    else
+    {
+      // nagłówki części: "Content-Type: image/jpeg\r\nContent-Length: N\r\n...\r\n\r\n"
+      size_t part = buffer.find("Content-Type: image/jpeg");
+      size_t end = part == std::string::npos ? part : buffer.find("\r\n\r\n", part);
+      if (end != std::string::npos)
+      {
+        size_t length = buffer.find("Content-Length:", part);
+        remaining = length < end ? atol(buffer.c_str() + length + 15) : 0;
+        viewer.bytes += remaining;
+        buffer.erase(0, end + 4);
+        if (remaining == 0)
+          viewer.frames++;
+        continue;
+      }
+      if (part == std::string::npos && buffer.size() > 64)
+        buffer.erase(0, buffer.size() - 64); // początek nagłówka może być na końcu bufora
+    }
+
+    if (!connection.fill(100) && !connection.timedOut())
+    {
+      viewer.error = "strumień przerwany";
+      break;
+    }
+  }
+  viewer.elapsed = (nowMs() - start) / 1000;
+}
+
+static void runPoller(const Options &options, Poller &poller, const std::atomic<bool> &stop)
+{
+  std::string host;
+  int port;
+  splitHostPort(options.host, HTTP_PORT, host, port);
+  double period = 1000.0 / options.pollRate;
+  double nextPoll = nowMs();
+  while (!stop)
+  {
+    double wait = nextPoll - nowMs();
+    if (wait > 0)
+    {
+      std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(std::min(wait, 50.0)));
+      continue;
+    }
+    nextPoll += period;
+
+    double start = nowMs();
+    std::string body;
+    if (httpGet(host, port, "/api/status", options.timeout * 1000, body) == 200)
+      poller.latency.push_back(nowMs() - start);
+    else
+      poller.errors++;
+  }
+}
+
+// obiekt "data" odpowiedzi /api/load albo pusty napis
+static std::string fetchLoad(const Options &options, bool reset)
+{
+  std::string host;
+  int port;
+  splitHostPort(options.host, HTTP_PORT, host, port);
+  std::string body;
+  if (httpGet(host, port, reset ? "/api/load?reset=1" : "/api/load", 10000, body) != 200)
+    return "";
+  return jsonObject(body, "data");
+}
+
+static std::string distributionJson(const Distribution &d)
+{
+  char text[160];
+  snprintf(text, sizeof(text), "{\"count\": %zu, \"p50\": %.2f, \"p90\": %.2f, \"p99\": %.2f, \"max\": %.2f}",
+           d.count, d.p50, d.p90, d.p99, d.max);
+  return text;
+}
+
+static void reportDistribution(const char *name, const Distribution &d, const char *suffix)
+{
+  fprintf(stderr, "  %-22s p50 %7.1f  p90 %7.1f  p99 %7.1f  max %7.1f%s\n", name, d.p50, d.p90, d.p99, d.max, suffix);
+}
+
+static const char *const REQUEST_CLASSES[] = {"page", "api", "camera", "dataset", "ws_command", "ws_push", "stream"};
+
+static void reportServer(const std::string &server)
+{
+  if (server.empty())
+  {
+    fprintf(stderr, "Pojazd: brak /api/load\n");
+    return;
+  }
+  fprintf(stderr, "Pojazd (okno %.0f ms):\n", jsonNumber(server, "window_ms"));
+  for (const char *name : REQUEST_CLASSES)
+  {
+    size_t at = server.find(std::string("\"") + name + "\":{");
+    if (at == std::string::npos || !(jsonNumber(server, "count", at) > 0))
+      continue;
+    fprintf(stderr, "  %-11s %6.0f  śr. %7.0f us  max %7.0f us  %5.1f%%\n", name, jsonNumber(server, "count", at),
+            jsonNumber(server, "avg_us", at), jsonNumber(server, "max_us", at), jsonNumber(server, "load_pct", at));
+  }
+}
+
+static bool parseOptions(int argc, char **argv, Options &options)
+{
+  for (int i = 1; i + 1 < argc; i += 2)
+  {
+    const char *arg = argv[i];
+    const char *value = argv[i + 1];
+    if (strcmp(arg, "--host") == 0)
+      options.host = value;
+    else if (strcmp(arg, "--ws-port") == 0)
+      options.wsPort = atoi(value);
+    else if (strcmp(arg, "--controllers") == 0)
+      options.controllers = atoi(value);
+    else if (strcmp(arg, "--binary-controllers") == 0)
+      options.binaryControllers = atoi(value);
+    else if (strcmp(arg, "--rate") == 0)
+      options.rate = atof(value);
+    else if (strcmp(arg, "--viewers") == 0)
+      options.viewers = atoi(value);
+    else if (strcmp(arg, "--pollers") == 0)
+      options.pollers = atoi(value);
+    else if (strcmp(arg, "--poll-rate") == 0)
+      options.pollRate = atof(value);
+    else if (strcmp(arg, "--duration") == 0)
+      options.duration = atof(value);
+    else if (strcmp(arg, "--timeout") == 0)
+      options.timeout = atof(value);
+    else if (strcmp(arg, "--json") == 0)
+      options.json = value;
+    else
+      return false;
+  }
+  return argc % 2 == 1 && options.controllers >= 0 && options.binaryControllers >= 0 && options.viewers >= 0 &&
+         options.pollers >= 0 && options.rate > 0 && options.pollRate > 0 && options.duration > 0 && options.timeout > 0;
+}
+
+int main(int argc, char **argv)
+{
+  Options options;
+  if (!parseOptions(argc, argv, options))
+  {
+    fprintf(stderr, "Użycie: %s [--host ADRES[:PORT]] [--ws-port N] [--controllers N] [--binary-controllers N] "
+                    "[--rate HZ] [--viewers N] [--pollers N] [--poll-rate HZ] [--duration S] [--timeout S] "
+                    "[--json PLIK]\n",
+            argv[0]);
+    return 2;
+  }
+
+  fetchLoad(options, true);
+
+  std::vector<Controller> controllers(options.controllers + options.binaryControllers);
+  for (int i = options.controllers; i < (int)controllers.size(); i++)
+    controllers[i].binary = true;
+  std::vector<Viewer> viewers(options.viewers);
+  std::vector<Poller> pollers(options.pollers);
+
+  std::atomic<bool> stop{false};
+  std::vector<std::thread> threads;
+  double start = nowMs();
+  for (Controller &controller : controllers)
+    threads.emplace_back(runController, std::cref(options), std::ref(controller), std::cref(stop));
+  for (Viewer &viewer : viewers)
+    threads.emplace_back(runViewer, std::cref(options), std::ref(viewer), std::cref(stop));
+  for (Poller &poller : pollers)
+    threads.emplace_back(runPoller, std::cref(options), std::ref(poller), std::cref(stop));
+  std::this_thread::sleep_for(std::chrono::duration<double>(options.duration));
+  stop = true;
+  for (std::thread &thread : threads)
+    thread.join();
+  double duration = (nowMs() - start) / 1000;
+
+  std::string server = fetchLoad(options, false);
+
+  std::string text = "{\n";
+  char line[256];
+  snprintf(line, sizeof(line), "  \"duration_s\": %.2f,\n  \"rate\": %.2f,\n", duration, options.rate);
+  text += line;
+
+  std::vector<double> lag;
+  for (int binary = 0; binary <= 1; binary++)
+  {
+    std::vector<double> rtt;
+    uint32_t clients = 0, sent = 0, timeouts = 0, rejected = 0;
+    for (const Controller &controller : controllers)
+    {
+      if (controller.binary != (binary == 1))
+        continue;
+      clients++;
+      sent += controller.sent;
+      timeouts += controller.timeouts;
+      rejected += controller.rejected;
+      rtt.insert(rtt.end(), controller.rtt.begin(), controller.rtt.end());
+    }
+    Distribution d = distribution(rtt);
+    snprintf(line, sizeof(line), "  \"%s_controllers\": {\"clients\": %u, \"sent\": %u, \"timeouts\": %u, \"rejected\": %u, ",
+             binary ? "binary" : "json", clients, sent, timeouts, rejected);
+    text += line + std::string("\"rtt_ms\": ") + distributionJson(d) + "},\n";
+    if (clients > 0)
+    {
+      fprintf(stderr, "Sterowanie %s: %u klientów, %u komend, %u bez odpowiedzi, %u odrzuconych\n",
+              binary ? "binarne" : "JSON", clients, sent, timeouts, rejected);
+      reportDistribution("RTT komendy (ms):", d, "");
+    }
+  }
+  for (const Controller &controller : controllers)
+  {
+    double offset = INFINITY;
+    for (const auto &event : controller.telemetry)
+      offset = std::min(offset, event.first - event.second);
+    for (const auto &event : controller.telemetry)
+      lag.push_back(event.first - event.second - offset);
+  }
+  Distribution lagDistribution = distribution(lag);
+  text += "  \"telemetry_lag_ms\": " + distributionJson(lagDistribution) + ",\n";
+  if (!controllers.empty())
+    reportDistribution("opóźnienie telemetrii:", lagDistribution, " (+min)");
+
+  text += "  \"viewers\": [";
+  for (size_t i = 0; i < viewers.size(); i++)
+  {
+    const Viewer &v = viewers[i];
+    double fps = v.elapsed > 0 ? v.frames / v.elapsed : 0;
+    double kbps = v.elapsed > 0 ? v.bytes / 1024.0 / v.elapsed : 0;
+    snprintf(line, sizeof(line), "%s\n    {\"frames\": %u, \"fps\": %.2f, \"kbps\": %.1f, \"error\": ", i ? "," : "",
+             v.frames, fps, kbps);
+    text += line + (v.error.empty() ? std::string("null") : jsonString(v.error)) + "}";
+    fprintf(stderr, "Widz %zu: %.1f fps, %.1f KB/s%s%s%s\n", i, fps, kbps, v.error.empty() ? "" : " (",
+            v.error.c_str(), v.error.empty() ? "" : ")");
+  }
+  text += viewers.empty() ? "],\n" : "\n  ],\n";
+
+  std::vector<double> latency;
+  uint32_t pollErrors = 0;
+  for (const Poller &poller : pollers)
+  {
+    latency.insert(latency.end(), poller.latency.begin(), poller.latency.end());
+    pollErrors += poller.errors;
+  }
+  Distribution latencyDistribution = distribution(latency);
+  snprintf(line, sizeof(line), "  \"pollers\": {\"clients\": %zu, \"errors\": %u, \"latency_ms\": ", pollers.size(), pollErrors);
+  text += line + distributionJson(latencyDistribution) + "},\n";
+  if (!pollers.empty())
+    fprintf(stderr, "REST: %zu żądań, %u błędów, p50 %.1f  p99 %.1f ms\n", latencyDistribution.count, pollErrors,
+            latencyDistribution.p50, latencyDistribution.p99);
+
+  text += "  \"server\": " + (server.empty() ? std::string("null") : server) + ",\n  \"errors\": [";
+  bool first = true;
+  for (const Controller &controller : controllers)
+  {
+    if (controller.error.empty())
+      continue;
+    text += (first ? "" : ", ") + jsonString(controller.error);
+    first = false;
+  }
+  text += "]\n}\n";
+
+  reportServer(server);
+  for (const Controller &controller : controllers)
+  {
+    if (!controller.error.empty())
+      fprintf(stderr, "błąd: %s\n", controller.error.c_str());
+  }
+
+  FILE *out = strcmp(options.json, "-") == 0 ? stdout : fopen(options.json, "w");
+  if (!out)
+  {
+    fprintf(stderr, "Nie można zapisać %s\n", options.json);
+    return 2;
+  }
+  fputs(text.c_str(), out);
+  if (out != stdout)
+    fclose(out);
+  return 0;
+}
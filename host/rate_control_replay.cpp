@@ -0,0 +1,212 @@
+// Sprawdzenie regulatora jakości JPEG na przebiegu rozmiarów klatek. Odtwarzany jest
+// updateRateControl() z main/rate_control.cpp, skompilowany bez zmian; sensor kamery zastępuje
+// esp_camera_sensor_get() z tego pliku, który tylko zapamiętuje ustawioną jakość.
+//
+// Przebieg (CSV frame,bytes,quality z tools/record_frame_sizes.py) opisuje złożoność sceny przy
+// stałej jakości. Rozmiar klatki przy jakości q jest przeskalowany z zapisanego:
+// bytes * 2 ^ ((quality - q) / halving), gdzie `halving` to liczba stopni jakości, o które
+// rozmiar maleje dwukrotnie. Wynik (JSON na stdout): liczba zmian jakości, zmiany kierunku
+// korekty (oscylacje), udział klatek w paśmie histerezy po ustaleniu i średni rozmiar względem
+// budżetu; z --check kod wyjścia 1 po przekroczeniu limitów. --synthetic zamiast pliku
+// odtwarza scenę spokojną - ruchliwą - spokojną.
+//
+// Użycie:
+//   rate_control_replay trace.csv [--target 15000] [--halving 12] [--check]
+//   rate_control_replay --synthetic --check
+
+#include "config.h"
+#include "rate_control.h"
+
+#include <esp_camera.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+static int sensorQuality = JPEG_QUALITY_INITIAL;
+
+static int setQuality(sensor_t *, int quality)
+{
+  sensorQuality = quality;
+  return 0;
+}
+
+static sensor_t sensor = {setQuality};
+
+sensor_t *esp_camera_sensor_get()
+{
+  return &sensor;
+}
+
+struct TraceFrame
+{
+  size_t bytes;
+  int quality; // jakość, przy której klatka została zapisana
+};
+
+struct Options
+{
+  const char *trace = NULL;
+  bool synthetic = false;
+  long target = -1; // -1 - budżet z config.h
+  double halving = 12;
+  size_t settle = 60; // klatki pomijane w statystykach na początku
+  bool check = false;
+  int maxReversals = 10;
+  double minInBand = 50;
+};
+
+static bool loadTrace(const char *path, std::vector<TraceFrame> &trace)
+{
+  FILE *f = fopen(path, "r");
+  if (!f)
+    return false;
+
+  char line[128];
+  while (fgets(line, sizeof(line), f))
+  {
+    unsigned long bytes;
+    int quality;
+    // nagłówek i puste wiersze nie pasują do wzorca
+    if (sscanf(line, "%*lu,%lu,%d", &bytes, &quality) == 2)
+      trace.push_back({bytes, quality});
+  }
+  fclose(f);
+  return true;
+}
+
+// scena spokojna, ruchliwa (klatki 2,5x większe) i znowu spokojna, z lekkim szumem
+static void syntheticTrace(std::vector<TraceFrame> &trace)
+{
+  for (int i = 0; i < 600; i++)
+  {
+    double base = (i >= 200 && i < 400) ? 12000 : 4800;
+    double noise = ((i * 7919) % 23 - 11) / 100.0;
+    trace.push_back({(size_t)(base * (1 + noise)), JPEG_QUALITY_INITIAL});
+  }
+}
+
+static bool parseOptions(int argc, char **argv, Options &options)
+{
+  for (int i = 1; i < argc; i++)
+  {
+    const char *arg = argv[i];
+    const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+    if (strcmp(arg, "--synthetic") == 0)
+      options.synthetic = true;
+    else if (strcmp(arg, "--check") == 0)
+      options.check = true;
+    else if (arg[0] != '-' && !options.trace)
+      options.trace = arg;
+    else if (!value)
+      return false;
+    else
+    {
+      if (strcmp(arg, "--target") == 0)
+        options.target = atol(value);
+      else if (strcmp(arg, "--halving") == 0)
+        options.halving = atof(value);
+      else if (strcmp(arg, "--settle") == 0)
+        options.settle = atol(value);
+      else if (strcmp(arg, "--max-reversals") == 0)
+        options.maxReversals = atoi(value);
+      else if (strcmp(arg, "--min-in-band") == 0)
+        options.minInBand = atof(value);
+      else
+        return false;
+      i++;
+    }
+  }
+  return (options.synthetic || options.trace) && options.halving > 0;
+}
+
+int main(int argc, char **argv)
+{
+  Options options;
+  if (!parseOptions(argc, argv, options))
+  {
+    fprintf(stderr, "Użycie: %s (trace.csv | --synthetic) [--target B] [--halving N] [--settle N] "
+                    "[--check] [--max-reversals N] [--min-in-band PCT]\n",
+            argv[0]);
+    return 2;
+  }
+
+  std::vector<TraceFrame> trace;
+  if (options.synthetic)
+    syntheticTrace(trace);
+  else if (!loadTrace(options.trace, trace))
+  {
+    fprintf(stderr, "Nie można otworzyć %s\n", options.trace);
+    return 2;
+  }
+
+  setupRateControl(JPEG_QUALITY_INITIAL);
+  if (options.target >= 0)
+    setRateControlTarget(options.target);
+  size_t target = getRateControlStats().targetBytes;
+
+  std::vector<double> sizes;
+  std::vector<int> qualities;
+  for (const TraceFrame &frame : trace)
+  {
+    double frameLen = frame.bytes * pow(2.0, (frame.quality - sensorQuality) / options.halving);
+    sizes.push_back(frameLen);
+    qualities.push_back(sensorQuality);
+    updateRateControl((size_t)frameLen);
+  }
+
+  // oscylacje: zmiany kierunku korekty jakości
+  int reversals = 0;
+  int lastStep = 0;
+  for (size_t i = 1; i < qualities.size(); i++)
+  {
+    int step = (qualities[i] > qualities[i - 1]) - (qualities[i] < qualities[i - 1]);
+    if (step && lastStep && step != lastStep)
+      reversals++;
+    if (step)
+      lastStep = step;
+  }
+
+  double hysteresis = JPEG_RATE_HYSTERESIS / 100.0;
+  size_t settled = 0;
+  size_t inBand = 0;
+  double total = 0;
+  for (size_t i = options.settle; i < sizes.size(); i++)
+  {
+    settled++;
+    total += sizes[i];
+    if (target && fabs(sizes[i] / target - 1) <= hysteresis)
+      inBand++;
+  }
+  double inBandPct = settled ? 100.0 * inBand / settled : 0;
+  double meanToTarget = settled && target ? total / settled / target : 0;
+
+  RateControlStats stats = getRateControlStats();
+  printf("{\n"
+         "  \"frames\": %zu,\n"
+         "  \"target_bytes\": %zu,\n"
+         "  \"adjustments\": %u,\n"
+         "  \"reversals\": %d,\n"
+         "  \"final_quality\": %d,\n"
+         "  \"in_band_pct\": %.1f,\n"
+         "  \"mean_to_target\": %.3f\n"
+         "}\n",
+         trace.size(), target, (unsigned)stats.adjustments, reversals, stats.quality, inBandPct, meanToTarget);
+
+  if (!options.check)
+    return 0;
+
+  bool failed = false;
+  if (reversals > options.maxReversals)
+  {
+    fprintf(stderr, "BŁĄD: oscylacje: %d zmian kierunku (limit %d)\n", reversals, options.maxReversals);
+    failed = true;
+  }
+  if (inBandPct < options.minInBand)
+  {
+    fprintf(stderr, "BŁĄD: w paśmie %.1f%% klatek (minimum %.1f%%)\n", inBandPct, options.minInBand);
+    failed = true;
+  }
+  return failed ? 1 : 0;
+}
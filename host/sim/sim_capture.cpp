@@ -0,0 +1,144 @@
+#include "sim_vehicle.h"
+#include "host_clock.h"
+
+#include "capture_pipeline.h"
+#include "hardware.h"
+#include "still_cache.h"
+
+static CapturedFrame capturePool[CAPTURE_BUFFER_COUNT];
+static CapturedFrame *latestFrame = NULL;
+static uint32_t nextSeq = 1;
+static int captureSubscribers = 0;
+static unsigned long frameInterval = 40;
+static int64_t nextFrameTime = 0;
+
+// wolny bufor: nikt go nie trzyma i nie jest najnowszą klatką
+static CapturedFrame *findFreeSlot()
+{
+  for (int i = 0; i < CAPTURE_BUFFER_COUNT; i++)
+  {
+    if (capturePool[i].refs == 0 && &capturePool[i] != latestFrame)
+      return &capturePool[i];
+  }
+  return NULL;
+}
+
+static void captureFrame()
+{
+  CapturedFrame *slot = findFreeSlot();
+  if (!slot)
+    return;
+
+  camera_fb_t *fb = getCameraFrame();
+  if (!fb)
+    return;
+  bool ok = storeFrame(slot, fb->buf, fb->len);
+  slot->timestamp = frameTimestamp(fb);
+  returnCameraFrame(fb);
+  if (!ok)
+    return;
+
+  slot->seq = nextSeq++;
+  slot->captureTime = millis();
+  slot->hasSignature = false;
+  latestFrame = slot;
+}
+
+void setupSimCapture(unsigned long interval)
+{
+  for (CapturedFrame &frame : capturePool)
+  {
+    free(frame.buf);
+    frame = CapturedFrame();
+  }
+  latestFrame = NULL;
+  captureSubscribers = 0;
+  frameInterval = interval;
+}
+
+void simAdvanceTo(int64_t time)
+{
+  while (captureSubscribers > 0 && nextFrameTime <= time)
+  {
+    if (nextFrameTime > hostClockNow())
+      hostClockSet(nextFrameTime);
+    captureFrame();
+    nextFrameTime = hostClockNow() + (int64_t)frameInterval * 1000;
+  }
+  if (time > hostClockNow())
+    hostClockSet(time);
+}
+
+bool startCapturePipeline()
+{
+  return true;
+}
+
+void captureSubscribe()
+{
+  // pierwsza klatka przy najbliższym upływie czasu, jak po wybudzeniu taska
+  if (captureSubscribers++ == 0)
+    nextFrameTime = hostClockNow();
+}
+
+void captureUnsubscribe()
+{
+  if (captureSubscribers > 0)
+    captureSubscribers--;
+}
+
+bool isCaptureRunning()
+{
+  return captureSubscribers > 0;
+}
+
+uint32_t takeFrameSeq()
+{
+  return nextSeq++;
+}
+
+CapturedFrame *acquireLatestFrame(uint32_t afterSeq)
+{
+  if (!latestFrame || (int32_t)(latestFrame->seq - afterSeq) <= 0)
+    return NULL;
+  latestFrame->refs++;
+  return latestFrame;
+}
+
+void retainFrame(CapturedFrame *frame)
+{
+  frame->refs++;
+}
+
+void releaseFrame(CapturedFrame *frame)
+{
+  if (frame)
+    frame->refs--;
+}
+
+bool storeFrame(CapturedFrame *slot, const uint8_t *buf, size_t len)
+{
+  if (len > slot->capacity)
+  {
+    // zapas jak w potoku na płytce, żeby nieco większa klatka nie wymagała kolejnej alokacji
+    size_t capacity = len + len / 4;
+    uint8_t *grown = static_cast<uint8_t *>(realloc(slot->buf, capacity));
+    if (!grown)
+      return false;
+    slot->buf = grown;
+    slot->capacity = capacity;
+  }
+  memcpy(slot->buf, buf, len);
+  slot->len = len;
+  return true;
+}
+
+// zdjęcia bez strumienia nie są symulowane - ml_frame bierze klatki z puli potoku
+StillCacheResult acquireCachedStill(framesize_t, unsigned long, CapturedFrame *&frame, unsigned long &age,
+                                    unsigned long &interruption)
+{
+  frame = NULL;
+  age = 0;
+  interruption = 0;
+  return STILL_CACHE_FAILED;
+}
@@ -0,0 +1,115 @@
+#include "sim_episode.h"
+#include "host_clock.h"
+
+#include "ml_step.h"
+#include "motor_control.h"
+#include "sensor_control.h"
+#include "vehicle_state.h"
+
+#define LOOP_DELAY 20             // ms, delay() na końcu loop() w main.ino
+#define STEP_CLIENT 0             // numer klienta WebSocket kroków
+#define TURN_BELOW 400            // mm; bliżej kontroler skręca
+#define TURN_UNTIL 700            // mm; skręca, aż przed pojazdem będzie tyle miejsca
+
+static SimEpisodeConfig config;
+static SimEpisodeResult result;
+static int64_t startTime = 0;
+static bool turning = false;
+
+static uint16_t readU16(const uint8_t *p)
+{
+  return p[0] | (p[1] << 8);
+}
+
+// kontroler: odległość z poprzedniej obserwacji, 0 - brak pomiaru
+static MlStepAction chooseAction(uint16_t distance, bool obstacleStop)
+{
+  if (obstacleStop || (distance > 0 && distance < TURN_BELOW))
+    turning = true;
+  else if (distance == 0 || distance > TURN_UNTIL)
+    turning = false;
+  return turning ? ML_STEP_LEFT : ML_STEP_FORWARD;
+}
+
+void startSimEpisode(const SimEpisodeConfig &episode)
+{
+  config = episode;
+  result = SimEpisodeResult();
+  turning = false;
+
+  hostClockSet(1000000);
+  startTime = hostClockNow();
+  setupSimVehicle(config.seed, config.cameraWidth, config.cameraHeight);
+  setupSimCapture(config.frameInterval);
+  endMlSteps(STEP_CLIENT);
+
+  setupMotors();
+  setupSensor();
+  stopMotors();
+  vehicle.mode = ML_CONTROL;
+  vehicle.lastEmergencyStopTime = 0;
+}
+
+// jeden krok: akcja, pętla główna do odpowiedzi, decyzja o następnej akcji
+static bool runStep(MlStepAction action)
+{
+  MlStepRequest request = {action, 0, 0, config.period, config.tensorWidth, config.tensorHeight, result.steps + 1};
+  uint32_t step;
+  if (!beginMlStep(STEP_CLIENT, request, step))
+    return false;
+
+  const uint8_t *buf = NULL;
+  size_t len = 0;
+  MlStepPoll poll;
+  for (;;)
+  {
+    poll = pollMlStep(STEP_CLIENT, buf, len);
+    if (poll != ML_STEP_PENDING)
+      break;
+    checkObstacles();
+    simAdvanceTo(hostClockNow() + LOOP_DELAY * 1000);
+  }
+
+  result.steps++;
+  if (poll != ML_STEP_READY || len < ML_STEP_HEADER_SIZE + ML_FRAME_HEADER_SIZE)
+  {
+    result.failures++;
+    chooseAction(0, false);
+    return true;
+  }
+
+  uint8_t flags = buf[18];
+  if (flags & ML_STEP_STALE_FRAME)
+    result.staleFrames++;
+  if (flags & ML_STEP_OBSTACLE_STOP)
+    result.obstacleStops++;
+
+  const uint8_t *luma = buf + ML_STEP_HEADER_SIZE + ML_FRAME_HEADER_SIZE;
+  size_t pixels = len - ML_STEP_HEADER_SIZE - ML_FRAME_HEADER_SIZE;
+  uint64_t sum = 0;
+  for (size_t i = 0; i < pixels; i++)
+    sum += luma[i];
+  result.lumaMean = pixels ? (float)sum / pixels : 0;
+
+  chooseAction(readU16(buf + 16), flags & ML_STEP_OBSTACLE_STOP);
+  return true;
+}
+
+uint32_t runSimSteps(uint32_t count)
+{
+  uint32_t done = 0;
+  for (; done < count; done++)
+  {
+    if (!runStep(turning ? ML_STEP_LEFT : ML_STEP_FORWARD))
+      break;
+  }
+  return done;
+}
+
+SimEpisodeResult getSimEpisodeResult()
+{
+  SimEpisodeResult current = result;
+  current.simTime = hostClockNow() - startTime;
+  current.vehicle = getSimVehicleStats();
+  return current;
+}
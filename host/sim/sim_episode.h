@@ -0,0 +1,44 @@
+#ifndef SIM_EPISODE_H
+#define SIM_EPISODE_H
+
+#include "sim_vehicle.h"
+
+#include <cstdint>
+
+// Zamknięta pętla sterowania na symulatorze: kroki lockstep z ml_step.h (akcja, okres
+// sterowania, obserwacja z klatki po okresie) wywoływane tak, jak robi to api_handler dla
+// {"command":"step"}, z pętlą główną firmware'u co 20 ms (checkObstacles(), odbiór kroku)
+// i potokiem przechwytywania z sim_vehicle.h. Prosty kontroler jedzie prosto i skręca przed
+// przeszkodą według odległości z odpowiedzi kroku.
+
+struct SimEpisodeConfig
+{
+  uint32_t seed = 1;
+  unsigned long period = 100;       // okres sterowania (ms)
+  int cameraWidth = 320;
+  int cameraHeight = 240;
+  unsigned long frameInterval = 40; // odstęp klatek kamery (ms)
+  int tensorWidth = 64;
+  int tensorHeight = 48;
+};
+
+struct SimEpisodeResult
+{
+  uint32_t steps;
+  uint32_t failures;      // kroki bez obserwacji
+  uint32_t staleFrames;   // obserwacje z klatki sprzed końca okresu
+  uint32_t obstacleStops; // kroki zatrzymane przez czujnik
+  int64_t simTime;        // czas wirtualny epizodu (µs)
+  float lumaMean;         // średnia jasność ostatniego tensora
+  SimVehicleStats vehicle;
+};
+
+// Nowy epizod; zegar wirtualny startuje od 1 s jak po uruchomieniu pojazdu
+void startSimEpisode(const SimEpisodeConfig &config);
+
+// Kolejne kroki pętli sterowania; zwraca liczbę wykonanych
+uint32_t runSimSteps(uint32_t count);
+
+SimEpisodeResult getSimEpisodeResult();
+
+#endif // SIM_EPISODE_H
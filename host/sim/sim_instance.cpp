@@ -0,0 +1,8 @@
+#include "sim_instance.h"
+
+static const SimInstanceApi api = {startSimEpisode, runSimSteps, getSimEpisodeResult};
+
+extern "C" __attribute__((visibility("default"))) const SimInstanceApi *simInstanceApi()
+{
+  return &api;
+}
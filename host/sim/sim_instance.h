@@ -0,0 +1,23 @@
+#ifndef SIM_INSTANCE_H
+#define SIM_INSTANCE_H
+
+#include "sim_episode.h"
+
+// Jedna instancja pojazdu do uruchamiania wielu naraz (vehicle_fleet). Logika firmware'u trzyma
+// stan w zmiennych globalnych modułów (`vehicle`, historia silników, filtr odległości, sloty
+// kroków, pula klatek, zegar wirtualny), więc każda instancja to osobno załadowana kopia modułu
+// vehicle_sim_instance - z własnym egzemplarzem tych zmiennych. Moduł eksportuje tylko
+// simInstanceApi(); wywołania jednej instancji nie mogą się nakładać, różne instancje mogą
+// działać równolegle w różnych wątkach.
+
+struct SimInstanceApi
+{
+  void (*start)(const SimEpisodeConfig &config);
+  uint32_t (*runSteps)(uint32_t count);
+  SimEpisodeResult (*result)();
+};
+
+#define SIM_INSTANCE_ENTRY "simInstanceApi"
+typedef const SimInstanceApi *(*SimInstanceEntry)();
+
+#endif // SIM_INSTANCE_H
@@ -0,0 +1,401 @@
+#include "sim_vehicle.h"
+#include "host_clock.h"
+
+#include "config.h"
+#include "hardware.h"
+#include "src/esp32cam/jpeg_encoder.hpp"
+
+#include <chrono>
+#include <vector>
+
+#define SIM_STEP 2000             // µs, krok całkowania modelu
+#define SIM_START_X 40.0f         // pozycja startowa (cm)
+#define SIM_START_Y 100.0f
+#define SIM_WHEEL_BASE 13.0f      // rozstaw kół (cm)
+#define SIM_WHEEL_MAX_SPEED 60.0f // prędkość koła przy PWM 255 (cm/s)
+#define SIM_MOTOR_DEADBAND 40     // PWM, poniżej którego koło stoi
+#define SIM_MOTOR_TAU 80.0f       // stała czasowa rozpędzania koła (ms)
+#define SIM_VEHICLE_RADIUS 10.0f  // promień obrysu pojazdu przy kolizjach (cm)
+#define SIM_SONAR_RANGE 400.0f    // zasięg HC-SR04 (cm)
+#define SIM_SONAR_MIN 2.0f
+#define SIM_SONAR_BEAM 0.26f      // połowa stożka czujnika (rad, 15°)
+#define SIM_SONAR_RAYS 5
+#define SIM_SONAR_NOISE 0.5f      // szum pomiaru odległości (cm)
+#define SIM_SONAR_DROPOUT 2       // pomiary bez echa (%)
+#define SIM_CAMERA_FOV 60.0f      // kąt widzenia kamery w poziomie (stopnie)
+#define SIM_CAMERA_QUALITY 80     // jakość JPEG renderu
+#define SIM_CAMERA_HEIGHT 8.0f    // wysokość obiektywu nad podłogą (cm)
+#define SIM_WALL_HEIGHT 30.0f
+#define SIM_FLOOR_TILE 20.0f      // bok pola szachownicy (cm)
+#define SIM_WALL_STRIPE 10.0f     // szerokość pasa na ścianie (cm)
+#define SIM_FAR 2000.0f           // promień bez trafienia (cm)
+#define SOUND_SPEED 0.0343f       // cm/µs
+
+struct Segment
+{
+  float x1, y1, x2, y2;
+  uint8_t r, g, b;
+};
+
+// arena 300 x 200 cm ze skrzynką na środku i ścianką przy prawej krawędzi
+static const Segment worldMap[] = {
+    {0, 0, 300, 0, 200, 195, 180},
+    {300, 0, 300, 200, 200, 195, 180},
+    {300, 200, 0, 200, 200, 195, 180},
+    {0, 200, 0, 0, 200, 195, 180},
+    {140, 80, 180, 80, 190, 70, 40},
+    {180, 80, 180, 120, 190, 70, 40},
+    {180, 120, 140, 120, 190, 70, 40},
+    {140, 120, 140, 80, 190, 70, 40},
+    {230, 0, 230, 70, 50, 90, 180},
+};
+#define WORLD_SEGMENTS (sizeof(worldMap) / sizeof(worldMap[0]))
+
+// kolumna renderu: granice ściany i kierunek promienia do rzutowania podłogi
+struct Column
+{
+  int top;
+  int bottom;
+  uint8_t r, g, b;
+  float floorX; // kierunek promienia podzielony przez cos kąta od osi kamery
+  float floorY;
+};
+
+// model
+static int motorDuty[4]; // IN1, IN2, IN3, IN4
+static float poseX = SIM_START_X;
+static float poseY = SIM_START_Y;
+static float poseHeading = 0;
+static float wheelLeft = 0;
+static float wheelRight = 0;
+static int64_t simTime = 0; // µs zegara wirtualnego, do której chwili model jest policzony
+static bool inContact = false;
+static uint32_t randomState = 1;
+static SimVehicleStats stats;
+
+// kamera - jedna klatka naraz, jak bufor sterownika przy fb_count 1
+static int cameraWidth = 320;
+static int cameraHeight = 240;
+static std::vector<uint8_t> pixels; // RGB888 (B-G-R)
+static std::vector<uint8_t> jpeg;
+static std::vector<Column> columns;
+static esp32cam::detail::JpegStripeEncoder encoder;
+static camera_fb_t renderedFrame;
+static bool frameTaken = false;
+
+static uint32_t nextRandom()
+{
+  randomState = randomState * 1664525 + 1013904223;
+  return randomState >> 8;
+}
+
+static float castRay(float ox, float oy, float dx, float dy, const Segment *&hit, float &along)
+{
+  float best = SIM_FAR;
+  hit = NULL;
+  for (size_t i = 0; i < WORLD_SEGMENTS; i++)
+  {
+    const Segment &s = worldMap[i];
+    float ex = s.x2 - s.x1, ey = s.y2 - s.y1;
+    float denom = dx * ey - dy * ex;
+    if (fabsf(denom) < 1e-6f)
+      continue;
+    float wx = s.x1 - ox, wy = s.y1 - oy;
+    float t = (wx * ey - wy * ex) / denom; // wzdłuż promienia
+    float u = (wx * dy - wy * dx) / denom; // wzdłuż odcinka, 0..1
+    if (t > 0 && t < best && u >= 0 && u <= 1)
+    {
+      best = t;
+      hit = &s;
+      along = u * sqrtf(ex * ex + ey * ey);
+    }
+  }
+  return best;
+}
+
+static float clearance(float x, float y)
+{
+  float nearest = SIM_FAR;
+  for (size_t i = 0; i < WORLD_SEGMENTS; i++)
+  {
+    const Segment &s = worldMap[i];
+    float ex = s.x2 - s.x1, ey = s.y2 - s.y1;
+    float u = ((x - s.x1) * ex + (y - s.y1) * ey) / (ex * ex + ey * ey);
+    u = constrain(u, 0.0f, 1.0f);
+    float px = s.x1 + u * ex - x, py = s.y1 + u * ey - y;
+    nearest = min(nearest, sqrtf(px * px + py * py));
+  }
+  return nearest;
+}
+
+// docelowa prędkość koła (cm/s) z wypełnień obu pinów mostka H
+static float wheelTarget(int forward, int backward)
+{
+  int pwm = forward - backward;
+  int magnitude = abs(pwm);
+  if (magnitude < SIM_MOTOR_DEADBAND)
+    return 0;
+  float speed = (float)(magnitude - SIM_MOTOR_DEADBAND) / (255 - SIM_MOTOR_DEADBAND) * SIM_WHEEL_MAX_SPEED;
+  return pwm > 0 ? speed : -speed;
+}
+
+// model policzony do bieżącej chwili zegara wirtualnego
+static void advance()
+{
+  int64_t now = hostClockNow();
+
+  // lewe koło do przodu na IN1, prawe na IN4 - jak w moveForward()
+  float targetLeft = wheelTarget(motorDuty[0], motorDuty[1]);
+  float targetRight = wheelTarget(motorDuty[3], motorDuty[2]);
+  const float dt = SIM_STEP / 1000000.0f;
+  const float lag = dt / (SIM_MOTOR_TAU / 1000.0f);
+
+  while (now - simTime >= SIM_STEP)
+  {
+    wheelLeft += (targetLeft - wheelLeft) * lag;
+    wheelRight += (targetRight - wheelRight) * lag;
+
+    float v = (wheelLeft + wheelRight) / 2;
+    float x = poseX + v * cosf(poseHeading) * dt;
+    float y = poseY + v * sinf(poseHeading) * dt;
+    poseHeading += (wheelRight - wheelLeft) / SIM_WHEEL_BASE * dt;
+    if (poseHeading > PI)
+      poseHeading -= 2 * PI;
+    else if (poseHeading < -PI)
+      poseHeading += 2 * PI;
+
+    // przy przeszkodzie pojazd stoi, a koła buksują
+    if (clearance(x, y) < SIM_VEHICLE_RADIUS)
+    {
+      if (!inContact)
+        stats.collisions++;
+      inContact = true;
+    }
+    else
+    {
+      stats.odometer += fabsf(v) * dt;
+      poseX = x;
+      poseY = y;
+      inContact = false;
+    }
+    simTime += SIM_STEP;
+  }
+}
+
+// najbliższa przeszkoda w stożku czujnika, licząc od przodu pojazdu
+static float sonarDistance(float x, float y, float heading)
+{
+  float nearest = SIM_FAR;
+  for (int i = 0; i < SIM_SONAR_RAYS; i++)
+  {
+    float angle = heading - SIM_SONAR_BEAM + 2 * SIM_SONAR_BEAM * i / (SIM_SONAR_RAYS - 1);
+    const Segment *hit;
+    float along;
+    nearest = min(nearest, castRay(x, y, cosf(angle), sinf(angle), hit, along));
+  }
+  float distance = nearest - SIM_VEHICLE_RADIUS;
+  if (distance > SIM_SONAR_RANGE)
+    return -1;
+  return max(distance, SIM_SONAR_MIN);
+}
+
+void writeMotorPin(uint8_t pin, int duty)
+{
+  int index;
+  switch (pin)
+  {
+  case LEFT_MOTOR_IN1:
+    index = 0;
+    break;
+  case LEFT_MOTOR_IN2:
+    index = 1;
+    break;
+  case RIGHT_MOTOR_IN3:
+    index = 2;
+    break;
+  case RIGHT_MOTOR_IN4:
+    index = 3;
+    break;
+  default:
+    return;
+  }
+
+  // dotychczasowe wypełnienie obowiązuje do chwili zapisu
+  advance();
+  motorDuty[index] = constrain(duty, 0, 255);
+}
+
+unsigned long measureEchoPulse(unsigned long timeout)
+{
+  // impuls wyzwalający jak w hardware.cpp
+  delayMicroseconds(12);
+  advance();
+  float distance = sonarDistance(poseX, poseY, poseHeading);
+  stats.echoes++;
+
+  bool dropout = nextRandom() % 100 < SIM_SONAR_DROPOUT;
+  unsigned long pulse = 0;
+  if (distance > 0 && !dropout)
+  {
+    distance += ((nextRandom() % 2001) / 1000.0f - 1) * SIM_SONAR_NOISE;
+    pulse = distance * 2 / SOUND_SPEED;
+  }
+  if (pulse == 0 || pulse > timeout)
+  {
+    // bez echa pulseIn() czeka do końca limitu
+    stats.dropouts++;
+    delayMicroseconds(timeout);
+    return 0;
+  }
+  delayMicroseconds(pulse);
+  return pulse;
+}
+
+static void renderView(int width, int height, float camX, float camY, float heading)
+{
+  float focal = (width / 2.0f) / tanf(SIM_CAMERA_FOV * PI / 360);
+  float horizon = height / 2.0f;
+
+  for (int x = 0; x < width; x++)
+  {
+    // kolumny od lewej: kąt od osi kamery maleje
+    float offset = atanf((x + 0.5f - width / 2.0f) / focal);
+    float angle = heading - offset;
+    float dx = cosf(angle), dy = sinf(angle), axial = cosf(offset);
+
+    const Segment *hit;
+    float along = 0;
+    float depth = castRay(camX, camY, dx, dy, hit, along) * axial;
+    Column &column = columns[x];
+    column.top = constrain((int)(horizon - (SIM_WALL_HEIGHT - SIM_CAMERA_HEIGHT) * focal / depth), 0, height);
+    column.bottom = constrain((int)(horizon + SIM_CAMERA_HEIGHT * focal / depth), 0, height);
+    column.floorX = dx / axial;
+    column.floorY = dy / axial;
+
+    // pasy na ścianach dają teksturę do oceny ruchu, jasność maleje z odległością
+    float shade = hit ? 1.0f / (1.0f + depth / 250.0f) : 0;
+    if (((int)(along / SIM_WALL_STRIPE)) & 1)
+      shade *= 0.75f;
+    column.r = hit ? hit->r * shade : 0;
+    column.g = hit ? hit->g * shade : 0;
+    column.b = hit ? hit->b * shade : 0;
+  }
+
+  uint8_t *p = pixels.data();
+  for (int y = 0; y < height; y++)
+  {
+    // odległość do podłogi widocznej w tym wierszu, wzdłuż osi kamery
+    float rowDepth = y + 0.5f > horizon ? SIM_CAMERA_HEIGHT * focal / (y + 0.5f - horizon) : SIM_FAR;
+    for (int x = 0; x < width; x++, p += 3)
+    {
+      const Column &column = columns[x];
+      if (y < column.top)
+      {
+        p[0] = 205;
+        p[1] = 190;
+        p[2] = 180;
+      }
+      else if (y < column.bottom)
+      {
+        p[0] = column.b;
+        p[1] = column.g;
+        p[2] = column.r;
+      }
+      else
+      {
+        float fx = camX + rowDepth * column.floorX;
+        float fy = camY + rowDepth * column.floorY;
+        bool dark = ((int)floorf(fx / SIM_FLOOR_TILE) + (int)floorf(fy / SIM_FLOOR_TILE)) & 1;
+        p[0] = dark ? 60 : 110;
+        p[1] = dark ? 70 : 120;
+        p[2] = dark ? 80 : 135;
+      }
+    }
+  }
+}
+
+camera_fb_t *getCameraFrame()
+{
+  if (frameTaken)
+    return NULL;
+
+  auto start = std::chrono::steady_clock::now();
+  advance();
+  renderView(cameraWidth, cameraHeight, poseX, poseY, poseHeading);
+
+  size_t len = 0;
+  if (encoder.begin(pixels.data(), cameraWidth, cameraHeight, esp32cam::detail::JpegStripeEncoder::RGB888,
+                    SIM_CAMERA_QUALITY, jpeg.data(), jpeg.size(), 1) &&
+      encoder.encodeStripe(0))
+    len = encoder.finish();
+  if (len == 0)
+    return NULL;
+
+  // znacznik czasu z chwili pozycji, tak jak znacznik klatki kamery z chwili ekspozycji
+  int64_t time = hostClockNow();
+  renderedFrame.buf = jpeg.data();
+  renderedFrame.len = len;
+  renderedFrame.width = cameraWidth;
+  renderedFrame.height = cameraHeight;
+  renderedFrame.format = PIXFORMAT_JPEG;
+  renderedFrame.timestamp.tv_sec = time / 1000000;
+  renderedFrame.timestamp.tv_usec = time % 1000000;
+  frameTaken = true;
+
+  float renderTime = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+  stats.renderTimeAvg = stats.frames == 0 ? renderTime : stats.renderTimeAvg * 0.9f + renderTime * 0.1f;
+  stats.frames++;
+  return &renderedFrame;
+}
+
+void returnCameraFrame(camera_fb_t *fb)
+{
+  if (fb == &renderedFrame)
+    frameTaken = false;
+}
+
+void setupSimVehicle(uint32_t seed, int width, int height)
+{
+  randomState = seed ? seed : 1;
+  cameraWidth = width;
+  cameraHeight = height;
+  pixels.assign((size_t)width * height * 3, 0);
+  // render z płaskich powierzchni kompresuje się znacznie poniżej bajtu na piksel
+  jpeg.assign((size_t)width * height + 4096, 0);
+  columns.assign(width, Column());
+  frameTaken = false;
+
+  stats = SimVehicleStats();
+  for (int &duty : motorDuty)
+    duty = 0;
+  simTime = hostClockNow();
+  resetSimVehicle(SIM_START_X, SIM_START_Y, 0);
+}
+
+bool resetSimVehicle(float x, float y, float heading)
+{
+  if (clearance(x, y) < SIM_VEHICLE_RADIUS)
+    return false;
+
+  advance();
+  poseX = x;
+  poseY = y;
+  poseHeading = heading * PI / 180;
+  wheelLeft = 0;
+  wheelRight = 0;
+  inContact = false;
+  return true;
+}
+
+SimVehicleStats getSimVehicleStats()
+{
+  advance();
+  SimVehicleStats result = stats;
+  result.x = poseX;
+  result.y = poseY;
+  result.heading = poseHeading * 180 / PI;
+  result.leftSpeed = wheelLeft;
+  result.rightSpeed = wheelRight;
+  result.distance = sonarDistance(poseX, poseY, poseHeading);
+  return result;
+}
@@ -0,0 +1,49 @@
+#ifndef SIM_VEHICLE_H
+#define SIM_VEHICLE_H
+
+#include <cstdint>
+
+// Symulator pojazdu na hoście: definicje funkcji z main/hardware.h, wobec których logika
+// firmware'u (motor_control, sensor_control, ml_step, ml_frame) kompiluje się bez zmian.
+// Napęd różnicowy z PWM pinów mostka H, HC-SR04 jako promienie w stożku czujnika i czas echa,
+// kamera jako render widoku z pozycji pojazdu (ściany w pionowe pasy, podłoga w szachownicę),
+// kodowany do JPEG koderem z src/esp32cam. Czas płynie według zegara wirtualnego
+// (stubs/host_clock.h): model liczy się w krokach stałej długości do bieżącej chwili zegara,
+// a pomiar echa przesuwa zegar o czas impulsu, jak blokujący pulseIn().
+//
+// Mapa: cm, kąt przeciwnie do ruchu wskazówek zegara, 0 - wzdłuż osi x.
+
+struct SimVehicleStats
+{
+  float x;              // cm
+  float y;
+  float heading;        // stopnie
+  float leftSpeed;      // prędkość koła (cm/s)
+  float rightSpeed;
+  float distance;       // prawdziwa odległość przed czujnikiem (cm, -1 - poza zasięgiem)
+  float odometer;       // przejechana droga (cm)
+  uint32_t collisions;  // zderzenia z przeszkodami
+  uint32_t echoes;      // pomiary HC-SR04
+  uint32_t dropouts;    // pomiary bez echa
+  uint32_t frames;      // wyrenderowane klatki
+  float renderTimeAvg;  // render i kodowanie JPEG (ms czasu rzeczywistego)
+};
+
+// Pojazd w pozycji startowej; `seed` - szum i pomiary bez echa czujnika (powtarzalne przebiegi)
+void setupSimVehicle(uint32_t seed, int cameraWidth, int cameraHeight);
+
+// Ustawienie pojazdu na mapie (cm, stopnie); false, gdy pozycja jest w przeszkodzie
+bool resetSimVehicle(float x, float y, float heading);
+
+SimVehicleStats getSimVehicleStats();
+
+// Potok przechwytywania na hoście (capture_pipeline.h w zakresie używanym przez ml_step
+// i ml_frame): przy subskrybentach klatka z getCameraFrame() co `interval` ms do puli
+// CAPTURE_BUFFER_COUNT buforów, jak task przechwytywania na płytce.
+void setupSimCapture(unsigned long interval);
+
+// Upływ czasu wirtualnego do `time` (µs) z przechwytywaniem klatek po drodze; zastępuje
+// delay() pętli głównej. Klatki zaległe po blokującym wywołaniu są przechwytywane od razu.
+void simAdvanceTo(int64_t time);
+
+#endif // SIM_VEHICLE_H
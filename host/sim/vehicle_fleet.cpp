@@ -0,0 +1,289 @@
+// Wiele niezależnych pojazdów na symulatorze naraz: każda instancja to osobno załadowana kopia
+// modułu vehicle_sim_instance (sim_instance.h) z własnym stanem firmware'u i zegarem wirtualnym.
+// Kroki instancji są dzielone na zadania po --chunk kroków dla puli wątków z podkradaniem
+// (work_stealing_pool.h); zadanie po wykonaniu dodaje kolejne tej samej instancji, więc jedna
+// instancja nie działa w dwóch wątkach naraz, a wolne wątki przejmują instancje od zajętych.
+//
+// Ten sam zestaw instancji jest uruchamiany dla każdej liczby wątków z --threads (domyślnie
+// 1, 2, 4, ... do liczby rdzeni). Wynik (JSON na stdout): kroki na sekundę, przyspieszenie
+// i sprawność względem jednego wątku, liczba podkradzionych zadań. Z --check kod wyjścia 1,
+// gdy instancja ma kroki bez obserwacji albo jej wynik zależy od liczby wątków (instancje
+// współdzielą stan).
+//
+// Użycie:
+//   vehicle_fleet [--instances 32] [--steps 200] [--chunk 10] [--threads 1,2,4,8]
+//                 [--camera 320x240] [--module vehicle_sim_instance.so] [--check]
+
+#include "sim_instance.h"
+#include "work_stealing_pool.h"
+
+#include <dlfcn.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct Options
+{
+  int instances = 0; // 0 - dwie na rdzeń
+  uint32_t steps = 200;
+  uint32_t chunk = 10;
+  std::vector<int> threads;
+  SimEpisodeConfig episode;
+  const char *module = VEHICLE_SIM_MODULE;
+  bool check = false;
+};
+
+struct Instance
+{
+  void *handle;
+  const SimInstanceApi *api;
+  uint32_t remaining;
+};
+
+struct Round
+{
+  int threads;
+  double wall;
+  uint32_t steps;
+  uint64_t steals;
+};
+
+static bool parseThreads(const char *value, std::vector<int> &threads)
+{
+  threads.clear();
+  for (const char *p = value; *p;)
+  {
+    char *end;
+    long count = strtol(p, &end, 10);
+    if (end == p || count < 1)
+      return false;
+    threads.push_back(count);
+    p = *end == ',' ? end + 1 : end;
+  }
+  return !threads.empty();
+}
+
+static bool parseOptions(int argc, char **argv, Options &options)
+{
+  for (int i = 1; i < argc; i++)
+  {
+    const char *arg = argv[i];
+    const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+    if (strcmp(arg, "--check") == 0)
+      options.check = true;
+    else if (!value)
+      return false;
+    else
+    {
+      if (strcmp(arg, "--instances") == 0)
+        options.instances = atoi(value);
+      else if (strcmp(arg, "--steps") == 0)
+        options.steps = atol(value);
+      else if (strcmp(arg, "--chunk") == 0)
+        options.chunk = atol(value);
+      else if (strcmp(arg, "--module") == 0)
+        options.module = value;
+      else if (strcmp(arg, "--threads") == 0)
+      {
+        if (!parseThreads(value, options.threads))
+          return false;
+      }
+      else if (strcmp(arg, "--camera") == 0)
+      {
+        SimEpisodeConfig &episode = options.episode;
+        if (sscanf(value, "%dx%d", &episode.cameraWidth, &episode.cameraHeight) != 2)
+          return false;
+      }
+      else
+        return false;
+      i++;
+    }
+  }
+  return options.instances >= 0 && options.steps > 0 && options.chunk > 0;
+}
+
+// dlopen() tej samej ścieżki zwraca już załadowany moduł, więc każda instancja dostaje
+// własną kopię pliku; po załadowaniu kopia jest usuwana, odwzorowanie w pamięci zostaje
+static bool loadInstances(const char *module, int count, std::vector<Instance> &instances)
+{
+  char dir[] = "/tmp/vehicle_fleet_XXXXXX";
+  if (!mkdtemp(dir))
+    return false;
+
+  FILE *src = fopen(module, "rb");
+  if (!src)
+  {
+    fprintf(stderr, "Nie można otworzyć %s\n", module);
+    rmdir(dir);
+    return false;
+  }
+  std::vector<char> image;
+  char buf[65536];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), src)) > 0)
+    image.insert(image.end(), buf, buf + n);
+  fclose(src);
+
+  bool ok = true;
+  for (int i = 0; i < count && ok; i++)
+  {
+    std::string path = std::string(dir) + "/instance_" + std::to_string(i) + ".so";
+    FILE *dst = fopen(path.c_str(), "wb");
+    ok = dst && fwrite(image.data(), 1, image.size(), dst) == image.size();
+    if (dst)
+      fclose(dst);
+
+    void *handle = ok ? dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL) : NULL;
+    unlink(path.c_str());
+    SimInstanceEntry entry = handle ? (SimInstanceEntry)dlsym(handle, SIM_INSTANCE_ENTRY) : NULL;
+    if (!entry)
+    {
+      fprintf(stderr, "Nie można załadować instancji %d: %s\n", i, handle ? dlerror() : "kopia modułu");
+      ok = false;
+      break;
+    }
+    instances.push_back({handle, entry(), 0});
+  }
+  rmdir(dir);
+  return ok;
+}
+
+static Round runRound(std::vector<Instance> &instances, const Options &options, int threads)
+{
+  for (size_t i = 0; i < instances.size(); i++)
+  {
+    SimEpisodeConfig episode = options.episode;
+    episode.seed = options.episode.seed + i;
+    instances[i].api->start(episode);
+    instances[i].remaining = options.steps;
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  WorkStealingPool pool(threads);
+  std::function<void(Instance *)> schedule = [&](Instance *instance)
+  {
+    pool.submit([&, instance]
+                {
+                  uint32_t count = std::min(options.chunk, instance->remaining);
+                  uint32_t done = instance->api->runSteps(count);
+                  instance->remaining = done == count ? instance->remaining - done : 0;
+                  if (instance->remaining > 0)
+                    schedule(instance); });
+  };
+  for (Instance &instance : instances)
+    schedule(&instance);
+  pool.wait();
+  double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  uint32_t steps = 0;
+  for (Instance &instance : instances)
+    steps += instance.api->result().steps;
+  return {threads, wall, steps, pool.steals()};
+}
+
+// wynik instancji niezależny od przydziału do wątków - porównanie bit w bit
+static bool sameResult(const SimEpisodeResult &a, const SimEpisodeResult &b)
+{
+  return a.steps == b.steps && a.failures == b.failures && a.simTime == b.simTime &&
+         a.vehicle.x == b.vehicle.x && a.vehicle.y == b.vehicle.y && a.vehicle.heading == b.vehicle.heading &&
+         a.vehicle.odometer == b.vehicle.odometer && a.vehicle.collisions == b.vehicle.collisions &&
+         a.lumaMean == b.lumaMean;
+}
+
+int main(int argc, char **argv)
+{
+  Options options;
+  if (!parseOptions(argc, argv, options))
+  {
+    fprintf(stderr, "Użycie: %s [--instances N] [--steps N] [--chunk N] [--threads 1,2,4] [--camera WxH] "
+                    "[--module PATH] [--check]\n",
+            argv[0]);
+    return 2;
+  }
+
+  int cores = std::max(1u, std::thread::hardware_concurrency());
+  if (options.instances == 0)
+    options.instances = 2 * cores;
+  if (options.threads.empty())
+  {
+    for (int threads = 1; threads < cores; threads *= 2)
+      options.threads.push_back(threads);
+    options.threads.push_back(cores);
+  }
+
+  std::vector<Instance> instances;
+  if (!loadInstances(options.module, options.instances, instances))
+    return 2;
+
+  std::vector<Round> rounds;
+  std::vector<SimEpisodeResult> reference;
+  uint32_t failures = 0;
+  int mismatches = 0;
+  for (int threads : options.threads)
+  {
+    rounds.push_back(runRound(instances, options, threads));
+    for (size_t i = 0; i < instances.size(); i++)
+    {
+      SimEpisodeResult result = instances[i].api->result();
+      if (reference.size() < instances.size())
+      {
+        reference.push_back(result);
+        failures += result.failures;
+      }
+      else if (!sameResult(result, reference[i]))
+        mismatches++;
+    }
+  }
+
+  double simSeconds = 0;
+  for (const SimEpisodeResult &result : reference)
+    simSeconds += result.simTime / 1e6;
+
+  printf("{\n"
+         "  \"instances\": %d,\n"
+         "  \"steps_per_instance\": %u,\n"
+         "  \"cores\": %d,\n"
+         "  \"sim_seconds\": %.1f,\n"
+         "  \"failures\": %u,\n"
+         "  \"mismatches\": %d,\n"
+         "  \"rounds\": [\n",
+         options.instances, options.steps, cores, simSeconds, failures, mismatches);
+  double base = rounds[0].wall * rounds[0].threads;
+  for (size_t i = 0; i < rounds.size(); i++)
+  {
+    const Round &round = rounds[i];
+    double speedup = round.wall > 0 ? base / round.wall : 0;
+    printf("    {\"threads\": %d, \"wall_seconds\": %.3f, \"steps_per_second\": %.0f, "
+           "\"realtime_factor\": %.1f, \"speedup\": %.2f, \"efficiency\": %.2f, \"steals\": %llu}%s\n",
+           round.threads, round.wall, round.wall > 0 ? round.steps / round.wall : 0,
+           round.wall > 0 ? simSeconds / round.wall : 0, speedup, speedup / round.threads,
+           (unsigned long long)round.steals, i + 1 < rounds.size() ? "," : "");
+  }
+  printf("  ]\n}\n");
+
+  for (Instance &instance : instances)
+    dlclose(instance.handle);
+
+  if (!options.check)
+    return 0;
+
+  bool failed = false;
+  if (failures > 0)
+  {
+    fprintf(stderr, "BŁĄD: %u kroków bez obserwacji\n", failures);
+    failed = true;
+  }
+  if (mismatches > 0)
+  {
+    fprintf(stderr, "BŁĄD: %d wyników instancji zależy od liczby wątków\n", mismatches);
+    failed = true;
+  }
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,135 @@
+// Benchmark zamkniętej pętli sterowania na symulatorze (sim_episode.h): kroki lockstep przez
+// ml_step, motor_control i sensor_control z main/, na zegarze wirtualnym. Wynik (JSON na stdout):
+// czas symulowany i rzeczywisty, ich stosunek (ile razy szybciej niż w czasie rzeczywistym),
+// kroki na sekundę, koszt renderu i stan pojazdu. Z --check kod wyjścia 1, gdy pętla nie
+// działa: kroki bez obserwacji, pojazd stoi, zderzenia albo symulacja wolniejsza niż rzeczywistość.
+//
+// Użycie:
+//   vehicle_sim_bench [--steps 1000] [--period 100] [--camera 320x240] [--tensor 64x48]
+//                     [--frame-interval 40] [--seed 1] [--check]
+
+#include "sim_episode.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+struct Options
+{
+  uint32_t steps = 1000;
+  SimEpisodeConfig episode;
+  bool check = false;
+};
+
+static bool parseSize(const char *value, int &width, int &height)
+{
+  return sscanf(value, "%dx%d", &width, &height) == 2 && width > 0 && height > 0;
+}
+
+static bool parseOptions(int argc, char **argv, Options &options)
+{
+  for (int i = 1; i < argc; i++)
+  {
+    const char *arg = argv[i];
+    const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+    if (strcmp(arg, "--check") == 0)
+      options.check = true;
+    else if (!value)
+      return false;
+    else
+    {
+      SimEpisodeConfig &episode = options.episode;
+      if (strcmp(arg, "--steps") == 0)
+        options.steps = atol(value);
+      else if (strcmp(arg, "--period") == 0)
+        episode.period = atol(value);
+      else if (strcmp(arg, "--frame-interval") == 0)
+        episode.frameInterval = atol(value);
+      else if (strcmp(arg, "--seed") == 0)
+        episode.seed = atol(value);
+      else if (strcmp(arg, "--camera") == 0)
+      {
+        if (!parseSize(value, episode.cameraWidth, episode.cameraHeight))
+          return false;
+      }
+      else if (strcmp(arg, "--tensor") == 0)
+      {
+        if (!parseSize(value, episode.tensorWidth, episode.tensorHeight))
+          return false;
+      }
+      else
+        return false;
+      i++;
+    }
+  }
+  return options.steps > 0 && options.episode.frameInterval > 0;
+}
+
+int main(int argc, char **argv)
+{
+  Options options;
+  if (!parseOptions(argc, argv, options))
+  {
+    fprintf(stderr, "Użycie: %s [--steps N] [--period MS] [--camera WxH] [--tensor WxH] "
+                    "[--frame-interval MS] [--seed N] [--check]\n",
+            argv[0]);
+    return 2;
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  startSimEpisode(options.episode);
+  runSimSteps(options.steps);
+  double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  SimEpisodeResult result = getSimEpisodeResult();
+
+  double sim = result.simTime / 1e6;
+  double realtimeFactor = wall > 0 ? sim / wall : 0;
+  const SimVehicleStats &vehicle = result.vehicle;
+  printf("{\n"
+         "  \"steps\": %u,\n"
+         "  \"sim_seconds\": %.2f,\n"
+         "  \"wall_seconds\": %.3f,\n"
+         "  \"realtime_factor\": %.1f,\n"
+         "  \"steps_per_second\": %.0f,\n"
+         "  \"failures\": %u,\n"
+         "  \"stale_frames\": %u,\n"
+         "  \"obstacle_stops\": %u,\n"
+         "  \"luma_mean\": %.1f,\n"
+         "  \"frames\": %u,\n"
+         "  \"render_ms_avg\": %.3f,\n"
+         "  \"echoes\": %u,\n"
+         "  \"odometer_cm\": %.1f,\n"
+         "  \"collisions\": %u,\n"
+         "  \"pose\": [%.1f, %.1f, %.1f]\n"
+         "}\n",
+         result.steps, sim, wall, realtimeFactor, wall > 0 ? result.steps / wall : 0, result.failures,
+         result.staleFrames, result.obstacleStops, result.lumaMean, vehicle.frames, vehicle.renderTimeAvg,
+         vehicle.echoes, vehicle.odometer, vehicle.collisions, vehicle.x, vehicle.y, vehicle.heading);
+
+  if (!options.check)
+    return 0;
+
+  bool failed = false;
+  if (result.steps != options.steps || result.failures > 0)
+  {
+    fprintf(stderr, "BŁĄD: %u z %u kroków, %u bez obserwacji\n", result.steps, options.steps, result.failures);
+    failed = true;
+  }
+  if (vehicle.odometer < 100)
+  {
+    fprintf(stderr, "BŁĄD: pojazd przejechał tylko %.1f cm\n", vehicle.odometer);
+    failed = true;
+  }
+  if (vehicle.collisions > 0)
+  {
+    fprintf(stderr, "BŁĄD: %u zderzeń mimo czujnika\n", vehicle.collisions);
+    failed = true;
+  }
+  if (realtimeFactor < 1)
+  {
+    fprintf(stderr, "BŁĄD: symulacja wolniejsza niż czas rzeczywisty (%.2fx)\n", realtimeFactor);
+    failed = true;
+  }
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,102 @@
+#include "work_stealing_pool.h"
+
+#include <chrono>
+
+// pula i indeks bieżącego wątku; spoza puli - brak
+static thread_local const WorkStealingPool *currentPool = nullptr;
+static thread_local int currentIndex = -1;
+
+WorkStealingPool::WorkStealingPool(int threads)
+{
+  threads = threads < 1 ? 1 : threads;
+  for (int i = 0; i < threads; i++)
+    m_workers.emplace_back(new Worker);
+  for (int i = 0; i < threads; i++)
+    m_threads.emplace_back(&WorkStealingPool::run, this, i);
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+  wait();
+  {
+    std::lock_guard<std::mutex> lock(m_wakeMutex);
+    m_stop = true;
+  }
+  m_wake.notify_all();
+  for (std::thread &thread : m_threads)
+    thread.join();
+}
+
+void WorkStealingPool::submit(std::function<void()> task)
+{
+  int index = currentPool == this ? currentIndex : (int)(m_nextWorker++ % m_workers.size());
+  m_pending++;
+  {
+    std::lock_guard<std::mutex> lock(m_workers[index]->mutex);
+    m_workers[index]->tasks.push_back(std::move(task));
+  }
+  // pod blokadą, żeby powiadomienie nie minęło wątku, który właśnie zasypia
+  std::lock_guard<std::mutex> lock(m_wakeMutex);
+  m_wake.notify_one();
+}
+
+void WorkStealingPool::wait()
+{
+  std::unique_lock<std::mutex> lock(m_wakeMutex);
+  m_done.wait(lock, [this]
+              { return m_pending == 0; });
+}
+
+bool WorkStealingPool::pop(int index, std::function<void()> &task)
+{
+  Worker &worker = *m_workers[index];
+  std::lock_guard<std::mutex> lock(worker.mutex);
+  if (worker.tasks.empty())
+    return false;
+  task = std::move(worker.tasks.back());
+  worker.tasks.pop_back();
+  return true;
+}
+
+bool WorkStealingPool::steal(int index, std::function<void()> &task)
+{
+  int count = (int)m_workers.size();
+  for (int i = 1; i < count; i++)
+  {
+    Worker &victim = *m_workers[(index + i) % count];
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    if (victim.tasks.empty())
+      continue;
+    task = std::move(victim.tasks.front());
+    victim.tasks.pop_front();
+    m_steals++;
+    return true;
+  }
+  return false;
+}
+
+void WorkStealingPool::run(int index)
+{
+  currentPool = this;
+  currentIndex = index;
+
+  std::function<void()> task;
+  while (!m_stop)
+  {
+    if (pop(index, task) || steal(index, task))
+    {
+      task();
+      task = nullptr;
+      if (--m_pending == 0)
+      {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+        m_done.notify_all();
+      }
+      continue;
+    }
+
+    // krótki limit: zadanie dodane do cudzej kolejki nie budzi wszystkich wątków
+    std::unique_lock<std::mutex> lock(m_wakeMutex);
+    m_wake.wait_for(lock, std::chrono::milliseconds(1));
+  }
+}
@@ -0,0 +1,57 @@
+#ifndef WORK_STEALING_POOL_H
+#define WORK_STEALING_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Pula wątków z podkradaniem zadań: każdy wątek ma własną kolejkę, z której bierze od końca
+// (ostatnio dodane, z ciepłą pamięcią podręczną), a bezczynny wątek zabiera zadania z początku
+// kolejek pozostałych. Zadanie może dodawać kolejne - trafiają do kolejki wątku, który je wykonuje.
+class WorkStealingPool
+{
+public:
+  explicit WorkStealingPool(int threads);
+  ~WorkStealingPool();
+
+  WorkStealingPool(const WorkStealingPool &) = delete;
+  WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+  // z wątku puli - do jego kolejki, spoza puli - do kolejek po kolei
+  void submit(std::function<void()> task);
+
+  // czeka na wykonanie wszystkich zadań, także dodanych w trakcie
+  void wait();
+
+  int threads() const { return (int)m_workers.size(); }
+  uint64_t steals() const { return m_steals; }
+
+private:
+  struct Worker
+  {
+    std::mutex mutex;
+    std::deque<std::function<void()>> tasks;
+  };
+
+  bool pop(int index, std::function<void()> &task);
+  bool steal(int index, std::function<void()> &task);
+  void run(int index);
+
+  std::vector<std::unique_ptr<Worker>> m_workers;
+  std::vector<std::thread> m_threads;
+  std::atomic<int64_t> m_pending{0};
+  std::atomic<uint64_t> m_steals{0};
+  std::atomic<unsigned> m_nextWorker{0};
+  std::atomic<bool> m_stop{false};
+  std::mutex m_wakeMutex;
+  std::condition_variable m_wake;
+  std::condition_variable m_done;
+};
+
+#endif // WORK_STEALING_POOL_H
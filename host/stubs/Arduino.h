@@ -0,0 +1,92 @@
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+// Zamiennik Arduino.h dla kompilacji logiki firmware'u na hoście - tylko to, czego używają
+// kompilowane tam źródła z main/. Czas płynie według zegara wirtualnego (host_clock.h).
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+using std::max;
+using std::min;
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+#define PI 3.1415926535897932384626433832795
+
+#define LOW 0x0
+#define HIGH 0x1
+#define INPUT 0x01
+#define OUTPUT 0x03
+
+// piny GPIO nie mają odpowiednika na hoście; sprzęt pojazdu obsługuje hardware.h
+inline void pinMode(uint8_t, uint8_t) {}
+inline void digitalWrite(uint8_t, uint8_t) {}
+
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+
+// sekcje krytyczne FreeRTOS: instancja firmware'u na hoście działa w jednym wątku naraz
+typedef int portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED 0
+#define portENTER_CRITICAL(mux) ((void)(mux))
+#define portEXIT_CRITICAL(mux) ((void)(mux))
+
+// String z Arduino w zakresie używanym przez logikę (sklejanie komunikatów, toInt())
+class String
+{
+public:
+  String(const char *s = "") : m_s(s ? s : "") {}
+  String(const std::string &s) : m_s(s) {}
+  String(char c) : m_s(1, c) {}
+  String(int v) : m_s(std::to_string(v)) {}
+  String(unsigned int v) : m_s(std::to_string(v)) {}
+  String(long v) : m_s(std::to_string(v)) {}
+  String(unsigned long v) : m_s(std::to_string(v)) {}
+  String(double v, unsigned int decimals = 2)
+  {
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%.*f", (int)decimals, v);
+    m_s = buf;
+  }
+
+  const char *c_str() const { return m_s.c_str(); }
+  unsigned int length() const { return m_s.size(); }
+  long toInt() const { return atol(m_s.c_str()); }
+  float toFloat() const { return atof(m_s.c_str()); }
+
+  String &operator+=(const String &other)
+  {
+    m_s += other.m_s;
+    return *this;
+  }
+  friend String operator+(const String &a, const String &b) { return String(a.m_s + b.m_s); }
+  bool operator==(const String &other) const { return m_s == other.m_s; }
+
+private:
+  std::string m_s;
+};
+
+// Serial: komunikaty firmware'u są odrzucane, żeby nie spowalniały symulacji
+class HardwareSerial
+{
+public:
+  void begin(unsigned long) {}
+  template <typename T>
+  void print(const T &) {}
+  template <typename T>
+  void println(const T &) {}
+  void println() {}
+};
+
+extern HardwareSerial Serial;
+
+#endif // HOST_ARDUINO_H
@@ -0,0 +1,19 @@
+#ifndef HOST_WEBSERVER_H
+#define HOST_WEBSERVER_H
+
+#include <Arduino.h>
+
+// Warstwa HTTP działa tylko na płytce. Handlery z kompilowanych na hoście plików muszą się
+// skompilować, ale program hosta ich nie wywołuje - serwer nie ma żądań.
+class WebServer
+{
+public:
+  bool hasArg(const String &) const { return false; }
+  String arg(const String &) const { return String(); }
+  void send(int, const char *, const String &) {}
+  void sendHeader(const String &, const String &) {}
+  void setContentLength(size_t) {}
+  void sendContent(const char *, size_t) {}
+};
+
+#endif // HOST_WEBSERVER_H
@@ -0,0 +1,10 @@
+#ifndef HOST_WEBSOCKETSSERVER_H
+#define HOST_WEBSOCKETSSERVER_H
+
+// Tylko limit klientów, według którego moduły wymiarują tablice stanu per klient;
+// samego serwera WebSocket na hoście nie ma
+#define WEBSOCKETS_SERVER_CLIENT_MAX 5
+
+class WebSocketsServer;
+
+#endif // HOST_WEBSOCKETSSERVER_H
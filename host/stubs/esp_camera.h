@@ -0,0 +1,59 @@
+#ifndef HOST_ESP_CAMERA_H
+#define HOST_ESP_CAMERA_H
+
+// Zamiennik esp_camera.h: bufor klatki i sensor z tymi ustawieniami, które zmienia logika
+// kompilowana na hoście. esp_camera_sensor_get() dostarcza program, który tę logikę uruchamia;
+// klatki pochodzą z getCameraFrame() (hardware.h), nie ze sterownika.
+
+#include <cstddef>
+#include <cstdint>
+#include <sys/time.h>
+
+typedef enum
+{
+  PIXFORMAT_RGB565,
+  PIXFORMAT_YUV422,
+  PIXFORMAT_YUV420,
+  PIXFORMAT_GRAYSCALE,
+  PIXFORMAT_JPEG,
+  PIXFORMAT_RGB888,
+} pixformat_t;
+
+typedef enum
+{
+  FRAMESIZE_96X96,
+  FRAMESIZE_QQVGA,
+  FRAMESIZE_QCIF,
+  FRAMESIZE_HQVGA,
+  FRAMESIZE_240X240,
+  FRAMESIZE_QVGA,
+  FRAMESIZE_CIF,
+  FRAMESIZE_HVGA,
+  FRAMESIZE_VGA,
+  FRAMESIZE_SVGA,
+  FRAMESIZE_XGA,
+  FRAMESIZE_HD,
+  FRAMESIZE_SXGA,
+  FRAMESIZE_UXGA,
+  FRAMESIZE_INVALID
+} framesize_t;
+
+typedef struct
+{
+  uint8_t *buf;
+  size_t len;
+  size_t width;
+  size_t height;
+  pixformat_t format;
+  struct timeval timestamp;
+} camera_fb_t;
+
+typedef struct _sensor sensor_t;
+struct _sensor
+{
+  int (*set_quality)(sensor_t *sensor, int quality);
+};
+
+sensor_t *esp_camera_sensor_get();
+
+#endif // HOST_ESP_CAMERA_H
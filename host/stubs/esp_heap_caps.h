@@ -0,0 +1,22 @@
+#ifndef HOST_ESP_HEAP_CAPS_H
+#define HOST_ESP_HEAP_CAPS_H
+
+#include <cstddef>
+#include <cstdlib>
+
+// Host nie ma PSRAM - każda pamięć pochodzi ze sterty
+#define MALLOC_CAP_8BIT (1 << 2)
+#define MALLOC_CAP_SPIRAM (1 << 10)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+
+inline void *heap_caps_malloc(size_t size, uint32_t)
+{
+  return malloc(size);
+}
+
+inline void heap_caps_free(void *ptr)
+{
+  free(ptr);
+}
+
+#endif // HOST_ESP_HEAP_CAPS_H
@@ -0,0 +1,60 @@
+#include "esp_jpg_decode.h"
+
+#include "src/esp32cam/jpeg_dc.hpp"
+
+#include <Arduino.h>
+#include <vector>
+
+static esp32cam::detail::JpegDcDecoder decoder;
+
+esp_err_t esp_jpg_decode(size_t len, jpg_scale_t scale, jpg_reader_cb reader, jpg_writer_cb writer, void *arg)
+{
+  std::vector<uint8_t> jpeg(len);
+  if (reader(arg, 0, jpeg.data(), len) != len)
+    return ESP_FAIL;
+
+  int width, height;
+  if (!decoder.readSize(jpeg.data(), len, width, height))
+    return ESP_FAIL;
+  std::vector<uint8_t> blocks((size_t)width * height);
+  if (!decoder.decode(jpeg.data(), len, blocks.data(), blocks.size(), width, height))
+    return ESP_FAIL;
+
+  // wymiary obrazu po skalowaniu liczone jak w dekoderze z ROM: z pełnego obrazu, nie z bloków
+  int factor = 1 << scale;
+  int blockSize = 8 / factor;
+  int pixelWidth = 0, pixelHeight = 0;
+  for (size_t i = 2; i + 9 < len; i += 2 + ((jpeg[i + 2] << 8) | jpeg[i + 3]))
+  {
+    if (jpeg[i] != 0xFF)
+      break;
+    if (jpeg[i + 1] == 0xC0 || jpeg[i + 1] == 0xC1)
+    {
+      pixelHeight = (jpeg[i + 5] << 8) | jpeg[i + 6];
+      pixelWidth = (jpeg[i + 7] << 8) | jpeg[i + 8];
+      break;
+    }
+  }
+  int outWidth = pixelWidth / factor;
+  int outHeight = pixelHeight / factor;
+  if (outWidth <= 0 || outHeight <= 0 || !writer(arg, 0, 0, outWidth, outHeight, NULL))
+    return ESP_FAIL;
+
+  // pas wysokości jednego bloku na wiersz bloków, każdy blok jako jednolity kwadrat
+  std::vector<uint8_t> rgb((size_t)outWidth * blockSize * 3);
+  for (int by = 0; by < height && by * blockSize < outHeight; by++)
+  {
+    int rows = min(blockSize, outHeight - by * blockSize);
+    for (int y = 0; y < rows; y++)
+    {
+      uint8_t *p = &rgb[(size_t)y * outWidth * 3];
+      for (int x = 0; x < outWidth; x++, p += 3)
+        p[0] = p[1] = p[2] = blocks[by * width + min(x / blockSize, width - 1)];
+    }
+    if (!writer(arg, 0, by * blockSize, outWidth, rows, rgb.data()))
+      return ESP_FAIL;
+  }
+
+  writer(arg, outWidth, outHeight, outWidth, outHeight, NULL);
+  return ESP_OK;
+}
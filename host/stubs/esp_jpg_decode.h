@@ -0,0 +1,29 @@
+#ifndef HOST_ESP_JPG_DECODE_H
+#define HOST_ESP_JPG_DECODE_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Zamiennik dekodera JPEG z ROM ESP32 (esp_jpg_decode.h z esp32-camera) o tym samym
+// interfejsie. Na hoście obraz odtwarzany jest ze średnich bloków 8x8 (JpegDcDecoder
+// z src/esp32cam) - wystarcza to do tensorów luminancji, które i tak uśredniają większe obszary.
+
+typedef int esp_err_t;
+#define ESP_OK 0
+#define ESP_FAIL -1
+
+typedef enum
+{
+  JPG_SCALE_NONE,
+  JPG_SCALE_2X,
+  JPG_SCALE_4X,
+  JPG_SCALE_8X,
+  JPG_SCALE_MAX = JPG_SCALE_8X
+} jpg_scale_t;
+
+typedef size_t (*jpg_reader_cb)(void *arg, size_t index, uint8_t *buf, size_t len);
+typedef bool (*jpg_writer_cb)(void *arg, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint8_t *data);
+
+esp_err_t esp_jpg_decode(size_t len, jpg_scale_t scale, jpg_reader_cb reader, jpg_writer_cb writer, void *arg);
+
+#endif // HOST_ESP_JPG_DECODE_H
@@ -0,0 +1,49 @@
+#include "host_clock.h"
+
+#include <Arduino.h>
+#include <esp_timer.h>
+
+HardwareSerial Serial;
+
+static int64_t clockTime = 0;
+
+int64_t hostClockNow()
+{
+  return clockTime;
+}
+
+void hostClockSet(int64_t time)
+{
+  clockTime = time;
+}
+
+void hostClockAdvance(int64_t us)
+{
+  if (us > 0)
+    clockTime += us;
+}
+
+unsigned long millis()
+{
+  return clockTime / 1000;
+}
+
+unsigned long micros()
+{
+  return clockTime;
+}
+
+void delay(uint32_t ms)
+{
+  hostClockAdvance((int64_t)ms * 1000);
+}
+
+void delayMicroseconds(uint32_t us)
+{
+  hostClockAdvance(us);
+}
+
+int64_t esp_timer_get_time()
+{
+  return clockTime;
+}
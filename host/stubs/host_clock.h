@@ -0,0 +1,15 @@
+#ifndef HOST_CLOCK_H
+#define HOST_CLOCK_H
+
+#include <cstdint>
+
+// Zegar wirtualny stubów: millis(), micros() i esp_timer_get_time() go odczytują, a delay()
+// i delayMicroseconds() przesuwają zamiast czekać. Program hosta decyduje, kiedy czas płynie,
+// więc pętla sterowania liczy się szybciej niż w czasie rzeczywistym i powtarzalnie.
+// Każda kopia logiki firmware'u (biblioteka ładowana osobno) ma własny zegar.
+
+int64_t hostClockNow(); // µs od startu
+void hostClockSet(int64_t time);
+void hostClockAdvance(int64_t us);
+
+#endif // HOST_CLOCK_H
@@ -2,68 +2,76 @@
 #include "motor_control.h"
 #include "sensor_control.h"
 #include "config.h"
+#include "vehicle_state.h"
+#include "request_stats.h"
+#include "benchmark.h"
+#include "request_body.h"
+#include "traffic_control.h"
+#include "camera_settings.h"
+#include "capture_pipeline.h"
+#include "rate_control.h"
+#include "resolution_ladder.h"
+#include "ml_frame.h"
+#include "ml_step.h"
+#include "src/esp32cam/camera.hpp"
 #include <ArduinoJson.h>
 #include <WiFi.h>
+#include <esp_timer.h>
 
-unsigned long lastSensorTime = 0;
 const unsigned long SENSOR_INTERVAL = 100;
 
-enum ControlMode
+// subskrypcja tensora luminancji przez WebSocket (po jednej na klienta)
+struct MlSubscription
 {
-    WEB_CONTROL,
-    ML_CONTROL
+    bool active;
+    int width;
+    int height;
+    unsigned long interval;
+    unsigned long lastSent;
+    uint32_t lastSeq;
 };
+MlSubscription mlSubscriptions[WEBSOCKETS_SERVER_CLIENT_MAX];
 
-enum SpeedMode
-{
-    SPEED_LOW,
-    SPEED_NORMAL,
-    SPEED_HIGH
-};
-
-ControlMode currentMode = WEB_CONTROL;     // domyślnie kontrola to manualna przez serwer web
-SpeedMode currentSpeedMode = SPEED_NORMAL; // domyślny tryb prędkości to normalny
-WebSocketsServer *wsServer = nullptr;
-WebServer *api_server_ptr = nullptr;
+// klienci, którzy sterowali pojazdem (komenda ruchu, zmiana trybu, krok) - tylko oni dostają ping
+bool steeringClients[WEBSOCKETS_SERVER_CLIENT_MAX];
 
 void addCORSHeaders()
 {
-    if (!api_server_ptr)
+    if (!vehicle.server)
         return;
-    api_server_ptr->sendHeader("Access-Control-Allow-Origin", "*");
-    api_server_ptr->sendHeader("Access-Control-Allow-Methods", "GET, POST, PUT, DELETE, OPTIONS");
-    api_server_ptr->sendHeader("Access-Control-Allow-Headers", "Content-Type, Authorization");
-    api_server_ptr->sendHeader("Access-Control-Max-Age", "86400"); // 24 hours cache
+    vehicle.server->sendHeader("Access-Control-Allow-Origin", "*");
+    vehicle.server->sendHeader("Access-Control-Allow-Methods", "GET, POST, PUT, PATCH, DELETE, OPTIONS");
+    vehicle.server->sendHeader("Access-Control-Allow-Headers", "Content-Type, Authorization");
+    vehicle.server->sendHeader("Access-Control-Max-Age", "86400"); // 24 hours cache
 }
 
-void handleOptions()
+// odbiór ciała żądania POST fragmentami, prosto z gniazda do bufora o stałym rozmiarze
+void handleAPIBodyChunk()
 {
-    if (!api_server_ptr)
+    if (!vehicle.server)
         return;
 
-    addCORSHeaders();
-    api_server_ptr->send(200, "text/plain", "OK");
+    if (!receiveRequestBodyChunk(*vehicle.server))
+    {
+        // szybka odpowiedź 413 - reszta ciała jest tylko odczytywana i pomijana
+        addCORSHeaders();
+        vehicle.server->send(413, "application/json", "{\"success\":false,\"message\":\"Payload too large\"}");
+    }
 }
 
-// Funkcja do ustawienia aktualnej prędkości silników na podstawie wybranego trybu
-int getCurrentSpeedValue()
+void handleOptions()
 {
-    switch (currentSpeedMode)
-    {
-    case SPEED_LOW:
-        return SPEED_MODE_LOW;
-    case SPEED_HIGH:
-        return SPEED_MODE_HIGH;
-    case SPEED_NORMAL:
-    default:
-        return SPEED_MODE_NORMAL;
-    }
+    if (!vehicle.server)
+        return;
+
+    addCORSHeaders();
+    vehicle.server->send(200, "text/plain", "OK");
 }
 
 // Konwersja trybu prędkości na string
 String getSpeedModeString()
 {
-    switch (currentSpeedMode)
+    switch (vehicle.speedMode)
     {
     case SPEED_LOW:
         return "low";
@@ -80,22 +88,78 @@ bool setSpeedModeFromString(const String &mode)
 {
     if (mode == "low")
     {
-        currentSpeedMode = SPEED_LOW;
+        vehicle.speedMode = SPEED_LOW;
         return true;
     }
     else if (mode == "normal")
     {
-        currentSpeedMode = SPEED_NORMAL;
+        vehicle.speedMode = SPEED_NORMAL;
         return true;
     }
     else if (mode == "high")
     {
-        currentSpeedMode = SPEED_HIGH;
+        vehicle.speedMode = SPEED_HIGH;
         return true;
     }
     return false;
 }
 
+// {"command":"step","source":"ml","action":"forward","period":100,"width":64,"height":48,"id":1}
+// albo z "left" i "right" zamiast "action"; odpowiedź binarna w formacie ml_step.h
+void handleStepCommand(uint8_t num, const JsonDocument &doc)
+{
+    // kroki zmieniają prędkość silników - tylko w trybie ML, jak pozostałe komendy ruchu
+    if (vehicle.mode != ML_CONTROL || doc["source"] != "ml")
+    {
+        vehicle.webSocket->sendTXT(num, "{\"status\":\"error\",\"message\":\"Step requires ML mode and source 'ml'\"}");
+        return;
+    }
+
+    MlStepRequest request;
+    request.left = 0;
+    request.right = 0;
+    String action = doc["action"] | "hold";
+    if (doc.containsKey("left") && doc.containsKey("right"))
+    {
+        request.action = ML_STEP_SPEED;
+        request.left = doc["left"];
+        request.right = doc["right"];
+    }
+    else if (action == "forward")
+        request.action = ML_STEP_FORWARD;
+    else if (action == "backward")
+        request.action = ML_STEP_BACKWARD;
+    else if (action == "left")
+        request.action = ML_STEP_LEFT;
+    else if (action == "right")
+        request.action = ML_STEP_RIGHT;
+    else if (action == "stop")
+        request.action = ML_STEP_STOP;
+    else if (action == "hold")
+        request.action = ML_STEP_HOLD;
+    else
+    {
+        vehicle.webSocket->sendTXT(num, "{\"status\":\"error\",\"message\":\"Invalid step action\"}");
+        return;
+    }
+
+    request.period = doc["period"] | (unsigned long)ML_STEP_DEFAULT_PERIOD;
+    request.width = doc["width"] | ML_TENSOR_WIDTH;
+    request.height = doc["height"] | ML_TENSOR_HEIGHT;
+    request.id = doc["id"] | 0U;
+    if (!isValidMlTensorSize(request.width, request.height))
+    {
+        vehicle.webSocket->sendTXT(num, "{\"status\":\"error\",\"message\":\"Invalid tensor size\"}");
+        return;
+    }
+
+    uint32_t step;
+    if (!beginMlStep(num, request, step))
+    {
+        vehicle.webSocket->sendTXT(num, "{\"status\":\"error\",\"message\":\"Step in progress\"}");
+    }
+}
+
 void webSocketEvent(uint8_t num, WStype_t type, uint8_t *payload, size_t length)
 {
     switch (type)
@@ -105,41 +169,108 @@ void webSocketEvent(uint8_t num, WStype_t type, uint8_t *payload, size_t length)
         break;
     case WStype_DISCONNECTED:
         Serial.printf("WebSocket %u rozlaczony\n", num);
+        if (num < WEBSOCKETS_SERVER_CLIENT_MAX)
+        {
+            mlSubscriptions[num].active = false;
+            steeringClients[num] = false;
+        }
+        endMlSteps(num);
         break;
     case WStype_CONNECTED:
     {
-        IPAddress ip = wsServer->remoteIP(num);
+        IPAddress ip = vehicle.webSocket->remoteIP(num);
         Serial.printf("WebSocket %u polaczony z %s\n", num, ip.toString().c_str());
 
-        wsServer->sendTXT(num, "{\"status\":\"connected\",\"mode\":" + String(currentMode == WEB_CONTROL ? "\"web\"" : "\"ml\"") + "}");
+        vehicle.webSocket->sendTXT(num, "{\"status\":\"connected\",\"mode\":" + String(vehicle.mode == WEB_CONTROL ? "\"web\"" : "\"ml\"") + "}");
     }
     break;
     case WStype_TEXT:
     {
+        RequestTimer timer(REQUEST_WS_COMMAND);
         Serial.printf("WebSocket %u odebrano: %s\n", num, payload);
 
-        DynamicJsonDocument doc(1024);
+        DynamicJsonDocument doc(WS_COMMAND_DOC_SIZE);
         DeserializationError error = deserializeJson(doc, payload);
         if (error)
         {
             Serial.printf("Bład deserializacji JSON: %s\n", error.c_str());
-            wsServer->sendTXT(num, "{\"success\": false, \"message\": \"Bład deserializacji JSON\"}");
+            vehicle.webSocket->sendTXT(num, "{\"success\": false, \"message\": \"Bład deserializacji JSON\"}");
             return;
         }
 
+        // odpowiedź na ping - pomiar RTT sterowania niezależnie od trybu
+        if (doc["command"] == "pong")
+        {
+            // znacznik odsyła klient - odrzucany, jeśli nie pochodzi z przeszłości pojazdu
+            // albo RTT jest nierealne (różnica bez znaku przekręciłaby się do ~4e9 ms)
+            unsigned long now = millis();
+            if (doc["t"].is<unsigned long>())
+            {
+                unsigned long sent = doc["t"];
+                if (sent <= now && now - sent <= CONTROL_RTT_MAX)
+                    reportControlRtt(now - sent);
+            }
+            return;
+        }
+
+        // subskrypcja tensora luminancji dla modelu - binarne ramki w formacie /ml/frame
+        if (doc["command"] == "ml_subscribe" && num < WEBSOCKETS_SERVER_CLIENT_MAX)
+        {
+            int width = doc["width"] | ML_TENSOR_WIDTH;
+            int height = doc["height"] | ML_TENSOR_HEIGHT;
+            if (!isValidMlTensorSize(width, height))
+            {
+                vehicle.webSocket->sendTXT(num, "{\"status\":\"error\",\"message\":\"Invalid tensor size\"}");
+                return;
+            }
+            MlSubscription &sub = mlSubscriptions[num];
+            sub.active = true;
+            sub.width = width;
+            sub.height = height;
+            sub.interval = max<unsigned long>(doc["interval"] | 100UL, ML_PUSH_MIN_INTERVAL);
+            sub.lastSent = 0;
+            sub.lastSeq = 0;
+            vehicle.webSocket->sendTXT(num, "{\"status\":\"ml_subscribed\",\"width\":" + String(width) + ",\"height\":" + String(height) + "}");
+            return;
+        }
+        if (doc["command"] == "ml_unsubscribe" && num < WEBSOCKETS_SERVER_CLIENT_MAX)
+        {
+            mlSubscriptions[num].active = false;
+            vehicle.webSocket->sendTXT(num, "{\"status\":\"ml_unsubscribed\"}");
+            return;
+        }
+
+        // krok lockstep: akcja, okres sterowania i jedna binarna odpowiedź z obserwacją
+        if (doc["command"] == "step")
+        {
+            if (num < WEBSOCKETS_SERVER_CLIENT_MAX)
+                steeringClients[num] = true;
+            handleStepCommand(num, doc);
+            return;
+        }
+        if (doc["command"] == "step_end")
+        {
+            endMlSteps(num);
+            vehicle.webSocket->sendTXT(num, "{\"status\":\"step_ended\"}");
+            return;
+        }
+
+        if ((doc.containsKey("mode") || doc.containsKey("command")) && num < WEBSOCKETS_SERVER_CLIENT_MAX)
+            steeringClients[num] = true;
+
         if (doc.containsKey("mode"))
         {
             String mode = doc["mode"];
             if (mode == "web")
             {
-                currentMode = WEB_CONTROL;
-                wsServer->broadcastTXT("{\"status\":\"mode_changed\",\"mode\":\"web\"}");
+                vehicle.mode = WEB_CONTROL;
+                vehicle.webSocket->broadcastTXT("{\"status\":\"mode_changed\",\"mode\":\"web\"}");
                 Serial.println("Kontrola zmieniona na kontrole WEB");
             }
             else if (mode == "ml")
             {
-                currentMode = ML_CONTROL;
-                wsServer->broadcastTXT("{\"status\":\"mode_changed\",\"mode\":\"ml\"}");
+                vehicle.mode = ML_CONTROL;
+                vehicle.webSocket->broadcastTXT("{\"status\":\"mode_changed\",\"mode\":\"ml\"}");
                 Serial.println("Kontrola zmieniona na kontrole ML");
             }
         }
@@ -150,98 +281,198 @@ void webSocketEvent(uint8_t num, WStype_t type, uint8_t *payload, size_t length)
             String command = doc["command"];
 
             // jesli w ML trybie to tylko kontrole ML zezwalamy
-            if (currentMode == ML_CONTROL && doc.containsKey("source") && doc["source"] == "ml")
+            if (vehicle.mode == ML_CONTROL && doc.containsKey("source") && doc["source"] == "ml")
             {
                 processCommand(command, doc);
             }
             // vice versa
-            else if (currentMode == WEB_CONTROL && doc.containsKey("source") && doc["source"] == "web")
+            else if (vehicle.mode == WEB_CONTROL && doc.containsKey("source") && doc["source"] == "web")
             {
                 processCommand(command, doc);
             }
             else
             {
                 Serial.println("Komenda odrzucona z powodu zlego argumentu 'source'");
-                wsServer->sendTXT(num, "{\"status\":\"error\",\"message\":\"Komenda odrzucona z powodu zlego argumentu 'source'\"}");
+                vehicle.webSocket->sendTXT(num, "{\"status\":\"error\",\"message\":\"Komenda odrzucona z powodu zlego argumentu 'source'\"}");
             }
         }
     }
     break;
+    case WStype_BIN:
+    {
+        RequestTimer timer(REQUEST_WS_COMMAND);
+        handleBinaryCommand(num, payload, length);
+    }
+    break;
+    default:
+        break;
     }
 }
 
-// Process movement commands from either source
-void processCommand(const String &command, const JsonDocument &doc)
+static MotorCommand binaryMotorCommand(uint8_t opcode)
 {
-    if (command == "forward")
+    switch (opcode)
     {
-        moveForward();
-        if (wsServer)
-            wsServer->broadcastTXT("{\"status\":\"moving\",\"direction\":\"forward\"}");
+    case WS_BIN_FORWARD:
+        return MOTOR_COMMAND_FORWARD;
+    case WS_BIN_BACKWARD:
+        return MOTOR_COMMAND_BACKWARD;
+    case WS_BIN_LEFT:
+        return MOTOR_COMMAND_LEFT;
+    case WS_BIN_RIGHT:
+        return MOTOR_COMMAND_RIGHT;
+    case WS_BIN_STOP:
+        return MOTOR_COMMAND_STOP;
+    case WS_BIN_SPEED:
+        return MOTOR_COMMAND_SPEED;
+    default:
+        return MOTOR_COMMAND_UNKNOWN;
     }
-    else if (command == "backward")
+}
+
+// Binarna komenda sterowania (format w api_handler.h) - bez parsowania JSON, z potwierdzeniem do nadawcy
+void handleBinaryCommand(uint8_t num, const uint8_t *payload, size_t length)
+{
+    uint8_t opcode = length > 0 ? payload[0] : 0xFF;
+    uint16_t id = length >= 4 ? payload[2] | (payload[3] << 8) : 0;
+    uint8_t status = WS_BIN_OK;
+
+    MotorCommand command = binaryMotorCommand(opcode);
+    if (length != WS_BIN_COMMAND_SIZE || (opcode != WS_BIN_ECHO && command == MOTOR_COMMAND_UNKNOWN))
     {
-        moveBackward();
-        if (wsServer)
-            wsServer->broadcastTXT("{\"status\":\"moving\",\"direction\":\"backward\"}");
+        status = WS_BIN_INVALID;
     }
-    else if (command == "left")
+    else if (opcode != WS_BIN_ECHO)
     {
-        turnLeft();
-        if (wsServer)
-            wsServer->broadcastTXT("{\"status\":\"moving\",\"direction\":\"left\"}");
+        if (num < WEBSOCKETS_SERVER_CLIENT_MAX)
+            steeringClients[num] = true;
+
+        // te same zasady co dla pola "source" komend JSON
+        uint8_t source = payload[1];
+        if ((vehicle.mode == ML_CONTROL && source == WS_BIN_SOURCE_ML) ||
+            (vehicle.mode == WEB_CONTROL && source == WS_BIN_SOURCE_WEB))
+        {
+            int16_t leftSpeed = (int16_t)(payload[4] | (payload[5] << 8));
+            int16_t rightSpeed = (int16_t)(payload[6] | (payload[7] << 8));
+            executeMotorCommand(command, leftSpeed, rightSpeed);
+        }
+        else
+        {
+            status = WS_BIN_REJECTED;
+        }
     }
-    else if (command == "right")
+
+    uint8_t ack[WS_BIN_ACK_SIZE] = {'C', 'A', 'C', 'K', opcode, status, (uint8_t)(id & 0xFF), (uint8_t)(id >> 8)};
+    vehicle.webSocket->sendBIN(num, ack, sizeof(ack));
+}
+
+// Komenda ruchu z nazwy - porównania napisów oddzielone od wykonania
+MotorCommand parseMotorCommand(const String &command)
+{
+    if (command == "forward")
+        return MOTOR_COMMAND_FORWARD;
+    if (command == "backward")
+        return MOTOR_COMMAND_BACKWARD;
+    if (command == "left")
+        return MOTOR_COMMAND_LEFT;
+    if (command == "right")
+        return MOTOR_COMMAND_RIGHT;
+    if (command == "stop")
+        return MOTOR_COMMAND_STOP;
+    if (command == "speed")
+        return MOTOR_COMMAND_SPEED;
+    if (command == "set_speed_mode")
+        return MOTOR_COMMAND_SET_SPEED_MODE;
+    return MOTOR_COMMAND_UNKNOWN;
+}
+
+// Wykonanie komendy ruchu (JSON albo binarnej) i rozgłoszenie stanu; prędkości tylko dla MOTOR_COMMAND_SPEED
+void executeMotorCommand(MotorCommand command, int leftSpeed, int rightSpeed)
+{
+    switch (command)
     {
+    case MOTOR_COMMAND_FORWARD:
+        moveForward();
+        if (vehicle.webSocket)
+            vehicle.webSocket->broadcastTXT("{\"status\":\"moving\",\"direction\":\"forward\"}");
+        break;
+    case MOTOR_COMMAND_BACKWARD:
+        moveBackward();
+        if (vehicle.webSocket)
+            vehicle.webSocket->broadcastTXT("{\"status\":\"moving\",\"direction\":\"backward\"}");
+        break;
+    case MOTOR_COMMAND_LEFT:
+        turnLeft();
+        if (vehicle.webSocket)
+            vehicle.webSocket->broadcastTXT("{\"status\":\"moving\",\"direction\":\"left\"}");
+        break;
+    case MOTOR_COMMAND_RIGHT:
         turnRight();
-        if (wsServer)
-            wsServer->broadcastTXT("{\"status\":\"moving\",\"direction\":\"right\"}");
-    }
-    else if (command == "stop")
-    {
+        if (vehicle.webSocket)
+            vehicle.webSocket->broadcastTXT("{\"status\":\"moving\",\"direction\":\"right\"}");
+        break;
+    case MOTOR_COMMAND_STOP:
         stopMotors();
-        if (wsServer)
-            wsServer->broadcastTXT("{\"status\":\"stopped\"}");
-    }
-    else if (command == "speed" && doc.containsKey("left") && doc.containsKey("right"))
-    {
-        int leftSpeed = doc["left"];
-        int rightSpeed = doc["right"];
+        if (vehicle.webSocket)
+            vehicle.webSocket->broadcastTXT("{\"status\":\"stopped\"}");
+        break;
+    case MOTOR_COMMAND_SPEED:
         setMotorSpeed(leftSpeed, rightSpeed);
-        if (wsServer)
+        if (vehicle.webSocket)
         {
             String response = "{\"status\":\"speed_set\",\"left\":" + String(leftSpeed) + ",\"right\":" + String(rightSpeed) + "}";
 
-            wsServer->broadcastTXT(response);
+            vehicle.webSocket->broadcastTXT(response);
         }
+        break;
+    default:
+        break;
     }
-    else if (command == "set_speed_mode" && doc.containsKey("mode"))
+}
+
+// Process movement commands from either source
+void processCommand(const String &command, const JsonDocument &doc)
+{
+    MotorCommand motorCommand = parseMotorCommand(command);
+    switch (motorCommand)
     {
-        String mode = doc["mode"];
-        bool success = setSpeedModeFromString(mode);
-        if (success)
+    case MOTOR_COMMAND_SPEED:
+        if (doc.containsKey("left") && doc.containsKey("right"))
+            executeMotorCommand(motorCommand, doc["left"], doc["right"]);
+        break;
+    case MOTOR_COMMAND_SET_SPEED_MODE:
+        if (doc.containsKey("mode"))
         {
-            if (wsServer)
+            String mode = doc["mode"];
+            bool success = setSpeedModeFromString(mode);
+            if (success)
             {
-                String response = "{\"status\":\"speed_mode_changed\",\"mode\":\"" + mode + "\"}";
-                wsServer->broadcastTXT(response);
+                if (vehicle.webSocket)
+                {
+                    String response = "{\"status\":\"speed_mode_changed\",\"mode\":\"" + mode + "\"}";
+                    vehicle.webSocket->broadcastTXT(response);
+                }
+                Serial.println("Speed mode changed to: " + mode);
             }
-            Serial.println("Speed mode changed to: " + mode);
-        }
-        else
-        {
-            if (wsServer)
+            else
             {
-                wsServer->broadcastTXT("{\"status\":\"error\",\"message\":\"Invalid speed mode. Use 'low', 'normal', or 'high'\"}");
+                if (vehicle.webSocket)
+                {
+                    vehicle.webSocket->broadcastTXT("{\"status\":\"error\",\"message\":\"Invalid speed mode. Use 'low', 'normal', or 'high'\"}");
+                }
+                Serial.println("Invalid speed mode: " + mode);
             }
-            Serial.println("Invalid speed mode: " + mode);
         }
+        break;
+    default:
+        executeMotorCommand(motorCommand, 0, 0);
+        break;
     }
 }
 
 void setupAPIEndpoints(WebServer &server)
 {
-    api_server_ptr = &server;
+    vehicle.server = &server;
 
     // requesty OPTIONS dla wszystkich endpointów
     server.on("/api", HTTP_OPTIONS, handleOptions);
@@ -251,15 +482,23 @@ void setupAPIEndpoints(WebServer &server)
     server.on("/api/docs", HTTP_OPTIONS, handleOptions);
     server.on("/api/mode", HTTP_OPTIONS, handleOptions);
     server.on("/api/sensor", HTTP_OPTIONS, handleOptions);
+    server.on("/api/traffic", HTTP_OPTIONS, handleOptions);
+    server.on("/api/load", HTTP_OPTIONS, handleOptions);
+    server.on("/api/bench", HTTP_OPTIONS, handleOptions);
+    server.on("/api/camera/settings", HTTP_OPTIONS, handleOptions);
 
     // routy API
-    server.on("/api", HTTP_GET, handleAPIRoot);
-    server.on("/api/info", HTTP_GET, handleAPIInfo);
-    server.on("/api/motor", HTTP_ANY, handleAPIMotorControl);
-    server.on("/api/status", HTTP_GET, handleAPIStatus);
-    server.on("/api/docs", HTTP_GET, handleAPIDocs);
-    server.on("/api/mode", HTTP_ANY, handleAPIMode);
-    server.on("/api/sensor", HTTP_ANY, handleAPISensor); // endpoint do obsługi sensora HC-SR04
+    server.on("/api", HTTP_GET, timedHandler<REQUEST_API, handleAPIRoot>);
+    server.on("/api/info", HTTP_GET, timedHandler<REQUEST_API, handleAPIInfo>);
+    server.on("/api/motor", HTTP_ANY, timedHandler<REQUEST_API, handleAPIMotorControl>, handleAPIBodyChunk);
+    server.on("/api/status", HTTP_GET, timedHandler<REQUEST_API, handleAPIStatus>);
+    server.on("/api/docs", HTTP_GET, timedHandler<REQUEST_API, handleAPIDocs>);
+    server.on("/api/mode", HTTP_ANY, timedHandler<REQUEST_API, handleAPIMode>, handleAPIBodyChunk);
+    server.on("/api/sensor", HTTP_ANY, timedHandler<REQUEST_API, handleAPISensor>); // endpoint do obsługi sensora HC-SR04
+    server.on("/api/traffic", HTTP_GET, timedHandler<REQUEST_API, handleAPITraffic>); // statystyki i regulator priorytetów ruchu
+    server.on("/api/load", HTTP_GET, timedHandler<REQUEST_API, handleAPILoad>); // czas obsługi żądań według klas
+    server.on("/api/bench", HTTP_GET, timedHandler<REQUEST_API, handleAPIBench>); // mikrobenchmarki gorących ścieżek
+    server.on("/api/camera/settings", HTTP_ANY, timedHandler<REQUEST_API, handleAPICameraSettings>, handleAPIBodyChunk); // strojenie sensora kamery
 
     Serial.println("API endpoints configured");
 }
@@ -267,7 +506,7 @@ void setupAPIEndpoints(WebServer &server)
 // root API do wyświetlania dostępnych endpointów
 void handleAPIRoot()
 {
-    if (!api_server_ptr)
+    if (!vehicle.server)
         return;
 
     addCORSHeaders();
@@ -285,21 +524,26 @@ void handleAPIRoot()
     endpoints.add("/api/docs");
     endpoints.add("/api/mode");
     endpoints.add("/api/sensor");
+    endpoints.add("/api/traffic");
+    endpoints.add("/api/load");
+    endpoints.add("/api/bench");
+    endpoints.add("/api/camera/settings");
     // endpointy kamery i strumienia
     endpoints.add("/capture");
     endpoints.add("/stream");
     endpoints.add("/camera/resolution");
+    endpoints.add("/ml/frame");
 
     String response;
     serializeJson(doc, response);
 
-    api_server_ptr->send(200, "application/json", response);
+    vehicle.server->send(200, "application/json", response);
 }
 
 // Informacje o urządzeniu
 void handleAPIInfo()
 {
-    if (!api_server_ptr)
+    if (!vehicle.server)
         return;
 
     addCORSHeaders();
@@ -318,19 +562,24 @@ void handleAPIInfo()
     String response;
     serializeJson(doc, response);
 
-    api_server_ptr->send(200, "application/json", response);
+    vehicle.server->send(200, "application/json", response);
 }
 
 // Motor control via API
 void handleAPIMotorControl()
 {
-    if (!api_server_ptr)
+    if (!vehicle.server)
+        return;
+
+    // odpowiedź 413 została już wysłana podczas odbioru ciała
+    if (consumeRequestBodyRejection())
         return;
 
+    configureControlSocket(vehicle.server->client());
     addCORSHeaders();
 
     // Dla metody GET zwracamy aktualny stan silników i tryb prędkości
-    if (api_server_ptr->method() == HTTP_GET)
+    if (vehicle.server->method() == HTTP_GET)
     {
         StaticJsonDocument<256> doc;
         doc["success"] = true;
@@ -342,12 +591,23 @@ void handleAPIMotorControl()
         String response;
         serializeJson(doc, response);
 
-        api_server_ptr->send(200, "application/json", response);
+        vehicle.server->send(200, "application/json", response);
         return;
     }
 
+    // filtr - z ciała zostają tylko klucze potrzebne do obsługi komendy
+    StaticJsonDocument<64> filter;
+    filter["command"] = true;
+    filter["left"] = true;
+    filter["right"] = true;
+    filter["mode"] = true;
+
+    StaticJsonDocument<256> doc;
+    DeserializationError error;
+    RequestBodyStatus bodyStatus = parseRequestBody(doc, filter, error);
+
     // sprawdzenie, czy dane są przesyłane
-    if (api_server_ptr->hasArg("plain") == false)
+    if (bodyStatus == BODY_MISSING)
     {
         StaticJsonDocument<256> errorDoc;
         errorDoc["success"] = false;
@@ -356,16 +616,18 @@ void handleAPIMotorControl()
         String errorResponse;
         serializeJson(errorDoc, errorResponse);
 
-        api_server_ptr->send(400, "application/json", errorResponse);
+        vehicle.server->send(400, "application/json", errorResponse);
         return;
     }
 
-    String data = api_server_ptr->arg("plain");
-    StaticJsonDocument<256> doc;
-    DeserializationError error = deserializeJson(doc, data);
+    if (bodyStatus == BODY_TOO_LARGE)
+    {
+        vehicle.server->send(413, "application/json", "{\"success\":false,\"message\":\"Payload too large\"}");
+        return;
+    }
 
     // error check
-    if (error)
+    if (bodyStatus == BODY_INVALID_JSON)
     {
         StaticJsonDocument<256> errorDoc;
         errorDoc["success"] = false;
@@ -374,7 +636,7 @@ void handleAPIMotorControl()
         String errorResponse;
         serializeJson(errorDoc, errorResponse);
 
-        api_server_ptr->send(400, "application/json", errorResponse);
+        vehicle.server->send(400, "application/json", errorResponse);
         return;
     }
 
@@ -423,7 +685,7 @@ void handleAPIMotorControl()
                 String response;
                 serializeJson(responseDoc, response);
 
-                api_server_ptr->send(200, "application/json", response);
+                vehicle.server->send(200, "application/json", response);
                 return;
             }
             else
@@ -435,7 +697,7 @@ void handleAPIMotorControl()
                 String errorResponse;
                 serializeJson(errorDoc, errorResponse);
 
-                api_server_ptr->send(400, "application/json", errorResponse);
+                vehicle.server->send(400, "application/json", errorResponse);
                 return;
             }
         }
@@ -448,7 +710,7 @@ void handleAPIMotorControl()
             String errorResponse;
             serializeJson(errorDoc, errorResponse);
 
-            api_server_ptr->send(400, "application/json", errorResponse);
+            vehicle.server->send(400, "application/json", errorResponse);
             return;
         }
 
@@ -460,7 +722,7 @@ void handleAPIMotorControl()
         String response;
         serializeJson(responseDoc, response);
 
-        api_server_ptr->send(200, "application/json", response);
+        vehicle.server->send(200, "application/json", response);
     }
     else
     {
@@ -472,18 +734,23 @@ void handleAPIMotorControl()
         String errorResponse;
         serializeJson(errorDoc, errorResponse);
 
-        api_server_ptr->send(400, "application/json", errorResponse);
+        vehicle.server->send(400, "application/json", errorResponse);
     }
 }
 
 // status pojazdu
 void handleAPIStatus()
 {
-    if (!api_server_ptr)
+    if (!vehicle.server)
         return;
 
     addCORSHeaders();
+    vehicle.server->send(200, "application/json", buildStatusResponse());
+}
 
+// odpowiedź /api/status, także dla benchmarku serializacji
+String buildStatusResponse()
+{
     StaticJsonDocument<512> doc;
     doc["success"] = true;
     doc["message"] = "Vehicle Status";
@@ -496,12 +763,12 @@ void handleAPIStatus()
     data["uptime"] = millis() / 1000;                // Uptime in seconds
     data["signal_strength"] = WiFi.RSSI();           // Siła sygnału WiFi
     data["motor_speed_mode"] = getSpeedModeString(); // Aktualny tryb prędkości
-    data["control_mode"] = (currentMode == WEB_CONTROL) ? "web" : "ml";
+    data["control_mode"] = (vehicle.mode == WEB_CONTROL) ? "web" : "ml";
 
     String response;
     serializeJson(doc, response);
 
-    api_server_ptr->send(200, "application/json", response);
+    return response;
 }
 
 // funkcje pomocnicze
@@ -520,7 +787,7 @@ String createJSONResponse(bool success, const String &message, JsonObject &data)
 // Add this new handler function
 void handleAPIDocs()
 {
-    if (!api_server_ptr)
+    if (!vehicle.server)
         return;
 
     addCORSHeaders();
@@ -631,6 +898,9 @@ void handleAPIDocs()
     html += "<pre>{<br>  \"source\": \"web|ml\",  // Source of the command<br>  \"command\": \"forward|backward|left|right|stop|speed\",<br>  \"left\": 100,   // Only for 'speed' command<br>  \"right\": 100   // Only for 'speed' command<br>}</pre>";
     html += "<h3>Mode Selection:</h3>";
     html += "<pre>{<br>  \"mode\": \"web|ml\"  // Switch between web control and ML control<br>}</pre>";
+    html += "<h3>Lockstep Step (ML mode):</h3>";
+    html += "<p>Applies the action, waits the control period and answers with one binary STEP message: step number, wheel speeds, distance and a luma tensor of a frame captured after the period.</p>";
+    html += "<pre>{<br>  \"source\": \"ml\",<br>  \"command\": \"step\",<br>  \"action\": \"forward|backward|left|right|stop|hold\",  // or \"left\"/\"right\" speeds<br>  \"period\": 100,  // ms<br>  \"width\": 64,<br>  \"height\": 48,<br>  \"id\": 1  // echoed in the response<br>}</pre>";
     html += "<h3>Sensor Data:</h3>";
     html += "<p>The WebSocket also broadcasts sensor data periodically:</p>";
     html += "<pre>{<br>  \"status\": \"success\",<br>  \"distance\": 42.5,<br>  \"timestamp\": 1234567890<br>}</pre>";
@@ -818,7 +1088,7 @@ void handleAPIDocs()
     html += "<h2><span class='method get'>GET</span> /camera/resolution</h2>";
     html += "<p>Changes the camera resolution.</p>";
     html += "<h3>Parameters:</h3>";
-    html += "<code>?res=RESOLUTION</code> where RESOLUTION is one of: UXGA, SXGA, XGA, SVGA, VGA, CIF, QVGA</p>";
+    html += "<code>?res=RESOLUTION</code> where RESOLUTION is one of: UXGA, SXGA, XGA, SVGA, VGA, CIF, QVGA, auto (stream picks QQVGA-VGA from link capacity)</p>";
     html += "<h3>Response Example:</h3>";
     html += "<pre>Resolution set to SVGA</pre>";
     html += "<div class='curl-form'>";
@@ -831,6 +1101,7 @@ void handleAPIDocs()
     html += "<option value='VGA'>VGA (640x480)</option>";
     html += "<option value='CIF'>CIF (400x296)</option>";
     html += "<option value='QVGA'>QVGA (320x240)</option>";
+    html += "<option value='auto'>Auto (stream)</option>";
     html += "</select>";
     html += "<button onclick='setResolution()'>Set Resolution</button>";
     html += "<div class='result'><pre id='resolution-output'></pre></div>";
@@ -841,17 +1112,22 @@ void handleAPIDocs()
 
     html += "</body></html>";
 
-    api_server_ptr->send(200, "text/html", html);
+    vehicle.server->send(200, "text/html", html);
 }
 
 void handleAPIMode()
 {
-    if (!api_server_ptr)
+    if (!vehicle.server)
+        return;
+
+    // odpowiedź 413 została już wysłana podczas odbioru ciała
+    if (consumeRequestBodyRejection())
         return;
 
+    configureControlSocket(vehicle.server->client());
     addCORSHeaders();
 
-    if (api_server_ptr->method() == HTTP_GET)
+    if (vehicle.server->method() == HTTP_GET)
     {
         // Return current mode
         StaticJsonDocument<256> doc;
@@ -859,29 +1135,38 @@ void handleAPIMode()
         doc["message"] = "Current control mode";
 
         JsonObject data = doc.createNestedObject("data");
-        data["mode"] = currentMode == WEB_CONTROL ? "web" : "ml";
+        data["mode"] = vehicle.mode == WEB_CONTROL ? "web" : "ml";
 
         String response;
         serializeJson(doc, response);
 
-        api_server_ptr->send(200, "application/json", response);
+        vehicle.server->send(200, "application/json", response);
     }
-    else if (api_server_ptr->method() == HTTP_POST)
+    else if (vehicle.server->method() == HTTP_POST)
     {
         // Change mode
-        if (api_server_ptr->hasArg("plain") == false)
+        StaticJsonDocument<32> filter;
+        filter["mode"] = true;
+
+        StaticJsonDocument<64> doc;
+        DeserializationError error;
+        RequestBodyStatus bodyStatus = parseRequestBody(doc, filter, error);
+
+        if (bodyStatus == BODY_MISSING)
         {
-            api_server_ptr->send(400, "application/json", "{\"success\":false,\"message\":\"No data provided\"}");
+            vehicle.server->send(400, "application/json", "{\"success\":false,\"message\":\"No data provided\"}");
             return;
         }
 
-        String data = api_server_ptr->arg("plain");
-        StaticJsonDocument<256> doc;
-        DeserializationError error = deserializeJson(doc, data);
+        if (bodyStatus == BODY_TOO_LARGE)
+        {
+            vehicle.server->send(413, "application/json", "{\"success\":false,\"message\":\"Payload too large\"}");
+            return;
+        }
 
-        if (error)
+        if (bodyStatus == BODY_INVALID_JSON)
         {
-            api_server_ptr->send(400, "application/json", "{\"success\":false,\"message\":\"Invalid JSON\"}");
+            vehicle.server->send(400, "application/json", "{\"success\":false,\"message\":\"Invalid JSON\"}");
             return;
         }
 
@@ -890,39 +1175,39 @@ void handleAPIMode()
             String mode = doc["mode"];
             if (mode == "web")
             {
-                currentMode = WEB_CONTROL;
-                if (wsServer)
-                    wsServer->broadcastTXT("{\"status\":\"mode_changed\",\"mode\":\"web\"}");
-                api_server_ptr->send(200, "application/json", "{\"success\":true,\"message\":\"Mode changed to web control\"}");
+                vehicle.mode = WEB_CONTROL;
+                if (vehicle.webSocket)
+                    vehicle.webSocket->broadcastTXT("{\"status\":\"mode_changed\",\"mode\":\"web\"}");
+                vehicle.server->send(200, "application/json", "{\"success\":true,\"message\":\"Mode changed to web control\"}");
             }
             else if (mode == "ml")
             {
-                currentMode = ML_CONTROL;
-                if (wsServer)
-                    wsServer->broadcastTXT("{\"status\":\"mode_changed\",\"mode\":\"ml\"}");
-                api_server_ptr->send(200, "application/json", "{\"success\":true,\"message\":\"Mode changed to ML control\"}");
+                vehicle.mode = ML_CONTROL;
+                if (vehicle.webSocket)
+                    vehicle.webSocket->broadcastTXT("{\"status\":\"mode_changed\",\"mode\":\"ml\"}");
+                vehicle.server->send(200, "application/json", "{\"success\":true,\"message\":\"Mode changed to ML control\"}");
             }
             else
             {
-                api_server_ptr->send(400, "application/json", "{\"success\":false,\"message\":\"Invalid mode. Use 'web' or 'ml'\"}");
+                vehicle.server->send(400, "application/json", "{\"success\":false,\"message\":\"Invalid mode. Use 'web' or 'ml'\"}");
             }
         }
         else
         {
-            api_server_ptr->send(400, "application/json", "{\"success\":false,\"message\":\"No mode specified\"}");
+            vehicle.server->send(400, "application/json", "{\"success\":false,\"message\":\"No mode specified\"}");
         }
     }
 }
 
 void handleAPISensor()
 {
-    if (!api_server_ptr)
+    if (!vehicle.server)
         return;
 
     addCORSHeaders();
 
     // Dla metody GET zwracamy aktualny stan sensora
-    if (api_server_ptr->method() == HTTP_GET)
+    if (vehicle.server->method() == HTTP_GET)
     {
         StaticJsonDocument<256> doc;
 
@@ -937,11 +1222,11 @@ void handleAPISensor()
 
         if (data["success"])
         {
-            api_server_ptr->send(200, "application/json", response);
+            vehicle.server->send(200, "application/json", response);
         }
         else
         {
-            api_server_ptr->send(500, "application/json", response);
+            vehicle.server->send(500, "application/json", response);
         }
         return;
     }
@@ -949,12 +1234,13 @@ void handleAPISensor()
 
 void handleSensorWebSocket()
 {
-    if (!wsServer || wsServer->connectedClients() == 0)
+    if (!vehicle.webSocket || vehicle.webSocket->connectedClients() == 0)
         return;
 
     unsigned long currentTime = millis();
-    if (currentTime - lastSensorTime >= SENSOR_INTERVAL)
+    if (currentTime - vehicle.lastSensorTime >= SENSOR_INTERVAL)
     {
+        RequestTimer timer(REQUEST_WS_PUSH);
         float distance = getDistance();
 
         DynamicJsonDocument doc(128);
@@ -969,17 +1255,391 @@ void handleSensorWebSocket()
         String message;
         serializeJson(doc, message);
 
-        wsServer->broadcastTXT(message);
-        lastSensorTime = currentTime;
+        vehicle.webSocket->broadcastTXT(message);
+        vehicle.lastSensorTime = currentTime;
+    }
+}
+
+// okresowy ping do klientów sterujących - klient odsyła {"command":"pong","t":...};
+// subskrybenci tensora i telemetrii nie sterują, więc ich opóźnienie nie dławi kamery
+void handleControlPing()
+{
+    if (!vehicle.webSocket || vehicle.webSocket->connectedClients() == 0)
+        return;
+
+    unsigned long currentTime = millis();
+    if (currentTime - vehicle.lastPingTime >= CONTROL_PING_INTERVAL)
+    {
+        RequestTimer timer(REQUEST_WS_PUSH);
+        String message = "{\"event\":\"ping\",\"t\":" + String(currentTime) + "}";
+        for (uint8_t num = 0; num < WEBSOCKETS_SERVER_CLIENT_MAX; num++)
+        {
+            if (steeringClients[num])
+                vehicle.webSocket->sendTXT(num, message);
+        }
+        vehicle.lastPingTime = currentTime;
+    }
+}
+
+// wysyłka tensora luminancji do subskrybentów WebSocket, tylko nowe klatki
+void handleMlFramePush()
+{
+    if (!vehicle.webSocket)
+        return;
+
+    unsigned long currentTime = millis();
+    for (uint8_t num = 0; num < WEBSOCKETS_SERVER_CLIENT_MAX; num++)
+    {
+        MlSubscription &sub = mlSubscriptions[num];
+        if (!sub.active || currentTime - sub.lastSent < sub.interval)
+            continue;
+
+        unsigned long start = micros();
+        const uint8_t *buf;
+        uint32_t seq;
+        size_t len = buildMlFrame(sub.width, sub.height, sub.lastSeq, buf, seq);
+        if (len == 0)
+            continue;
+
+        vehicle.webSocket->sendBIN(num, buf, len);
+        sub.lastSent = currentTime;
+        sub.lastSeq = seq;
+        recordRequest(REQUEST_WS_PUSH, micros() - start);
+    }
+}
+
+// odpowiedzi kroków lockstep po okresie sterowania
+void handleMlStepPush()
+{
+    if (!vehicle.webSocket)
+        return;
+
+    for (uint8_t num = 0; num < WEBSOCKETS_SERVER_CLIENT_MAX; num++)
+    {
+        unsigned long start = micros();
+        const uint8_t *buf;
+        size_t len;
+        MlStepPoll result = pollMlStep(num, buf, len);
+        if (result == ML_STEP_READY)
+            vehicle.webSocket->sendBIN(num, buf, len);
+        else if (result == ML_STEP_FAILED)
+            vehicle.webSocket->sendTXT(num, "{\"status\":\"error\",\"message\":\"Step observation failed\"}");
+        // oczekujące kroki bez wysyłki nie są liczone
+        if (result == ML_STEP_READY || result == ML_STEP_FAILED)
+            recordRequest(REQUEST_WS_PUSH, micros() - start);
+    }
+    expireMlSteps();
+}
+
+// statystyki priorytetów ruchu; ?governor=on|off włącza/wyłącza dławienie kamery
+void handleAPITraffic()
+{
+    if (!vehicle.server)
+        return;
+
+    addCORSHeaders();
+
+    if (vehicle.server->hasArg("governor"))
+    {
+        String governor = vehicle.server->arg("governor");
+        if (governor != "on" && governor != "off")
+        {
+            vehicle.server->send(400, "application/json", "{\"success\":false,\"message\":\"Invalid governor value. Use 'on' or 'off'\"}");
+            return;
+        }
+        setTrafficGovernorEnabled(governor == "on");
+    }
+
+    TrafficStats stats = getTrafficStats();
+
+    StaticJsonDocument<384> doc;
+    doc["success"] = true;
+    doc["message"] = "Traffic statistics";
+
+    JsonObject data = doc.createNestedObject("data");
+    data["governor"] = stats.governorEnabled ? "on" : "off";
+    data["ws_loop_time_avg_ms"] = stats.wsLoopTimeAvg;
+    data["ws_loop_time_max_ms"] = stats.wsLoopTimeMax;
+    data["control_rtt_avg_ms"] = stats.controlRttAvg;
+    data["control_rtt_last_ms"] = stats.controlRttLast;
+    data["control_rtt_expired"] = stats.controlRttExpired;
+    data["control_rtt_expiries"] = stats.controlRttExpiries;
+    data["control_latency_budget_ms"] = CONTROL_LATENCY_BUDGET;
+    data["stream_rate_limit"] = stats.streamRateLimit;
+    data["throttle_events"] = stats.throttleEvents;
+    data["stream_delay_ms"] = stats.streamDelayMs;
+
+    String response;
+    serializeJson(doc, response);
+
+    vehicle.server->send(200, "application/json", response);
+}
+
+// czas obsługi żądań według klas od ostatniego wyzerowania; ?reset=1 zaczyna nowe okno pomiaru
+void handleAPILoad()
+{
+    if (!vehicle.server)
+        return;
+
+    addCORSHeaders();
+
+    RequestLoadStats stats = getRequestLoadStats(vehicle.server->hasArg("reset"));
+
+    StaticJsonDocument<1024> doc;
+    doc["success"] = true;
+    doc["message"] = "Request load";
+
+    JsonObject data = doc.createNestedObject("data");
+    data["window_ms"] = stats.window;
+    JsonObject classes = data.createNestedObject("classes");
+    for (int i = 0; i < REQUEST_CLASS_COUNT; i++)
+    {
+        const RequestClassStats &s = stats.classes[i];
+        JsonObject entry = classes.createNestedObject(requestClassName(static_cast<RequestClass>(i)));
+        entry["count"] = s.count;
+        entry["total_ms"] = (uint32_t)(s.totalUs / 1000);
+        entry["avg_us"] = s.count > 0 ? (uint32_t)(s.totalUs / s.count) : 0;
+        entry["max_us"] = s.maxUs;
+        // udział w czasie okna - dla klas z pętli głównej to zajętość pętli
+        entry["load_pct"] = stats.window > 0 ? s.totalUs / (stats.window * 10.0f) : 0;
+    }
+
+    String response;
+    serializeJson(doc, response);
+
+    vehicle.server->send(200, "application/json", response);
+}
+
+// mikrobenchmarki (benchmark.h); ?filter=mjpeg wybiera benchmarki po nazwie, ?min_time=100 - ms na benchmark
+void handleAPIBench()
+{
+    if (!vehicle.server)
+        return;
+
+    addCORSHeaders();
+
+    // pomiar blokuje pętlę główną razem z zatrzymaniem awaryjnym - tylko na stojącym pojeździe
+    MotorSpeeds speeds = getMotorSpeedsAt(esp_timer_get_time());
+    if (speeds.left != 0 || speeds.right != 0)
+    {
+        StaticJsonDocument<256> errorDoc;
+        errorDoc["success"] = false;
+        errorDoc["message"] = "Stop the vehicle before running benchmarks";
+
+        String errorResponse;
+        serializeJson(errorDoc, errorResponse);
+
+        vehicle.server->send(409, "application/json", errorResponse);
+        return;
+    }
+
+    unsigned long minTime = BENCHMARK_DEFAULT_MIN_TIME;
+    if (vehicle.server->hasArg("min_time"))
+        minTime = constrain((int)vehicle.server->arg("min_time").toInt(), 1, BENCHMARK_MAX_MIN_TIME);
+
+    BenchmarkResult results[BENCHMARK_MAX_RESULTS];
+    int count = runBenchmarks(vehicle.server->arg("filter").c_str(), minTime, results, BENCHMARK_MAX_RESULTS);
+
+    // pola wyników jak w formacie JSON Google Benchmark, do porównania między wersjami firmware'u
+    DynamicJsonDocument doc(4096);
+    doc["success"] = true;
+    doc["message"] = "Benchmarks";
+
+    JsonObject data = doc.createNestedObject("data");
+    JsonObject context = data.createNestedObject("context");
+    context["device"] = "NeuroVehicle";
+    context["version"] = "3.0.0";
+    context["build"] = __DATE__ " " __TIME__;
+    context["mhz_per_cpu"] = ESP.getCpuFreqMHz();
+    context["free_heap"] = ESP.getFreeHeap();
+    context["min_time_ms"] = minTime;
+
+    JsonArray benchmarks = data.createNestedArray("benchmarks");
+    for (int i = 0; i < count; i++)
+    {
+        const BenchmarkResult &r = results[i];
+        JsonObject entry = benchmarks.createNestedObject();
+        entry["name"] = r.name;
+        entry["run_type"] = "iteration";
+        if (r.skipped)
+        {
+            entry["error_occurred"] = true;
+            entry["error_message"] = "No camera frame";
+            continue;
+        }
+        entry["iterations"] = r.iterations;
+        entry["real_time"] = r.nsPerOp;
+        entry["cpu_time"] = r.nsPerOp;
+        entry["time_unit"] = "ns";
+        if (r.bytesPerSecond > 0)
+            entry["bytes_per_second"] = r.bytesPerSecond;
+    }
+
+    String response;
+    serializeJson(doc, response);
+
+    vehicle.server->send(200, "application/json", response);
+}
+
+// ustawienia sensora kamery: GET - bieżące, PATCH - zmiana wybranych pól
+void handleAPICameraSettings()
+{
+    if (!vehicle.server)
+        return;
+
+    // odpowiedź 413 została już wysłana podczas odbioru ciała
+    if (consumeRequestBodyRejection())
+        return;
+
+    addCORSHeaders();
+
+    if (vehicle.server->method() == HTTP_GET)
+    {
+        esp32cam::CameraClass::UpdateStats batch = esp32cam::Camera.getUpdateStats();
+
+        StaticJsonDocument<640> doc;
+        doc["success"] = true;
+        doc["message"] = "Camera settings";
+
+        JsonObject data = doc.createNestedObject("data");
+        cameraSettingsToJson(esp32cam::Camera.status(), data.createNestedObject("settings"));
+        data["jpeg_target_bytes"] = getRateControlStats().targetBytes;
+
+        JsonObject last = data.createNestedObject("batches");
+        last["count"] = batch.batches;
+        last["updates"] = batch.updates;
+        last["failures"] = batch.failures;
+        last["last_duration_us"] = batch.lastBatchMicros;
+        last["last_discarded_frames"] = batch.lastDiscardFrames;
+
+        String response;
+        serializeJson(doc, response);
+
+        vehicle.server->send(200, "application/json", response);
+    }
+    else if (vehicle.server->method() == HTTP_PATCH)
+    {
+        StaticJsonDocument<256> filter;
+        filter["resolution"] = true;
+        filter["brightness"] = true;
+        filter["contrast"] = true;
+        filter["saturation"] = true;
+        filter["gain"] = true;
+        filter["light_mode"] = true;
+        filter["special_effect"] = true;
+        filter["hmirror"] = true;
+        filter["vflip"] = true;
+        filter["raw_gma"] = true;
+        filter["lens_correction"] = true;
+        filter["jpeg_target_bytes"] = true;
+
+        StaticJsonDocument<384> doc;
+        DeserializationError error;
+        RequestBodyStatus bodyStatus = parseRequestBody(doc, filter, error);
+
+        if (bodyStatus == BODY_MISSING)
+        {
+            vehicle.server->send(400, "application/json", "{\"success\":false,\"message\":\"No data provided\"}");
+            return;
+        }
+
+        if (bodyStatus == BODY_TOO_LARGE)
+        {
+            vehicle.server->send(413, "application/json", "{\"success\":false,\"message\":\"Payload too large\"}");
+            return;
+        }
+
+        if (bodyStatus == BODY_INVALID_JSON)
+        {
+            vehicle.server->send(400, "application/json", "{\"success\":false,\"message\":\"Invalid JSON\"}");
+            return;
+        }
+
+        esp32cam::Settings current = esp32cam::Camera.status();
+        esp32cam::Settings requested = current;
+        String message;
+        if (!cameraSettingsFromJson(doc.as<JsonObjectConst>(), requested, message))
+        {
+            vehicle.server->send(400, "application/json", "{\"success\":false,\"message\":\"" + message + "\"}");
+            return;
+        }
+
+        if (doc.containsKey("jpeg_target_bytes"))
+        {
+            long target = doc["jpeg_target_bytes"] | -1L;
+            if (target < 0 || target > 100000)
+            {
+                vehicle.server->send(400, "application/json", "{\"success\":false,\"message\":\"jpeg_target_bytes must be between 0 (off) and 100000\"}");
+                return;
+            }
+            setRateControlTarget(target);
+        }
+
+        // tylko zmienione pola trafiają do paczki rejestrów
+        uint16_t changed = diffCameraSettings(current, requested);
+        if (changed & CAMERA_SETTINGS_RESOLUTION)
+        {
+            // ręczna rozdzielczość wyłącza drabinkę strumienia
+            setResolutionLadderEnabled(false);
+        }
+
+        // w trakcie przechwytywania paczka czeka na task kamery i wchodzi między klatkami;
+        // bez przechwytywania zapis od razu, bez odrzucania klatek
+        bool queued = isCaptureRunning();
+        if (changed)
+        {
+            bool ok = esp32cam::Camera.updateAsync(
+                [requested, changed](esp32cam::Settings &settings)
+                { mergeCameraSettings(requested, changed, settings); },
+                queued ? RESOLUTION_DISCARD_FRAMES : 0);
+            if (!ok)
+            {
+                vehicle.server->send(503, "application/json", "{\"success\":false,\"message\":\"Camera busy, try again\"}");
+                return;
+            }
+        }
+
+        esp32cam::CameraClass::UpdateStats before = esp32cam::Camera.getUpdateStats();
+        if (changed && !queued)
+        {
+            esp32cam::Camera.processPending();
+        }
+        esp32cam::CameraClass::UpdateStats after = esp32cam::Camera.getUpdateStats();
+
+        if (after.failures != before.failures)
+        {
+            vehicle.server->send(500, "application/json", "{\"success\":false,\"message\":\"Failed to update camera settings\"}");
+            return;
+        }
+
+        StaticJsonDocument<384> result;
+        result["success"] = true;
+        result["message"] = queued && changed ? "Camera settings queued" : "Camera settings updated";
+
+        JsonObject data = result.createNestedObject("data");
+        cameraSettingsChangesToJson(changed, data.createNestedArray("changed"));
+        if (changed && !queued)
+        {
+            data["duration_us"] = after.lastBatchMicros;
+        }
+
+        String response;
+        serializeJson(result, response);
+
+        vehicle.server->send(queued && changed ? 202 : 200, "application/json", response);
+    }
+    else
+    {
+        vehicle.server->send(405, "application/json", "{\"success\":false,\"message\":\"Method not allowed\"}");
     }
 }
 
 void setupWebSocketServer(WebSocketsServer &ws_server)
 {
-    wsServer = &ws_server;
+    vehicle.webSocket = &ws_server;
 
     // Set up header validation to allow any origin
-    wsServer->onValidateHttpHeader([](String headerName, String headerValue)
+    vehicle.webSocket->onValidateHttpHeader([](String headerName, String headerValue)
                                    {
         if (headerName.equalsIgnoreCase("Origin")) {
             // Accept any origin
@@ -989,6 +1649,6 @@ void setupWebSocketServer(WebSocketsServer &ws_server)
         // Accept all other headers
         return true; }, nullptr, 0);
 
-    wsServer->onEvent(webSocketEvent);
+    vehicle.webSocket->onEvent(webSocketEvent);
     Serial.println("Serwer WebSocket przypisany z obsługą CORS");
 }
\ No newline at end of file
@@ -5,9 +5,58 @@
 #include <ArduinoJson.h>
 #include <WebSocketsServer.h>
 
+// pojemność dokumentu JSON komendy WebSocket
+#define WS_COMMAND_DOC_SIZE 1024
+
+enum MotorCommand
+{
+    MOTOR_COMMAND_FORWARD,
+    MOTOR_COMMAND_BACKWARD,
+    MOTOR_COMMAND_LEFT,
+    MOTOR_COMMAND_RIGHT,
+    MOTOR_COMMAND_STOP,
+    MOTOR_COMMAND_SPEED,
+    MOTOR_COMMAND_SET_SPEED_MODE,
+    MOTOR_COMMAND_UNKNOWN
+};
+
+// Binarna komenda sterowania WebSocket (ramka BIN), little-endian, 8 bajtów: uint8 kod (WsBinaryOpcode),
+// uint8 źródło (1 - web, 2 - ml, jak pole "source" komend JSON), uint16 id, int16 prędkość lewego
+// i prawego koła (tylko WS_BIN_SPEED). Nadawca dostaje binarne potwierdzenie, 8 bajtów: char[4] "CACK",
+// uint8 kod, uint8 status (WsBinaryStatus), uint16 odesłane id.
+#define WS_BIN_COMMAND_SIZE 8
+#define WS_BIN_ACK_SIZE 8
+
+enum WsBinaryOpcode
+{
+    WS_BIN_ECHO,     // samo potwierdzenie bez ruchu - pomiar RTT w każdym trybie
+    WS_BIN_FORWARD,
+    WS_BIN_BACKWARD,
+    WS_BIN_LEFT,
+    WS_BIN_RIGHT,
+    WS_BIN_STOP,
+    WS_BIN_SPEED
+};
+
+enum WsBinarySource
+{
+    WS_BIN_SOURCE_WEB = 1,
+    WS_BIN_SOURCE_ML = 2
+};
+
+enum WsBinaryStatus
+{
+    WS_BIN_OK,
+    WS_BIN_REJECTED, // źródło nie pasuje do trybu sterowania
+    WS_BIN_INVALID   // zły rozmiar ramki albo nieznany kod
+};
+
 void setupAPIEndpoints(WebServer& server);
 void setupWebSocketServer(WebSocketsServer& ws_server);
 void handleSensorWebSocket();
+void handleControlPing();
+void handleMlFramePush();
+void handleMlStepPush();
 
 // handlery API
 void handleAPIRoot();
@@ -17,11 +66,20 @@ void handleAPIStatus();
 void handleAPIDocs();
 void handleAPIMode();
 void handleAPISensor();
+void handleAPITraffic();
+void handleAPILoad();
+void handleAPIBench();
+void handleAPICameraSettings();
 
+void handleStepCommand(uint8_t num, const JsonDocument& doc);
 void webSocketEvent(uint8_t num, WStype_t type, uint8_t* payload, size_t length);
+void handleBinaryCommand(uint8_t num, const uint8_t* payload, size_t length);
 void processCommand(const String& command, const JsonDocument& doc);
+void executeMotorCommand(MotorCommand command, int leftSpeed, int rightSpeed);
+MotorCommand parseMotorCommand(const String& command);
 
 // funkcje pomocnicze
 String createJSONResponse(bool success, const String& message, JsonObject& data);
+String buildStatusResponse();
 
 #endif // API_HANDLER_H
\ No newline at end of file
@@ -0,0 +1,188 @@
+#include "benchmark.h"
+#include "api_handler.h"
+#include "sensor_control.h"
+#include "src/esp32cam/camera.hpp"
+#include "src/esp32cam/mjpeg.hpp"
+
+#include <ArduinoJson.h>
+#include <esp_timer.h>
+#include <memory>
+
+using esp32cam::Frame;
+using esp32cam::MjpegConfig;
+using esp32cam::detail::MjpegController;
+using esp32cam::detail::MjpegHeader;
+
+// wyniki iteracji trafiają tutaj, żeby kompilator nie usunął mierzonego kodu
+static volatile uint32_t sink;
+
+// gniazdo-atrapa: przyjmuje wszystko od razu, więc mierzony jest tylko koszt po stronie pojazdu
+class NullPrint : public Print
+{
+public:
+    size_t write(uint8_t) override { return 1; }
+    size_t write(const uint8_t *, size_t size) override { return size; }
+};
+
+struct BenchmarkContext
+{
+    std::shared_ptr<Frame> frame;
+    NullPrint out;
+};
+
+typedef void (*BenchmarkFunction)(BenchmarkContext &ctx, uint32_t iterations);
+
+struct Benchmark
+{
+    const char *name;
+    BenchmarkFunction run;
+    bool needsFrame;
+};
+
+static const char WS_SPEED_COMMAND[] = "{\"command\":\"speed\",\"source\":\"ml\",\"left\":120,\"right\":-80}";
+
+// komendy z webSocketEvent() w proporcjach sterowania z przeglądarki; ostatnia nie jest komendą ruchu
+static const char *const WS_COMMANDS[] = {"forward", "left", "right", "stop", "set_speed_mode", "ml_subscribe"};
+#define WS_COMMAND_COUNT (sizeof(WS_COMMANDS) / sizeof(WS_COMMANDS[0]))
+
+// jak webSocketEvent(): nowy dokument na każdą wiadomość, parsowanie w buforze biblioteki WebSockets
+static void benchWsCommandParse(BenchmarkContext &, uint32_t iterations)
+{
+    uint8_t payload[sizeof(WS_SPEED_COMMAND)];
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        memcpy(payload, WS_SPEED_COMMAND, sizeof(payload));
+        DynamicJsonDocument doc(WS_COMMAND_DOC_SIZE);
+        if (deserializeJson(doc, payload))
+            return;
+        sink += doc["left"].as<int>() + doc["command"].as<const char *>()[0];
+    }
+}
+
+static void benchWsCommandDispatch(BenchmarkContext &, uint32_t iterations)
+{
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        String command = WS_COMMANDS[i % WS_COMMAND_COUNT];
+        sink += parseMotorCommand(command);
+    }
+}
+
+static void benchApiStatusResponse(BenchmarkContext &, uint32_t iterations)
+{
+    for (uint32_t i = 0; i < iterations; i++)
+        sink += buildStatusResponse().length();
+}
+
+static void benchMjpegPartHeader(BenchmarkContext &, uint32_t iterations)
+{
+    MjpegHeader hdr;
+    int64_t timestamp = esp_timer_get_time();
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        hdr.preparePartHeader(40000 + (i & 0x3fff), timestamp + i * 33333LL, i, timestamp + i * 33333LL + 1500);
+        sink += hdr.size;
+    }
+}
+
+static void benchFrameWrite(BenchmarkContext &ctx, uint32_t iterations)
+{
+    for (uint32_t i = 0; i < iterations; i++)
+        sink += ctx.frame->writeTo(ctx.out);
+}
+
+static void benchMjpegDecideAction(BenchmarkContext &, uint32_t iterations)
+{
+    MjpegController ctrl(MjpegConfig{});
+    for (uint32_t i = 0; i < iterations; i++)
+        sink += ctrl.decideAction();
+}
+
+// pełny cykl klatki jak w pętli streamMjpeg(): przechwycenie, zwrot, wysłanie
+static void benchMjpegControllerCycle(BenchmarkContext &ctx, uint32_t iterations)
+{
+    MjpegController ctrl(MjpegConfig{});
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        sink += ctrl.decideAction();
+        ctrl.notifyCapture();
+        sink += ctrl.decideAction();
+        ctrl.notifyReturn(ctx.frame);
+        sink += ctrl.decideAction();
+        ctrl.notifySent(true);
+    }
+}
+
+static void benchEchoToDistance(BenchmarkContext &, uint32_t iterations)
+{
+    // czasy echa od bliskiej przeszkody po limit pomiaru (30 ms)
+    for (uint32_t i = 0; i < iterations; i++)
+        sink += (int)echoToDistance(100 + (i * 7919) % 30000);
+}
+
+static const Benchmark BENCHMARKS[] = {
+    {"ws_command_parse", benchWsCommandParse, false},
+    {"ws_command_dispatch", benchWsCommandDispatch, false},
+    {"api_status_response", benchApiStatusResponse, false},
+    {"mjpeg_part_header", benchMjpegPartHeader, false},
+    {"frame_write", benchFrameWrite, true},
+    {"mjpeg_decide_action", benchMjpegDecideAction, false},
+    {"mjpeg_controller_cycle", benchMjpegControllerCycle, true},
+    {"echo_to_distance", benchEchoToDistance, false},
+};
+#define BENCHMARK_COUNT (sizeof(BENCHMARKS) / sizeof(BENCHMARKS[0]))
+
+static BenchmarkResult runBenchmark(const Benchmark &benchmark, BenchmarkContext &ctx, unsigned long minTime)
+{
+    BenchmarkResult result = {benchmark.name, 0, 0, 0, false};
+    if (benchmark.needsFrame && !ctx.frame)
+    {
+        result.skipped = true;
+        return result;
+    }
+
+    // rozgrzanie: pamięć podręczna flash i alokacje przy pierwszym użyciu
+    benchmark.run(ctx, 1);
+
+    int64_t target = (int64_t)minTime * 1000;
+    uint32_t iterations = 1;
+    int64_t elapsed;
+    for (;;)
+    {
+        int64_t start = esp_timer_get_time();
+        benchmark.run(ctx, iterations);
+        elapsed = esp_timer_get_time() - start;
+        if (elapsed >= target || iterations >= BENCHMARK_MAX_ITERATIONS)
+            break;
+
+        // następna seria celuje w minTime z zapasem; po zbyt krótkiej serii - dziesięć razy więcej
+        double multiplier = elapsed * 10 > target ? target * 1.4 / elapsed : 10;
+        iterations = (uint32_t)min<double>(max<double>(iterations * multiplier, iterations + 1.0), BENCHMARK_MAX_ITERATIONS);
+        delay(1);
+    }
+
+    result.iterations = iterations;
+    result.nsPerOp = elapsed * 1000.0f / iterations;
+    if (benchmark.run == benchFrameWrite && elapsed > 0)
+        result.bytesPerSecond = (float)ctx.frame->size() * iterations * 1e6f / elapsed;
+    return result;
+}
+
+int runBenchmarks(const char *filter, unsigned long minTime, BenchmarkResult *results, int capacity)
+{
+    BenchmarkContext ctx;
+    int count = 0;
+    for (size_t i = 0; i < BENCHMARK_COUNT && count < capacity; i++)
+    {
+        const Benchmark &benchmark = BENCHMARKS[i];
+        if (filter && filter[0] && !strstr(benchmark.name, filter))
+            continue;
+
+        // jedna klatka z kamery na cały pomiar, oddawana po ostatnim benchmarku
+        if (benchmark.needsFrame && !ctx.frame)
+            ctx.frame = esp32cam::Camera.capture();
+
+        results[count++] = runBenchmark(benchmark, ctx, minTime);
+    }
+    return count;
+}
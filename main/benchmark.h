@@ -0,0 +1,29 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <Arduino.h>
+
+// Mikrobenchmarki gorących ścieżek firmware'u, uruchamiane na pojeździe przez /api/bench:
+// parsowanie komendy WebSocket, wybór komendy ruchu, serializacja /api/status, nagłówki części
+// MJPEG, wysyłka klatki do gniazda-atrapy, decyzje MjpegController i przeliczenie echa HC-SR04.
+// Jak w Google Benchmark liczba iteracji rośnie, aż seria trwa co najmniej `minTime`, a wynikiem
+// jest czas jednej iteracji. Pomiar blokuje task, który go wywołał.
+
+#define BENCHMARK_MAX_RESULTS 16
+#define BENCHMARK_DEFAULT_MIN_TIME 100 // ms na benchmark
+#define BENCHMARK_MAX_MIN_TIME 2000
+#define BENCHMARK_MAX_ITERATIONS 1000000
+
+struct BenchmarkResult
+{
+    const char *name;
+    uint32_t iterations;
+    float nsPerOp;        // czas jednej iteracji (ns)
+    float bytesPerSecond; // dla wysyłki klatki, 0 - nie dotyczy
+    bool skipped;         // benchmark wymaga klatki, a kamera jej nie dała
+};
+
+// Benchmarki, których nazwa zawiera `filter` (pusty - wszystkie); zwraca liczbę wyników
+int runBenchmarks(const char *filter, unsigned long minTime, BenchmarkResult *results, int capacity);
+
+#endif // BENCHMARK_H
@@ -1,12 +1,43 @@
 #include "camera_control.h"
+#include "config.h"
+#include "hardware.h"
+#include "traffic_control.h"
+#include "stream_client.h"
+#include "capture_pipeline.h"
+#include "rate_control.h"
+#include "resolution_ladder.h"
+#include "still_cache.h"
+#include "ml_frame.h"
+#include "ml_step.h"
+#include "dc_thumbnail.h"
+#include "heap_monitor.h"
+#include "dataset_recorder.h"
+#include "request_stats.h"
+
+#include "src/esp32cam/camera.hpp"
+
+#include <freertos/queue.h>
+
+using esp32cam::detail::MjpegHeader;
 
 int streamingClients = 0;
 bool isStreaming = false;
 bool isCameraActive = true;
 
-TaskHandle_t streamTaskHandle = NULL;
-WiFiClient *streamClient = NULL;
+// stała pula workerów strumienia ze statycznymi stosami i kolejka zadań
+static StaticTask_t streamWorkerTcb[STREAM_WORKER_COUNT];
+static StackType_t streamWorkerStack[STREAM_WORKER_COUNT][STREAM_WORKER_STACK];
+static StaticQueue_t streamJobQueueBuffer;
+static uint8_t streamJobQueueStorage[STREAM_WORKER_COUNT * sizeof(StreamClient *)];
+static QueueHandle_t streamJobQueue = NULL;
+
+StreamClient *activeStreams[STREAM_WORKER_COUNT] = {NULL};
+unsigned long lastTimeToFirstFrame = 0;
 framesize_t saved_framesize;
+// rozdzielczość sprzed strumienia czeka w kolejce kamery na task przechwytywania
+static volatile bool framesizeRestorePending = false;
+// streamingClients zmieniają równolegle workery strumienia i serwer WWW
+static portMUX_TYPE streamClientsMux = portMUX_INITIALIZER_UNLOCKED;
 
 bool setupCamera()
 {
@@ -35,7 +66,7 @@ bool setupCamera()
   // config.pixel_format = PIXFORMAT_RGB565; // for face detection/recognition
   config.grab_mode = CAMERA_GRAB_WHEN_EMPTY;
   config.fb_location = CAMERA_FB_IN_PSRAM;
-  config.jpeg_quality = 47;
+  config.jpeg_quality = JPEG_QUALITY_INITIAL;
   config.fb_count = 1;
 
   // if PSRAM IC present, init with UXGA resolution and higher JPEG quality
@@ -44,7 +75,9 @@ bool setupCamera()
   {
     if (psramFound())
     {
-      config.jpeg_quality = 47;
+      // bufory na największą rozdzielczość - drabinka i zdjęcia przełączają się w górę bez reinicjalizacji
+      config.frame_size = CAMERA_MAX_FRAMESIZE;
+      config.jpeg_quality = JPEG_QUALITY_INITIAL;
       config.fb_count = 2;
       config.grab_mode = CAMERA_GRAB_LATEST;
     }
@@ -80,20 +113,30 @@ bool setupCamera()
   sensor_t *s = esp_camera_sensor_get();
   s->set_exposure_ctrl(s, 0);       // Enable auto exposure (1) or disable (0)
   s->set_aec2(s, 0);                // Enable advanced auto exposure 
-  s->set_gain_ctrl(s, 0);           // Auto gain control
 
-  // initial sensors are flipped vertically and colors are a bit saturated
-  if (s->id.PID == OV3660_PID)
+  // pozostałe ustawienia startowe jedną paczką przez esp32cam::Settings,
+  // w czasie pracy zmieniane przez /api/camera/settings
+  bool ov3660 = s->id.PID == OV3660_PID;
+  bool jpeg = config.pixel_format == PIXFORMAT_JPEG;
+  esp32cam::Camera.update([ov3660, jpeg](esp32cam::Settings &settings)
   {
-    s->set_vflip(s, 1);       // flip it back
-    s->set_brightness(s, 1);  // up the brightness just a bit
-    s->set_saturation(s, -2); // lower the saturation
-  }
-  // drop down frame size for higher initial frame rate
-  if (config.pixel_format == PIXFORMAT_JPEG)
-  {
-    s->set_framesize(s, FRAMESIZE_QVGA);
-  }
+    settings.gain = 1; // bez AGC, wzmocnienie 1x
+
+    // initial sensors are flipped vertically and colors are a bit saturated
+    if (ov3660)
+    {
+      settings.vflip = true;    // flip it back
+      settings.brightness = 1;  // up the brightness just a bit
+      settings.saturation = -2; // lower the saturation
+    }
+    // drop down frame size for higher initial frame rate
+    if (jpeg)
+    {
+      settings.resolution = esp32cam::Resolution(FRAMESIZE_QVGA);
+    }
+  });
+
+  setupRateControl(config.jpeg_quality);
 
   Serial.printf("Camera initialized successfully\n");
   return true;
@@ -102,7 +145,7 @@ bool setupCamera()
 // funkcja odpowiedzialna za przechwytywanie i strumowanie klatki
 void captureAndStreamFrame(WiFiClient client)
 {
-  camera_fb_t *fb = esp_camera_fb_get(); // przechwycenie klatki
+  camera_fb_t *fb = getCameraFrame(); // przechwycenie klatki
   if (!fb)
   {
     Serial.println("Camera capture failed");
@@ -110,66 +153,93 @@ void captureAndStreamFrame(WiFiClient client)
   }
 
   client.write((const char *)fb->buf, fb->len);
-  esp_camera_fb_return(fb);
+  returnCameraFrame(fb);
 }
 
-void streamTask(void *parameter)
+// pętla strumienia jednego klienta, wykonywana przez worker z puli;
+// klatki przechwytuje potok na drugim rdzeniu, tutaj są tylko wysyłane
+void runStream(StreamClient *streamClient)
 {
-  int failCount = 0;
-  const int maxFails = 5;
+  bool deactivationSent = false;
+  unsigned long nextFrameTime = millis();
+  uint32_t reportedFrames = 0;
+
+  captureSubscribe();
 
   while (isStreaming)
   {
     if (streamClient && streamClient->connected())
     {
+      // wysyłka bez blokowania - kursor klienta przesuwa się o tyle, ile przyjmie gniazdo
+      unsigned long pumpStart = micros();
+      if (!streamClient->pump())
+      {
+        break;
+      }
+      recordRequest(REQUEST_STREAM, micros() - pumpStart, streamClient->sentFrames() - reportedFrames);
+
+      // pomiar wysyłki dla drabinki rozdzielczości
+      if (streamClient->sentFrames() != reportedFrames)
+      {
+        reportedFrames = streamClient->sentFrames();
+        reportStreamSend(streamClient->lastFrameBytes(), streamClient->lastSendTime());
+      }
+
       if (!isCameraActive) {
+        // potok wyłączył kamerę po serii błędów - informacja dla klienta po skończonej klatce
+        if (!deactivationSent && !streamClient->isBusy()) {
+          static const char message[] = "Camera deactivated. Please reconnect.";
+          WiFiClient &socket = streamClient->socket();
+          MjpegHeader hdr;
+          socket.print("Content-Type: text/plain\r\n");
+          socket.printf("Content-Length: %u\r\n\r\n", (unsigned)(sizeof(message) - 1));
+          socket.print(message);
+          hdr.preparePartTrailer();
+          hdr.writeTo(socket);
+          deactivationSent = true;
+        }
         delay(500);
-        continue;  // pomijanie przechwytywania klatki, jeśli kamera jest nieaktywna
+        continue;  // pomijanie klatek, jeśli kamera jest nieaktywna
       }
+      deactivationSent = false;
 
-      camera_fb_t *fb = esp_camera_fb_get(); // przechwycenie klatki
-      if (!fb)
+      unsigned long now = millis();
+      if ((long)(now - nextFrameTime) < 0)
       {
-        Serial.println("Camera capture failed");
-        failCount++;
-        
-        // shutdown kamery jak za duzo błędów
-        if (failCount >= maxFails) {
-          Serial.println("Too many camera failures, shutting down camera");
-          isCameraActive = false;
-          
-          // cleanup
-          if (streamClient && streamClient->connected()) {
-            streamClient->println();
-            streamClient->println("--frame");
-            streamClient->println("Content-Type: text/plain");
-            streamClient->println("Content-Length: 35");
-            streamClient->println();
-            streamClient->println("Camera deactivated. Please reconnect.");
-          }
-          
-          delay(100);
-          continue;
-        }
-        
-        delay(100);
+        delay(streamClient->isBusy() ? 2 : min<unsigned long>(nextFrameTime - now, 10));
         continue;
       }
 
-      failCount = 0;
+      // klient nie skończył poprzedniej klatki - pomijamy tę, dostanie najnowszą
+      if (streamClient->isBusy())
+      {
+        streamClient->skip();
+        reportStreamSkip();
+        nextFrameTime = now + 100;
+        continue;
+      }
 
-      streamClient->println();
-      streamClient->println("--frame");
-      streamClient->print("Content-Type: image/jpeg\r\n");
-      streamClient->print("Content-Length: ");
-      streamClient->println(fb->len);
-      streamClient->println();
+      // najnowsza klatka z puli potoku, bez kopiowania
+      CapturedFrame *frame = acquireLatestFrame(streamClient->lastSeq());
+      if (!frame)
+      {
+        delay(5);
+        continue;
+      }
 
-      streamClient->write(fb->buf, fb->len);
-      esp_camera_fb_return(fb);
+      // scena bez zmian - klatka nie jest wysyłana (co MOTION_KEEPALIVE i tak wychodzi jedna)
+      if (!streamClient->motionGate().admit(frame, now))
+      {
+        streamClient->suppress(frame);
+        nextFrameTime = now + STREAM_FRAME_INTERVAL;
+        continue;
+      }
 
-      int frameDelay = fb->len > 25000 ? 150 : 100;
-      delay(frameDelay);
+      size_t frameLen = frame->len;
+      streamClient->offer(frame);
+
+      // rozmiar klatek trzyma regulator jakości JPEG, limit przepływności - regulator ruchu
+      nextFrameTime = now + max<unsigned long>(STREAM_FRAME_INTERVAL, acquireStreamBudget(frameLen));
     }
     else
     {
@@ -177,49 +247,153 @@ void streamTask(void *parameter)
     }
   }
 
-  // Cleanup
-  streamingClients--;
-  if (streamingClients == 0) {
-    isStreaming = false;
-    Serial.println("No clients connected, stopping stream.");
+  captureUnsubscribe();
+}
+
+// worker strumienia - tworzony raz przy starcie, obsługuje kolejne żądania /stream
+void streamWorker(void *parameter)
+{
+  int slot = (int)(intptr_t)parameter;
+
+  while (true)
+  {
+    StreamClient *streamClient = NULL;
+    if (xQueueReceive(streamJobQueue, &streamClient, portMAX_DELAY) != pdTRUE)
+    {
+      continue;
+    }
+
+    activeStreams[slot] = streamClient;
+    runStream(streamClient);
+    activeStreams[slot] = NULL;
+
+    // Cleanup
+    if (streamClient->timeToFirstFrame() > 0) {
+      lastTimeToFirstFrame = streamClient->timeToFirstFrame();
+    }
+    Serial.printf("Stream ended: %u frames sent, %u skipped, lag %lu ms (max %lu ms), first frame after %lu ms\n",
+                  streamClient->sentFrames(), streamClient->skippedFrames(),
+                  streamClient->lastLag(), streamClient->maxLag(), streamClient->timeToFirstFrame());
+
+    portENTER_CRITICAL(&streamClientsMux);
+    bool lastClient = --streamingClients <= 0;
+    if (lastClient) {
+      streamingClients = 0;
+      isStreaming = false;
+    }
+    portEXIT_CRITICAL(&streamClientsMux);
+
+    if (lastClient) {
+      Serial.println("No clients connected, stopping stream.");
+
+      // powrót do rozdzielczości sprzed strumienia przez kolejkę kamery - zapis rejestrów
+      // sensora z workera ścigałby się z taskiem przechwytywania i drabinką
+      stopResolutionLadder();
+      framesizeRestorePending = true;
+      if (!esp32cam::Camera.changeResolutionAsync(esp32cam::Resolution(saved_framesize), RESOLUTION_DISCARD_FRAMES,
+                                                  [](bool) { framesizeRestorePending = false; }))
+        framesizeRestorePending = false;
+    }
     
-    sensor_t *s = esp_camera_sensor_get();
-    s->set_framesize(s, saved_framesize);
+    delete streamClient;
+  }
+}
+
+// utworzenie puli workerów strumienia (rdzeń 0) i kolejki zadań
+void startStreamWorkers()
+{
+  if (streamJobQueue)
+  {
+    return;
+  }
+
+  streamJobQueue = xQueueCreateStatic(STREAM_WORKER_COUNT, sizeof(StreamClient *),
+                                      streamJobQueueStorage, &streamJobQueueBuffer);
+
+  for (int i = 0; i < STREAM_WORKER_COUNT; i++)
+  {
+    xTaskCreateStaticPinnedToCore(
+      streamWorker,
+      "StreamWorker",
+      STREAM_WORKER_STACK,
+      (void *)(intptr_t)i,
+      1,
+      streamWorkerStack[i],
+      &streamWorkerTcb[i],
+      0
+    );
   }
-  
-  delete streamClient;
-  streamClient = NULL;
-  streamTaskHandle = NULL;
-  vTaskDelete(NULL); // usuniecie tasku
 }
 
 // funkcja odpowiedzialna za strumowanie MJPEG
 // do klienta, który się połączył
-void streamMJPEG(WiFiClient client)
+void streamMJPEG(WiFiClient client, const MotionGateConfig &motion)
 {
-  sensor_t *s = esp_camera_sensor_get();
-  saved_framesize = s->status.framesize;
-  s->set_framesize(s, FRAMESIZE_QVGA); // zmiana rozdzielczości na QVGA
+  // wszystkie workery zajęte - odmowa zamiast czekania w kolejce
+  if (!streamJobQueue || streamingClients >= STREAM_WORKER_COUNT)
+  {
+    client.print("HTTP/1.1 503 Service Unavailable\r\nContent-Type: text/plain\r\n"
+                 "Access-Control-Allow-Origin: *\r\nConnection: close\r\n\r\nToo many streams");
+    client.stop();
+    return;
+  }
 
-  client.println("HTTP/1.1 200 OK");
-  client.println("Content-Type: multipart/x-mixed-replace; boundary=frame");
-  client.println("Access-Control-Allow-Origin: *");
-  client.println("");
+  // czas do pierwszej klatki liczony od przyjęcia żądania
+  StreamClient *streamClient = new StreamClient(client, motion);
 
+  // pierwszy strumień: zapamiętanie rozdzielczości, dalej dobiera ją drabinka (start od QVGA);
+  // niezastosowany jeszcze powrót po poprzednim strumieniu zostawia zapamiętaną wartość
+  if (streamingClients == 0)
+  {
+    if (!framesizeRestorePending)
+    {
+      sensor_t *s = esp_camera_sensor_get();
+      saved_framesize = s->status.framesize;
+    }
+    startResolutionLadder();
+  }
+
+  configureStreamSocket(client);
+
+  MjpegHeader hdr;
+  hdr.prepareResponseContentType();
+  client.print("HTTP/1.1 200 OK\r\nContent-Type: ");
+  client.write(hdr.buf, hdr.size);
+  client.print("\r\nAccess-Control-Allow-Origin: *\r\n\r\n");
+
+  // pierwsza granica części, kolejne są wysyłane razem z końcem każdej klatki
+  hdr.preparePartTrailer();
+  hdr.writeTo(client);
+
+  portENTER_CRITICAL(&streamClientsMux);
   streamingClients++;
   isStreaming = true;
+  portEXIT_CRITICAL(&streamClientsMux);
+
+  // przekazanie klienta do wolnego workera z puli
+  xQueueSend(streamJobQueue, &streamClient, portMAX_DELAY);
+}
 
-  streamClient = new WiFiClient(client);
-
-  xTaskCreatePinnedToCore(
-    streamTask,
-    "StreamTask",
-    8192,
-    NULL,
-    1,
-    &streamTaskHandle,
-    0
-  ); // tworzymy task na rdzeniu 0
+// nazwa rozdzielczości z parametru `res` na framesize_t
+static bool parseFrameSize(const String &res, framesize_t &frameSize)
+{
+  if (res == "UXGA")
+    frameSize = FRAMESIZE_UXGA;
+  else if (res == "SXGA")
+    frameSize = FRAMESIZE_SXGA;
+  else if (res == "XGA")
+    frameSize = FRAMESIZE_XGA;
+  else if (res == "SVGA")
+    frameSize = FRAMESIZE_SVGA;
+  else if (res == "VGA")
+    frameSize = FRAMESIZE_VGA;
+  else if (res == "CIF")
+    frameSize = FRAMESIZE_CIF;
+  else if (res == "QVGA")
+    frameSize = FRAMESIZE_QVGA;
+  else
+    return false;
+  return true;
 }
 
 // funkcja do wysłania pojedynczej klatki
@@ -230,19 +404,64 @@ void handleCapture(WebServer &server)
     isCameraActive = true;
     Serial.println("Camera reactivated by user capture request");
   }
-  
-  camera_fb_t *fb = esp_camera_fb_get();
-  if (!fb)
+
+  // bez `res`: STILL_FRAMESIZE w trakcie strumienia, bez strumienia bieżąca rozdzielczość
+  framesize_t stillSize = FRAMESIZE_INVALID;
+  if (server.hasArg("res") && !parseFrameSize(server.arg("res"), stillSize))
+  {
+    server.send(400, "text/plain", "Invalid resolution");
+    return;
+  }
+
+  unsigned long maxAge = STILL_CACHE_WINDOW;
+  if (server.hasArg("max_age"))
+  {
+    maxAge = server.arg("max_age").toInt();
+  }
+
+  // zdjęcie wspólne dla żądań w oknie świeżości; w trakcie strumienia w wyższej
+  // rozdzielczości robi je task przechwytywania między klatkami, bez zatrzymywania podglądu
+  CapturedFrame *still = NULL;
+  unsigned long age = 0;
+  unsigned long interruption = 0;
+  StillCacheResult result = acquireCachedStill(stillSize, maxAge, still, age, interruption);
+
+  if (result == STILL_CACHE_RATE_LIMITED)
+  {
+    server.sendHeader("Retry-After", String((STILL_MIN_INTERVAL + 999) / 1000));
+    server.send(429, "text/plain", "Still capture rate limited");
+    return;
+  }
+  if (result == STILL_CACHE_FAILED)
   {
     server.send(500, "text/plain", "Camera capture failed");
     return;
   }
 
-  server.setContentLength(fb->len);
+  server.sendHeader("X-Cache", result == STILL_CACHE_HIT ? "HIT" : result == STILL_CACHE_STALE ? "STALE" : "MISS");
+  server.sendHeader("X-Frame-Age", String(age));
+  char timestamp[21];
+  snprintf(timestamp, sizeof(timestamp), "%lld", (long long)still->timestamp);
+  server.sendHeader("X-Timestamp", timestamp);
+  server.sendHeader("X-Sequence", String(still->seq));
+  if (interruption > 0)
+  {
+    server.sendHeader("X-Stream-Interruption", String(interruption));
+  }
+
+  // miniatura 1/8 z samych współczynników DC zamiast pełnego JPEG
+  if (server.arg("thumb") == "1")
+  {
+    sendDcThumbnail(server, still);
+    releaseFrame(still);
+    return;
+  }
+
+  server.setContentLength(still->len);
   server.send(200, "image/jpeg", "");
-  server.sendContent((const char *)fb->buf, fb->len);
+  server.sendContent((const char *)still->buf, still->len);
 
-  esp_camera_fb_return(fb);
+  releaseFrame(still);
 }
 
 // funkcja do zmiany rozdzielczości kamery
@@ -252,26 +471,34 @@ void handleResolution(WebServer &server)
   String res = server.arg("res");
   framesize_t frameSize;
 
-  if (res == "UXGA")
-    frameSize = FRAMESIZE_UXGA;
-  else if (res == "SXGA")
-    frameSize = FRAMESIZE_SXGA;
-  else if (res == "XGA")
-    frameSize = FRAMESIZE_XGA;
-  else if (res == "SVGA")
-    frameSize = FRAMESIZE_SVGA;
-  else if (res == "VGA")
-    frameSize = FRAMESIZE_VGA;
-  else if (res == "CIF")
-    frameSize = FRAMESIZE_CIF;
-  else if (res == "QVGA")
-    frameSize = FRAMESIZE_QVGA;
-  else
+  if (res == "auto")
+  {
+    setResolutionLadderEnabled(true);
+    server.send(200, "text/plain", "Resolution set to auto");
+    return;
+  }
+  else if (!parseFrameSize(res, frameSize))
   {
     server.send(400, "text/plain", "Invalid resolution");
     return;
   }
 
+  // ręczny wybór ma pierwszeństwo przed drabinką do res=auto lub następnego strumienia
+  setResolutionLadderEnabled(false);
+
+  // w trakcie strumienia zmiana czeka na task przechwytywania i wchodzi między klatkami,
+  // bez blokowania serwera na czas stabilizacji sensora
+  if (isStreaming && isCameraActive)
+  {
+    if (!esp32cam::Camera.changeResolutionAsync(esp32cam::Resolution(frameSize), RESOLUTION_DISCARD_FRAMES))
+    {
+      server.send(503, "text/plain", "Camera busy, try again");
+      return;
+    }
+    server.send(202, "text/plain", "Resolution change to " + res + " queued");
+    return;
+  }
+
   sensor_t *s = esp_camera_sensor_get();
   if (s->set_framesize(s, frameSize) != 0)
   {
@@ -291,6 +518,21 @@ void handleStream(WebServer &server)
     Serial.println("Camera reactivated by user stream request");
   }
   
+  // bramkowanie ruchem ustawiane osobno dla każdego strumienia
+  MotionGateConfig motion = defaultMotionGateConfig();
+  if (server.hasArg("motion"))
+  {
+    motion.enabled = server.arg("motion") != "0";
+  }
+  if (server.hasArg("motion_threshold"))
+  {
+    motion.threshold = constrain((int)server.arg("motion_threshold").toInt(), 1, 255);
+  }
+  if (server.hasArg("keepalive"))
+  {
+    motion.keepAlive = max(0L, server.arg("keepalive").toInt());
+  }
+
   WiFiClient client = server.client();
 
   if (!client.connected())
@@ -298,14 +540,107 @@ void handleStream(WebServer &server)
     return;
   }
 
-  streamMJPEG(client);
+  streamMJPEG(client, motion);
 }
 
 // funkcja do obsługi statusu kamery. Zwraca status kamery jako "active" lub "inactive"
 void handleCameraStatus(WebServer &server)
 {
   String status = isCameraActive ? "active" : "inactive";
-  server.send(200, "text/plain", "Camera status: " + status);
+  String message = "Camera status: " + status;
+
+  // opóźnienie i pominięte klatki aktywnych strumieni
+  for (int i = 0; i < STREAM_WORKER_COUNT; i++)
+  {
+    StreamClient *client = activeStreams[i];
+    if (!client)
+    {
+      continue;
+    }
+    message += "\nStream " + String(i) + ": sent " + String(client->sentFrames()) +
+               ", skipped " + String(client->skippedFrames()) +
+               ", lag " + String(client->lastLag()) + " ms (max " + String(client->maxLag()) + " ms)" +
+               ", pending " + String(client->pendingBytes()) + " B" +
+               ", first frame " + String(client->timeToFirstFrame()) + " ms";
+    const MotionGate &gate = client->motionGate();
+    if (gate.config().enabled)
+    {
+      message += ", motion gate: suppressed " + String(gate.suppressedFrames()) +
+                 ", saved " + String((uint32_t)(gate.savedBytes() / 1024)) + " KB" +
+                 ", score " + String(gate.lastScore()) + "/" + String(gate.config().threshold);
+    }
+  }
+  message += "\nLast time to first frame: " + String(lastTimeToFirstFrame) + " ms";
+
+  CaptureStats capture = getCaptureStats();
+  message += "\nCapture: " + String(capture.bufferCount) + " buffers, " + String(capture.fps, 1) + " fps" +
+             ", frames " + String(capture.frames) + ", failures " + String(capture.failures) +
+             ", no free buffer " + String(capture.noFreeBuffer) +
+             ", copy " + String(capture.copyTimeAvg, 2) + " ms";
+
+  RateControlStats rate = getRateControlStats();
+  message += "\nJPEG rate control: " + String(rate.enabled ? "on" : "off") +
+             ", target " + String(rate.targetBytes) + " B, average " + String(rate.averageBytes, 0) + " B" +
+             ", quality " + String(rate.quality) + ", adjustments " + String(rate.adjustments);
+
+  StillStats still = getStillStats();
+  message += "\nStills: " + String(still.stills) + ", failures " + String(still.failures) +
+             ", rate limited " + String(still.rateLimited) +
+             ", stream interruption " + String(still.lastInterruption) + " ms (max " + String(still.maxInterruption) + " ms" +
+             ", budget " + String(STILL_MAX_INTERRUPTION) + " ms, overruns " + String(still.overruns) + ")" +
+             ", ceiling " + String(still.ceilingWidth) + "x" + String(still.ceilingHeight);
+
+  StillCacheStats cache = getStillCacheStats();
+  message += "\nStill cache: " + String(cache.requests) + " requests, hit rate " + String(cache.hitRate * 100.0f, 0) + "%" +
+             ", captures " + String(cache.captures) +
+             ", failures " + String(cache.failures) + ", window " + String(STILL_CACHE_WINDOW) + " ms";
+
+  MlFrameStats ml = getMlFrameStats();
+  message += "\nML tensor: " + String(ml.frames) + " frames, failures " + String(ml.failures) +
+             ", decode " + String(ml.decodeTimeAvg, 1) + " ms (last " + String(ml.lastDecodeTime) + " ms, scale 1/" + String(ml.lastScale) + ")";
+
+  MlStepStats steps = getMlStepStats();
+  message += "\nML steps: " + String(steps.steps) + ", failures " + String(steps.failures) +
+             ", stale frames " + String(steps.staleFrames) + ", latency " + String(steps.latencyAvg, 1) + " ms" +
+             ", frame after period +" + String(steps.overshootAvg, 1) + " ms";
+
+  MotionGateStats motion = getMotionGateStats();
+  message += "\nMotion gate: suppressed " + String(motion.suppressed) + " frames" +
+             ", saved " + String((uint32_t)(motion.savedBytes / 1024)) + " KB" +
+             ", signatures " + String(motion.signatures) + " (" + String(motion.signatureTimeAvg, 2) + " ms)" +
+             ", failures " + String(motion.failures);
+
+  DcThumbnailStats thumb = getDcThumbnailStats();
+  message += "\nDC thumbnail: " + String(thumb.decodes) + " decodes, failures " + String(thumb.failures) +
+             ", decode " + String(thumb.decodeTimeAvg, 2) + " ms, last " + String(thumb.lastWidth) + "x" + String(thumb.lastHeight) +
+             ", mean luma " + String(thumb.lastMean);
+
+  ResolutionLadderStats ladder = getResolutionLadderStats();
+  message += "\nResolution ladder: " + String(ladder.enabled ? (ladder.active ? "active" : "idle") : "manual") +
+             ", " + String(ladder.width) + "x" + String(ladder.height) +
+             ", throughput " + String(ladder.throughput / 1024.0f, 1) + " KB/s" +
+             ", send " + String(ladder.sendTimeAvg, 1) + " ms, skipped " + String(ladder.skipRatio * 100.0f, 0) + "%" +
+             ", up " + String(ladder.stepsUp) + ", down " + String(ladder.stepsDown) +
+             ", discarded " + String(ladder.discardedFrames);
+
+  HeapMonitorStats heap = getHeapMonitorStats();
+  message += "\nHeap: PSRAM free " + String(heap.psramFree / 1024) + " KB, largest block " + String(heap.psramLargest / 1024) + " KB" +
+             " (min " + String(heap.psramMinLargest / 1024) + " KB)" +
+             ", internal free " + String(heap.internalFree / 1024) + " KB (min " + String(heap.internalMinFree / 1024) + " KB)" +
+             ", largest block " + String(heap.internalLargest / 1024) + " KB (min " + String(heap.internalMinLargest / 1024) + " KB)";
+  message += "\nBuffer pool: allocations " + String(heap.poolAllocations) + " (" + String(heap.poolAllocRate, 2) + "/s)" +
+             ", reuses " + String(heap.poolReuses) + ", failures " + String(heap.poolFailures) +
+             ", cached " + String(heap.poolCachedBytes / 1024) + " KB, in use " + String(heap.poolInUseBytes / 1024) + " KB";
+
+  DatasetRecorderStats dataset = getDatasetRecorderStats();
+  if (dataset.records > 0 || dataset.state != DATASET_IDLE)
+  {
+    message += "\nDataset " + String(dataset.file) + ": " + String(dataset.records) + " records, " + String(dataset.bytes / 1024) + " KB" +
+               ", write " + String(dataset.writeTimeAvg, 1) + " ms (max " + String(dataset.writeTimeMax) + " ms)" +
+               ", overruns " + String(dataset.overruns) + ", failures " + String(dataset.writeFailures);
+  }
+
+  server.send(200, "text/plain", message);
 }
 
 void handleNotFound(WebServer &server)
@@ -315,20 +650,32 @@ void handleNotFound(WebServer &server)
 
 void startCameraServer(WebServer &server)
 {
+  setupResolutionLadder();
+  setupStillCache();
+  setupDcThumbnail();
+  setupMotionGate();
+  startCapturePipeline();
+  startStreamWorkers();
+  setupDatasetRecorder(server);
+
   server.on("/capture", HTTP_GET, [&]()
-            { handleCapture(server); });
+            { RequestTimer timer(REQUEST_CAMERA); handleCapture(server); });
   server.on("/stream", HTTP_GET, [&]()
-            { handleStream(server); });
+            { RequestTimer timer(REQUEST_CAMERA); handleStream(server); });
   server.on("/camera/resolution", HTTP_GET, [&]()
-            { handleResolution(server); });
+            { RequestTimer timer(REQUEST_CAMERA); handleResolution(server); });
   server.on("/camera/stop", HTTP_GET, [&]()
             { 
-              isStreaming = false; 
+              portENTER_CRITICAL(&streamClientsMux);
+              isStreaming = false;
               streamingClients = 0;
+              portEXIT_CRITICAL(&streamClientsMux);
               Serial.println("Streaming stopped by client.");
               server.send(200, "text/plain", "Stopped streaming"); });
   server.on("/camera/status", HTTP_GET, [&]()
-            { handleCameraStatus(server); });
+            { RequestTimer timer(REQUEST_CAMERA); handleCameraStatus(server); });
+  server.on("/ml/frame", HTTP_GET, [&]()
+            { RequestTimer timer(REQUEST_CAMERA); handleMlFrame(server); });
   server.onNotFound([&]()
-                    { handleNotFound(server); });
+                    { RequestTimer timer(REQUEST_PAGE); handleNotFound(server); });
 }
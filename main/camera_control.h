@@ -11,10 +11,11 @@
 
 #include "camera_related/camera_pins.h"
 #include "esp_camera.h"
+#include "motion_gate.h"
 
 // funkcje do obsługi kamery
 bool setupCamera();
-void streamMJPEG(WiFiClient client);
+void streamMJPEG(WiFiClient client, const MotionGateConfig &motion);
 void handleCapture(WebServer& server);
 void handleResolution(WebServer& server);
 void handleStream(WebServer& server);
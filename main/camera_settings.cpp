@@ -0,0 +1,196 @@
+#include "camera_settings.h"
+
+using esp32cam::LightMode;
+using esp32cam::Resolution;
+using esp32cam::Settings;
+using esp32cam::SpecialEffect;
+
+static const char *const lightModeNames[] = {"none", "auto", "sunny", "cloudy", "office", "home"};
+static const char *const specialEffectNames[] = {"none", "negative", "blackwhite", "reddish", "greenish", "bluish", "antique"};
+
+static int findName(const char *const *names, int count, const char *name)
+{
+  for (int i = 0; i < count; i++)
+  {
+    if (strcmp(names[i], name) == 0)
+      return i;
+  }
+  return -1;
+}
+
+static String resolutionName(const Resolution &resolution)
+{
+  return String(resolution.getWidth()) + "x" + String(resolution.getHeight());
+}
+
+void cameraSettingsToJson(const Settings &settings, JsonObject obj)
+{
+  obj["resolution"] = resolutionName(settings.resolution);
+  obj["brightness"] = settings.brightness;
+  obj["contrast"] = settings.contrast;
+  obj["saturation"] = settings.saturation;
+  obj["gain"] = settings.gain;
+  obj["light_mode"] = lightModeNames[static_cast<int>(settings.lightMode) + 1];
+  obj["special_effect"] = specialEffectNames[static_cast<int>(settings.specialEffect)];
+  obj["hmirror"] = settings.hmirror;
+  obj["vflip"] = settings.vflip;
+  obj["raw_gma"] = settings.rawGma;
+  obj["lens_correction"] = settings.lensCorrection;
+}
+
+static bool readLevel(JsonObjectConst obj, const char *key, int8_t &value, String &error)
+{
+  JsonVariantConst v = obj[key];
+  if (v.isNull())
+    return true;
+  if (!v.is<int>() || v.as<int>() < -2 || v.as<int>() > 2)
+  {
+    error = String(key) + " must be an integer between -2 and 2";
+    return false;
+  }
+  value = v.as<int>();
+  return true;
+}
+
+static bool readFlag(JsonObjectConst obj, const char *key, bool &value, String &error)
+{
+  JsonVariantConst v = obj[key];
+  if (v.isNull())
+    return true;
+  if (!v.is<bool>())
+  {
+    error = String(key) + " must be a boolean";
+    return false;
+  }
+  value = v.as<bool>();
+  return true;
+}
+
+bool cameraSettingsFromJson(JsonObjectConst obj, Settings &settings, String &error)
+{
+  if (!obj["resolution"].isNull())
+  {
+    // format WxH, np. 640x480
+    int width = 0, height = 0;
+    const char *res = obj["resolution"] | "";
+    Resolution resolution;
+    if (sscanf(res, "%dx%d", &width, &height) == 2)
+      resolution = Resolution::find(width, height);
+    if (!resolution.isValid() || resolution.getWidth() != width || resolution.getHeight() != height)
+    {
+      error = "resolution must be WIDTHxHEIGHT of a supported frame size";
+      return false;
+    }
+    settings.resolution = resolution;
+  }
+
+  if (!readLevel(obj, "brightness", settings.brightness, error) ||
+      !readLevel(obj, "contrast", settings.contrast, error) ||
+      !readLevel(obj, "saturation", settings.saturation, error))
+    return false;
+
+  JsonVariantConst gain = obj["gain"];
+  if (!gain.isNull())
+  {
+    // 1..31 - stałe wzmocnienie, -2..-128 (potęgi dwójki) - AGC z limitem
+    int value = gain.is<int>() ? gain.as<int>() : 0;
+    bool manual = value >= 1 && value <= 31;
+    bool automatic = value <= -2 && value >= -128 && ((-value) & (-value - 1)) == 0;
+    if (!manual && !automatic)
+    {
+      error = "gain must be 1..31 or -2, -4, ..., -128 for AGC";
+      return false;
+    }
+    settings.gain = value;
+  }
+
+  if (!obj["light_mode"].isNull())
+  {
+    int index = findName(lightModeNames, 6, obj["light_mode"] | "");
+    if (index < 0)
+    {
+      error = "light_mode must be one of none, auto, sunny, cloudy, office, home";
+      return false;
+    }
+    settings.lightMode = static_cast<LightMode>(index - 1);
+  }
+
+  if (!obj["special_effect"].isNull())
+  {
+    int index = findName(specialEffectNames, 7, obj["special_effect"] | "");
+    if (index < 0)
+    {
+      error = "special_effect must be one of none, negative, blackwhite, reddish, greenish, bluish, antique";
+      return false;
+    }
+    settings.specialEffect = static_cast<SpecialEffect>(index);
+  }
+
+  return readFlag(obj, "hmirror", settings.hmirror, error) &&
+         readFlag(obj, "vflip", settings.vflip, error) &&
+         readFlag(obj, "raw_gma", settings.rawGma, error) &&
+         readFlag(obj, "lens_correction", settings.lensCorrection, error);
+}
+
+static const char *const fieldNames[] = {"resolution", "brightness", "contrast", "saturation", "gain", "light_mode",
+                                         "special_effect", "hmirror", "vflip", "raw_gma", "lens_correction"};
+
+uint16_t diffCameraSettings(const Settings &current, const Settings &requested)
+{
+  const bool differs[] = {
+      current.resolution != requested.resolution,
+      current.brightness != requested.brightness,
+      current.contrast != requested.contrast,
+      current.saturation != requested.saturation,
+      current.gain != requested.gain,
+      current.lightMode != requested.lightMode,
+      current.specialEffect != requested.specialEffect,
+      current.hmirror != requested.hmirror,
+      current.vflip != requested.vflip,
+      current.rawGma != requested.rawGma,
+      current.lensCorrection != requested.lensCorrection,
+  };
+
+  uint16_t mask = 0;
+  for (int i = 0; i < CAMERA_SETTINGS_FIELDS; i++)
+  {
+    if (differs[i])
+      mask |= 1 << i;
+  }
+  return mask;
+}
+
+void mergeCameraSettings(const Settings &from, uint16_t mask, Settings &to)
+{
+  if (mask & (1 << 0))
+    to.resolution = from.resolution;
+  if (mask & (1 << 1))
+    to.brightness = from.brightness;
+  if (mask & (1 << 2))
+    to.contrast = from.contrast;
+  if (mask & (1 << 3))
+    to.saturation = from.saturation;
+  if (mask & (1 << 4))
+    to.gain = from.gain;
+  if (mask & (1 << 5))
+    to.lightMode = from.lightMode;
+  if (mask & (1 << 6))
+    to.specialEffect = from.specialEffect;
+  if (mask & (1 << 7))
+    to.hmirror = from.hmirror;
+  if (mask & (1 << 8))
+    to.vflip = from.vflip;
+  if (mask & (1 << 9))
+    to.rawGma = from.rawGma;
+  if (mask & (1 << 10))
+    to.lensCorrection = from.lensCorrection;
+}
+
+void cameraSettingsChangesToJson(uint16_t mask, JsonArray changed)
+{
+  for (int i = 0; i < CAMERA_SETTINGS_FIELDS; i++)
+  {
+    if (mask & (1 << i))
+      changed.add(fieldNames[i]);
+  }
+}
@@ -0,0 +1,32 @@
+#ifndef CAMERA_SETTINGS_H
+#define CAMERA_SETTINGS_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+#include "src/esp32cam/config.hpp"
+
+// Ustawienia sensora kamery w czasie pracy (esp32cam::Settings <-> JSON).
+// Zmiany są porównywane z bieżącym status() i zapisywane jedną paczką rejestrów
+// przez CameraClass::update() między klatkami - bez ponownego flashowania.
+
+// bieżące ustawienia sensora jako obiekt JSON
+void cameraSettingsToJson(const esp32cam::Settings &settings, JsonObject obj);
+
+// nałożenie pól obecnych w JSON na `settings`; false i komunikat przy błędnej wartości
+bool cameraSettingsFromJson(JsonObjectConst obj, esp32cam::Settings &settings, String &error);
+
+#define CAMERA_SETTINGS_FIELDS 11
+#define CAMERA_SETTINGS_RESOLUTION (1 << 0)
+
+// maska pól, które różnią się między `current` a `requested`
+uint16_t diffCameraSettings(const esp32cam::Settings &current, const esp32cam::Settings &requested);
+
+// przepisanie z `from` do `to` tylko pól z maski - zmiany z kolejki składają się
+// z ustawieniami aktualnymi w chwili zapisu, a nie w chwili żądania
+void mergeCameraSettings(const esp32cam::Settings &from, uint16_t mask, esp32cam::Settings &to);
+
+// nazwy pól z maski jako tablica JSON
+void cameraSettingsChangesToJson(uint16_t mask, JsonArray changed);
+
+#endif // CAMERA_SETTINGS_H
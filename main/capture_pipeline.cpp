@@ -0,0 +1,406 @@
+#include "capture_pipeline.h"
+#include "config.h"
+#include "hardware.h"
+#include "rate_control.h"
+#include "resolution_ladder.h"
+
+#include "src/esp32cam/camera.hpp"
+
+#include <esp_camera.h>
+#include <esp_heap_caps.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#define CAPTURE_MAX_FAILS 5
+
+#if CAPTURE_BUFFER_COUNT < 2 || CAPTURE_BUFFER_COUNT > 4
+#error "CAPTURE_BUFFER_COUNT must be between 2 and 4"
+#endif
+
+extern bool isCameraActive;
+
+static portMUX_TYPE captureMux = portMUX_INITIALIZER_UNLOCKED;
+static CapturedFrame capturePool[CAPTURE_BUFFER_COUNT];
+static CapturedFrame *latestFrame = NULL;
+static uint32_t nextSeq = 1;
+static int captureSubscribers = 0;
+static TaskHandle_t captureTaskHandle = NULL;
+
+// zdjęcie w wysokiej rozdzielczości zlecone przez serwer WWW
+// dwa bufory - poprzednie zdjęcie może być jeszcze wysyłane albo trzymane przez cache
+static CapturedFrame stillFrames[2];
+static CapturedFrame *stillFrame = NULL;
+static framesize_t stillRequest = FRAMESIZE_INVALID;
+static bool stillReady = false;
+static TaskHandle_t stillWaiter = NULL;
+static framesize_t stillCeiling = CAMERA_MAX_FRAMESIZE;
+static unsigned long lastStillTime = 0;
+static unsigned long lastInterruption = 0;
+static StillStats stillStats;
+
+static uint32_t capturedFrames = 0;
+static uint32_t captureFailures = 0;
+static uint32_t noFreeBuffer = 0;
+static float captureFps = 0;
+static float copyTimeAvg = 0;
+
+// wolny bufor: nikt go nie wysyła i nie jest najnowszą klatką
+static CapturedFrame *findFreeSlot()
+{
+  CapturedFrame *slot = NULL;
+  portENTER_CRITICAL(&captureMux);
+  for (int i = 0; i < CAPTURE_BUFFER_COUNT; i++)
+  {
+    if (capturePool[i].refs == 0 && &capturePool[i] != latestFrame)
+    {
+      slot = &capturePool[i];
+      break;
+    }
+  }
+  portEXIT_CRITICAL(&captureMux);
+  return slot;
+}
+
+static bool reserveSlot(CapturedFrame *slot, size_t len)
+{
+  if (len <= slot->capacity)
+    return true;
+
+  free(slot->buf);
+  slot->capacity = 0;
+  // zapas, żeby nie realokować przy każdej większej klatce
+  size_t capacity = len + len / 4;
+  slot->buf = static_cast<uint8_t *>(heap_caps_malloc(capacity, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
+  if (slot->buf == NULL)
+    slot->buf = static_cast<uint8_t *>(malloc(capacity));
+  if (slot->buf == NULL)
+    return false;
+
+  slot->capacity = capacity;
+  return true;
+}
+
+bool storeFrame(CapturedFrame *slot, const uint8_t *buf, size_t len)
+{
+  if (!reserveSlot(slot, len))
+    return false;
+
+  memcpy(slot->buf, buf, len);
+  slot->len = len;
+  slot->hasSignature = false;
+  return true;
+}
+
+static void takeStill(framesize_t frameSize)
+{
+  unsigned long start = millis();
+
+  // najpierw zmiany czekające w kolejce, żeby rozdzielczość strumienia była aktualna
+  esp32cam::Camera.processPending();
+  sensor_t *s = esp_camera_sensor_get();
+  framesize_t streamSize = s->status.framesize;
+
+  if (frameSize != streamSize)
+  {
+    esp32cam::Camera.changeResolutionAsync(esp32cam::Resolution(frameSize), STILL_DISCARD_FRAMES);
+    esp32cam::Camera.processPending();
+  }
+
+  CapturedFrame *slot = NULL;
+  portENTER_CRITICAL(&captureMux);
+  for (int i = 0; i < 2 && !slot; i++)
+  {
+    if (stillFrames[i].refs == 0)
+      slot = &stillFrames[i];
+  }
+  portEXIT_CRITICAL(&captureMux);
+
+  bool ok = false;
+  camera_fb_t *fb = getCameraFrame();
+  if (fb && slot)
+  {
+    ok = storeFrame(slot, fb->buf, fb->len);
+    slot->timestamp = frameTimestamp(fb);
+  }
+  if (fb)
+    returnCameraFrame(fb);
+
+  // powrót do rozdzielczości strumienia, również z odrzuceniem niestabilnych klatek
+  if (frameSize != streamSize)
+  {
+    esp32cam::Camera.changeResolutionAsync(esp32cam::Resolution(streamSize), RESOLUTION_DISCARD_FRAMES);
+    esp32cam::Camera.processPending();
+  }
+
+  unsigned long interruption = millis() - start;
+  // za długa przerwa - kolejne zdjęcia o szczebel niżej
+  bool overrun = interruption > STILL_MAX_INTERRUPTION;
+  if (overrun && frameSize > streamSize)
+    stillCeiling = static_cast<framesize_t>(frameSize - 1);
+  // z dużym zapasem - ponowna próba szczebel wyżej
+  else if (ok && frameSize == stillCeiling && stillCeiling < CAMERA_MAX_FRAMESIZE &&
+           interruption < STILL_MAX_INTERRUPTION / 2)
+    stillCeiling = static_cast<framesize_t>(stillCeiling + 1);
+
+  TaskHandle_t waiter;
+  portENTER_CRITICAL(&captureMux);
+  if (ok)
+  {
+    // numer z licznika strumienia - X-Sequence i afterSeq w ml_frame porównują go z klatkami puli
+    slot->seq = nextSeq++;
+    slot->captureTime = start;
+    stillFrame = slot;
+  }
+  stillReady = ok;
+  stillRequest = FRAMESIZE_INVALID;
+  lastInterruption = interruption;
+  stillStats.stills += ok ? 1 : 0;
+  stillStats.failures += ok ? 0 : 1;
+  stillStats.overruns += overrun ? 1 : 0;
+  stillStats.maxInterruption = max(stillStats.maxInterruption, interruption);
+  waiter = stillWaiter;
+  stillWaiter = NULL;
+  portEXIT_CRITICAL(&captureMux);
+
+  if (waiter)
+    xTaskNotifyGive(waiter);
+}
+
+static void captureTask(void *parameter)
+{
+  int failCount = 0;
+  unsigned long lastFrameTime = millis();
+
+  while (true)
+  {
+    if (captureSubscribers == 0 || !isCameraActive)
+    {
+      ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(500));
+      continue;
+    }
+
+    // zdjęcie zlecone przez serwer WWW - wykonywane między klatkami strumienia
+    if (stillRequest != FRAMESIZE_INVALID)
+    {
+      takeStill(stillRequest);
+      continue;
+    }
+
+    // zmiany konfiguracji kamery (drabinka, /camera/resolution) są stosowane tylko między
+    // klatkami; niestabilne klatki po zmianie są odrzucane i nie trafiają do puli
+    updateResolutionLadder();
+    esp32cam::Camera.processPending();
+
+    CapturedFrame *slot = findFreeSlot();
+    if (!slot)
+    {
+      // wszyscy klienci jeszcze wysyłają - sensor czeka, aż zwolni się bufor
+      noFreeBuffer++;
+      delay(2);
+      continue;
+    }
+
+    camera_fb_t *fb = getCameraFrame();
+    if (!fb)
+    {
+      Serial.println("Camera capture failed");
+      captureFailures++;
+
+      // shutdown kamery jak za duzo błędów
+      if (++failCount >= CAPTURE_MAX_FAILS)
+      {
+        Serial.println("Too many camera failures, shutting down camera");
+        isCameraActive = false;
+        failCount = 0;
+      }
+      delay(100);
+      continue;
+    }
+    failCount = 0;
+
+    // korekta jakości między klatkami - rozmiar kolejnych klatek zbliża się do budżetu
+    updateRateControl(fb->len);
+
+    unsigned long copyStart = micros();
+    bool ok = reserveSlot(slot, fb->len);
+    if (ok)
+    {
+      memcpy(slot->buf, fb->buf, fb->len);
+      slot->len = fb->len;
+      slot->hasSignature = false;
+      slot->timestamp = frameTimestamp(fb);
+    }
+    returnCameraFrame(fb);
+    if (!ok)
+    {
+      Serial.println("Capture buffer allocation failed");
+      delay(100);
+      continue;
+    }
+
+    unsigned long now = millis();
+    copyTimeAvg = copyTimeAvg * 0.9f + (micros() - copyStart) / 1000.0f * 0.1f;
+    if (now > lastFrameTime)
+      captureFps = captureFps * 0.9f + 1000.0f / (now - lastFrameTime) * 0.1f;
+    lastFrameTime = now;
+
+    // publikacja nowej klatki
+    portENTER_CRITICAL(&captureMux);
+    slot->seq = nextSeq++;
+    slot->captureTime = now;
+    latestFrame = slot;
+    capturedFrames++;
+    portEXIT_CRITICAL(&captureMux);
+  }
+}
+
+bool startCapturePipeline()
+{
+  if (captureTaskHandle)
+    return true;
+
+  memset(capturePool, 0, sizeof(capturePool));
+  memset(stillFrames, 0, sizeof(stillFrames));
+  return xTaskCreatePinnedToCore(
+             captureTask,
+             "CaptureTask",
+             4096,
+             NULL,
+             1,
+             &captureTaskHandle,
+             CAPTURE_TASK_CORE) == pdPASS;
+}
+
+uint32_t takeFrameSeq()
+{
+  portENTER_CRITICAL(&captureMux);
+  uint32_t seq = nextSeq++;
+  portEXIT_CRITICAL(&captureMux);
+  return seq;
+}
+
+void captureSubscribe()
+{
+  portENTER_CRITICAL(&captureMux);
+  captureSubscribers++;
+  portEXIT_CRITICAL(&captureMux);
+
+  if (captureTaskHandle)
+    xTaskNotifyGive(captureTaskHandle);
+}
+
+void captureUnsubscribe()
+{
+  portENTER_CRITICAL(&captureMux);
+  if (captureSubscribers > 0)
+    captureSubscribers--;
+  portEXIT_CRITICAL(&captureMux);
+}
+
+bool isCaptureRunning()
+{
+  return captureTaskHandle && captureSubscribers > 0 && isCameraActive;
+}
+
+CapturedFrame *acquireLatestFrame(uint32_t afterSeq)
+{
+  CapturedFrame *frame = NULL;
+  portENTER_CRITICAL(&captureMux);
+  if (latestFrame && (int32_t)(latestFrame->seq - afterSeq) > 0)
+  {
+    frame = latestFrame;
+    frame->refs++;
+  }
+  portEXIT_CRITICAL(&captureMux);
+  return frame;
+}
+
+void retainFrame(CapturedFrame *frame)
+{
+  portENTER_CRITICAL(&captureMux);
+  frame->refs++;
+  portEXIT_CRITICAL(&captureMux);
+}
+
+void releaseFrame(CapturedFrame *frame)
+{
+  if (!frame)
+    return;
+
+  portENTER_CRITICAL(&captureMux);
+  frame->refs--;
+  portEXIT_CRITICAL(&captureMux);
+}
+
+CaptureStats getCaptureStats()
+{
+  CaptureStats stats;
+  stats.bufferCount = CAPTURE_BUFFER_COUNT;
+  stats.frames = capturedFrames;
+  stats.failures = captureFailures;
+  stats.noFreeBuffer = noFreeBuffer;
+  stats.fps = captureFps;
+  stats.copyTimeAvg = copyTimeAvg;
+  return stats;
+}
+
+StillStatus captureStill(framesize_t frameSize, CapturedFrame *&frame, unsigned long &interruption)
+{
+  frame = NULL;
+  if (!isCaptureRunning())
+    return STILL_FAILED;
+
+  // powiadomienie spóźnione po przekroczeniu czasu poprzedniego zdjęcia
+  ulTaskNotifyTake(pdTRUE, 0);
+
+  unsigned long now = millis();
+  portENTER_CRITICAL(&captureMux);
+  bool limited = stillRequest != FRAMESIZE_INVALID ||
+                 (lastStillTime && now - lastStillTime < STILL_MIN_INTERVAL);
+  if (limited)
+  {
+    stillStats.rateLimited++;
+  }
+  else
+  {
+    lastStillTime = now;
+    stillReady = false;
+    stillWaiter = xTaskGetCurrentTaskHandle();
+    stillRequest = frameSize > stillCeiling ? stillCeiling : frameSize;
+  }
+  portEXIT_CRITICAL(&captureMux);
+
+  if (limited)
+    return STILL_RATE_LIMITED;
+
+  xTaskNotifyGive(captureTaskHandle);
+  ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(STILL_TIMEOUT));
+
+  portENTER_CRITICAL(&captureMux);
+  // po przekroczeniu czasu task przechwytywania nie budzi już tego wątku
+  stillWaiter = NULL;
+  bool ok = stillReady && stillRequest == FRAMESIZE_INVALID;
+  if (ok)
+  {
+    stillReady = false;
+    stillFrame->refs++;
+    frame = stillFrame;
+  }
+  interruption = lastInterruption;
+  portEXIT_CRITICAL(&captureMux);
+
+  return ok ? STILL_OK : STILL_FAILED;
+}
+
+StillStats getStillStats()
+{
+  portENTER_CRITICAL(&captureMux);
+  StillStats stats = stillStats;
+  portEXIT_CRITICAL(&captureMux);
+
+  stats.lastInterruption = lastInterruption;
+  esp32cam::Resolution ceiling(stillCeiling);
+  stats.ceilingWidth = ceiling.getWidth();
+  stats.ceilingHeight = ceiling.getHeight();
+  return stats;
+}
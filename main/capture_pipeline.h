@@ -0,0 +1,91 @@
+#ifndef CAPTURE_PIPELINE_H
+#define CAPTURE_PIPELINE_H
+
+#include <Arduino.h>
+#include <esp_camera.h>
+
+#include "config.h"
+
+// Klatka przechwycona przez potok - kopia JPEG w buforze PSRAM z licznikiem referencji
+struct CapturedFrame
+{
+  uint8_t *buf;
+  size_t capacity;
+  size_t len;
+  uint32_t seq;              // numer kolejny klatki
+  unsigned long captureTime; // millis() w chwili przechwycenia
+  int64_t timestamp;         // czas przechwycenia ze sterownika kamery (µs, zegar esp_timer)
+  int refs;                  // liczba klientów trzymających klatkę
+  // sygnatura luminancji do detekcji ruchu, liczona przy pierwszym użyciu (motion_gate)
+  uint8_t signature[MOTION_GRID_WIDTH * MOTION_GRID_HEIGHT];
+  bool hasSignature;
+};
+
+struct CaptureStats
+{
+  int bufferCount;         // liczba buforów w puli
+  uint32_t frames;         // przechwycone klatki
+  uint32_t failures;       // nieudane przechwycenia
+  uint32_t noFreeBuffer;   // klatki pominięte, bo wszystkie bufory były zajęte
+  float fps;               // średnia krocząca liczby klatek na sekundę
+  float copyTimeAvg;       // średni czas kopiowania klatki do puli (ms)
+};
+
+// Potok przechwytywania: task na rdzeniu CAPTURE_TASK_CORE przechwytuje klatki do puli
+// CAPTURE_BUFFER_COUNT buforów PSRAM, a workery strumienia wysyłają je na drugim rdzeniu.
+bool startCapturePipeline();
+
+// Potok pracuje tylko, gdy ma subskrybentów
+void captureSubscribe();
+void captureUnsubscribe();
+
+// czy task przechwytuje klatki (są subskrybenci i kamera jest aktywna)
+bool isCaptureRunning();
+
+// Kolejny numer klatki - jeden licznik dla klatek strumienia i zdjęć
+uint32_t takeFrameSeq();
+
+// Najnowsza klatka o numerze większym niż `afterSeq` (z referencją) lub NULL
+CapturedFrame *acquireLatestFrame(uint32_t afterSeq);
+void retainFrame(CapturedFrame *frame);
+void releaseFrame(CapturedFrame *frame);
+
+// kopia JPEG do bufora klatki (PSRAM, z zapasem przy powiększaniu)
+bool storeFrame(CapturedFrame *slot, const uint8_t *buf, size_t len);
+
+// znacznik czasu bufora kamery w µs (zegar esp_timer_get_time())
+inline int64_t frameTimestamp(const camera_fb_t *fb)
+{
+  return (int64_t)fb->timestamp.tv_sec * 1000000 + fb->timestamp.tv_usec;
+}
+
+CaptureStats getCaptureStats();
+
+enum StillStatus
+{
+  STILL_OK,
+  STILL_RATE_LIMITED, // poprzednie zdjęcie zbyt niedawno
+  STILL_FAILED
+};
+
+struct StillStats
+{
+  uint32_t stills;                  // wykonane zdjęcia
+  uint32_t failures;                // nieudane zdjęcia
+  uint32_t rateLimited;             // żądania odrzucone przez STILL_MIN_INTERVAL
+  uint32_t overruns;                // przerwy dłuższe niż STILL_MAX_INTERRUPTION
+  unsigned long lastInterruption;   // przerwa w strumieniu przy ostatnim zdjęciu (ms)
+  unsigned long maxInterruption;
+  int ceilingWidth;                 // największa dopuszczalna rozdzielczość zdjęcia
+  int ceilingHeight;
+};
+
+// Zdjęcie w rozdzielczości `frameSize` w trakcie strumienia: task przechwytywania między
+// klatkami przełącza rozdzielczość, odrzuca niestabilne klatki, robi zdjęcie i wraca do
+// rozdzielczości strumienia. Przy STILL_OK `frame` ma referencję do zwolnienia przez releaseFrame().
+// Rozdzielczość, przy której przerwa przekroczyła STILL_MAX_INTERRUPTION, jest dalej obniżana.
+StillStatus captureStill(framesize_t frameSize, CapturedFrame *&frame, unsigned long &interruption);
+
+StillStats getStillStats();
+
+#endif // CAPTURE_PIPELINE_H
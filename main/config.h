@@ -26,4 +26,87 @@
 #define GATEWAY_ADDRESS 192,168,4,1
 #define SUBNET_MASK 255,255,255,0
 
+// Ustawienia API
+#define API_BODY_MAX_SIZE 256   // Maksymalny rozmiar ciała żądania POST (bajty), większe dostają 413
+
+// Priorytety ruchu: sterowanie ma pierwszeństwo przed strumieniem kamery
+#define CONTROL_LATENCY_BUDGET 60      // Budżet opóźnienia sterowania (ms), powyżej dławimy kamerę
+#define CONTROL_PING_INTERVAL 1000     // Co ile ms wysyłany jest ping do klientów WebSocket
+#define CONTROL_RTT_MAX 5000           // Dłuższe RTT z odpowiedzi pong jest odrzucane jako błędne (ms)
+#define CONTROL_RTT_EXPIRY (3 * CONTROL_PING_INTERVAL) // Bez pong przez ten czas RTT przestaje dławić kamerę (ms)
+#define TRAFFIC_GOVERNOR_INTERVAL 100  // Co ile ms regulator koryguje limit strumienia
+#define STREAM_MAX_RATE 400000         // Maksymalna przepływność strumienia kamery (B/s)
+#define STREAM_MIN_RATE 40000          // Minimalna przepływność przy dławieniu (B/s)
+#define STREAM_RATE_STEP 20000         // Krok powrotu limitu po ustąpieniu przeciążenia (B/s)
+
+// Pula workerów strumienia MJPEG (tworzona raz przy starcie)
+#define STREAM_WORKER_COUNT 2          // Maksymalna liczba jednoczesnych strumieni /stream
+#define STREAM_WORKER_STACK 8192       // Rozmiar stosu workera (bajty)
+
+// Potok przechwytywania klatek (przechwytywanie i wysyłka na osobnych rdzeniach)
+#define CAPTURE_BUFFER_COUNT 3         // Liczba buforów klatek w PSRAM (2-4)
+#define CAPTURE_TASK_CORE 1            // Rdzeń taska przechwytywania (workery strumienia na 0)
+
+// Regulator rozmiaru klatki JPEG (jakość sensora 0-63, mniejsza wartość = lepsza jakość)
+#define JPEG_QUALITY_INITIAL 47        // Jakość początkowa
+#define JPEG_QUALITY_BEST 10           // Najlepsza jakość, na jaką może zejść regulator
+#define JPEG_QUALITY_WORST 63          // Najgorsza jakość
+#define JPEG_TARGET_FRAME_SIZE 15000   // Budżet bajtów na klatkę (0 - regulator wyłączony)
+#define JPEG_RATE_HYSTERESIS 15        // Pasmo bez zmian wokół budżetu (%)
+#define JPEG_RATE_HOLD_FRAMES 3        // Minimalna liczba klatek między zmianami jakości
+#define STREAM_FRAME_INTERVAL 100      // Minimalny odstęp między klatkami strumienia (ms)
+
+// Drabinka rozdzielczości strumienia (QQVGA -> QVGA -> CIF -> VGA)
+#define RESOLUTION_WINDOW 1000         // Okno pomiarowe przepływności i czasu wysyłki (ms)
+#define RESOLUTION_UP_DWELL 5000       // Czas zapasu łącza przed zwiększeniem rozdzielczości (ms)
+#define RESOLUTION_DOWN_DWELL 1500     // Czas przeciążenia łącza przed zmniejszeniem rozdzielczości (ms)
+#define RESOLUTION_MIN_HOLD 3000       // Minimalny czas na szczeblu po zmianie (ms)
+#define RESOLUTION_UP_MAX_QUALITY 30   // Najgorsza jakość JPEG, przy której wolno zwiększyć rozdzielczość
+#define RESOLUTION_DISCARD_FRAMES 2    // Klatki odrzucane po zmianie rozdzielczości
+
+// Zdjęcia w wysokiej rozdzielczości w trakcie strumienia
+#define CAMERA_MAX_FRAMESIZE FRAMESIZE_SXGA // Rozdzielczość inicjalizacji (rozmiar buforów w PSRAM)
+#define STILL_FRAMESIZE FRAMESIZE_VGA  // Domyślna rozdzielczość zdjęcia
+#define STILL_DISCARD_FRAMES 2         // Klatki odrzucane po przełączeniu na rozdzielczość zdjęcia
+#define STILL_MAX_INTERRUPTION 1000    // Maksymalna przerwa w strumieniu na zdjęcie (ms)
+#define STILL_MIN_INTERVAL 2000        // Minimalny odstęp między zdjęciami w trakcie strumienia (ms)
+#define STILL_TIMEOUT 3000             // Maksymalny czas oczekiwania na zdjęcie (ms)
+#define STILL_CACHE_WINDOW 500         // Okno świeżości wspólnego zdjęcia dla /capture (ms)
+
+// Tensor luminancji dla modelu (/ml/frame i WebSocket)
+#define ML_TENSOR_WIDTH 64             // Domyślna szerokość tensora
+#define ML_TENSOR_HEIGHT 48            // Domyślna wysokość tensora
+#define ML_TENSOR_MAX_WIDTH 160        // Maksymalna szerokość tensora
+#define ML_TENSOR_MAX_HEIGHT 120       // Maksymalna wysokość tensora
+#define ML_PUSH_MIN_INTERVAL 50        // Minimalny odstęp wysyłki tensora przez WebSocket (ms)
+
+// Kroki lockstep przez WebSocket ({"command":"step",...})
+#define ML_STEP_DEFAULT_PERIOD 100     // Domyślny okres sterowania (ms)
+#define ML_STEP_MAX_PERIOD 2000        // Najdłuższy okres sterowania (ms)
+#define ML_STEP_FRAME_TIMEOUT 500      // Oczekiwanie na klatkę po okresie, potem najnowsza starsza (ms)
+#define ML_STEP_IDLE_TIMEOUT 5000      // Koniec sesji kroków (i subskrypcji kamery) bez kroków (ms)
+
+// Miniatura ze współczynników DC JPEG (/capture?thumb=1)
+#define DC_THUMB_MAX_PIXELS 30000      // Bufor miniatury: (1600 / 8) * (1200 / 8) dla UXGA
+
+// Bramkowanie strumienia ruchem (/stream?motion=...)
+#define MOTION_GATE_ENABLED false      // Domyślnie wyłączone - klient włącza je przez ?motion=1
+#define MOTION_GRID_WIDTH 16           // Siatka sygnatury luminancji klatki (komórki)
+#define MOTION_GRID_HEIGHT 12
+#define MOTION_THRESHOLD 12            // Zmiana jasności komórki (0-255), od której klatka jest wysyłana
+#define MOTION_KEEPALIVE 5000          // Maksymalny odstęp między klatkami bez ruchu (ms)
+
+// Monitor pamięci (/camera/status)
+#define HEAP_MONITOR_INTERVAL 1000     // Okres próbkowania wolnej pamięci i największego bloku (ms)
+
+// Rejestrator zbioru uczącego (/dataset/...)
+#define DATASET_STORAGE_SD true        // true - karta SD (SD_MMC, tryb 1-bit), false - LittleFS
+#define DATASET_DIR "/dataset"         // Katalog nagrań
+#define DATASET_MAX_RECORDS 18000      // Pojemność indeksu (30 min przy 10 rekordach/s), potem koniec nagrania
+#define DATASET_RECORD_INTERVAL 100    // Domyślny odstęp między rekordami (ms)
+#define DATASET_FLUSH_RECORDS 20       // Rekordy między flush() - tyle najwyżej ginie przy zaniku zasilania
+#define DATASET_DISTANCE_INTERVAL 100  // Odstęp pomiarów odległości w trakcie nagrywania (ms)
+#define DATASET_RECORDER_CORE 0        // Rdzeń taska zapisu (przechwytywanie na CAPTURE_TASK_CORE)
+#define DATASET_DOWNLOAD_CHUNK 4096    // Bufor wysyłki pliku (bajty)
+
 #endif // CONFIG_H
\ No newline at end of file
@@ -0,0 +1,582 @@
+#include "dataset_recorder.h"
+#include "config.h"
+#include "capture_pipeline.h"
+#include "motor_control.h"
+#include "sensor_control.h"
+#include "vehicle_state.h"
+#include "request_stats.h"
+
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#if DATASET_STORAGE_SD
+#include <SD_MMC.h>
+#define DATASET_FS SD_MMC
+#else
+#include <LittleFS.h>
+#define DATASET_FS LittleFS
+#endif
+
+#define DATASET_START_TIMEOUT 2000 // czas na otwarcie pliku przez task (ms)
+#define DATASET_STOP_TIMEOUT 3000  // czas na zapis indeksu przez task (ms)
+
+
+struct IndexEntry
+{
+  uint32_t offset;
+  uint32_t seq;
+  int64_t timestamp;
+};
+
+static bool storageReady = false;
+static TaskHandle_t recorderTaskHandle = NULL;
+static volatile DatasetRecorderState state = DATASET_IDLE;
+
+// plik i bufory należą do taska zapisu; pętla główna zmienia tylko `state`
+static File file;
+static char filePath[48];
+static unsigned long recordInterval = DATASET_RECORD_INTERVAL;
+static IndexEntry *recordIndex = NULL;
+static uint8_t *staging = NULL; // nagłówek rekordu + JPEG + wyrównanie, zapisywane jednym write()
+static size_t stagingCapacity = 0;
+static uint32_t fileSize = 0;
+static unsigned long recordStart = 0;
+static unsigned long lastDistanceTime = 0;
+static DatasetRecorderStats stats;
+
+static void writeU16(uint8_t *p, uint16_t v)
+{
+  p[0] = v & 0xFF;
+  p[1] = v >> 8;
+}
+
+static void writeU32(uint8_t *p, uint32_t v)
+{
+  for (int i = 0; i < 4; i++)
+    p[i] = (v >> (8 * i)) & 0xFF;
+}
+
+static void writeU64(uint8_t *p, uint64_t v)
+{
+  for (int i = 0; i < 8; i++)
+    p[i] = (v >> (8 * i)) & 0xFF;
+}
+
+static bool writeAll(const uint8_t *buf, size_t len)
+{
+  if (file.write(buf, len) != len)
+    return false;
+  fileSize += len;
+  return true;
+}
+
+static bool reserveStaging(size_t len)
+{
+  if (len <= stagingCapacity)
+    return true;
+
+  free(staging);
+  stagingCapacity = 0;
+  // zapas, żeby nie realokować przy każdej większej klatce
+  size_t capacity = len + len / 4;
+  staging = static_cast<uint8_t *>(heap_caps_malloc(capacity, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
+  if (staging == NULL)
+    return false;
+
+  stagingCapacity = capacity;
+  return true;
+}
+
+static bool openRecording()
+{
+  recordIndex = static_cast<IndexEntry *>(heap_caps_malloc(DATASET_MAX_RECORDS * sizeof(IndexEntry), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
+  if (!recordIndex)
+    return false;
+
+  file = DATASET_FS.open(filePath, FILE_WRITE);
+
+  uint8_t header[DATASET_HEADER_SIZE] = {0};
+  memcpy(header, "NVDS", 4);
+  writeU16(header + 4, DATASET_VERSION);
+  writeU16(header + 6, DATASET_RECORD_HEADER_SIZE);
+  writeU64(header + 8, esp_timer_get_time());
+  writeU32(header + 16, recordInterval);
+  fileSize = 0;
+  if (file && writeAll(header, sizeof(header)))
+    return true;
+
+  file.close();
+  free(recordIndex);
+  recordIndex = NULL;
+  return false;
+}
+
+// indeks i stopka; bez nich czytnik przechodzi plik rekord po rekordzie
+static bool closeRecording()
+{
+  uint32_t indexOffset = fileSize;
+  uint8_t buf[8 + 32 * DATASET_INDEX_ENTRY_SIZE];
+  memcpy(buf, "NVIX", 4);
+  writeU32(buf + 4, stats.records);
+  bool ok = writeAll(buf, 8);
+
+  for (uint32_t i = 0; ok && i < stats.records;)
+  {
+    size_t n = 0;
+    for (; n < 32 && i < stats.records; n++, i++)
+    {
+      uint8_t *entry = buf + n * DATASET_INDEX_ENTRY_SIZE;
+      writeU32(entry, recordIndex[i].offset);
+      writeU32(entry + 4, recordIndex[i].seq);
+      writeU64(entry + 8, recordIndex[i].timestamp);
+    }
+    ok = writeAll(buf, n * DATASET_INDEX_ENTRY_SIZE);
+  }
+
+  uint8_t trailer[DATASET_TRAILER_SIZE] = {0};
+  memcpy(trailer, "NVEN", 4);
+  writeU32(trailer + 4, indexOffset);
+  writeU32(trailer + 8, stats.records);
+  ok = ok && writeAll(trailer, sizeof(trailer));
+
+  file.close();
+  free(recordIndex);
+  recordIndex = NULL;
+  free(staging);
+  staging = NULL;
+  stagingCapacity = 0;
+  stats.bytes = fileSize;
+  return ok;
+}
+
+// rekord najnowszej klatki; bufor potoku jest trzymany tylko na czas kopiowania do `staging`,
+// więc wolny zapis nie zabiera klatek strumieniom
+static bool recordFrame(CapturedFrame *frame)
+{
+  size_t padding = (4 - frame->len % 4) % 4;
+  size_t len = DATASET_RECORD_HEADER_SIZE + frame->len + padding;
+  if (!reserveStaging(len))
+  {
+    releaseFrame(frame);
+    return false;
+  }
+
+  uint8_t *header = staging;
+  memcpy(staging + DATASET_RECORD_HEADER_SIZE, frame->buf, frame->len);
+  memset(staging + DATASET_RECORD_HEADER_SIZE + frame->len, 0, padding);
+  uint32_t seq = frame->seq;
+  int64_t timestamp = frame->timestamp;
+  size_t jpegLen = frame->len;
+  releaseFrame(frame);
+
+  // stan pojazdu w chwili przechwycenia klatki, nie zapisu
+  MotorSpeeds speeds = getMotorSpeedsAt(timestamp);
+  DistanceReading distance = getFilteredDistance();
+
+  memset(header, 0, DATASET_RECORD_HEADER_SIZE);
+  memcpy(header, "NVFR", 4);
+  writeU32(header + 4, jpegLen);
+  writeU32(header + 8, seq);
+  writeU32(header + 12, distance.distance < 0 ? 0 : (int32_t)((timestamp - distance.timestamp) / 1000));
+  writeU64(header + 16, timestamp);
+  writeU16(header + 24, speeds.left);
+  writeU16(header + 26, speeds.right);
+  writeU16(header + 28, distance.distance < 0 ? 0 : (uint16_t)(distance.distance * 10));
+  header[30] = vehicle.mode == ML_CONTROL ? 1 : 0;
+  header[31] = speeds.known ? 0 : DATASET_RECORD_SPEEDS_UNCERTAIN;
+
+  uint32_t offset = fileSize;
+  if (!writeAll(staging, len))
+    return false;
+
+  recordIndex[stats.records++] = {offset, seq, timestamp};
+  stats.bytes = fileSize;
+  if (stats.records % DATASET_FLUSH_RECORDS == 0)
+    file.flush();
+  return true;
+}
+
+static void recorderTask(void *parameter)
+{
+  uint32_t lastSeq = 0;
+  unsigned long nextRecordTime = 0;
+
+  while (true)
+  {
+    if (state == DATASET_STARTING)
+    {
+      lastSeq = 0;
+      nextRecordTime = millis();
+      if (openRecording())
+      {
+        captureSubscribe();
+        recordStart = millis();
+        state = DATASET_RECORDING;
+      }
+      else
+      {
+        state = DATASET_FAILED;
+      }
+      continue;
+    }
+
+    if (state == DATASET_STOPPING)
+    {
+      captureUnsubscribe();
+      bool ok = closeRecording();
+      stats.duration = millis() - recordStart;
+      state = ok && stats.writeFailures == 0 ? DATASET_IDLE : DATASET_FAILED;
+      Serial.printf("Dataset %s: %u records, %u B\n", filePath, stats.records, stats.bytes);
+      continue;
+    }
+
+    if (state != DATASET_RECORDING)
+    {
+      ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+      continue;
+    }
+
+    unsigned long now = millis();
+    if ((long)(now - nextRecordTime) < 0)
+    {
+      delay(min<unsigned long>(nextRecordTime - now, 10));
+      continue;
+    }
+
+    CapturedFrame *frame = acquireLatestFrame(lastSeq);
+    if (!frame)
+    {
+      delay(5);
+      continue;
+    }
+    lastSeq = frame->seq;
+
+    unsigned long writeStart = millis();
+    bool ok = recordFrame(frame);
+    unsigned long writeTime = millis() - writeStart;
+    stats.writeTimeAvg = stats.writeTimeAvg * 0.9f + writeTime * 0.1f;
+    stats.writeTimeMax = max(stats.writeTimeMax, writeTime);
+    stats.duration = millis() - recordStart;
+    if (writeTime > recordInterval)
+      stats.overruns++;
+
+    if (!ok)
+    {
+      // pełna karta albo błąd zapisu - dotychczasowe rekordy zostają, z indeksem
+      stats.writeFailures++;
+      state = DATASET_STOPPING;
+    }
+    else if (stats.records >= DATASET_MAX_RECORDS)
+    {
+      stats.indexFull = true;
+      state = DATASET_STOPPING;
+    }
+    nextRecordTime = now + recordInterval;
+  }
+}
+
+static bool isRecording()
+{
+  return state == DATASET_STARTING || state == DATASET_RECORDING || state == DATASET_STOPPING;
+}
+
+// nazwa pliku z parametru - bez ścieżek
+static bool isValidDatasetName(const String &name)
+{
+  if (name.length() == 0 || name.length() > 24 || name[0] == '.')
+    return false;
+  for (size_t i = 0; i < name.length(); i++)
+  {
+    char c = name[i];
+    if (!isalnum(c) && c != '_' && c != '-' && c != '.')
+      return false;
+  }
+  return true;
+}
+
+static String baseName(const char *path)
+{
+  String name(path);
+  int slash = name.lastIndexOf('/');
+  return slash >= 0 ? name.substring(slash + 1) : name;
+}
+
+// kolejny numer nagrania: rec_0001.nvds, rec_0002.nvds, ...
+static int nextRecordingNumber()
+{
+  int next = 1;
+  File dir = DATASET_FS.open(DATASET_DIR);
+  if (!dir || !dir.isDirectory())
+    return next;
+  for (File entry = dir.openNextFile(); entry; entry = dir.openNextFile())
+  {
+    String name = baseName(entry.name());
+    if (name.startsWith("rec_") && name.endsWith(".nvds"))
+      next = max(next, (int)name.substring(4).toInt() + 1);
+  }
+  return next;
+}
+
+static const char *stateName(DatasetRecorderState s)
+{
+  switch (s)
+  {
+  case DATASET_STARTING:
+    return "starting";
+  case DATASET_RECORDING:
+    return "recording";
+  case DATASET_STOPPING:
+    return "stopping";
+  case DATASET_FAILED:
+    return "failed";
+  case DATASET_IDLE:
+  default:
+    return "idle";
+  }
+}
+
+static String statsJson()
+{
+  DatasetRecorderStats s = getDatasetRecorderStats();
+  return String("{\"state\":\"") + stateName(s.state) + "\"" +
+         ",\"file\":\"" + s.file + "\"" +
+         ",\"records\":" + String(s.records) +
+         ",\"bytes\":" + String(s.bytes) +
+         ",\"duration\":" + String(s.duration) +
+         ",\"write_time_avg\":" + String(s.writeTimeAvg, 2) +
+         ",\"write_time_max\":" + String(s.writeTimeMax) +
+         ",\"overruns\":" + String(s.overruns) +
+         ",\"write_failures\":" + String(s.writeFailures) +
+         ",\"index_full\":" + String(s.indexFull ? "true" : "false") +
+         ",\"storage\":\"" + (DATASET_STORAGE_SD ? "sd" : "littlefs") + "\"" +
+         ",\"storage_ready\":" + String(storageReady ? "true" : "false") + "}";
+}
+
+static void sendJson(WebServer &server, int code, const String &json)
+{
+  server.sendHeader("Access-Control-Allow-Origin", "*");
+  server.send(code, "application/json", json);
+}
+
+static void waitWhile(DatasetRecorderState waitState, unsigned long timeout)
+{
+  unsigned long start = millis();
+  while (state == waitState && millis() - start < timeout)
+    delay(10);
+}
+
+static void handleDatasetStart(WebServer &server)
+{
+  if (!storageReady)
+  {
+    sendJson(server, 503, "{\"success\":false,\"message\":\"Storage not available\"}");
+    return;
+  }
+  if (isRecording())
+  {
+    sendJson(server, 409, "{\"success\":false,\"message\":\"Already recording\"}");
+    return;
+  }
+
+  recordInterval = server.hasArg("interval") ? constrain((unsigned long)server.arg("interval").toInt(), 20UL, 10000UL)
+                                             : DATASET_RECORD_INTERVAL;
+  snprintf(filePath, sizeof(filePath), "%s/rec_%04d.nvds", DATASET_DIR, nextRecordingNumber());
+
+  memset(&stats, 0, sizeof(stats));
+  strncpy(stats.file, baseName(filePath).c_str(), sizeof(stats.file) - 1);
+  state = DATASET_STARTING;
+  xTaskNotifyGive(recorderTaskHandle);
+  waitWhile(DATASET_STARTING, DATASET_START_TIMEOUT);
+
+  if (state != DATASET_RECORDING)
+  {
+    sendJson(server, 500, "{\"success\":false,\"message\":\"Cannot open recording\"}");
+    return;
+  }
+  sendJson(server, 200, String("{\"success\":true,\"file\":\"") + stats.file + "\",\"interval\":" + String(recordInterval) + "}");
+}
+
+static void handleDatasetStop(WebServer &server)
+{
+  if (state == DATASET_RECORDING)
+    state = DATASET_STOPPING;
+  waitWhile(DATASET_STOPPING, DATASET_STOP_TIMEOUT);
+  sendJson(server, 200, statsJson());
+}
+
+static void handleDatasetList(WebServer &server)
+{
+  String json = "[";
+  File dir = DATASET_FS.open(DATASET_DIR);
+  if (storageReady && dir && dir.isDirectory())
+  {
+    bool first = true;
+    for (File entry = dir.openNextFile(); entry; entry = dir.openNextFile())
+    {
+      if (entry.isDirectory())
+        continue;
+      json += String(first ? "" : ",") + "{\"name\":\"" + baseName(entry.name()) + "\",\"size\":" + String((uint32_t)entry.size()) + "}";
+      first = false;
+    }
+  }
+  json += "]";
+  sendJson(server, 200, json);
+}
+
+// nagłówek Range z jednym zakresem: "bytes=a-b", "bytes=a-" albo "bytes=-n"
+static bool parseRange(const String &range, size_t size, size_t &start, size_t &end)
+{
+  int dash = range.indexOf('-');
+  if (!range.startsWith("bytes=") || dash < 0 || size == 0)
+    return false;
+
+  String first = range.substring(6, dash);
+  String last = range.substring(dash + 1);
+  if (first.length() == 0)
+  {
+    // ostatnie n bajtów
+    long n = last.toInt();
+    if (n <= 0)
+      return false;
+    start = (size_t)n >= size ? 0 : size - n;
+    end = size - 1;
+    return true;
+  }
+
+  start = first.toInt();
+  end = last.length() == 0 ? size - 1 : min((size_t)last.toInt(), size - 1);
+  return start < size && start <= end;
+}
+
+// pobieranie nagrania; klient może brać plik zakresami i wznawiać przerwane pobieranie -
+// pętla główna (sterowanie) jest zajęta tylko na czas jednego zakresu
+static void handleDatasetFile(WebServer &server)
+{
+  String name = server.arg("name");
+  if (!isValidDatasetName(name))
+  {
+    sendJson(server, 400, "{\"success\":false,\"message\":\"Invalid file name\"}");
+    return;
+  }
+  if (isRecording() && name == stats.file)
+  {
+    sendJson(server, 409, "{\"success\":false,\"message\":\"File is being recorded\"}");
+    return;
+  }
+
+  String path = String(DATASET_DIR) + "/" + name;
+  if (server.method() == HTTP_DELETE)
+  {
+    bool removed = storageReady && DATASET_FS.remove(path);
+    sendJson(server, removed ? 200 : 404, removed ? "{\"success\":true}" : "{\"success\":false,\"message\":\"Not found\"}");
+    return;
+  }
+
+  File f = storageReady ? DATASET_FS.open(path, FILE_READ) : File();
+  if (!f || f.isDirectory())
+  {
+    sendJson(server, 404, "{\"success\":false,\"message\":\"Not found\"}");
+    return;
+  }
+
+  size_t size = f.size();
+  size_t start = 0, end = size - 1;
+  String range = server.header("Range");
+  bool partial = range.startsWith("bytes=") && range.indexOf(',') < 0;
+  if (partial && !parseRange(range, size, start, end))
+  {
+    server.sendHeader("Content-Range", "bytes */" + String((uint32_t)size));
+    server.send(416, "text/plain", "Range not satisfiable");
+    f.close();
+    return;
+  }
+  size_t len = size == 0 ? 0 : end - start + 1;
+
+  server.sendHeader("Access-Control-Allow-Origin", "*");
+  server.sendHeader("Accept-Ranges", "bytes");
+  if (partial)
+    server.sendHeader("Content-Range", "bytes " + String((uint32_t)start) + "-" + String((uint32_t)end) + "/" + String((uint32_t)size));
+  server.setContentLength(len);
+  server.send(partial ? 206 : 200, "application/octet-stream", "");
+
+  static uint8_t chunk[DATASET_DOWNLOAD_CHUNK];
+  WiFiClient client = server.client();
+  f.seek(start);
+  while (len > 0 && client.connected())
+  {
+    size_t n = f.read(chunk, min(len, sizeof(chunk)));
+    if (n == 0 || client.write(chunk, n) != n)
+      break;
+    len -= n;
+  }
+  f.close();
+}
+
+bool setupDatasetRecorder(WebServer &server)
+{
+#if DATASET_STORAGE_SD
+  // tryb 1-bit: karta używa tylko GPIO 2, 14 i 15 - GPIO 12 zostaje dla czujnika odległości
+  storageReady = SD_MMC.begin("/sdcard", true);
+#else
+  storageReady = LittleFS.begin(true);
+#endif
+  if (storageReady && !DATASET_FS.exists(DATASET_DIR))
+    DATASET_FS.mkdir(DATASET_DIR);
+  if (!storageReady)
+    Serial.println("Dataset storage not available");
+
+  // nagłówek Range dla wznawianego pobierania
+  static const char *headerKeys[] = {"Range"};
+  server.collectHeaders(headerKeys, 1);
+
+  server.on("/dataset/start", HTTP_GET, [&]()
+            { RequestTimer timer(REQUEST_DATASET); handleDatasetStart(server); });
+  server.on("/dataset/stop", HTTP_GET, [&]()
+            { RequestTimer timer(REQUEST_DATASET); handleDatasetStop(server); });
+  server.on("/dataset/status", HTTP_GET, [&]()
+            { RequestTimer timer(REQUEST_DATASET); sendJson(server, 200, statsJson()); });
+  server.on("/dataset/list", HTTP_GET, [&]()
+            { RequestTimer timer(REQUEST_DATASET); handleDatasetList(server); });
+  server.on("/dataset/file", HTTP_GET, [&]()
+            { RequestTimer timer(REQUEST_DATASET); handleDatasetFile(server); });
+  server.on("/dataset/file", HTTP_DELETE, [&]()
+            { RequestTimer timer(REQUEST_DATASET); handleDatasetFile(server); });
+
+  if (recorderTaskHandle)
+    return storageReady;
+  return xTaskCreatePinnedToCore(
+             recorderTask,
+             "DatasetRecorder",
+             6144,
+             NULL,
+             1,
+             &recorderTaskHandle,
+             DATASET_RECORDER_CORE) == pdPASS &&
+         storageReady;
+}
+
+void updateDatasetRecorder()
+{
+  if (state != DATASET_RECORDING)
+    return;
+
+  // świeży pomiar z innej ścieżki (WebSocket czujnika, jazda do przodu) wystarcza
+  DistanceReading reading = getFilteredDistance();
+  if (reading.distance >= 0 && esp_timer_get_time() - reading.timestamp < DATASET_DISTANCE_INTERVAL * 1000LL)
+    return;
+
+  unsigned long now = millis();
+  if (now - lastDistanceTime < DATASET_DISTANCE_INTERVAL)
+    return;
+  lastDistanceTime = now;
+  getDistance();
+}
+
+DatasetRecorderStats getDatasetRecorderStats()
+{
+  DatasetRecorderStats result = stats;
+  result.state = state;
+  return result;
+}
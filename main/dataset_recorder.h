@@ -0,0 +1,65 @@
+#ifndef DATASET_RECORDER_H
+#define DATASET_RECORDER_H
+
+#include <Arduino.h>
+#include <WebServer.h>
+
+// Rejestrator zbioru uczącego: rekordy (klatka JPEG, prędkości kół, tryb sterowania,
+// odległość po filtrze) dopasowane czasem przechwycenia klatki, dopisywane do pliku na karcie SD
+// albo w LittleFS. Na końcu pliku indeks rekordów; bez niego (zanik zasilania) plik czyta się
+// sekwencyjnie. Format opisuje README, czytnik to tools/dataset_reader.py.
+//
+// Plik (little-endian):
+//   nagłówek 32 B: "NVDS", u16 wersja, u16 rozmiar nagłówka rekordu,
+//                  i64 start (µs, esp_timer), u32 odstęp rekordów (ms), 12 B zarezerwowane
+//   rekordy:       nagłówek 32 B, JPEG, zera do wyrównania do 4 B
+//                  nagłówek: "NVFR", u32 długość JPEG, u32 numer klatki, i32 wiek pomiaru odległości
+//                  względem klatki (ms), i64 znacznik czasu klatki (µs, esp_timer), i16 prędkość lewego
+//                  i prawego koła (PWM, ujemna - do tyłu), u16 odległość (mm, 0 - brak pomiaru),
+//                  u8 tryb sterowania (0 - web, 1 - ml), u8 flagi (DATASET_RECORD_*)
+//   indeks:        "NVIX", u32 liczba, wpisy 16 B: u32 przesunięcie rekordu, u32 numer klatki,
+//                  i64 znacznik czasu klatki
+//   stopka 16 B:   "NVEN", u32 przesunięcie indeksu, u32 liczba rekordów, 4 B zarezerwowane
+
+#define DATASET_VERSION 1
+#define DATASET_HEADER_SIZE 32
+#define DATASET_RECORD_HEADER_SIZE 32
+#define DATASET_INDEX_ENTRY_SIZE 16
+#define DATASET_TRAILER_SIZE 16
+
+// flagi rekordu
+#define DATASET_RECORD_SPEEDS_UNCERTAIN 0x01 // zmiana prędkości sprzed klatki wypadła z historii
+
+enum DatasetRecorderState
+{
+  DATASET_IDLE,
+  DATASET_STARTING,  // task otwiera plik
+  DATASET_RECORDING,
+  DATASET_STOPPING,  // task dopisuje indeks i zamyka plik
+  DATASET_FAILED     // nie udało się otworzyć pliku albo zapis został przerwany
+};
+
+struct DatasetRecorderStats
+{
+  DatasetRecorderState state;
+  char file[32];             // bieżący albo ostatni plik
+  uint32_t records;
+  uint32_t overruns;         // rekordy zapisywane dłużej niż zadany odstęp (za wolna pamięć)
+  uint32_t writeFailures;
+  uint32_t bytes;            // rozmiar pliku
+  float writeTimeAvg;        // średni czas zapisu rekordu (ms)
+  unsigned long writeTimeMax;
+  unsigned long duration;    // czas nagrywania (ms)
+  bool indexFull;            // nagrywanie zakończone po DATASET_MAX_RECORDS rekordach
+};
+
+// Montowanie pamięci, task zapisu i endpointy /dataset/...
+bool setupDatasetRecorder(WebServer &server);
+
+// Wołane z pętli głównej: w trakcie nagrywania co DATASET_DISTANCE_INTERVAL pomiar odległości
+// (czujnik obsługuje tylko pętla główna)
+void updateDatasetRecorder();
+
+DatasetRecorderStats getDatasetRecorderStats();
+
+#endif // DATASET_RECORDER_H
@@ -0,0 +1,128 @@
+#include "dc_thumbnail.h"
+#include "config.h"
+
+#include "src/esp32cam/jpeg_dc.hpp"
+#include "src/esp32cam/bmp.hpp"
+
+#include <esp_heap_caps.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <new>
+
+using esp32cam::detail::BmpWriter;
+using esp32cam::detail::JpegDcDecoder;
+
+// kawałek odpowiedzi miniatury: dwa pełne segmenty TCP
+#define DC_THUMB_SEND_CHUNK (2 * 1436)
+
+// dekoder trzyma tablice Huffmana (~12 KB) - jeden egzemplarz współdzielony pod mutexem
+static JpegDcDecoder *decoder = NULL;
+static SemaphoreHandle_t decoderLock = NULL;
+
+// bufor miniatury dla /capture?thumb=1 - obsługuje go tylko pętla główna
+static uint8_t *thumbBuffer = NULL;
+// nagłówki i paleta BMP miniatury (1 KB) - także tylko pętla główna
+static BmpWriter thumbBmp;
+
+static DcThumbnailStats stats;
+
+void setupDcThumbnail()
+{
+  if (!decoderLock)
+    decoderLock = xSemaphoreCreateMutex();
+  if (!decoder)
+    decoder = new (std::nothrow) JpegDcDecoder;
+  if (!thumbBuffer)
+  {
+    thumbBuffer = static_cast<uint8_t *>(heap_caps_malloc(DC_THUMB_MAX_PIXELS, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
+    if (!thumbBuffer)
+      thumbBuffer = static_cast<uint8_t *>(malloc(DC_THUMB_MAX_PIXELS));
+  }
+}
+
+bool decodeDcThumbnail(const CapturedFrame *frame, uint8_t *out, size_t capacity, int &width, int &height, uint8_t &mean)
+{
+  if (!decoder || !decoderLock || !frame)
+    return false;
+
+  xSemaphoreTake(decoderLock, portMAX_DELAY);
+  unsigned long start = micros();
+  bool ok = decoder->decode(frame->buf, frame->len, out, capacity, width, height);
+  unsigned long elapsed = micros() - start;
+
+  if (ok)
+  {
+    uint32_t sum = 0;
+    int pixels = width * height;
+    for (int i = 0; i < pixels; i++)
+      sum += out[i];
+    mean = pixels > 0 ? sum / pixels : 0;
+
+    stats.decodeTimeAvg = stats.decodes == 0 ? elapsed / 1000.0f : stats.decodeTimeAvg * 0.9f + elapsed / 1000.0f * 0.1f;
+    stats.decodes++;
+    stats.lastDecodeMicros = elapsed;
+    stats.lastWidth = width;
+    stats.lastHeight = height;
+    stats.lastMean = mean;
+  }
+  else
+  {
+    stats.failures++;
+  }
+  xSemaphoreGive(decoderLock);
+  return ok;
+}
+
+DcThumbnailStats getDcThumbnailStats()
+{
+  return stats;
+}
+
+void sendDcThumbnail(WebServer &server, const CapturedFrame *frame)
+{
+  int width = 0;
+  int height = 0;
+  uint8_t mean = 0;
+  if (!thumbBuffer || !decodeDcThumbnail(frame, thumbBuffer, DC_THUMB_MAX_PIXELS, width, height, mean) ||
+      !thumbBmp.begin(thumbBuffer, width, height, BmpWriter::GRAYSCALE))
+  {
+    server.send(500, "text/plain", "Thumbnail decode failed");
+    return;
+  }
+
+  server.sendHeader("X-Luma-Mean", String(mean));
+  server.sendHeader("X-Decode-Time", String(stats.lastDecodeMicros));
+  server.setContentLength(thumbBmp.size());
+  server.send(200, "image/bmp", "");
+
+  // nagłówek z paletą i wiersze z wyrównaniem zbierane w kawałki - jedno sendContent
+  // (jeden zapis chunked) na kawałek zamiast na każdy wiersz
+  static uint8_t chunk[DC_THUMB_SEND_CHUNK];
+  size_t used = 0;
+  auto append = [&](const uint8_t *data, size_t len)
+  {
+    while (len > 0)
+    {
+      size_t n = min<size_t>(len, sizeof(chunk) - used);
+      memcpy(chunk + used, data, n);
+      used += n;
+      data += n;
+      len -= n;
+      if (used == sizeof(chunk))
+      {
+        server.sendContent((const char *)chunk, used);
+        used = 0;
+      }
+    }
+  };
+
+  static const uint8_t padding[3] = {0, 0, 0};
+  append(thumbBmp.header(), thumbBmp.headerSize());
+  for (int y = 0; y < thumbBmp.rows(); y++)
+  {
+    append(thumbBmp.row(y, NULL), thumbBmp.rowBytes());
+    append(padding, thumbBmp.padding());
+  }
+  if (used > 0)
+    server.sendContent((const char *)chunk, used);
+}
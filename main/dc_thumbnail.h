@@ -0,0 +1,34 @@
+#ifndef DC_THUMBNAIL_H
+#define DC_THUMBNAIL_H
+
+#include <Arduino.h>
+#include <WebServer.h>
+
+#include "capture_pipeline.h"
+
+// Miniatura 1/8 luminancji ze współczynników DC JPEG: jeden piksel na blok 8x8, bez IDCT
+// i konwersji kolorów. Tania podstawa statystyk sceny (średnia jasność, detekcja ruchu).
+
+struct DcThumbnailStats
+{
+  uint32_t decodes;       // udane dekodowania
+  uint32_t failures;      // nieudane (brak pamięci, nieobsługiwany JPEG)
+  float decodeTimeAvg;    // średni czas dekodowania (ms)
+  unsigned long lastDecodeMicros;
+  int lastWidth;
+  int lastHeight;
+  uint8_t lastMean;       // średnia jasność ostatniej miniatury
+};
+
+void setupDcThumbnail();
+
+// Dekodowanie miniatury klatki do `out` (wierszami, szerokość * wysokość bajtów).
+// Bezpieczne z wielu tasków; `mean` to średnia jasność miniatury.
+bool decodeDcThumbnail(const CapturedFrame *frame, uint8_t *out, size_t capacity, int &width, int &height, uint8_t &mean);
+
+DcThumbnailStats getDcThumbnailStats();
+
+// Odpowiedź /capture?thumb=1: 8-bitowy BMP w skali szarości z nagłówkiem X-Luma-Mean
+void sendDcThumbnail(WebServer &server, const CapturedFrame *frame);
+
+#endif // DC_THUMBNAIL_H
@@ -7,9 +7,9 @@
 #ifndef ESP32CAM_H
 #define ESP32CAM_H
 
-#include "esp32cam/asyncweb.hpp"
-#include "esp32cam/camera.hpp"
-#include "esp32cam/logger.hpp"
+#include "src/esp32cam/asyncweb.hpp"
+#include "src/esp32cam/camera.hpp"
+#include "src/esp32cam/logger.hpp"
 
 namespace esp32cam {
 
@@ -0,0 +1,29 @@
+#include "hardware.h"
+#include "sensor_control.h"
+
+void writeMotorPin(uint8_t pin, int duty)
+{
+  analogWrite(pin, duty);
+}
+
+unsigned long measureEchoPulse(unsigned long timeout)
+{
+  digitalWrite(TRIGGER_PIN, LOW);
+  delayMicroseconds(2);
+
+  digitalWrite(TRIGGER_PIN, HIGH);
+  delayMicroseconds(10);
+  digitalWrite(TRIGGER_PIN, LOW);
+
+  return pulseIn(ECHO_PIN, HIGH, timeout);
+}
+
+camera_fb_t *getCameraFrame()
+{
+  return esp_camera_fb_get();
+}
+
+void returnCameraFrame(camera_fb_t *fb)
+{
+  esp_camera_fb_return(fb);
+}
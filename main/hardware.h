@@ -0,0 +1,21 @@
+#ifndef HARDWARE_H
+#define HARDWARE_H
+
+#include <Arduino.h>
+#include <esp_camera.h>
+
+// Jedyne miejsca, w których logika pojazdu dotyka sprzętu: PWM silników, impuls echa HC-SR04
+// i bufory klatek kamery. Na płytce obsługuje je hardware.cpp; symulator na hoście (host/sim/)
+// dostarcza własne definicje, a logika sterowania kompiluje się bez zmian.
+
+// Wypełnienie PWM (0-255) na pinie mostka H silnika
+void writeMotorPin(uint8_t pin, int duty);
+
+// Wyzwolenie pomiaru i czas impulsu echa (µs); 0 - brak echa w `timeout` (µs)
+unsigned long measureEchoPulse(unsigned long timeout);
+
+// Klatka JPEG z kamery; zwracana przez returnCameraFrame()
+camera_fb_t *getCameraFrame();
+void returnCameraFrame(camera_fb_t *fb);
+
+#endif // HARDWARE_H
@@ -0,0 +1,47 @@
+#include "heap_monitor.h"
+#include "config.h"
+
+#include "src/esp32cam/buffer_pool.hpp"
+
+#include <esp_heap_caps.h>
+
+using esp32cam::detail::BufferPool;
+
+static HeapMonitorStats stats = {};
+static unsigned long lastSample = 0;
+static uint32_t lastAllocations = 0;
+
+void updateHeapMonitor()
+{
+  unsigned long now = millis();
+  if (stats.samples > 0 && now - lastSample < HEAP_MONITOR_INTERVAL)
+    return;
+
+  stats.psramFree = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+  stats.psramLargest = heap_caps_get_largest_free_block(MALLOC_CAP_SPIRAM);
+  stats.internalFree = heap_caps_get_free_size(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+  stats.internalLargest = heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+  stats.internalMinFree = heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+  if (stats.samples == 0 || stats.psramLargest < stats.psramMinLargest)
+    stats.psramMinLargest = stats.psramLargest;
+  if (stats.samples == 0 || stats.internalLargest < stats.internalMinLargest)
+    stats.internalMinLargest = stats.internalLargest;
+
+  BufferPool::Stats pool = BufferPool::get().getStats();
+  stats.poolAllocations = pool.allocations;
+  stats.poolReuses = pool.reuses;
+  stats.poolFailures = pool.failures;
+  stats.poolCachedBytes = pool.cachedBytes;
+  stats.poolInUseBytes = pool.inUseBytes;
+  if (stats.samples > 0 && now > lastSample)
+    stats.poolAllocRate = (pool.allocations - lastAllocations) * 1000.0f / (now - lastSample);
+
+  lastAllocations = pool.allocations;
+  lastSample = now;
+  stats.samples++;
+}
+
+HeapMonitorStats getHeapMonitorStats()
+{
+  return stats;
+}
@@ -0,0 +1,35 @@
+#ifndef HEAP_MONITOR_H
+#define HEAP_MONITOR_H
+
+#include <Arduino.h>
+
+// Monitor fragmentacji pamięci: wolna pamięć, największy wolny blok i jego minimum od startu,
+// próbkowane co HEAP_MONITOR_INTERVAL z pętli głównej. Spadek największego bloku przy stałej
+// wolnej pamięci oznacza fragmentację - na tym kończą się długie sesje strumienia.
+
+struct HeapMonitorStats
+{
+  size_t psramFree;         // wolna pamięć PSRAM (B)
+  size_t psramLargest;      // największy wolny blok PSRAM (B)
+  size_t psramMinLargest;   // minimum największego bloku PSRAM od startu (B)
+  size_t internalFree;      // wolna pamięć wewnętrzna (B)
+  size_t internalLargest;   // największy wolny blok pamięci wewnętrznej (B)
+  size_t internalMinLargest;
+  size_t internalMinFree;   // minimum wolnej pamięci wewnętrznej od startu (z alokatora)
+  uint32_t samples;
+
+  // pula buforów konwersji klatek (esp32cam::detail::BufferPool)
+  uint32_t poolAllocations; // nowe bloki z malloc
+  uint32_t poolReuses;      // bloki wzięte z puli
+  uint32_t poolFailures;
+  size_t poolCachedBytes;   // bloki czekające w puli
+  size_t poolInUseBytes;    // bloki wydane
+  float poolAllocRate;      // nowe bloki na sekundę w ostatnim okresie próbkowania
+};
+
+// Wołane z pętli głównej; próbkuje nie częściej niż co HEAP_MONITOR_INTERVAL ms.
+void updateHeapMonitor();
+
+HeapMonitorStats getHeapMonitorStats();
+
+#endif // HEAP_MONITOR_H
@@ -0,0 +1,82 @@
+#include "luma_decimator.h"
+
+#include <string.h>
+
+bool LumaDecimator::begin(int srcWidth, int srcHeight, int outWidth, int outHeight, uint32_t *sums)
+{
+  // bez powiększania - każda komórka wyjścia musi dostać co najmniej jeden piksel
+  if (srcWidth > MAX_SOURCE || srcHeight > MAX_SOURCE || outWidth > MAX_OUTPUT || outHeight > MAX_OUTPUT ||
+      outWidth < 1 || outHeight < 1 || srcWidth < outWidth || srcHeight < outHeight || sums == NULL)
+    return false;
+
+  m_srcWidth = srcWidth;
+  m_srcHeight = srcHeight;
+  m_outWidth = outWidth;
+  m_outHeight = outHeight;
+  m_sums = sums;
+  memset(m_sums, 0, sizeof(uint32_t) * outWidth * outHeight);
+  memset(m_colCount, 0, sizeof(m_colCount));
+  memset(m_rowCount, 0, sizeof(m_rowCount));
+
+  for (int x = 0; x < srcWidth; x++)
+  {
+    m_colMap[x] = (uint8_t)((x * outWidth) / srcWidth);
+    m_colCount[m_colMap[x]]++;
+  }
+  for (int y = 0; y < srcHeight; y++)
+  {
+    m_rowMap[y] = (uint8_t)((y * outHeight) / srcHeight);
+    m_rowCount[m_rowMap[y]]++;
+  }
+  return true;
+}
+
+void LumaDecimator::addRgb(int x, int y, int w, int h, const uint8_t *rgb)
+{
+  // bloki na krawędzi obrazu mogą wystawać poza niego
+  int stride = w * 3;
+  if (x + w > m_srcWidth)
+    w = m_srcWidth - x;
+  if (y + h > m_srcHeight)
+    h = m_srcHeight - y;
+
+  for (int row = 0; row < h; row++)
+  {
+    uint32_t *sumRow = m_sums + m_rowMap[y + row] * m_outWidth;
+    const uint8_t *colMap = m_colMap + x;
+    const uint8_t *p = rgb + row * stride;
+    for (int col = 0; col < w; col++, p += 3)
+      sumRow[colMap[col]] += rgbToLuma(p[0], p[1], p[2]);
+  }
+}
+
+void LumaDecimator::addLuma(int x, int y, int w, int h, const uint8_t *luma)
+{
+  int stride = w;
+  if (x + w > m_srcWidth)
+    w = m_srcWidth - x;
+  if (y + h > m_srcHeight)
+    h = m_srcHeight - y;
+
+  for (int row = 0; row < h; row++)
+  {
+    uint32_t *sumRow = m_sums + m_rowMap[y + row] * m_outWidth;
+    const uint8_t *colMap = m_colMap + x;
+    const uint8_t *p = luma + row * stride;
+    for (int col = 0; col < w; col++)
+      sumRow[colMap[col]] += p[col];
+  }
+}
+
+void LumaDecimator::finish(uint8_t *out) const
+{
+  for (int oy = 0; oy < m_outHeight; oy++)
+  {
+    const uint32_t *sumRow = m_sums + oy * m_outWidth;
+    for (int ox = 0; ox < m_outWidth; ox++)
+    {
+      uint32_t count = (uint32_t)m_colCount[ox] * m_rowCount[oy];
+      *out++ = (uint8_t)((sumRow[ox] + count / 2) / count);
+    }
+  }
+}
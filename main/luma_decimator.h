@@ -0,0 +1,51 @@
+#ifndef LUMA_DECIMATOR_H
+#define LUMA_DECIMATOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Zmniejszanie obrazu do tensora luminancji (8 bit) uśrednianiem obszarów.
+// Piksele przychodzą blokami w dowolnej kolejności (tak jak oddaje je dekoder JPEG),
+// każdy piksel źródła trafia do dokładnie jednej komórki wyjścia - sumy i liczniki
+// są liczone na tablicach odwzorowań kolumn/wierszy, bez dzielenia w pętli.
+// Bez zależności od Arduino - ten sam kod kompiluje się na hoście.
+class LumaDecimator
+{
+public:
+  static const int MAX_SOURCE = 1600; // najszerszy obsługiwany obraz źródłowy
+  static const int MAX_OUTPUT = 255;  // indeksy komórek mieszczą się w uint8_t
+
+  // `sums` - bufor roboczy na outWidth * outHeight sum
+  bool begin(int srcWidth, int srcHeight, int outWidth, int outHeight, uint32_t *sums);
+
+  // blok RGB888 (R, G, B) o rozmiarze w x h w punkcie (x, y) obrazu źródłowego
+  void addRgb(int x, int y, int w, int h, const uint8_t *rgb);
+
+  // blok luminancji (1 bajt na piksel)
+  void addLuma(int x, int y, int w, int h, const uint8_t *luma);
+
+  // średnie komórek do `out` (outWidth * outHeight bajtów)
+  void finish(uint8_t *out) const;
+
+  int outWidth() const { return m_outWidth; }
+  int outHeight() const { return m_outHeight; }
+
+private:
+  int m_srcWidth = 0;
+  int m_srcHeight = 0;
+  int m_outWidth = 0;
+  int m_outHeight = 0;
+  uint32_t *m_sums = NULL;
+  uint8_t m_colMap[MAX_SOURCE];
+  uint8_t m_rowMap[MAX_SOURCE];
+  uint16_t m_colCount[MAX_OUTPUT];
+  uint16_t m_rowCount[MAX_OUTPUT];
+};
+
+// luminancja BT.601 w arytmetyce stałoprzecinkowej (wagi sumują się do 256)
+static inline uint8_t rgbToLuma(uint8_t r, uint8_t g, uint8_t b)
+{
+  return (77 * r + 150 * g + 29 * b + 128) >> 8;
+}
+
+#endif // LUMA_DECIMATOR_H
@@ -10,6 +10,9 @@
 #include "sensor_control.h"
 
 #include "camera_control.h"
+#include "traffic_control.h"
+#include "heap_monitor.h"
+#include "dataset_recorder.h"
 
 // Utworzenie serwera web na porcie 80
 WebServer server(80);
@@ -59,8 +62,18 @@ void setup() {
 void loop() {
   // Obsługa żądań klientów
   server.handleClient();
+
+  unsigned long wsLoopStart = millis();
   webSocket.loop();
+  reportWebSocketLoopTime(millis() - wsLoopStart); // czas obsługi ruchu WebSocket
+
   handleSensorWebSocket(); // obsługa WebSocket dla sensora
+  handleControlPing(); // pomiar RTT sterowania
+  handleMlFramePush(); // tensor luminancji dla subskrybentów ML
+  handleMlStepPush(); // odpowiedzi kroków lockstep po okresie sterowania
+  updateTrafficGovernor(); // dławienie kamery przy opóźnionym sterowaniu
   checkObstacles(); // sprawdzanie przeszkód
+  updateHeapMonitor(); // próbkowanie fragmentacji pamięci
+  updateDatasetRecorder(); // pomiary odległości do rekordów zbioru uczącego
   delay(20);  // Małe opóźnienie dla stabilności
 }
@@ -0,0 +1,269 @@
+#include "ml_frame.h"
+#include "config.h"
+#include "capture_pipeline.h"
+#include "still_cache.h"
+#include "luma_decimator.h"
+
+#include <esp_camera.h>
+#include <esp_heap_caps.h>
+#include <esp_jpg_decode.h>
+
+// bufory współdzielone przez /ml/frame i WebSocket - oba obsługuje pętla główna
+static uint8_t *frameBuffer = NULL; // nagłówek + tensor
+static uint32_t *sumBuffer = NULL;  // sumy komórek decymatora
+static LumaDecimator decimator;
+
+static uint32_t mlFrames = 0;
+static uint32_t mlFailures = 0;
+static float decodeTimeAvg = 0;
+static unsigned long lastDecodeTime = 0;
+static int lastScale = 0;
+
+struct JpegSource
+{
+  const uint8_t *buf;
+  size_t len;
+};
+
+// esp_jpg_decode przekazuje ten sam argument do odczytu i zapisu
+struct DecodeContext
+{
+  JpegSource src;
+  int outWidth;
+  int outHeight;
+  bool started;
+};
+
+static size_t readJpeg(void *arg, size_t index, uint8_t *buf, size_t len)
+{
+  JpegSource *src = &static_cast<DecodeContext *>(arg)->src;
+  if (index >= src->len)
+    return 0;
+  if (index + len > src->len)
+    len = src->len - index;
+  // dekoder pomija dane, podając buf == NULL
+  if (buf)
+    memcpy(buf, src->buf + index, len);
+  return len;
+}
+
+static bool writeRgb(void *arg, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint8_t *data)
+{
+  DecodeContext *ctx = static_cast<DecodeContext *>(arg);
+  if (!data)
+  {
+    // początek dekodowania: (0, 0) i wymiary obrazu po skalowaniu; koniec - bez akcji
+    if (x == 0 && y == 0 && !ctx->started)
+    {
+      ctx->started = decimator.begin(w, h, ctx->outWidth, ctx->outHeight, sumBuffer);
+      return ctx->started;
+    }
+    return true;
+  }
+  decimator.addRgb(x, y, w, h, data);
+  return true;
+}
+
+bool isValidMlTensorSize(int width, int height)
+{
+  return width >= 8 && height >= 8 && width <= ML_TENSOR_MAX_WIDTH && height <= ML_TENSOR_MAX_HEIGHT;
+}
+
+static bool allocateBuffers()
+{
+  if (frameBuffer)
+    return true;
+
+  size_t cells = ML_TENSOR_MAX_WIDTH * ML_TENSOR_MAX_HEIGHT;
+  frameBuffer = static_cast<uint8_t *>(heap_caps_malloc(ML_FRAME_HEADER_SIZE + cells, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
+  sumBuffer = static_cast<uint32_t *>(heap_caps_malloc(cells * sizeof(uint32_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
+  if (!frameBuffer)
+    frameBuffer = static_cast<uint8_t *>(malloc(ML_FRAME_HEADER_SIZE + cells));
+  if (!sumBuffer)
+    sumBuffer = static_cast<uint32_t *>(malloc(cells * sizeof(uint32_t)));
+  if (frameBuffer && sumBuffer)
+    return true;
+
+  free(frameBuffer);
+  free(sumBuffer);
+  frameBuffer = NULL;
+  sumBuffer = NULL;
+  return false;
+}
+
+static void writeU16(uint8_t *p, uint16_t v)
+{
+  p[0] = v & 0xFF;
+  p[1] = v >> 8;
+}
+
+static void writeU32(uint8_t *p, uint32_t v)
+{
+  for (int i = 0; i < 4; i++)
+    p[i] = (v >> (8 * i)) & 0xFF;
+}
+
+static void writeI64(uint8_t *p, int64_t v)
+{
+  for (int i = 0; i < 8; i++)
+    p[i] = ((uint64_t)v >> (8 * i)) & 0xFF;
+}
+
+// skala dekodera: największe zmniejszenie, po którym obraz jest nadal nie mniejszy od tensora
+static jpg_scale_t chooseScale(int width, int height, int outWidth, int outHeight, int &factor)
+{
+  static const jpg_scale_t scales[] = {JPG_SCALE_8X, JPG_SCALE_4X, JPG_SCALE_2X};
+  factor = 8;
+  for (jpg_scale_t scale : scales)
+  {
+    if (width / factor >= outWidth && height / factor >= outHeight)
+      return scale;
+    factor /= 2;
+  }
+  factor = 1;
+  return JPG_SCALE_NONE;
+}
+
+// wymiary JPEG z nagłówka SOF0/SOF2
+static bool readJpegSize(const uint8_t *buf, size_t len, int &width, int &height)
+{
+  size_t i = 2;
+  while (i + 9 < len)
+  {
+    if (buf[i] != 0xFF)
+      return false;
+    uint8_t marker = buf[i + 1];
+    size_t segment = (buf[i + 2] << 8) | buf[i + 3];
+    if (marker == 0xC0 || marker == 0xC2)
+    {
+      height = (buf[i + 5] << 8) | buf[i + 6];
+      width = (buf[i + 7] << 8) | buf[i + 8];
+      return true;
+    }
+    i += 2 + segment;
+  }
+  return false;
+}
+
+static bool decodeLuma(const CapturedFrame *frame, int outWidth, int outHeight, uint8_t *out)
+{
+  int width, height;
+  if (!readJpegSize(frame->buf, frame->len, width, height))
+    return false;
+
+  int factor;
+  jpg_scale_t scale = chooseScale(width, height, outWidth, outHeight, factor);
+  lastScale = factor;
+
+  DecodeContext ctx = {{frame->buf, frame->len}, outWidth, outHeight, false};
+  if (esp_jpg_decode(frame->len, scale, readJpeg, writeRgb, &ctx) != ESP_OK || !ctx.started)
+    return false;
+
+  decimator.finish(out);
+  return true;
+}
+
+// tensor z nagłówkiem w frameBuffer; klatka zostaje z referencją wołającego
+static size_t encodeMlFrame(const CapturedFrame *frame, int width, int height)
+{
+  unsigned long start = millis();
+  if (!decodeLuma(frame, width, height, frameBuffer + ML_FRAME_HEADER_SIZE))
+  {
+    mlFailures++;
+    return 0;
+  }
+
+  lastDecodeTime = millis() - start;
+  decodeTimeAvg = mlFrames == 0 ? lastDecodeTime : decodeTimeAvg * 0.9f + lastDecodeTime * 0.1f;
+  mlFrames++;
+
+  memcpy(frameBuffer, "LUMA", 4);
+  writeU16(frameBuffer + 4, width);
+  writeU16(frameBuffer + 6, height);
+  writeU32(frameBuffer + 8, frame->seq);
+  writeI64(frameBuffer + 12, frame->timestamp);
+  return ML_FRAME_HEADER_SIZE + width * height;
+}
+
+size_t buildMlFrame(int width, int height, uint32_t afterSeq, const uint8_t *&buf, uint32_t &seq)
+{
+  if (!isValidMlTensorSize(width, height) || !allocateBuffers())
+    return 0;
+
+  // w trakcie strumienia najnowsza klatka z puli potoku, bez osobnego przechwytywania
+  CapturedFrame *frame = NULL;
+  bool pooled = isCaptureRunning();
+  if (pooled)
+  {
+    frame = acquireLatestFrame(afterSeq);
+  }
+  else
+  {
+    unsigned long age, interruption;
+    StillCacheResult result = acquireCachedStill(FRAMESIZE_INVALID, STILL_CACHE_WINDOW, frame, age, interruption);
+    if (result != STILL_CACHE_HIT && result != STILL_CACHE_MISS)
+      frame = NULL;
+    else if (frame && (int32_t)(frame->seq - afterSeq) <= 0)
+    {
+      releaseFrame(frame);
+      frame = NULL;
+    }
+  }
+  if (!frame)
+    return 0;
+
+  size_t len = encodeMlFrame(frame, width, height);
+  seq = frame->seq;
+  releaseFrame(frame);
+
+  buf = frameBuffer;
+  return len;
+}
+
+size_t buildMlFrameFrom(const CapturedFrame *frame, int width, int height, const uint8_t *&buf)
+{
+  if (!isValidMlTensorSize(width, height) || !allocateBuffers())
+    return 0;
+
+  buf = frameBuffer;
+  return encodeMlFrame(frame, width, height);
+}
+
+MlFrameStats getMlFrameStats()
+{
+  MlFrameStats stats;
+  stats.frames = mlFrames;
+  stats.failures = mlFailures;
+  stats.decodeTimeAvg = decodeTimeAvg;
+  stats.lastDecodeTime = lastDecodeTime;
+  stats.lastScale = lastScale;
+  return stats;
+}
+
+void handleMlFrame(WebServer &server)
+{
+  int width = server.hasArg("w") ? server.arg("w").toInt() : ML_TENSOR_WIDTH;
+  int height = server.hasArg("h") ? server.arg("h").toInt() : ML_TENSOR_HEIGHT;
+  if (!isValidMlTensorSize(width, height))
+  {
+    server.send(400, "text/plain", "Invalid tensor size");
+    return;
+  }
+
+  const uint8_t *buf;
+  uint32_t seq;
+  // bez strumienia poprzednia klatka nie jest znana - wystarczy dowolna
+  size_t len = buildMlFrame(width, height, 0, buf, seq);
+  if (len == 0)
+  {
+    server.send(503, "text/plain", "No frame available");
+    return;
+  }
+
+  server.sendHeader("Access-Control-Allow-Origin", "*");
+  server.sendHeader("X-Sequence", String(seq));
+  server.sendHeader("X-Decode-Time", String(lastDecodeTime));
+  server.setContentLength(len);
+  server.send(200, "application/octet-stream", "");
+  server.sendContent((const char *)buf, len);
+}
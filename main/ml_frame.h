@@ -0,0 +1,47 @@
+#ifndef ML_FRAME_H
+#define ML_FRAME_H
+
+#include <Arduino.h>
+#include <WebServer.h>
+
+#include "capture_pipeline.h"
+
+// Tensor luminancji dla modelu NeuroControl: mała, stała rozdzielczość (np. 64x48, 96x96),
+// 8 bit na piksel, liczona na urządzeniu ze skalowanego dekodowania JPEG.
+//
+// Format binarny (little-endian), wspólny dla /ml/frame i WebSocket:
+//   0  char[4]  "LUMA"
+//   4  uint16   szerokość
+//   6  uint16   wysokość
+//   8  uint32   numer kolejny klatki
+//   12 int64    czas przechwycenia ze sterownika kamery (µs, zegar esp_timer - jak w zbiorze
+//               uczącym i krokach lockstep)
+//   20 uint8[]  luminancja wierszami, szerokość * wysokość bajtów
+#define ML_FRAME_HEADER_SIZE 20
+
+struct MlFrameStats
+{
+  uint32_t frames;        // wygenerowane tensory
+  uint32_t failures;      // nieudane dekodowania
+  float decodeTimeAvg;    // średni czas dekodowania i zmniejszania (ms)
+  unsigned long lastDecodeTime;
+  int lastScale;          // skala dekodera JPEG ostatniej klatki (1, 2, 4, 8)
+};
+
+// poprawny rozmiar tensora (do ML_TENSOR_MAX_WIDTH x ML_TENSOR_MAX_HEIGHT)
+bool isValidMlTensorSize(int width, int height);
+
+// Tensor z najnowszej klatki strumienia (albo wspólnego zdjęcia bez strumienia)
+// nowszej niż `afterSeq`. Bufor z nagłówkiem i danymi jest ważny do następnego wywołania.
+// Zwraca rozmiar w bajtach albo 0, gdy brak nowej klatki lub dekodowanie się nie udało.
+size_t buildMlFrame(int width, int height, uint32_t afterSeq, const uint8_t *&buf, uint32_t &seq);
+
+// Tensor z podanej klatki (z referencją wołającego); bufor jak w buildMlFrame()
+size_t buildMlFrameFrom(const CapturedFrame *frame, int width, int height, const uint8_t *&buf);
+
+MlFrameStats getMlFrameStats();
+
+// GET /ml/frame?w=64&h=48
+void handleMlFrame(WebServer &server);
+
+#endif // ML_FRAME_H
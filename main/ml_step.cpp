@@ -0,0 +1,217 @@
+#include "ml_step.h"
+#include "config.h"
+#include "capture_pipeline.h"
+#include "motor_control.h"
+#include "sensor_control.h"
+#include "vehicle_state.h"
+
+#include <WebSocketsServer.h>
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+
+// krok w toku jednego klienta WebSocket
+struct StepSlot
+{
+  bool session;              // sesja kroków trzyma subskrypcję potoku przechwytywania
+  bool pending;
+  uint32_t steps;
+  MlStepRequest request;
+  unsigned long requestTime; // millis() przyjęcia kroku
+  unsigned long deadline;    // millis() końca okresu sterowania
+  int64_t actionTime;        // µs (esp_timer) zastosowania akcji
+  bool distanceSampled;
+  uint8_t flags;
+};
+
+static StepSlot slots[WEBSOCKETS_SERVER_CLIENT_MAX];
+static uint8_t *response = NULL; // nagłówek kroku + tensor, jeden bufor na wszystkich klientów
+static MlStepStats stats;
+
+static void writeU16(uint8_t *p, uint16_t v)
+{
+  p[0] = v & 0xFF;
+  p[1] = v >> 8;
+}
+
+static void writeU32(uint8_t *p, uint32_t v)
+{
+  for (int i = 0; i < 4; i++)
+    p[i] = (v >> (8 * i)) & 0xFF;
+}
+
+static void applyAction(const MlStepRequest &request)
+{
+  switch (request.action)
+  {
+  case ML_STEP_FORWARD:
+    moveForward();
+    break;
+  case ML_STEP_BACKWARD:
+    moveBackward();
+    break;
+  case ML_STEP_LEFT:
+    turnLeft();
+    break;
+  case ML_STEP_RIGHT:
+    turnRight();
+    break;
+  case ML_STEP_STOP:
+    stopMotors();
+    break;
+  case ML_STEP_SPEED:
+    setMotorSpeed(request.left, request.right);
+    break;
+  case ML_STEP_HOLD:
+  default:
+    break;
+  }
+}
+
+bool beginMlStep(uint8_t num, const MlStepRequest &request, uint32_t &step)
+{
+  if (num >= WEBSOCKETS_SERVER_CLIENT_MAX || slots[num].pending)
+    return false;
+
+  StepSlot &slot = slots[num];
+  if (!slot.session)
+  {
+    // klatki po okresie muszą płynąć także bez klienta /stream
+    captureSubscribe();
+    slot.session = true;
+  }
+
+  slot.request = request;
+  slot.request.period = constrain(request.period, 0UL, (unsigned long)ML_STEP_MAX_PERIOD);
+  slot.requestTime = millis();
+  slot.deadline = slot.requestTime + slot.request.period;
+  slot.actionTime = esp_timer_get_time();
+  slot.distanceSampled = false;
+  slot.flags = 0;
+
+  applyAction(request);
+  // moveForward() nie rusza przy przeszkodzie
+  MotorSpeeds speeds = getMotorSpeedsAt(esp_timer_get_time());
+  if (request.action == ML_STEP_FORWARD && speeds.left == 0 && speeds.right == 0)
+    slot.flags |= ML_STEP_OBSTACLE_STOP;
+
+  slot.pending = true;
+  step = ++slot.steps;
+  return true;
+}
+
+static bool allocateResponse()
+{
+  if (response)
+    return true;
+
+  size_t size = ML_STEP_HEADER_SIZE + ML_FRAME_HEADER_SIZE + ML_TENSOR_MAX_WIDTH * ML_TENSOR_MAX_HEIGHT;
+  response = static_cast<uint8_t *>(heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
+  if (!response)
+    response = static_cast<uint8_t *>(malloc(size));
+  return response != NULL;
+}
+
+MlStepPoll pollMlStep(uint8_t num, const uint8_t *&buf, size_t &len)
+{
+  if (num >= WEBSOCKETS_SERVER_CLIENT_MAX || !slots[num].pending)
+    return ML_STEP_IDLE;
+
+  StepSlot &slot = slots[num];
+  unsigned long now = millis();
+  if ((long)(now - slot.deadline) < 0)
+    return ML_STEP_PENDING;
+
+  // pomiar odległości na końcu okresu - czujnik obsługuje tylko pętla główna
+  if (!slot.distanceSampled)
+  {
+    getDistance();
+    slot.distanceSampled = true;
+  }
+
+  // obserwacja z klatki przechwyconej po końcu okresu; po ML_STEP_FRAME_TIMEOUT - z najnowszej
+  int64_t deadlineTime = slot.actionTime + (int64_t)slot.request.period * 1000;
+  bool late = now - slot.deadline > ML_STEP_FRAME_TIMEOUT;
+  CapturedFrame *frame = acquireLatestFrame(0);
+  if ((!frame || frame->timestamp < deadlineTime) && !late)
+  {
+    releaseFrame(frame);
+    return ML_STEP_PENDING;
+  }
+
+  slot.pending = false;
+  size_t tensorLen = 0;
+  const uint8_t *tensor = NULL;
+  if (frame && allocateResponse())
+    tensorLen = buildMlFrameFrom(frame, slot.request.width, slot.request.height, tensor);
+  if (tensorLen == 0)
+  {
+    releaseFrame(frame);
+    stats.failures++;
+    return ML_STEP_FAILED;
+  }
+
+  uint8_t flags = slot.flags;
+  if (frame->timestamp < deadlineTime)
+  {
+    flags |= ML_STEP_STALE_FRAME;
+    stats.staleFrames++;
+  }
+  if (vehicle.lastEmergencyStopTime && (long)(vehicle.lastEmergencyStopTime - slot.requestTime) >= 0)
+    flags |= ML_STEP_OBSTACLE_STOP;
+
+  MotorSpeeds speeds = getMotorSpeedsAt(frame->timestamp);
+  DistanceReading distance = getFilteredDistance();
+  int64_t frameDelay = frame->timestamp - slot.actionTime;
+  releaseFrame(frame);
+
+  memcpy(response, "STEP", 4);
+  writeU32(response + 4, slot.steps);
+  writeU32(response + 8, slot.request.id);
+  writeU16(response + 12, speeds.left);
+  writeU16(response + 14, speeds.right);
+  writeU16(response + 16, distance.distance < 0 ? 0 : (uint16_t)(distance.distance * 10));
+  response[18] = flags;
+  response[19] = 0;
+  writeU32(response + 20, frameDelay > 0 ? frameDelay / 1000 : 0);
+  memcpy(response + ML_STEP_HEADER_SIZE, tensor, tensorLen);
+
+  unsigned long latency = millis() - slot.requestTime;
+  float overshoot = frameDelay / 1000.0f - slot.request.period;
+  stats.latencyAvg = stats.steps == 0 ? latency : stats.latencyAvg * 0.9f + latency * 0.1f;
+  stats.overshootAvg = stats.steps == 0 ? overshoot : stats.overshootAvg * 0.9f + overshoot * 0.1f;
+  stats.steps++;
+
+  buf = response;
+  len = ML_STEP_HEADER_SIZE + tensorLen;
+  return ML_STEP_READY;
+}
+
+void endMlSteps(uint8_t num)
+{
+  if (num >= WEBSOCKETS_SERVER_CLIENT_MAX)
+    return;
+
+  StepSlot &slot = slots[num];
+  if (slot.session)
+    captureUnsubscribe();
+  slot = StepSlot();
+}
+
+void expireMlSteps()
+{
+  unsigned long now = millis();
+  for (uint8_t num = 0; num < WEBSOCKETS_SERVER_CLIENT_MAX; num++)
+  {
+    StepSlot &slot = slots[num];
+    if (slot.session && !slot.pending && now - slot.deadline > ML_STEP_IDLE_TIMEOUT)
+    {
+      captureUnsubscribe();
+      slot.session = false;
+    }
+  }
+}
+
+MlStepStats getMlStepStats()
+{
+  return stats;
+}
@@ -0,0 +1,84 @@
+#ifndef ML_STEP_H
+#define ML_STEP_H
+
+#include <Arduino.h>
+
+#include "ml_frame.h"
+
+// Krok sterowania w trybie lockstep (WebSocket, {"command":"step",...}): akcja jest stosowana
+// od razu, po okresie sterowania wraca jedna binarna odpowiedź z obserwacją - tensorem luminancji
+// klatki przechwyconej po upływie okresu, odległością i stanem kół w chwili tej klatki.
+// Każda obserwacja jest więc skutkiem dokładnie jednej akcji, a pętla modelu ma jeden
+// round-trip na krok zamiast komendy i osobnego odczytu klatki.
+//
+// Odpowiedź (little-endian):
+//   0  char[4]  "STEP"
+//   4  uint32   numer kroku w sesji klienta (od 1)
+//   8  uint32   identyfikator kroku od klienta ("id", 0 gdy brak)
+//   12 int16    prędkość lewego koła w chwili klatki (PWM, ujemna - do tyłu)
+//   14 int16    prędkość prawego koła
+//   16 uint16   odległość po filtrze (mm, 0 - brak pomiaru)
+//   18 uint8    flagi (ML_STEP_*)
+//   19 uint8    zarezerwowane
+//   20 uint32   czas od akcji do przechwycenia klatki (ms)
+//   24 ...      tensor w formacie /ml/frame (nagłówek "LUMA" i luminancja)
+#define ML_STEP_HEADER_SIZE 24
+
+// flagi odpowiedzi
+#define ML_STEP_STALE_FRAME 0x01   // brak klatki po okresie w ML_STEP_FRAME_TIMEOUT - najnowsza starsza
+#define ML_STEP_OBSTACLE_STOP 0x02 // silniki zatrzymane przez czujnik w trakcie kroku
+
+enum MlStepAction
+{
+  ML_STEP_HOLD,     // bez zmiany prędkości
+  ML_STEP_FORWARD,
+  ML_STEP_BACKWARD,
+  ML_STEP_LEFT,
+  ML_STEP_RIGHT,
+  ML_STEP_STOP,
+  ML_STEP_SPEED     // prędkości kół z `left` i `right`
+};
+
+struct MlStepRequest
+{
+  MlStepAction action;
+  int left;
+  int right;
+  unsigned long period; // okres sterowania (ms)
+  int width;            // rozmiar tensora
+  int height;
+  uint32_t id;          // identyfikator od klienta, odsyłany w odpowiedzi
+};
+
+enum MlStepPoll
+{
+  ML_STEP_IDLE,     // brak kroku w toku
+  ML_STEP_PENDING,  // trwa okres sterowania albo oczekiwanie na klatkę
+  ML_STEP_READY,    // odpowiedź w `buf`, ważna do następnego wywołania
+  ML_STEP_FAILED    // brak klatki albo nieudane dekodowanie
+};
+
+struct MlStepStats
+{
+  uint32_t steps;
+  uint32_t failures;
+  uint32_t staleFrames;
+  float latencyAvg;   // od żądania do gotowej odpowiedzi (ms)
+  float overshootAvg; // klatka przechwycona później niż po okresie (ms)
+};
+
+// Zastosowanie akcji i start okresu sterowania; false, gdy klient ma już krok w toku
+bool beginMlStep(uint8_t num, const MlStepRequest &request, uint32_t &step);
+
+// Wołane z pętli głównej dla każdego klienta z krokiem w toku
+MlStepPoll pollMlStep(uint8_t num, const uint8_t *&buf, size_t &len);
+
+// Rozłączenie klienta albo koniec sesji kroków
+void endMlSteps(uint8_t num);
+
+// Koniec sesji po ML_STEP_IDLE_TIMEOUT bez kroków (potok przechwytywania może zasnąć)
+void expireMlSteps();
+
+MlStepStats getMlStepStats();
+
+#endif // ML_STEP_H
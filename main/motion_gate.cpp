@@ -0,0 +1,151 @@
+#include "motion_gate.h"
+#include "config.h"
+#include "dc_thumbnail.h"
+
+#include <esp_heap_caps.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+#define MOTION_GRID_CELLS (MOTION_GRID_WIDTH * MOTION_GRID_HEIGHT)
+
+// miniatura i sumy komórek współdzielone przez workery strumienia; sygnatura klatki
+// jest liczona raz, pozostałe strumienie biorą ją z klatki
+static SemaphoreHandle_t signatureLock = NULL;
+static uint8_t *thumbBuffer = NULL;
+static uint32_t cellSums[MOTION_GRID_CELLS];
+static uint16_t cellCounts[MOTION_GRID_CELLS];
+
+static portMUX_TYPE statsMux = portMUX_INITIALIZER_UNLOCKED;
+static MotionGateStats stats;
+
+void setupMotionGate()
+{
+  if (!signatureLock)
+    signatureLock = xSemaphoreCreateMutex();
+  if (!thumbBuffer)
+  {
+    thumbBuffer = static_cast<uint8_t *>(heap_caps_malloc(DC_THUMB_MAX_PIXELS, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
+    if (!thumbBuffer)
+      thumbBuffer = static_cast<uint8_t *>(malloc(DC_THUMB_MAX_PIXELS));
+  }
+}
+
+MotionGateConfig defaultMotionGateConfig()
+{
+  MotionGateConfig config;
+  config.enabled = MOTION_GATE_ENABLED;
+  config.threshold = MOTION_THRESHOLD;
+  config.keepAlive = MOTION_KEEPALIVE;
+  return config;
+}
+
+// średnie miniatury DC w komórkach siatki - niezależne od rozdzielczości strumienia
+static bool computeSignature(CapturedFrame *frame)
+{
+  if (!signatureLock || !thumbBuffer)
+    return false;
+
+  xSemaphoreTake(signatureLock, portMAX_DELAY);
+  if (frame->hasSignature)
+  {
+    xSemaphoreGive(signatureLock);
+    return true;
+  }
+
+  unsigned long start = micros();
+  int width = 0;
+  int height = 0;
+  uint8_t mean;
+  bool ok = decodeDcThumbnail(frame, thumbBuffer, DC_THUMB_MAX_PIXELS, width, height, mean) &&
+            width >= MOTION_GRID_WIDTH && height >= MOTION_GRID_HEIGHT;
+  if (ok)
+  {
+    memset(cellSums, 0, sizeof(cellSums));
+    memset(cellCounts, 0, sizeof(cellCounts));
+    for (int y = 0; y < height; y++)
+    {
+      const uint8_t *row = thumbBuffer + y * width;
+      int cellRow = y * MOTION_GRID_HEIGHT / height * MOTION_GRID_WIDTH;
+      for (int x = 0; x < width; x++)
+      {
+        int cell = cellRow + x * MOTION_GRID_WIDTH / width;
+        cellSums[cell] += row[x];
+        cellCounts[cell]++;
+      }
+    }
+    for (int i = 0; i < MOTION_GRID_CELLS; i++)
+      frame->signature[i] = cellSums[i] / cellCounts[i];
+    frame->hasSignature = true;
+  }
+  float elapsed = (micros() - start) / 1000.0f;
+  xSemaphoreGive(signatureLock);
+
+  portENTER_CRITICAL(&statsMux);
+  if (ok)
+  {
+    stats.signatureTimeAvg = stats.signatures == 0 ? elapsed : stats.signatureTimeAvg * 0.9f + elapsed * 0.1f;
+    stats.signatures++;
+  }
+  else
+  {
+    stats.failures++;
+  }
+  portEXIT_CRITICAL(&statsMux);
+  return ok;
+}
+
+MotionGate::MotionGate(const MotionGateConfig &config)
+    : m_config(config)
+{
+}
+
+bool MotionGate::admit(CapturedFrame *frame, unsigned long now)
+{
+  if (!m_config.enabled)
+    return true;
+
+  // bez sygnatury klatka przechodzi, ale nie zmienia odniesienia
+  if (!computeSignature(frame))
+    return true;
+
+  int score = 0;
+  if (m_hasReference)
+  {
+    for (int i = 0; i < MOTION_GRID_CELLS; i++)
+    {
+      int diff = abs((int)frame->signature[i] - (int)m_reference[i]);
+      if (diff > score)
+        score = diff;
+    }
+  }
+  m_lastScore = score;
+
+  bool keepAlive = now - m_lastAdmit >= m_config.keepAlive;
+  if (m_hasReference && score < m_config.threshold && !keepAlive)
+    return false;
+
+  // odniesieniem jest ostatnia wysłana klatka, więc powolne zmiany sceny też się sumują
+  memcpy(m_reference, frame->signature, sizeof(m_reference));
+  m_hasReference = true;
+  m_lastAdmit = now;
+  return true;
+}
+
+void MotionGate::suppress(const CapturedFrame *frame)
+{
+  m_suppressed++;
+  m_savedBytes += frame->len;
+
+  portENTER_CRITICAL(&statsMux);
+  stats.suppressed++;
+  stats.savedBytes += frame->len;
+  portEXIT_CRITICAL(&statsMux);
+}
+
+MotionGateStats getMotionGateStats()
+{
+  portENTER_CRITICAL(&statsMux);
+  MotionGateStats copy = stats;
+  portEXIT_CRITICAL(&statsMux);
+  return copy;
+}
@@ -0,0 +1,63 @@
+#ifndef MOTION_GATE_H
+#define MOTION_GATE_H
+
+#include <Arduino.h>
+
+#include "capture_pipeline.h"
+
+// Bramkowanie strumienia ruchem: klatka jest wysyłana, gdy jej sygnatura luminancji
+// (siatka MOTION_GRID_WIDTH x MOTION_GRID_HEIGHT średnich z miniatury DC) różni się od
+// sygnatury ostatnio wysłanej klatki w którejś komórce o co najmniej `threshold`
+// (SAD komórki), albo gdy od ostatniej wysyłki minęło `keepAlive` ms.
+
+struct MotionGateConfig
+{
+  bool enabled;
+  int threshold;           // zmiana jasności komórki (0-255)
+  unsigned long keepAlive; // ms
+};
+
+struct MotionGateStats
+{
+  uint32_t signatures;     // policzone sygnatury klatek
+  uint32_t failures;       // klatki bez sygnatury (wysyłane bez bramkowania)
+  float signatureTimeAvg;  // średni czas liczenia sygnatury (ms)
+  uint32_t suppressed;     // klatki niewysłane, wszystkie strumienie
+  uint64_t savedBytes;     // zaoszczędzone bajty, wszystkie strumienie
+};
+
+void setupMotionGate();
+
+MotionGateConfig defaultMotionGateConfig();
+
+// Stan bramki jednego strumienia
+class MotionGate
+{
+public:
+  explicit MotionGate(const MotionGateConfig &config);
+
+  const MotionGateConfig &config() const { return m_config; }
+
+  // czy wysłać klatkę; przy true klatka staje się odniesieniem dla kolejnych
+  bool admit(CapturedFrame *frame, unsigned long now);
+
+  // klatka niewysłana - do statystyk
+  void suppress(const CapturedFrame *frame);
+
+  uint32_t suppressedFrames() const { return m_suppressed; }
+  uint64_t savedBytes() const { return m_savedBytes; }
+  int lastScore() const { return m_lastScore; } // największa zmiana komórki ostatniej klatki
+
+private:
+  MotionGateConfig m_config;
+  uint8_t m_reference[MOTION_GRID_WIDTH * MOTION_GRID_HEIGHT];
+  bool m_hasReference = false;
+  unsigned long m_lastAdmit = 0;
+  uint32_t m_suppressed = 0;
+  uint64_t m_savedBytes = 0;
+  int m_lastScore = -1;
+};
+
+MotionGateStats getMotionGateStats();
+
+#endif // MOTION_GATE_H
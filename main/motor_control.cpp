@@ -1,9 +1,55 @@
 #include "motor_control.h"
 #include "sensor_control.h"
 #include "config.h"
+#include "hardware.h"
+#include "vehicle_state.h"
 #include <Arduino.h>
+#include <esp_timer.h>
 
-extern int getCurrentSpeedValue(); // Deklaracja funkcji z innego pliku
+#define MOTOR_HISTORY_SIZE 16 // zmiany prędkości pamiętane do dopasowania z klatkami
+
+// krótka historia zmian prędkości - czytana przez rejestrator z innego taska
+static MotorSpeeds motorHistory[MOTOR_HISTORY_SIZE];
+static int motorHistoryCount = 0;
+static int motorHistoryNext = 0;
+static portMUX_TYPE motorHistoryMux = portMUX_INITIALIZER_UNLOCKED;
+
+static void trackMotorSpeeds(int leftSpeed, int rightSpeed)
+{
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&motorHistoryMux);
+    motorHistory[motorHistoryNext] = {(int16_t)leftSpeed, (int16_t)rightSpeed, now, true};
+    motorHistoryNext = (motorHistoryNext + 1) % MOTOR_HISTORY_SIZE;
+    if (motorHistoryCount < MOTOR_HISTORY_SIZE)
+        motorHistoryCount++;
+    portEXIT_CRITICAL(&motorHistoryMux);
+}
+
+MotorSpeeds getMotorSpeedsAt(int64_t time)
+{
+    // przed pierwszą komendą silniki stoją od startu
+    MotorSpeeds result = {0, 0, 0, true};
+    portENTER_CRITICAL(&motorHistoryMux);
+    // od najnowszej zmiany wstecz - pierwsza nie późniejsza niż `time`
+    int i = 0;
+    for (; i < motorHistoryCount; i++)
+    {
+        const MotorSpeeds &entry = motorHistory[(motorHistoryNext - 1 - i + MOTOR_HISTORY_SIZE) % MOTOR_HISTORY_SIZE];
+        if (entry.since <= time)
+        {
+            result = entry;
+            break;
+        }
+    }
+    // zmiana z chwili `time` wypadła już z historii - najstarszy znany stan
+    if (i == motorHistoryCount && motorHistoryCount == MOTOR_HISTORY_SIZE)
+    {
+        result = motorHistory[motorHistoryNext];
+        result.known = false;
+    }
+    portEXIT_CRITICAL(&motorHistoryMux);
+    return result;
+}
 
 // Inicjalizacja pinów silników
 void setupMotors()
@@ -39,13 +85,14 @@ void moveForward()
 
     // Lewy silnik do przodu
     // digitalWrite(LEFT_MOTOR_ENA, HIGH);
-    analogWrite(LEFT_MOTOR_IN1, currentSpeed);
-    analogWrite(LEFT_MOTOR_IN2, 0);
+    writeMotorPin(LEFT_MOTOR_IN1, currentSpeed);
+    writeMotorPin(LEFT_MOTOR_IN2, 0);
 
     // Prawy silnik do przodu
     // digitalWrite(RIGHT_MOTOR_ENB, HIGH);
-    analogWrite(RIGHT_MOTOR_IN3, 0);
-    analogWrite(RIGHT_MOTOR_IN4, currentSpeed);
+    writeMotorPin(RIGHT_MOTOR_IN3, 0);
+    writeMotorPin(RIGHT_MOTOR_IN4, currentSpeed);
+    trackMotorSpeeds(currentSpeed, currentSpeed);
 }
 
 // Funkcja do jazdy pojazdem do tyłu
@@ -55,11 +102,12 @@ void moveBackward()
     int currentSpeed = getCurrentSpeedValue();
     Serial.println("Jazda do tyłu (prędkość: " + String(currentSpeed) + ")");
 
-    analogWrite(RIGHT_MOTOR_IN3, currentSpeed);
-    analogWrite(RIGHT_MOTOR_IN4, 0);
+    writeMotorPin(RIGHT_MOTOR_IN3, currentSpeed);
+    writeMotorPin(RIGHT_MOTOR_IN4, 0);
 
-    analogWrite(LEFT_MOTOR_IN1, 0);
-    analogWrite(LEFT_MOTOR_IN2, currentSpeed);
+    writeMotorPin(LEFT_MOTOR_IN1, 0);
+    writeMotorPin(LEFT_MOTOR_IN2, currentSpeed);
+    trackMotorSpeeds(-currentSpeed, -currentSpeed);
 }
 
 // Funkcja do skręcania pojazdem w lewo
@@ -72,13 +120,14 @@ void turnLeft()
 
     // Lewy silnik stop lub do tyłu
     // digitalWrite(LEFT_MOTOR_ENA, HIGH);
-    analogWrite(LEFT_MOTOR_IN1, 0);
-    analogWrite(LEFT_MOTOR_IN2, currentSpeed);
+    writeMotorPin(LEFT_MOTOR_IN1, 0);
+    writeMotorPin(LEFT_MOTOR_IN2, currentSpeed);
 
     // Prawy silnik do przodu
     // digitalWrite(RIGHT_MOTOR_ENB, HIGH);
-    analogWrite(RIGHT_MOTOR_IN3, 0);
-    analogWrite(RIGHT_MOTOR_IN4, currentSpeed);
+    writeMotorPin(RIGHT_MOTOR_IN3, 0);
+    writeMotorPin(RIGHT_MOTOR_IN4, currentSpeed);
+    trackMotorSpeeds(-currentSpeed, currentSpeed);
 }
 
 // Funkcja do skręcania pojazdem w prawo
@@ -91,13 +140,14 @@ void turnRight()
 
     // Lewy silnik do przodu
     // digitalWrite(LEFT_MOTOR_ENA, HIGH);
-    analogWrite(LEFT_MOTOR_IN1, currentSpeed);
-    analogWrite(LEFT_MOTOR_IN2, 0);
+    writeMotorPin(LEFT_MOTOR_IN1, currentSpeed);
+    writeMotorPin(LEFT_MOTOR_IN2, 0);
 
     // Prawy silnik stop lub do tyłu
     // digitalWrite(RIGHT_MOTOR_ENB, HIGH);
-    analogWrite(RIGHT_MOTOR_IN3, currentSpeed);
-    analogWrite(RIGHT_MOTOR_IN4, 0);
+    writeMotorPin(RIGHT_MOTOR_IN3, currentSpeed);
+    writeMotorPin(RIGHT_MOTOR_IN4, 0);
+    trackMotorSpeeds(currentSpeed, -currentSpeed);
 }
 
 // Funkcja do zatrzymania wszystkich silników
@@ -108,13 +158,14 @@ void stopMotors()
 
     // Zatrzymanie lewego silnika
     // digitalWrite(LEFT_MOTOR_ENA, LOW);
-    analogWrite(LEFT_MOTOR_IN1, 0);
-    analogWrite(LEFT_MOTOR_IN2, 0);
+    writeMotorPin(LEFT_MOTOR_IN1, 0);
+    writeMotorPin(LEFT_MOTOR_IN2, 0);
 
     // Zatrzymanie prawego silnika
     // digitalWrite(RIGHT_MOTOR_ENB, LOW);
-    analogWrite(RIGHT_MOTOR_IN3, 0);
-    analogWrite(RIGHT_MOTOR_IN4, 0);
+    writeMotorPin(RIGHT_MOTOR_IN3, 0);
+    writeMotorPin(RIGHT_MOTOR_IN4, 0);
+    trackMotorSpeeds(0, 0);
 }
 
 // Funkcja do kontrolowania prędkości obu silników
@@ -128,43 +179,45 @@ void setMotorSpeed(int leftSpeed, int rightSpeed)
     {
         // Lewy silnik do przodu
         digitalWrite(LEFT_MOTOR_ENA, HIGH);
-        analogWrite(LEFT_MOTOR_IN1, leftSpeed);
-        analogWrite(LEFT_MOTOR_IN2, 0);
+        writeMotorPin(LEFT_MOTOR_IN1, leftSpeed);
+        writeMotorPin(LEFT_MOTOR_IN2, 0);
     }
     else if (leftSpeed < 0)
     {
         // Lewy silnik do tyłu
         digitalWrite(LEFT_MOTOR_ENA, HIGH);
-        analogWrite(LEFT_MOTOR_IN1, 0);
-        analogWrite(LEFT_MOTOR_IN2, -leftSpeed);
+        writeMotorPin(LEFT_MOTOR_IN1, 0);
+        writeMotorPin(LEFT_MOTOR_IN2, -leftSpeed);
     }
     else
     {
         // Zatrzymanie lewego silnika
         digitalWrite(LEFT_MOTOR_ENA, LOW);
-        analogWrite(LEFT_MOTOR_IN1, 0);
-        analogWrite(LEFT_MOTOR_IN2, 0);
+        writeMotorPin(LEFT_MOTOR_IN1, 0);
+        writeMotorPin(LEFT_MOTOR_IN2, 0);
     }
 
     if (rightSpeed > 0)
     {
         // Prawy silnik do przodu
         digitalWrite(RIGHT_MOTOR_ENB, HIGH);
-        analogWrite(RIGHT_MOTOR_IN3, rightSpeed);
-        analogWrite(RIGHT_MOTOR_IN4, 0);
+        writeMotorPin(RIGHT_MOTOR_IN3, rightSpeed);
+        writeMotorPin(RIGHT_MOTOR_IN4, 0);
     }
     else if (rightSpeed < 0)
     {
         // Prawy silnik do tyłu
         digitalWrite(RIGHT_MOTOR_ENB, HIGH);
-        analogWrite(RIGHT_MOTOR_IN3, 0);
-        analogWrite(RIGHT_MOTOR_IN4, -rightSpeed);
+        writeMotorPin(RIGHT_MOTOR_IN3, 0);
+        writeMotorPin(RIGHT_MOTOR_IN4, -rightSpeed);
     }
     else
     {
         // Zatrzymanie prawego silnika
         digitalWrite(RIGHT_MOTOR_ENB, LOW);
-        analogWrite(RIGHT_MOTOR_IN3, 0);
-        analogWrite(RIGHT_MOTOR_IN4, 0);
+        writeMotorPin(RIGHT_MOTOR_IN3, 0);
+        writeMotorPin(RIGHT_MOTOR_IN4, 0);
     }
+
+    trackMotorSpeeds(leftSpeed, rightSpeed);
 }
\ No newline at end of file
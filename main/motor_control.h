@@ -1,6 +1,8 @@
 #ifndef MOTOR_CONTROL_H
 #define MOTOR_CONTROL_H
 
+#include <Arduino.h>
+
 // Funkcje do kontrolowania silników
 void setupMotors();
 void moveForward();
@@ -10,4 +12,16 @@ void turnRight();
 void stopMotors();
 void setMotorSpeed(int leftSpeed, int rightSpeed);
 
+// Prędkości kół (PWM, dodatnie - do przodu, ujemne - do tyłu) obowiązujące od chwili `since`
+struct MotorSpeeds
+{
+    int16_t left;
+    int16_t right;
+    int64_t since; // µs, zegar esp_timer_get_time()
+    bool known;    // false - `time` sprzed krótkiej historii zmian, podano najstarszy znany stan
+};
+
+// Prędkości obowiązujące w chwili `time` (µs, zegar esp_timer) - do dopasowania do znacznika klatki
+MotorSpeeds getMotorSpeedsAt(int64_t time);
+
 #endif // MOTOR_CONTROL_H
\ No newline at end of file
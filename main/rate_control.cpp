@@ -0,0 +1,78 @@
+#include "rate_control.h"
+#include "config.h"
+
+#include <esp_camera.h>
+
+static size_t targetBytes = JPEG_TARGET_FRAME_SIZE;
+static float averageBytes = 0;
+static int quality = 0;
+static int framesSinceChange = 0;
+static uint32_t adjustments = 0;
+
+void setupRateControl(int initialQuality)
+{
+  quality = initialQuality;
+  averageBytes = 0;
+  framesSinceChange = 0;
+}
+
+void setRateControlTarget(size_t bytesPerFrame)
+{
+  targetBytes = bytesPerFrame;
+  framesSinceChange = 0;
+}
+
+void resetRateControl()
+{
+  averageBytes = 0;
+  framesSinceChange = 0;
+}
+
+// odtwarzany na hoście na zapisanych przebiegach rozmiarów klatek (host/rate_control_replay.cpp)
+void updateRateControl(size_t frameLen)
+{
+  if (targetBytes == 0)
+    return;
+
+  averageBytes = averageBytes == 0 ? frameLen : averageBytes * 0.7f + frameLen * 0.3f;
+
+  // nowa jakość działa dopiero po kilku klatkach - bez czekania regulator by oscylował
+  if (++framesSinceChange < JPEG_RATE_HOLD_FRAMES)
+    return;
+
+  // histereza: w paśmie +-JPEG_RATE_HYSTERESIS % wokół celu jakość się nie zmienia
+  float ratio = averageBytes / targetBytes;
+  int next = quality;
+  if (ratio > 1.0f + JPEG_RATE_HYSTERESIS / 100.0f)
+  {
+    // za duże klatki - szybciej w dół, żeby nie zapchać łącza
+    next += ratio > 1.5f ? 4 : 1;
+  }
+  else if (ratio < 1.0f - JPEG_RATE_HYSTERESIS / 100.0f)
+  {
+    next -= 1;
+  }
+  next = constrain(next, JPEG_QUALITY_BEST, JPEG_QUALITY_WORST);
+
+  if (next == quality)
+    return;
+
+  sensor_t *s = esp_camera_sensor_get();
+  if (!s || s->set_quality(s, next) != 0)
+    return;
+
+  quality = next;
+  framesSinceChange = 0;
+  adjustments++;
+}
+
+RateControlStats getRateControlStats()
+{
+  RateControlStats stats;
+  stats.enabled = targetBytes > 0;
+  stats.targetBytes = targetBytes;
+  stats.averageBytes = averageBytes;
+  stats.quality = quality;
+  stats.adjustments = adjustments;
+  return stats;
+}
@@ -0,0 +1,28 @@
+#ifndef RATE_CONTROL_H
+#define RATE_CONTROL_H
+
+#include <Arduino.h>
+
+// Regulator rozmiaru klatki JPEG: między klatkami koryguje jakość sensora (set_quality),
+// żeby średni rozmiar klatki trzymał się budżetu bajtów - przepływność strumienia
+// w sieci AP jest wtedy przewidywalna niezależnie od zawartości sceny.
+void setupRateControl(int initialQuality);
+void updateRateControl(size_t frameLen);
+
+void setRateControlTarget(size_t bytesPerFrame);
+
+// po skokowej zmianie rozmiaru klatek (np. rozdzielczości) średnia liczona od nowa
+void resetRateControl();
+
+struct RateControlStats
+{
+  bool enabled;
+  size_t targetBytes;    // budżet bajtów na klatkę
+  float averageBytes;    // średnia krocząca rozmiaru klatki
+  int quality;           // aktualna jakość sensora (0-63, mniej = lepiej)
+  uint32_t adjustments;  // liczba zmian jakości
+};
+
+RateControlStats getRateControlStats();
+
+#endif // RATE_CONTROL_H
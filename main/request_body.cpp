@@ -0,0 +1,97 @@
+#include "request_body.h"
+#include "config.h"
+
+// Bufor o stałym rozmiarze na ciało żądania - zamiast kopii w String z arg("plain")
+static char bodyBuffer[API_BODY_MAX_SIZE];
+static size_t bodyLength = 0;
+static bool bodyReceived = false;
+static bool bodyOverflow = false;
+static bool bodyRejected = false;
+
+bool receiveRequestBodyChunk(WebServer &server)
+{
+    HTTPRaw &raw = server.raw();
+
+    switch (raw.status)
+    {
+    case RAW_START:
+        bodyLength = 0;
+        bodyReceived = false;
+        bodyOverflow = false;
+        bodyRejected = false;
+
+        // Content-Length znany z nagłówków - odrzucamy za duże ciało zanim cokolwiek odczytamy
+        if (server.clientContentLength() > sizeof(bodyBuffer))
+        {
+            Serial.printf("Ciało żądania za duże: %u bajtów (limit %u)\n",
+                          (unsigned)server.clientContentLength(), (unsigned)sizeof(bodyBuffer));
+            bodyOverflow = true;
+            bodyRejected = true;
+            return false;
+        }
+        break;
+
+    case RAW_WRITE:
+        bodyReceived = true;
+        // po przekroczeniu limitu reszta ciała jest tylko odczytywana z gniazda i pomijana
+        if (bodyOverflow || bodyLength + raw.currentSize > sizeof(bodyBuffer))
+        {
+            bodyOverflow = true;
+            break;
+        }
+        memcpy(bodyBuffer + bodyLength, raw.buf, raw.currentSize);
+        bodyLength += raw.currentSize;
+        break;
+
+    case RAW_ABORTED:
+        bodyLength = 0;
+        bodyReceived = false;
+        break;
+
+    case RAW_END:
+    default:
+        break;
+    }
+
+    return true;
+}
+
+bool consumeRequestBodyRejection()
+{
+    if (!bodyRejected)
+    {
+        return false;
+    }
+
+    bodyRejected = false;
+    bodyOverflow = false;
+    bodyReceived = false;
+    bodyLength = 0;
+    return true;
+}
+
+RequestBodyStatus parseRequestBody(JsonDocument &doc, const JsonDocument &filter, DeserializationError &error)
+{
+    // ciało jest jednorazowe - kolejne żądanie bez ciała nie może odczytać poprzedniego
+    bool received = bodyReceived;
+    bodyReceived = false;
+
+    bodyRejected = false;
+    if (bodyOverflow)
+    {
+        bodyOverflow = false;
+        return BODY_TOO_LARGE;
+    }
+    if (!received || bodyLength == 0)
+    {
+        return BODY_MISSING;
+    }
+
+    // bufor char* jest deserializowany w miejscu (bez kopiowania stringów)
+    error = deserializeJson(doc, bodyBuffer, bodyLength, DeserializationOption::Filter(filter));
+    if (error)
+    {
+        return BODY_INVALID_JSON;
+    }
+    return BODY_OK;
+}
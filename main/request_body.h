@@ -0,0 +1,28 @@
+#ifndef REQUEST_BODY_H
+#define REQUEST_BODY_H
+
+#include <WebServer.h>
+#include <ArduinoJson.h>
+
+// Wynik odczytu ciała żądania API
+enum RequestBodyStatus
+{
+    BODY_OK,           // ciało odebrane i sparsowane
+    BODY_MISSING,      // brak ciała żądania
+    BODY_TOO_LARGE,    // ciało przekroczyło limit API_BODY_MAX_SIZE
+    BODY_INVALID_JSON  // błąd deserializacji JSON
+};
+
+// Odbiór kolejnego fragmentu ciała żądania (wywoływany przez WebServer w trybie raw).
+// Zwraca false, jeśli ciało jest za duże i należy od razu odpowiedzieć kodem 413.
+bool receiveRequestBodyChunk(WebServer& server);
+
+// Czy ciało bieżącego żądania zostało odrzucone (413 już wysłane); zeruje flagę
+bool consumeRequestBodyRejection();
+
+// Deserializacja odebranego ciała z filtrem zostawiającym tylko potrzebne klucze. Ciało
+// odrzucone w trakcie odbioru daje BODY_TOO_LARGE - handler sprawdza wcześniej
+// consumeRequestBodyRejection(), żeby nie wysłać drugiej odpowiedzi 413.
+RequestBodyStatus parseRequestBody(JsonDocument& doc, const JsonDocument& filter, DeserializationError& error);
+
+#endif // REQUEST_BODY_H
@@ -0,0 +1,58 @@
+#include "request_stats.h"
+
+static portMUX_TYPE requestMux = portMUX_INITIALIZER_UNLOCKED;
+static RequestClassStats classes[REQUEST_CLASS_COUNT];
+static unsigned long windowStart = 0;
+
+void recordRequest(RequestClass requestClass, unsigned long elapsedUs, uint32_t count)
+{
+    if (requestClass >= REQUEST_CLASS_COUNT)
+        return;
+
+    portENTER_CRITICAL(&requestMux);
+    RequestClassStats &stats = classes[requestClass];
+    stats.count += count;
+    stats.totalUs += elapsedUs;
+    if (elapsedUs > stats.maxUs)
+        stats.maxUs = elapsedUs;
+    portEXIT_CRITICAL(&requestMux);
+}
+
+RequestLoadStats getRequestLoadStats(bool reset)
+{
+    RequestLoadStats result;
+    unsigned long now = millis();
+    portENTER_CRITICAL(&requestMux);
+    result.window = now - windowStart;
+    memcpy(result.classes, classes, sizeof(classes));
+    if (reset)
+    {
+        memset(classes, 0, sizeof(classes));
+        windowStart = now;
+    }
+    portEXIT_CRITICAL(&requestMux);
+    return result;
+}
+
+const char *requestClassName(RequestClass requestClass)
+{
+    switch (requestClass)
+    {
+    case REQUEST_PAGE:
+        return "page";
+    case REQUEST_API:
+        return "api";
+    case REQUEST_CAMERA:
+        return "camera";
+    case REQUEST_DATASET:
+        return "dataset";
+    case REQUEST_WS_COMMAND:
+        return "ws_command";
+    case REQUEST_WS_PUSH:
+        return "ws_push";
+    case REQUEST_STREAM:
+        return "stream";
+    default:
+        return "unknown";
+    }
+}
@@ -0,0 +1,60 @@
+#ifndef REQUEST_STATS_H
+#define REQUEST_STATS_H
+
+#include <Arduino.h>
+
+// Czas obsługi żądań według klas - ile czasu procesora zabiera każda klasa ruchu pod
+// obciążeniem (/api/load, host/load/vehicle_load.cpp). Mierzony jest czas handlera na tasku, który
+// go wykonuje: pętla główna dla HTTP i WebSocket, workery strumienia dla klatek MJPEG.
+enum RequestClass
+{
+    REQUEST_PAGE,       // strona sterowania i proste endpointy web_server
+    REQUEST_API,        // REST /api/...
+    REQUEST_CAMERA,     // /capture, /camera/..., /ml/frame, przyjęcie klienta /stream
+    REQUEST_DATASET,    // /dataset/...
+    REQUEST_WS_COMMAND, // komendy WebSocket
+    REQUEST_WS_PUSH,    // wysyłki WebSocket z pętli: czujnik, ping, tensory, kroki lockstep
+    REQUEST_STREAM,     // wysyłka klatek MJPEG (liczone klatki)
+    REQUEST_CLASS_COUNT
+};
+
+struct RequestClassStats
+{
+    uint32_t count;
+    uint64_t totalUs;
+    uint32_t maxUs;
+};
+
+struct RequestLoadStats
+{
+    unsigned long window;                          // czas od ostatniego wyzerowania (ms)
+    RequestClassStats classes[REQUEST_CLASS_COUNT];
+};
+
+void recordRequest(RequestClass requestClass, unsigned long elapsedUs, uint32_t count = 1);
+
+RequestLoadStats getRequestLoadStats(bool reset = false);
+
+const char *requestClassName(RequestClass requestClass);
+
+// Pomiar handlera od konstrukcji do końca zakresu
+class RequestTimer
+{
+public:
+    explicit RequestTimer(RequestClass requestClass) : requestClass(requestClass), start(micros()) {}
+    ~RequestTimer() { recordRequest(requestClass, micros() - start); }
+
+private:
+    RequestClass requestClass;
+    unsigned long start;
+};
+
+// Handler WebServer mierzony w klasie `C`, do rejestracji w server.on()
+template <RequestClass C, void (*Handler)()>
+void timedHandler()
+{
+    RequestTimer timer(C);
+    Handler();
+}
+
+#endif // REQUEST_STATS_H
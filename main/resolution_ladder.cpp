@@ -0,0 +1,218 @@
+#include "resolution_ladder.h"
+#include "config.h"
+#include "rate_control.h"
+
+#include "src/esp32cam/camera.hpp"
+
+using esp32cam::Resolution;
+
+#define LADDER_LEVELS 4
+
+static Resolution ladder[LADDER_LEVELS];
+static int ladderLevels = 0;
+static int level = 0;
+static int appliedLevel = -1;
+static bool changePending = false;
+static bool ladderEnabled = true;
+static bool ladderActive = false;
+
+// pomiary z workerów (rdzeń 0), czytane przez task przechwytywania (rdzeń 1)
+static portMUX_TYPE ladderMux = portMUX_INITIALIZER_UNLOCKED;
+static size_t windowBytes = 0;
+static unsigned long windowSendTime = 0;
+static uint32_t windowFrames = 0;
+static uint32_t windowSkips = 0;
+
+static unsigned long windowStart = 0;
+static unsigned long lastChangeTime = 0;
+static unsigned long congestedSince = 0;
+static unsigned long headroomSince = 0;
+
+static float throughput = 0;
+static float sendTimeAvg = 0;
+static float skipRatio = 0;
+static uint32_t stepsUp = 0;
+static uint32_t stepsDown = 0;
+static uint32_t discardedFrames = 0;
+
+void setupResolutionLadder()
+{
+  static const int sizes[LADDER_LEVELS][2] = {{160, 120}, {320, 240}, {400, 296}, {640, 480}};
+
+  ladderLevels = 0;
+  for (int i = 0; i < LADDER_LEVELS; i++)
+  {
+    Resolution r = Resolution::find(sizes[i][0], sizes[i][1]);
+    if (r.isValid())
+      ladder[ladderLevels++] = r;
+  }
+}
+
+static int findLevel(int width, int height)
+{
+  for (int i = 0; i < ladderLevels; i++)
+  {
+    if (ladder[i].getWidth() >= width && ladder[i].getHeight() >= height)
+      return i;
+  }
+  return ladderLevels - 1;
+}
+
+void startResolutionLadder()
+{
+  portENTER_CRITICAL(&ladderMux);
+  windowBytes = 0;
+  windowSendTime = 0;
+  windowFrames = 0;
+  windowSkips = 0;
+  portEXIT_CRITICAL(&ladderMux);
+
+  // start od QVGA - dotychczasowa rozdzielczość strumienia
+  level = findLevel(320, 240);
+  appliedLevel = -1;
+  changePending = false;
+  windowStart = millis();
+  lastChangeTime = windowStart;
+  congestedSince = 0;
+  headroomSince = 0;
+  // każda sesja strumienia zaczyna w trybie automatycznym
+  ladderEnabled = true;
+  ladderActive = true;
+}
+
+void stopResolutionLadder()
+{
+  ladderActive = false;
+}
+
+void setResolutionLadderEnabled(bool enabled)
+{
+  if (enabled && !ladderEnabled)
+  {
+    // wymuszenie ponownego ustawienia szczebla po ręcznej zmianie
+    appliedLevel = -1;
+  }
+  ladderEnabled = enabled;
+}
+
+void reportStreamSend(size_t bytes, unsigned long sendTime)
+{
+  portENTER_CRITICAL(&ladderMux);
+  windowBytes += bytes;
+  windowSendTime += sendTime;
+  windowFrames++;
+  portEXIT_CRITICAL(&ladderMux);
+}
+
+void reportStreamSkip()
+{
+  portENTER_CRITICAL(&ladderMux);
+  windowSkips++;
+  portEXIT_CRITICAL(&ladderMux);
+}
+
+// ocena okna pomiarowego; zwraca nowy szczebel
+static int evaluateWindow(unsigned long now)
+{
+  portENTER_CRITICAL(&ladderMux);
+  size_t bytes = windowBytes;
+  unsigned long sendTime = windowSendTime;
+  uint32_t frames = windowFrames;
+  uint32_t skips = windowSkips;
+  windowBytes = 0;
+  windowSendTime = 0;
+  windowFrames = 0;
+  windowSkips = 0;
+  portEXIT_CRITICAL(&ladderMux);
+
+  unsigned long elapsed = now - windowStart;
+  windowStart = now;
+
+  throughput = elapsed > 0 ? bytes * 1000.0f / elapsed : 0;
+  skipRatio = frames + skips > 0 ? (float)skips / (frames + skips) : 0;
+  if (frames > 0)
+    sendTimeAvg = (float)sendTime / frames;
+
+  // łącze nie nadąża: wysyłka klatki zajmuje większość odstępu między klatkami
+  // albo klienci pomijają klatki
+  bool congested = frames + skips > 0 &&
+                   (sendTimeAvg > STREAM_FRAME_INTERVAL * 0.8f || skipRatio > 0.2f);
+  // zapas: szybka wysyłka, brak pominięć i regulator JPEG ma zapas jakości
+  // na większą klatkę przy tym samym budżecie bajtów
+  bool headroom = frames > 0 && skips == 0 &&
+                  sendTimeAvg < STREAM_FRAME_INTERVAL * 0.3f &&
+                  getRateControlStats().quality <= RESOLUTION_UP_MAX_QUALITY;
+
+  congestedSince = congested ? (congestedSince ? congestedSince : now) : 0;
+  headroomSince = headroom ? (headroomSince ? headroomSince : now) : 0;
+
+  if (now - lastChangeTime < RESOLUTION_MIN_HOLD)
+    return level;
+
+  if (congestedSince && now - congestedSince >= RESOLUTION_DOWN_DWELL && level > 0)
+  {
+    stepsDown++;
+    return level - 1;
+  }
+  if (headroomSince && now - headroomSince >= RESOLUTION_UP_DWELL && level < ladderLevels - 1)
+  {
+    stepsUp++;
+    return level + 1;
+  }
+  return level;
+}
+
+// wywoływane przez Camera.processPending() w tasku przechwytywania
+static void onLevelApplied(int target, bool ok)
+{
+  changePending = false;
+  if (!ok)
+  {
+    // bez ponawiania w każdej klatce - zostajemy na poprzednim szczeblu
+    appliedLevel = level = appliedLevel >= 0 ? appliedLevel : target;
+    return;
+  }
+
+  appliedLevel = target;
+  lastChangeTime = millis();
+  congestedSince = 0;
+  headroomSince = 0;
+  discardedFrames += RESOLUTION_DISCARD_FRAMES;
+  // rozmiar klatek zmienia się skokowo - regulator jakości zaczyna uśredniać od nowa
+  resetRateControl();
+}
+
+void updateResolutionLadder()
+{
+  if (!ladderActive || !ladderEnabled || ladderLevels == 0 || changePending)
+    return;
+
+  unsigned long now = millis();
+  if (now - windowStart >= RESOLUTION_WINDOW)
+    level = evaluateWindow(now);
+
+  if (level == appliedLevel)
+    return;
+
+  // pierwsze klatki po zmianie rozdzielczości są niestabilne (ekspozycja, stare bufory)
+  int target = level;
+  changePending = esp32cam::Camera.changeResolutionAsync(
+      ladder[target], RESOLUTION_DISCARD_FRAMES,
+      [target](bool ok) { onLevelApplied(target, ok); });
+}
+
+ResolutionLadderStats getResolutionLadderStats()
+{
+  ResolutionLadderStats stats;
+  stats.enabled = ladderEnabled;
+  stats.active = ladderActive;
+  stats.width = ladderLevels > 0 ? ladder[level].getWidth() : 0;
+  stats.height = ladderLevels > 0 ? ladder[level].getHeight() : 0;
+  stats.throughput = throughput;
+  stats.sendTimeAvg = sendTimeAvg;
+  stats.skipRatio = skipRatio;
+  stats.stepsUp = stepsUp;
+  stats.stepsDown = stepsDown;
+  stats.discardedFrames = discardedFrames;
+  return stats;
+}
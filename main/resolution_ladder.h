@@ -0,0 +1,42 @@
+#ifndef RESOLUTION_LADDER_H
+#define RESOLUTION_LADDER_H
+
+#include <Arduino.h>
+
+// Automatyczny dobór rozdzielczości strumienia z drabinki QQVGA -> QVGA -> CIF -> VGA.
+// Workery strumienia raportują czas wysyłki klatek i pominięcia, a task przechwytywania
+// między klatkami decyduje o zmianie szczebla (z histerezą czasu przebywania).
+void setupResolutionLadder();
+
+// start/stop razem z pierwszym/ostatnim strumieniem
+void startResolutionLadder();
+void stopResolutionLadder();
+
+// ręczna zmiana rozdzielczości wyłącza drabinkę, res=auto włącza ją ponownie
+void setResolutionLadderEnabled(bool enabled);
+
+// pomiary z workerów strumienia
+void reportStreamSend(size_t bytes, unsigned long sendTime);
+void reportStreamSkip();
+
+// wywoływane przez task przechwytywania między klatkami; zmiana szczebla jest kolejkowana
+// w esp32cam::Camera i stosowana przez processPending() razem z odrzuceniem niestabilnych klatek
+void updateResolutionLadder();
+
+struct ResolutionLadderStats
+{
+  bool enabled;
+  bool active;
+  int width;               // bieżący szczebel
+  int height;
+  float throughput;        // przepływność wysyłki strumieni (B/s)
+  float sendTimeAvg;       // średni czas wysyłki klatki (ms)
+  float skipRatio;         // udział pominiętych klatek w ostatnim oknie
+  uint32_t stepsUp;
+  uint32_t stepsDown;
+  uint32_t discardedFrames;
+};
+
+ResolutionLadderStats getResolutionLadderStats();
+
+#endif // RESOLUTION_LADDER_H
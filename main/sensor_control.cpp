@@ -1,36 +1,80 @@
 #include "sensor_control.h"
 #include "motor_control.h"
+#include "hardware.h"
+#include "vehicle_state.h"
+
+#include <esp_timer.h>
 
 #define SAFETY_DISTANCE 16.0 // po przekroczeniu tej wartości silniki się zatrzymują
+#define DISTANCE_FILTER_SIZE 3
+#define DISTANCE_FILTER_MAX_GAP 500000 // µs; po dłuższej przerwie filtr zaczyna od nowa
 
-bool isMovingForward = false;
-unsigned long lastEmergencyStopTime = 0;
 const unsigned long EMERGENCY_COOLDOWN = 500; // cooldown in ms to prevent rapid on/off
 
+// ostatnie poprawne pomiary - czytane także przez rejestrator z innego taska
+static float distanceSamples[DISTANCE_FILTER_SIZE];
+static int distanceSampleCount = 0;
+static DistanceReading filteredDistance = {-1, 0};
+static portMUX_TYPE distanceMux = portMUX_INITIALIZER_UNLOCKED;
+
+static void filterDistance(float distance)
+{
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&distanceMux);
+    if (distanceSampleCount > 0 && now - filteredDistance.timestamp > DISTANCE_FILTER_MAX_GAP)
+        distanceSampleCount = 0;
+    if (distanceSampleCount == DISTANCE_FILTER_SIZE)
+    {
+        memmove(distanceSamples, distanceSamples + 1, (DISTANCE_FILTER_SIZE - 1) * sizeof(float));
+        distanceSampleCount--;
+    }
+    distanceSamples[distanceSampleCount++] = distance;
+
+    // mediana z trzech; przy mniejszej liczbie pomiarów - ostatni
+    float median = distance;
+    if (distanceSampleCount == DISTANCE_FILTER_SIZE)
+    {
+        float a = distanceSamples[0], b = distanceSamples[1], c = distanceSamples[2];
+        median = max(min(a, b), min(max(a, b), c));
+    }
+    filteredDistance = {median, now};
+    portEXIT_CRITICAL(&distanceMux);
+}
+
+DistanceReading getFilteredDistance()
+{
+    portENTER_CRITICAL(&distanceMux);
+    DistanceReading reading = filteredDistance;
+    portEXIT_CRITICAL(&distanceMux);
+    if (reading.timestamp == 0 || esp_timer_get_time() - reading.timestamp > DISTANCE_FILTER_MAX_GAP)
+        reading.distance = -1;
+    return reading;
+}
+
 void setupSensor() {
     pinMode(TRIGGER_PIN, OUTPUT); // TRIGGER jako wyjście
     pinMode(ECHO_PIN, INPUT);     // ECHO jako wejście
     digitalWrite(TRIGGER_PIN, LOW); // ustawienie na starcie trigger na LOW
 }
 
-float getDistance() {
-    digitalWrite(TRIGGER_PIN, LOW);
-    delayMicroseconds(2);
-    
-    digitalWrite(TRIGGER_PIN, HIGH);
-    delayMicroseconds(10);
-    digitalWrite(TRIGGER_PIN, LOW);
-    
-    long duration = pulseIn(ECHO_PIN, HIGH, 30000); // Timeout after 30ms
-
+float echoToDistance(unsigned long duration) {
     // klakulacja odległości w cm
-    float distance = duration * 0.0343 / 2;
+    float distance = duration * 0.0343f / 2;
 
     // filtrowanie zbyt dużych wartości (np. powyżej 400cm bo to pewnie error)
     if (distance > 400 || duration == 0) {
         return -1;
     }
-    
+    return distance;
+}
+
+float getDistance() {
+    float distance = echoToDistance(measureEchoPulse(30000)); // Timeout after 30ms
+    if (distance < 0) {
+        return -1;
+    }
+
+    filterDistance(distance);
     return distance;
 }
 
@@ -38,19 +82,19 @@ void checkObstacles() {
     unsigned long currentMillis = millis();
     
     // Only check if we're moving forward and enough time has passed since last emergency stop
-    if (isMovingForward && (currentMillis - lastEmergencyStopTime > EMERGENCY_COOLDOWN)) {
+    if (vehicle.movingForward && (currentMillis - vehicle.lastEmergencyStopTime > EMERGENCY_COOLDOWN)) {
         float distance = getDistance();
         
         // Valid distance reading that is too close
         if (distance > 0 && distance <= SAFETY_DISTANCE) {
             Serial.println("EMERGENCY STOP: Obstacle detected at " + String(distance) + " cm");
             stopMotors();
-            isMovingForward = false;
-            lastEmergencyStopTime = currentMillis;
+            vehicle.movingForward = false;
+            vehicle.lastEmergencyStopTime = currentMillis;
         }
     }
 }
 
 void setForwardMovement(bool isForward) {
-    isMovingForward = isForward;
+    vehicle.movingForward = isForward;
 }
\ No newline at end of file
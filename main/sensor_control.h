@@ -9,7 +9,19 @@
 
 void setupSensor();
 float getDistance();
+// Czas echa HC-SR04 (µs) na odległość w cm, -1 - brak echa albo poza zasięgiem
+float echoToDistance(unsigned long duration);
 void checkObstacles();
 void setForwardMovement(bool isForward);
 
+// Odległość po filtrze medianowym z trzech ostatnich poprawnych pomiarów getDistance()
+// (odrzuca pojedyncze fałszywe echa HC-SR04); bez wyzwalania nowego pomiaru
+struct DistanceReading
+{
+    float distance;    // cm, -1 - brak świeżego poprawnego pomiaru
+    int64_t timestamp; // ostatni pomiar w filtrze (µs, zegar esp_timer_get_time())
+};
+
+DistanceReading getFilteredDistance();
+
 #endif // SENSOR_CONTROL_H
\ No newline at end of file
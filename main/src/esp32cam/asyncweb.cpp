@@ -0,0 +1,330 @@
+#if __has_include(<ESPAsyncWebServer.h>)
+
+#include "asyncweb.hpp"
+#include "logger.hpp"
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/idf_additions.h>
+#include <freertos/semphr.h>
+
+#define STILL_LOG(fmt, ...) ESP32CAM_LOG("StillResponse(%p) " fmt, this, ##__VA_ARGS__)
+#define MJPEG_LOG(fmt, ...) ESP32CAM_LOG("MjpegResponse(%p) " fmt, this, ##__VA_ARGS__)
+
+namespace esp32cam {
+namespace detail {
+
+class CaptureServiceLock {
+public:
+  explicit CaptureServiceLock(void* mutex)
+    : m_mutex(reinterpret_cast<SemaphoreHandle_t>(mutex)) {
+    xSemaphoreTake(m_mutex, portMAX_DELAY);
+  }
+
+  ~CaptureServiceLock() {
+    xSemaphoreGive(m_mutex);
+  }
+
+private:
+  SemaphoreHandle_t m_mutex;
+};
+
+CaptureService&
+CaptureService::get() {
+  static CaptureService instance;
+  return instance;
+}
+
+CaptureService::CaptureService()
+  : m_mutex(xSemaphoreCreateMutex()) {}
+
+bool
+CaptureService::subscribe(bool continuous) {
+  if (m_mutex == nullptr) {
+    return false;
+  }
+
+  CaptureServiceLock lock(m_mutex);
+  if (m_task == nullptr) {
+    TaskHandle_t task = nullptr;
+    if (xTaskCreatePinnedToCore(run, "esp32cam-capture", 4096, this, 1, &task,
+                                xPortGetCoreID()) != pdPASS) {
+      return false;
+    }
+    m_task = task;
+  }
+
+  ++m_stats.subscribers;
+  if (continuous) {
+    ++m_continuous;
+    xTaskNotifyGive(reinterpret_cast<TaskHandle_t>(m_task));
+  }
+  return true;
+}
+
+void
+CaptureService::unsubscribe(bool continuous) {
+  CaptureServiceLock lock(m_mutex);
+  if (continuous) {
+    --m_continuous;
+  }
+  if (--m_stats.subscribers > 0) {
+    return;
+  }
+
+  // nobody is left to consume queued frames; return their buffers to the camera driver
+  for (auto& entry : m_queue) {
+    entry.frame.reset();
+  }
+  m_count = 0;
+  m_stats.depth = 0;
+}
+
+uint32_t
+CaptureService::request() {
+  CaptureServiceLock lock(m_mutex);
+  m_requested = true;
+  xTaskNotifyGive(reinterpret_cast<TaskHandle_t>(m_task));
+  // a capture already in progress has started before this request
+  return m_nextSeq + (m_capturing ? 1 : 0);
+}
+
+bool
+CaptureService::retrieve(uint32_t& minSeq, std::shared_ptr<Frame>& frame) {
+  CaptureServiceLock lock(m_mutex);
+  for (size_t i = m_count; i > 0; --i) {
+    const Entry& entry = m_queue[(m_head + i - 1) % QUEUE_CAPACITY];
+    if (static_cast<int32_t>(entry.seq - minSeq) >= 0) {
+      frame = entry.frame;
+      minSeq = entry.seq + 1;
+      return true;
+    }
+  }
+  return false;
+}
+
+CaptureService::Stats
+CaptureService::getStats() const {
+  CaptureServiceLock lock(m_mutex);
+  return m_stats;
+}
+
+void
+CaptureService::run(void* ctx) {
+  auto self = reinterpret_cast<CaptureService*>(ctx);
+  while (true) {
+    self->loop();
+  }
+}
+
+void
+CaptureService::loop() {
+  bool wanted = false;
+  {
+    CaptureServiceLock lock(m_mutex);
+    wanted = m_continuous > 0 || m_requested;
+    if (wanted) {
+      m_requested = false;
+      m_capturing = true;
+      // make room before capturing: the evicted frame returns its buffer to the camera driver
+      if (m_count == QUEUE_CAPACITY) {
+        m_queue[m_head].frame.reset();
+        m_head = (m_head + 1) % QUEUE_CAPACITY;
+        --m_count;
+        ++m_stats.evictions;
+      }
+    }
+  }
+
+  if (!wanted) {
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(10000));
+    return;
+  }
+
+  std::shared_ptr<Frame> frame = Camera.capture();
+
+  CaptureServiceLock lock(m_mutex);
+  m_capturing = false;
+  if (frame == nullptr) {
+    ++m_stats.failures;
+  } else {
+    ++m_stats.captures;
+  }
+  if (m_stats.subscribers == 0) {
+    return;
+  }
+
+  Entry& entry = m_queue[(m_head + m_count) % QUEUE_CAPACITY];
+  entry.seq = m_nextSeq++;
+  entry.frame = std::move(frame);
+  ++m_count;
+  m_stats.depth = m_count;
+  m_stats.maxDepth = std::max<uint32_t>(m_stats.maxDepth, m_count);
+}
+
+} // namespace detail
+namespace asyncweb {
+
+StillResponse::StillResponse() {
+  STILL_LOG("created");
+  auto& service = detail::CaptureService::get();
+  if (m_subscribed = service.subscribe(); !m_subscribed) {
+    _code = 500;
+    return;
+  }
+
+  _code = 200;
+  _contentType = "image/jpeg";
+  _sendContentLength = false;
+  m_minSeq = service.request();
+}
+
+StillResponse::~StillResponse() {
+  if (m_subscribed) {
+    detail::CaptureService::get().unsubscribe();
+  }
+  STILL_LOG("deleted");
+}
+
+size_t
+StillResponse::_fillBuffer(uint8_t* buf, size_t buflen) {
+  if (m_index == 0 && !m_frame) {
+    if (!detail::CaptureService::get().retrieve(m_minSeq, m_frame)) {
+      return RESPONSE_TRY_AGAIN;
+    }
+    if (!m_frame) {
+      STILL_LOG("capture failed");
+      return 0;
+    }
+    STILL_LOG("frame has %zu octets", m_frame->size());
+  }
+
+  if (m_index >= m_frame->size()) {
+    STILL_LOG("sent to client");
+    return 0;
+  }
+
+  size_t len = std::min(buflen, m_frame->size() - m_index);
+  std::copy_n(m_frame->data() + m_index, len, buf);
+  m_index += len;
+  return len;
+}
+
+MjpegResponse::MjpegResponse(const MjpegConfig& cfg)
+  : m_continuous(cfg.minInterval < 0)
+  , m_ctrl(cfg) {
+  MJPEG_LOG("created");
+  if (m_subscribed = detail::CaptureService::get().subscribe(m_continuous); !m_subscribed) {
+    _code = 500;
+    m_ctrl.notifyFail();
+    return;
+  }
+
+  _code = 200;
+  m_hdr.prepareResponseContentType();
+  _contentType = String(m_hdr.buf, m_hdr.size);
+  _sendContentLength = false;
+}
+
+MjpegResponse::~MjpegResponse() {
+  auto& service = detail::CaptureService::get();
+  if (m_subscribed) {
+    service.unsubscribe(m_continuous);
+  }
+
+  int nFrames = m_ctrl.countSentFrames();
+  float fps = 1000.0 * nFrames / (millis() - m_createTime);
+  auto stats = service.getStats();
+  MJPEG_LOG("deleted after %d frames at fps %f, capture queue depth=%u max=%u evictions=%u",
+            m_ctrl.countSentFrames(), fps, stats.depth, stats.maxDepth, stats.evictions);
+}
+
+size_t
+MjpegResponse::_fillBuffer(uint8_t* buf, size_t buflen) {
+  auto act = m_ctrl.decideAction();
+  switch (act) {
+    case Ctrl::RETURN: {
+      if (std::shared_ptr<Frame> frame;
+          detail::CaptureService::get().retrieve(m_minSeq, frame)) {
+        m_ctrl.notifyReturn(std::move(frame));
+      }
+      m_sendSince = millis();
+      m_sendNext = SIPartHeader;
+      m_sendRemain = 0;
+
+      if (m_ctrl.decideAction() != Ctrl::SEND) {
+        return RESPONSE_TRY_AGAIN;
+      }
+      // fallthrough
+    }
+    case Ctrl::SEND: {
+      size_t len = sendPart(buf, buflen);
+      if (len == 0 && m_sendNext == SINone) {
+        m_ctrl.notifySent(true);
+      } else {
+        if (static_cast<int>(millis() - m_sendSince) > m_ctrl.cfg.frameTimeout) {
+          m_ctrl.notifySent(false);
+        }
+        return len;
+      }
+
+      if (m_ctrl.decideAction() != Ctrl::CAPTURE) {
+        return RESPONSE_TRY_AGAIN;
+      }
+      // fallthrough
+    }
+    case Ctrl::CAPTURE: {
+      // in continuous mode, frames keep arriving; otherwise ask for a fresh one
+      if (!m_continuous) {
+        m_minSeq = detail::CaptureService::get().request();
+      }
+      m_ctrl.notifyCapture();
+      return RESPONSE_TRY_AGAIN;
+    }
+    case Ctrl::STOP:
+      return 0;
+    default:
+      return RESPONSE_TRY_AGAIN;
+  }
+}
+
+size_t
+MjpegResponse::sendPart(uint8_t* buf, size_t buflen) {
+  if (m_sendRemain == 0) {
+    switch (m_sendNext) {
+      case SIPartHeader:
+        // retrieve() has moved m_minSeq past the frame being sent
+        m_hdr.preparePartHeader(m_ctrl.getFrame()->size(), m_ctrl.getFrame()->getTimestamp(),
+                                m_minSeq - 1, esp_timer_get_time());
+        m_sendBuf = reinterpret_cast<const uint8_t*>(m_hdr.buf);
+        m_sendRemain = m_hdr.size;
+        m_sendNext = SIFrame;
+        break;
+      case SIFrame: {
+        Frame* frame = m_ctrl.getFrame();
+        m_sendBuf = frame->data();
+        m_sendRemain = frame->size();
+        m_sendNext = SIPartTrailer;
+        break;
+      }
+      case SIPartTrailer:
+        m_hdr.preparePartTrailer();
+        m_sendBuf = reinterpret_cast<const uint8_t*>(m_hdr.buf);
+        m_sendRemain = m_hdr.size;
+        m_sendNext = SINone;
+        break;
+      case SINone:
+        return 0;
+    }
+  }
+
+  size_t len = std::min(m_sendRemain, buflen);
+  std::copy_n(m_sendBuf, len, buf);
+  m_sendBuf += len;
+  m_sendRemain -= len;
+  return len;
+}
+
+} // namespace asyncweb
+} // namespace esp32cam
+
+#endif // __has_include(<ESPAsyncWebServer.h>)
@@ -8,27 +8,80 @@
 namespace esp32cam {
 namespace detail {
 
-class CaptureTask {
+/**
+ * @brief Capture service shared by all async responses.
+ *
+ * One FreeRTOS task captures frames on behalf of every subscriber into a bounded queue.
+ * When the queue is full, the oldest frame is evicted before the next capture, so that a
+ * stalled subscriber cannot keep the capture task waiting. Subscribers hold frames by
+ * reference; the camera frame buffer is returned once the last reference is dropped.
+ */
+class CaptureService {
 public:
-  explicit CaptureTask(uint32_t queueLength, uint32_t priority = 1);
+  /** @brief Maximum number of queued frames. */
+  static constexpr size_t QUEUE_CAPACITY = 2;
+
+  struct Stats {
+    uint32_t subscribers = 0; ///< active subscribers
+    uint32_t depth = 0;       ///< frames currently in queue
+    uint32_t maxDepth = 0;    ///< highest observed queue depth
+    uint32_t captures = 0;    ///< frames captured
+    uint32_t failures = 0;    ///< failed captures
+    uint32_t evictions = 0;   ///< frames evicted from a full queue
+  };
 
-  ~CaptureTask();
+  /** @brief Access the shared instance. */
+  static CaptureService& get();
 
-  explicit operator bool() const {
-    return m_queue != nullptr && m_task != nullptr;
-  }
+  /**
+   * @brief Register a subscriber.
+   * @param continuous if true, frames are captured back-to-back while subscribed.
+   * @return whether the capture task is running.
+   */
+  bool subscribe(bool continuous = false);
+
+  /** @brief Unregister a subscriber; queued frames are dropped after the last one leaves. */
+  void unsubscribe(bool continuous = false);
+
+  /**
+   * @brief Ask for a frame captured after this call.
+   * @return minimum sequence number of a frame that satisfies the request.
+   */
+  uint32_t request();
 
-  void request(bool continuous = false);
+  /**
+   * @brief Retrieve the newest queued frame.
+   * @param[in,out] minSeq minimum sequence number; updated past the returned frame.
+   * @param[out] frame the frame, or nullptr if that capture has failed.
+   * @retval false no frame with sequence number @p minSeq or above is available yet.
+   */
+  bool retrieve(uint32_t& minSeq, std::shared_ptr<Frame>& frame);
 
-  std::unique_ptr<Frame> retrieve();
+  Stats getStats() const;
 
 private:
+  CaptureService();
+
   static void run(void* ctx);
 
+  void loop();
+
 private:
-  void* m_queue = nullptr;
+  struct Entry {
+    uint32_t seq = 0;
+    std::shared_ptr<Frame> frame;
+  };
+
+  void* m_mutex = nullptr;
   void* m_task = nullptr;
-  bool m_continuous = false;
+  Entry m_queue[QUEUE_CAPACITY];
+  size_t m_head = 0;
+  size_t m_count = 0;
+  uint32_t m_nextSeq = 0;
+  bool m_requested = false;
+  bool m_capturing = false;
+  int m_continuous = 0;
+  Stats m_stats;
 };
 
 } // namespace detail
@@ -42,10 +95,10 @@ namespace asyncweb {
 /**
  * @brief HTTP response of one still image.
  *
- * Start a FreeRTOS task to capture an image frame under the current camera settings,
+ * Request an image frame from the shared capture service under the current camera settings,
  * and respond to the HTTP request as a still JPEG image.
- * If multiple StillResponse instances are active concurrently, each will get a different image.
- * If task creation fails, respond with HTTP 500 error.
+ * If multiple StillResponse instances are active concurrently, they may share the same image.
+ * If the capture service cannot start, respond with HTTP 500 error.
  * If image capture fails, the response would be empty, but still has HTTP 200 due to
  * ESPAsyncWebServer library limitations.
  */
@@ -62,8 +115,9 @@ public:
   size_t _fillBuffer(uint8_t* buf, size_t buflen) override;
 
 private:
-  detail::CaptureTask m_task;
-  std::unique_ptr<Frame> m_frame;
+  bool m_subscribed = false;
+  uint32_t m_minSeq = 0;
+  std::shared_ptr<Frame> m_frame;
   size_t m_index = 0;
 };
 
@@ -76,11 +130,10 @@ handleStill(AsyncWebServerRequest* request) {
 /**
  * @brief HTTP response of MJPEG stream.
  *
- * Start a FreeRTOS task to capture image frames under the current camera settings,
+ * Receive image frames from the shared capture service under the current camera settings,
  * and respond to the HTTP request as a Motion JPEG stream.
- * If multiple MjpegResponse instances are active concurrently, each stream will contain
- * different images.
- * If task creation fails, respond with HTTP 500 error.
+ * If multiple MjpegResponse instances are active concurrently, they may share images.
+ * If the capture service cannot start, respond with HTTP 500 error.
  * If image capture fails, the stream is stopped.
  *
  * Normally, a new frame is captured after the prior frame has been fully sent to the client.
@@ -105,7 +158,9 @@ private:
   size_t sendPart(uint8_t* buf, size_t buflen);
 
 private:
-  detail::CaptureTask m_task;
+  bool m_subscribed = false;
+  bool m_continuous = false;
+  uint32_t m_minSeq = 0;
   using Ctrl = detail::MjpegController;
   Ctrl m_ctrl;
   detail::MjpegHeader m_hdr;
@@ -0,0 +1,151 @@
+#include "bmp.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace esp32cam {
+namespace detail {
+namespace {
+
+uint8_t*
+putU16(uint8_t* p, uint16_t v) {
+  p[0] = static_cast<uint8_t>(v);
+  p[1] = static_cast<uint8_t>(v >> 8);
+  return p + 2;
+}
+
+uint8_t*
+putU32(uint8_t* p, uint32_t v) {
+  return putU16(putU16(p, static_cast<uint16_t>(v)), static_cast<uint16_t>(v >> 16));
+}
+
+inline uint8_t
+clamp8(int v) {
+  return static_cast<uint8_t>(std::min(255, std::max(0, v)));
+}
+
+} // namespace
+
+bool
+BmpWriter::begin(const uint8_t* pixels, int width, int height, PixelFormat format) {
+  if (pixels == nullptr || width <= 0 || height <= 0) {
+    return false;
+  }
+  m_pixels = pixels;
+  m_width = width;
+  m_height = height;
+  m_format = format;
+
+  int bitsPerPixel;
+  size_t extra = 0; // palette or bitfield masks
+  switch (format) {
+    case GRAYSCALE:
+      bitsPerPixel = 8;
+      extra = 256 * 4;
+      break;
+    case RGB565:
+      bitsPerPixel = 16;
+      extra = 3 * 4;
+      break;
+    case RGB888:
+    case YUV422:
+    default:
+      bitsPerPixel = 24;
+      break;
+  }
+  m_rowBytes = static_cast<size_t>(width) * bitsPerPixel / 8;
+  m_stride = (m_rowBytes + 3) & ~static_cast<size_t>(3);
+  m_headerSize = 54 + extra;
+
+  uint8_t* p = m_header;
+  *p++ = 'B';
+  *p++ = 'M';
+  p = putU32(p, size());
+  p = putU32(p, 0);
+  p = putU32(p, m_headerSize);
+  p = putU32(p, 40);
+  p = putU32(p, width);
+  p = putU32(p, static_cast<uint32_t>(-height)); // top-down
+  p = putU16(p, 1);
+  p = putU16(p, bitsPerPixel);
+  p = putU32(p, format == RGB565 ? 3 : 0); // BI_BITFIELDS or BI_RGB
+  p = putU32(p, m_stride * height);
+  p = putU32(p, 2835); // 72 DPI
+  p = putU32(p, 2835);
+  p = putU32(p, format == GRAYSCALE ? 256 : 0);
+  p = putU32(p, 0);
+
+  if (format == GRAYSCALE) {
+    for (int i = 0; i < 256; ++i) {
+      *p++ = static_cast<uint8_t>(i);
+      *p++ = static_cast<uint8_t>(i);
+      *p++ = static_cast<uint8_t>(i);
+      *p++ = 0;
+    }
+  } else if (format == RGB565) {
+    p = putU32(p, 0xF800);
+    p = putU32(p, 0x07E0);
+    p = putU32(p, 0x001F);
+  }
+  return true;
+}
+
+size_t
+BmpWriter::scratchSize() const {
+  return m_format == RGB565 || m_format == YUV422 ? m_rowBytes : 0;
+}
+
+const uint8_t*
+BmpWriter::row(int y, uint8_t* scratch) const {
+  switch (m_format) {
+    case GRAYSCALE:
+      return m_pixels + static_cast<size_t>(y) * m_width;
+    case RGB888:
+      // camera order is already B-G-R
+      return m_pixels + static_cast<size_t>(y) * m_width * 3;
+    case RGB565: {
+      // BMP stores 16-bit pixels little endian
+      const uint8_t* src = m_pixels + static_cast<size_t>(y) * m_width * 2;
+      for (int x = 0; x < m_width; ++x) {
+        scratch[2 * x] = src[2 * x + 1];
+        scratch[2 * x + 1] = src[2 * x];
+      }
+      return scratch;
+    }
+    case YUV422:
+    default: {
+      const uint8_t* src = m_pixels + static_cast<size_t>(y) * m_width * 2;
+      uint8_t* dst = scratch;
+      for (int x = 0; x < m_width; ++x) {
+        const uint8_t* pair = src + 4 * (x >> 1);
+        int luma = src[2 * x];
+        int u = pair[1] - 128;
+        int v = pair[3] - 128;
+        // BT.601 full range, 8-bit fixed point
+        *dst++ = clamp8(luma + ((454 * u) >> 8));
+        *dst++ = clamp8(luma - ((88 * u + 183 * v) >> 8));
+        *dst++ = clamp8(luma + ((359 * v) >> 8));
+      }
+      return scratch;
+    }
+  }
+}
+
+void
+BmpWriter::writeTo(uint8_t* out) const {
+  std::memcpy(out, m_header, m_headerSize);
+  uint8_t* p = out + m_headerSize;
+  size_t pad = padding();
+  for (int y = 0; y < m_height; ++y) {
+    // converted rows are produced in place
+    const uint8_t* src = row(y, p);
+    if (src != p) {
+      std::memcpy(p, src, m_rowBytes);
+    }
+    std::memset(p + m_rowBytes, 0, pad);
+    p += m_stride;
+  }
+}
+
+} // namespace detail
+} // namespace esp32cam
@@ -0,0 +1,90 @@
+#ifndef ESP32CAM_BMP_HPP
+#define ESP32CAM_BMP_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace esp32cam {
+namespace detail {
+
+/**
+ * @brief Produce a BMP file from raw camera pixels row by row.
+ *
+ * Rows are stored top-down (negative height). Grayscale becomes an 8-bit paletted image and
+ * RGB888 a 24-bit image; their rows are the camera rows themselves, so they can be written
+ * without copying. RGB565 rows are byte-swapped into a 16-bit bitfields image, and YUV422
+ * rows are converted to 24-bit, both through a caller-provided scratch row.
+ */
+class BmpWriter {
+public:
+  enum PixelFormat {
+    GRAYSCALE, ///< 1 byte per pixel
+    RGB565,    ///< 2 bytes per pixel, big endian
+    RGB888,    ///< 3 bytes per pixel, B-G-R order
+    YUV422,    ///< 2 bytes per pixel, Y0-U-Y1-V
+  };
+
+  /**
+   * @brief Prepare headers.
+   * @return whether the dimensions are acceptable.
+   */
+  bool begin(const uint8_t* pixels, int width, int height, PixelFormat format);
+
+  /** @brief Retrieve BMP file size. */
+  size_t size() const {
+    return m_headerSize + m_stride * m_height;
+  }
+
+  /** @brief Retrieve BMP headers and palette. */
+  const uint8_t* header() const {
+    return m_header;
+  }
+
+  size_t headerSize() const {
+    return m_headerSize;
+  }
+
+  int rows() const {
+    return m_height;
+  }
+
+  /** @brief Retrieve pixel bytes per row, excluding padding. */
+  size_t rowBytes() const {
+    return m_rowBytes;
+  }
+
+  /** @brief Retrieve number of zero bytes that follow each row. */
+  size_t padding() const {
+    return m_stride - m_rowBytes;
+  }
+
+  /** @brief Retrieve scratch size needed by @c row() ; zero means rows are not copied. */
+  size_t scratchSize() const;
+
+  /**
+   * @brief Retrieve pixel bytes of row @p y .
+   * @param scratch buffer of @c scratchSize() octets, may be nullptr if that is zero.
+   */
+  const uint8_t* row(int y, uint8_t* scratch) const;
+
+  /**
+   * @brief Write the whole BMP file into @p out .
+   * @pre @p out has @c size() octets.
+   */
+  void writeTo(uint8_t* out) const;
+
+private:
+  const uint8_t* m_pixels = nullptr;
+  int m_width = 0;
+  int m_height = 0;
+  PixelFormat m_format = GRAYSCALE;
+  size_t m_rowBytes = 0;
+  size_t m_stride = 0;
+  size_t m_headerSize = 0;
+  uint8_t m_header[54 + 256 * 4];
+};
+
+} // namespace detail
+} // namespace esp32cam
+
+#endif // ESP32CAM_BMP_HPP
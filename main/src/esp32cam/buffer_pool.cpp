@@ -0,0 +1,151 @@
+#include "buffer_pool.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <esp_heap_caps.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+namespace esp32cam {
+namespace detail {
+namespace {
+
+/** @brief Prefix of every pooled buffer, keeps the payload 16-byte aligned. */
+struct alignas(16) BlockHeader {
+  uint32_t magic;
+  int32_t cls; ///< size class, or -1 for an uncached large buffer
+  size_t capacity;
+};
+
+constexpr uint32_t BLOCK_MAGIC = 0x4246504C; // "BFPL"
+
+BlockHeader*
+headerOf(uint8_t* buf) {
+  return reinterpret_cast<BlockHeader*>(buf - sizeof(BlockHeader));
+}
+
+class PoolLock {
+public:
+  explicit PoolLock(void* mutex)
+    : m_mutex(static_cast<SemaphoreHandle_t>(mutex)) {
+    xSemaphoreTake(m_mutex, portMAX_DELAY);
+  }
+
+  ~PoolLock() {
+    xSemaphoreGive(m_mutex);
+  }
+
+private:
+  SemaphoreHandle_t m_mutex;
+};
+
+} // namespace
+
+BufferPool&
+BufferPool::get() {
+  static BufferPool instance;
+  return instance;
+}
+
+BufferPool::BufferPool()
+  : m_lock(xSemaphoreCreateMutex()) {}
+
+int
+BufferPool::classOf(size_t size) {
+  for (int cls = 0; cls < N_CLASSES; ++cls) {
+    if (size <= classSize(cls)) {
+      return cls;
+    }
+  }
+  return -1;
+}
+
+size_t
+BufferPool::classSize(int cls) {
+  return static_cast<size_t>(1) << (MIN_SHIFT + cls);
+}
+
+uint8_t*
+BufferPool::acquire(size_t size, size_t& capacity) {
+  int cls = classOf(size);
+  capacity = cls < 0 ? size : classSize(cls);
+
+  if (cls >= 0) {
+    PoolLock lock(m_lock);
+    if (m_nCached[cls] > 0) {
+      uint8_t* buf = m_cache[cls][--m_nCached[cls]];
+      ++m_stats.reuses;
+      m_stats.cachedBytes -= capacity;
+      m_stats.inUseBytes += capacity;
+      return buf;
+    }
+  }
+
+  // heap allocation outside the lock; PSRAM first
+  size_t total = sizeof(BlockHeader) + capacity;
+  auto block = static_cast<uint8_t*>(heap_caps_malloc(total, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
+  if (block == nullptr) {
+    block = static_cast<uint8_t*>(malloc(total));
+  }
+
+  PoolLock lock(m_lock);
+  if (block == nullptr) {
+    ++m_stats.failures;
+    return nullptr;
+  }
+  ++m_stats.allocations;
+  m_stats.inUseBytes += capacity;
+
+  auto header = reinterpret_cast<BlockHeader*>(block);
+  header->magic = BLOCK_MAGIC;
+  header->cls = cls;
+  header->capacity = capacity;
+  return block + sizeof(BlockHeader);
+}
+
+uint8_t*
+BufferPool::grow(uint8_t* buf, size_t used, size_t size, size_t& capacity) {
+  uint8_t* larger = acquire(size, capacity);
+  if (larger == nullptr) {
+    return nullptr;
+  }
+  if (buf != nullptr) {
+    std::memcpy(larger, buf, used);
+    release(buf);
+  }
+  return larger;
+}
+
+void
+BufferPool::release(uint8_t* buf) {
+  if (buf == nullptr) {
+    return;
+  }
+  BlockHeader* header = headerOf(buf);
+  if (header->magic != BLOCK_MAGIC) {
+    return; // not ours; leaking is safer than freeing a foreign pointer
+  }
+
+  int cls = header->cls;
+  {
+    PoolLock lock(m_lock);
+    m_stats.inUseBytes -= header->capacity;
+    if (cls >= 0 && m_nCached[cls] < CACHE_DEPTH) {
+      m_cache[cls][m_nCached[cls]++] = buf;
+      m_stats.cachedBytes += header->capacity;
+      return;
+    }
+    ++m_stats.frees;
+  }
+  header->magic = 0;
+  free(header);
+}
+
+BufferPool::Stats
+BufferPool::getStats() const {
+  PoolLock lock(m_lock);
+  return m_stats;
+}
+
+} // namespace detail
+} // namespace esp32cam
@@ -0,0 +1,69 @@
+#ifndef ESP32CAM_BUFFER_POOL_HPP
+#define ESP32CAM_BUFFER_POOL_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace esp32cam {
+namespace detail {
+
+/**
+ * @brief Size-classed pool of output buffers for frame conversions.
+ *
+ * Sizes are rounded up to a power of two between 16 KiB and 2 MiB. Released buffers are kept
+ * per size class and handed out again, so that converting frames at a steady resolution does
+ * not allocate from the heap and PSRAM does not fragment. Larger buffers bypass the cache.
+ */
+class BufferPool {
+public:
+  struct Stats {
+    uint32_t allocations = 0; ///< buffers allocated from the heap
+    uint32_t reuses = 0;      ///< requests served from the cache
+    uint32_t frees = 0;       ///< buffers returned to the heap because the cache was full
+    uint32_t failures = 0;    ///< failed heap allocations
+    size_t cachedBytes = 0;   ///< capacity of buffers currently held in the cache
+    size_t inUseBytes = 0;    ///< capacity of buffers currently handed out
+  };
+
+  static BufferPool& get();
+
+  /**
+   * @brief Obtain a buffer of at least @p size octets.
+   * @param[out] capacity actual usable size.
+   * @return buffer, or nullptr if allocation failed.
+   */
+  uint8_t* acquire(size_t size, size_t& capacity);
+
+  /**
+   * @brief Obtain a larger buffer, keeping the first @p used octets of @p buf .
+   * @return new buffer; @p buf has been released. On failure, nullptr and @p buf is kept.
+   */
+  uint8_t* grow(uint8_t* buf, size_t used, size_t size, size_t& capacity);
+
+  /** @brief Give back a buffer obtained from @c acquire() or @c grow() . */
+  void release(uint8_t* buf);
+
+  Stats getStats() const;
+
+private:
+  BufferPool();
+
+  static int classOf(size_t size);
+
+  static size_t classSize(int cls);
+
+private:
+  static constexpr int MIN_SHIFT = 14; ///< 16 KiB
+  static constexpr int N_CLASSES = 8;  ///< up to 2 MiB
+  static constexpr int CACHE_DEPTH = 2;
+
+  void* m_lock = nullptr;
+  uint8_t* m_cache[N_CLASSES][CACHE_DEPTH] = {};
+  int m_nCached[N_CLASSES] = {};
+  Stats m_stats;
+};
+
+} // namespace detail
+} // namespace esp32cam
+
+#endif // ESP32CAM_BUFFER_POOL_HPP
@@ -0,0 +1,230 @@
+#include "camera.hpp"
+
+#include "logger.hpp"
+
+#include <Arduino.h>
+#include <algorithm>
+#include <esp_camera.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+namespace esp32cam {
+
+Print* LogOutput = nullptr;
+CameraClass Camera;
+
+namespace {
+
+class PendingLock {
+public:
+  explicit PendingLock(void* mutex)
+    : m_mutex(reinterpret_cast<SemaphoreHandle_t>(mutex)) {
+    xSemaphoreTake(m_mutex, portMAX_DELAY);
+  }
+
+  ~PendingLock() {
+    xSemaphoreGive(m_mutex);
+  }
+
+private:
+  SemaphoreHandle_t m_mutex;
+};
+
+} // namespace
+
+CameraClass::CameraClass()
+  : m_mutex(xSemaphoreCreateMutex()) {}
+
+bool
+CameraClass::begin(const Config& config) {
+  return esp_camera_init(reinterpret_cast<const camera_config_t*>(config.m_cfg)) == ESP_OK;
+}
+
+bool
+CameraClass::end() {
+  return esp_camera_deinit() == ESP_OK;
+}
+
+ResolutionList
+CameraClass::listResolutions() const {
+  sensor_t* sensor = esp_camera_sensor_get();
+  if (sensor == nullptr) {
+    return ResolutionList();
+  }
+
+  camera_sensor_info_t* info = esp_camera_sensor_get_info(&sensor->id);
+  if (info == nullptr) {
+    return ResolutionList();
+  }
+
+  return ResolutionList(info->max_size + 1);
+}
+
+bool
+CameraClass::changeResolution(const Resolution& resolution, int sleepFor) {
+  sensor_t* sensor = esp_camera_sensor_get();
+  if (sensor == nullptr) {
+    return false;
+  }
+
+  framesize_t frameSize = resolution.as<framesize_t>();
+  if (sensor->status.framesize == frameSize) {
+    return true;
+  }
+
+  if (sensor->set_framesize(sensor, frameSize) != 0) {
+    return false;
+  }
+  if (sleepFor > 0) {
+    delay(sleepFor);
+  }
+  return true;
+}
+
+bool
+CameraClass::changeResolutionAsync(const Resolution& resolution, int discardFrames,
+                                   UpdateCallback callback) {
+  return updateAsync([resolution](Settings& settings) { settings.resolution = resolution; },
+                     discardFrames, std::move(callback));
+}
+
+bool
+CameraClass::updateAsync(std::function<void(Settings&)> modifier, int discardFrames,
+                         UpdateCallback callback) {
+  if (m_mutex == nullptr) {
+    return false;
+  }
+
+  PendingLock lock(m_mutex);
+  if (m_pendingCount == PENDING_CAPACITY) {
+    ESP32CAM_LOG("updateAsync queue full");
+    return false;
+  }
+  Pending& pending = m_pending[m_pendingCount++];
+  pending.modifier = std::move(modifier);
+  pending.discardFrames = discardFrames;
+  pending.callback = std::move(callback);
+  return true;
+}
+
+int
+CameraClass::processPending() {
+  if (m_mutex == nullptr) {
+    return 0;
+  }
+
+  Pending batch[PENDING_CAPACITY];
+  size_t count = 0;
+  {
+    PendingLock lock(m_mutex);
+    for (; count < m_pendingCount; ++count) {
+      batch[count] = std::move(m_pending[count]);
+    }
+    m_pendingCount = 0;
+  }
+  if (count == 0) {
+    return 0;
+  }
+
+  // compose all pending modifications, so that update() writes each changed register once
+  Settings settings = status();
+  int discardFrames = 0;
+  for (size_t i = 0; i < count; ++i) {
+    batch[i].modifier(settings);
+    discardFrames = std::max(discardFrames, batch[i].discardFrames);
+  }
+  unsigned long start = micros();
+  bool ok = update(settings);
+  uint32_t batchMicros = micros() - start;
+
+  // frames already in the driver, or exposed while registers were changing, are unstable
+  for (int i = 0; ok && i < discardFrames; ++i) {
+    camera_fb_t* fb = esp_camera_fb_get();
+    if (fb != nullptr) {
+      esp_camera_fb_return(fb);
+    }
+  }
+  ESP32CAM_LOG("processPending %d updates %s in %uus, %d frames discarded",
+               static_cast<int>(count), ok ? "success" : "failure",
+               static_cast<unsigned>(batchMicros), ok ? discardFrames : 0);
+
+  {
+    PendingLock lock(m_mutex);
+    ++m_updateStats.batches;
+    m_updateStats.updates += count;
+    m_updateStats.failures += ok ? 0 : 1;
+    m_updateStats.lastBatchMicros = batchMicros;
+    m_updateStats.lastDiscardFrames = ok ? discardFrames : 0;
+  }
+
+  for (size_t i = 0; i < count; ++i) {
+    if (batch[i].callback) {
+      batch[i].callback(ok);
+    }
+  }
+  return static_cast<int>(count);
+}
+
+CameraClass::UpdateStats
+CameraClass::getUpdateStats() const {
+  if (m_mutex == nullptr) {
+    return m_updateStats;
+  }
+  PendingLock lock(m_mutex);
+  return m_updateStats;
+}
+
+std::unique_ptr<Frame>
+CameraClass::capture() {
+  processPending();
+
+  camera_fb_t* fb = esp_camera_fb_get();
+  if (fb == nullptr) {
+    return nullptr;
+  }
+  return std::unique_ptr<Frame>(new Frame(fb));
+}
+
+int
+CameraClass::streamMjpeg(Client& client, const MjpegConfig& cfg) {
+  detail::MjpegHeader hdr;
+  hdr.prepareResponseHeaders();
+  hdr.writeTo(client);
+
+  using Ctrl = detail::MjpegController;
+  Ctrl ctrl(cfg);
+  while (true) {
+    auto act = ctrl.decideAction();
+    switch (act) {
+      case Ctrl::CAPTURE: {
+        ctrl.notifyCapture();
+        break;
+      }
+      case Ctrl::RETURN: {
+        ctrl.notifyReturn(capture());
+        break;
+      }
+      case Ctrl::SEND: {
+        Frame* frame = ctrl.getFrame();
+        detail::SegmentWriter writer(client, cfg.frameTimeout);
+        hdr.preparePartHeader(frame->size(), frame->getTimestamp(), ctrl.countSentFrames(),
+                              esp_timer_get_time());
+        bool ok = writer.write(hdr.buf, hdr.size) && writer.write(frame->data(), frame->size());
+        hdr.preparePartTrailer();
+        ctrl.notifySent(ok && writer.write(hdr.buf, hdr.size) && writer.flush());
+        break;
+      }
+      case Ctrl::STOP: {
+        client.stop();
+        return ctrl.countSentFrames();
+      }
+      default: {
+        delay(act);
+        break;
+      }
+    }
+  }
+}
+
+} // namespace esp32cam
@@ -0,0 +1,160 @@
+#ifndef ESP32CAM_CAMERA_HPP
+#define ESP32CAM_CAMERA_HPP
+
+#include "config.hpp"
+#include "mjpeg.hpp"
+#include <functional>
+
+namespace esp32cam {
+
+class CameraClass {
+public:
+  /** @brief Callback invoked when a queued update has been applied or has failed. */
+  using UpdateCallback = std::function<void(bool ok)>;
+
+  /** @brief Maximum number of queued updates. */
+  static constexpr size_t PENDING_CAPACITY = 4;
+
+  /** @brief Statistics of queued updates applied by @c processPending(). */
+  struct UpdateStats {
+    uint32_t batches = 0;           ///< number of batches written
+    uint32_t updates = 0;           ///< number of queued updates included in those batches
+    uint32_t failures = 0;          ///< number of failed batches
+    uint32_t lastBatchMicros = 0;   ///< register writes duration of the last batch
+    int lastDiscardFrames = 0;      ///< settling frames discarded after the last batch
+  };
+
+  CameraClass();
+
+  /**
+   * @brief Enable camera.
+   * @return whether success.
+   */
+  bool begin(const Config& config);
+
+  /**
+   * @brief Disable camera.
+   * @return whether success.
+   */
+  bool end();
+
+  /**
+   * @brief Retrieve list of resolutions (likely) supported by hardware.
+   * @pre Camera is enabled.
+   */
+  ResolutionList listResolutions() const;
+
+  /**
+   * @brief Change camera resolution.
+   * @pre Camera is enabled.
+   * @param resolution new resolution; must be no higher than initial resolution.
+   * @param sleepFor how long to wait for stabilization (millis).
+   * @deprecated Use @c changeResolutionAsync instead, which does not block the caller.
+   */
+  bool changeResolution(const Resolution& resolution, int sleepFor = 500);
+
+  /**
+   * @brief Queue a resolution change to be applied between frames.
+   * @param resolution new resolution; must be no higher than initial resolution.
+   * @param discardFrames how many frames to discard after the change, while the sensor settles.
+   * @param callback invoked on the capturing task once the change is applied.
+   * @return whether the change has been queued.
+   */
+  bool changeResolutionAsync(const Resolution& resolution, int discardFrames = 2,
+                             UpdateCallback callback = nullptr);
+
+  /**
+   * @brief Retrieve runtime settings.
+   * @pre Camera is enabled.
+   */
+  Settings status() const;
+
+  /**
+   * @brief Update runtime settings.
+   * @param settings updated settings.
+   * @param sleepFor how long to wait for stabilization (millis).
+   * @pre Camera is enabled.
+   * @post Camera may be left in inconsistent state in case of failure.
+   * @return whether success.
+   */
+  bool update(const Settings& settings, int sleepFor = 0);
+
+  /**
+   * @brief Update runtime settings using modifier function.
+   * @param modifier function to modify settings.
+   * @param sleepFor how long to wait for stabilization (millis).
+   * @pre Camera is enabled.
+   * @post Camera may be left in inconsistent state in case of failure.
+   * @return whether success.
+   */
+  template<typename Fn>
+  std::enable_if_t<std::is_assignable_v<std::function<void(Settings&)>, Fn>, bool> //
+  update(const Fn& modifier, int sleepFor = 0) {
+    Settings settings = status();
+    modifier(settings);
+    return update(settings, sleepFor);
+  }
+
+  /**
+   * @brief Queue a settings update to be applied between frames.
+   * @param modifier function to modify settings; invoked on the capturing task with the
+   *                 settings current at that time, so that queued updates compose.
+   * @param discardFrames how many frames to discard after applying, while the sensor settles.
+   * @param callback invoked on the capturing task once the update is applied.
+   * @return whether the update has been queued; false if the queue is full.
+   *
+   * Queued updates are applied by @c capture() or @c processPending(). All updates pending at
+   * that time are written as one batch, which instead of sleeping discards the frames captured
+   * while the sensor settles.
+   */
+  bool updateAsync(std::function<void(Settings&)> modifier, int discardFrames = 0,
+                   UpdateCallback callback = nullptr);
+
+  /**
+   * @brief Apply queued updates and discard settling frames.
+   * @pre Camera is enabled.
+   * @return number of updates applied.
+   *
+   * This is called by @c capture(). Callers that retrieve frames with esp_camera_fb_get()
+   * directly should call it between frames.
+   */
+  int processPending();
+
+  /** @brief Retrieve statistics of queued updates. */
+  UpdateStats getUpdateStats() const;
+
+  /**
+   * @brief Capture a frame of picture.
+   * @pre Camera is enabled.
+   * @return the picture frame, or nullptr on error.
+   *
+   * Queued updates are applied before capturing.
+   */
+  std::unique_ptr<Frame> capture();
+
+  /**
+   * @brief Stream Motion JPEG.
+   * @pre The camera has been initialized to JPEG mode.
+   * @return number of frames streamed.
+   */
+  int streamMjpeg(Client& client, const MjpegConfig& cfg = MjpegConfig());
+
+private:
+  struct Pending {
+    std::function<void(Settings&)> modifier;
+    int discardFrames = 0;
+    UpdateCallback callback;
+  };
+
+  void* m_mutex = nullptr;
+  Pending m_pending[PENDING_CAPACITY];
+  size_t m_pendingCount = 0;
+  UpdateStats m_updateStats;
+};
+
+/** @brief ESP32 camera API. */
+extern CameraClass Camera;
+
+} // namespace esp32cam
+
+#endif // ESP32CAM_CAMERA_HPP
@@ -0,0 +1,445 @@
+#include "frame.hpp"
+#include "bmp.hpp"
+#include "buffer_pool.hpp"
+#include "config.hpp"
+#include "jpeg_dc.hpp"
+#include "jpeg_encoder.hpp"
+#include "mjpeg.hpp"
+
+#include <Arduino.h>
+#include <esp_camera.h>
+#include <esp_heap_caps.h>
+#include <esp_jpg_decode.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include <algorithm>
+#include <img_converters.h>
+#include <memory>
+#include <new>
+
+namespace esp32cam {
+
+static const int PIXFORMAT_BMP = -101;
+
+struct Frame::CameraFbT : public camera_fb_t {};
+
+Frame::Frame() = default;
+
+Frame::Frame(void* fb)
+  : m_fb(static_cast<CameraFbT*>(fb))
+  , m_data(m_fb->buf)
+  , m_size(m_fb->len)
+  , m_width(m_fb->width)
+  , m_height(m_fb->height)
+  , m_pixFormat(m_fb->format)
+  , m_timestamp(static_cast<int64_t>(m_fb->timestamp.tv_sec) * 1000000 + m_fb->timestamp.tv_usec) {}
+
+Frame::~Frame() {
+  releaseData();
+}
+
+void
+Frame::releaseFb() {
+  if (m_fb != nullptr) {
+    esp_camera_fb_return(m_fb);
+    m_fb = nullptr;
+    m_data = nullptr;
+  }
+}
+
+void
+Frame::releaseData() {
+  if (m_fb != nullptr) {
+    releaseFb();
+  } else if (m_pooled) {
+    detail::BufferPool::get().release(m_data);
+  } else if (m_data != nullptr) {
+    free(m_data);
+  }
+  m_data = nullptr;
+  m_pooled = false;
+}
+
+void
+Frame::replaceData(uint8_t* data, size_t size, int pixFormat, bool pooled) {
+  releaseData();
+  m_data = data;
+  m_size = size;
+  m_pixFormat = pixFormat;
+  m_pooled = pooled;
+}
+
+bool
+Frame::writeTo(Print& os, int timeout) {
+  return writeToImpl(os, timeout, nullptr);
+}
+
+bool
+Frame::writeTo(Client& os, int timeout) {
+  return writeToImpl(os, timeout, &os);
+}
+
+bool
+Frame::writeToImpl(Print& os, int timeout, Client* client) {
+  auto startTime = millis();
+  for (size_t i = 0; i < m_size; i += os.write(&m_data[i], m_size - i)) {
+    if (millis() - startTime > static_cast<unsigned long>(timeout) ||
+        (client != nullptr && !client->connected())) {
+      return false;
+    }
+    yield();
+  }
+  return true;
+}
+
+bool
+Frame::isJpeg() const {
+  return m_pixFormat == PIXFORMAT_JPEG;
+}
+
+namespace {
+
+/**
+ * @brief Encode JPEG stripes on the other core.
+ *
+ * The worker task has no core affinity; while the caller is busy encoding its own stripe,
+ * the scheduler runs the worker on the other core. One caller at a time can use the worker;
+ * concurrent callers encode all stripes themselves.
+ */
+class StripeWorker {
+public:
+  static StripeWorker& get() {
+    static StripeWorker instance;
+    return instance;
+  }
+
+  /** @brief Start encoding @p stripe of @p encoder in the background. */
+  bool start(detail::JpegStripeEncoder* encoder, int stripe) {
+    if (m_task == nullptr || xSemaphoreTake(m_lock, 0) != pdTRUE) {
+      return false;
+    }
+    m_encoder = encoder;
+    m_stripe = stripe;
+    xTaskNotifyGive(m_task);
+    return true;
+  }
+
+  /** @brief Wait for the stripe started by @c start() . */
+  bool wait() {
+    xSemaphoreTake(m_done, portMAX_DELAY);
+    bool ok = m_ok;
+    xSemaphoreGive(m_lock);
+    return ok;
+  }
+
+private:
+  StripeWorker() {
+    m_lock = xSemaphoreCreateMutex();
+    m_done = xSemaphoreCreateBinary();
+    if (m_lock == nullptr || m_done == nullptr ||
+        xTaskCreatePinnedToCore(run, "JpegStripe", 4096, this, uxTaskPriorityGet(nullptr), &m_task,
+                                tskNO_AFFINITY) != pdPASS) {
+      m_task = nullptr;
+    }
+  }
+
+  static void run(void* arg) {
+    auto self = static_cast<StripeWorker*>(arg);
+    while (true) {
+      ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+      self->m_ok = self->m_encoder->encodeStripe(self->m_stripe);
+      xSemaphoreGive(self->m_done);
+    }
+  }
+
+private:
+  TaskHandle_t m_task = nullptr;
+  SemaphoreHandle_t m_lock = nullptr;
+  SemaphoreHandle_t m_done = nullptr;
+  detail::JpegStripeEncoder* m_encoder = nullptr;
+  int m_stripe = 0;
+  bool m_ok = false;
+};
+
+bool
+toStripeFormat(int pixFormat, detail::JpegStripeEncoder::PixelFormat& format) {
+  switch (pixFormat) {
+    case PIXFORMAT_GRAYSCALE:
+      format = detail::JpegStripeEncoder::GRAYSCALE;
+      return true;
+    case PIXFORMAT_RGB565:
+      format = detail::JpegStripeEncoder::RGB565;
+      return true;
+    case PIXFORMAT_RGB888:
+      format = detail::JpegStripeEncoder::RGB888;
+      return true;
+    case PIXFORMAT_YUV422:
+      format = detail::JpegStripeEncoder::YUV422;
+      return true;
+    default:
+      return false;
+  }
+}
+
+} // namespace
+
+bool
+Frame::toJpegStriped(int quality) {
+  detail::JpegStripeEncoder::PixelFormat format;
+  if (!toStripeFormat(m_pixFormat, format)) {
+    return false;
+  }
+
+  // 8 bits per pixel is far above what any quality setting produces for camera images
+  size_t capacity;
+  uint8_t* data = detail::BufferPool::get().acquire(static_cast<size_t>(m_width) * m_height, capacity);
+  if (data == nullptr) {
+    return false;
+  }
+
+  detail::JpegStripeEncoder encoder;
+  bool ok = encoder.begin(m_data, m_width, m_height, format, quality, data, capacity, 2);
+  if (ok) {
+    // second half on the other core, first half here
+    bool background = encoder.countStripes() > 1 && StripeWorker::get().start(&encoder, 1);
+    ok = encoder.encodeStripe(0);
+    if (background) {
+      ok = StripeWorker::get().wait() && ok;
+    }
+    for (int i = background ? 2 : 1; i < encoder.countStripes(); ++i) {
+      ok = encoder.encodeStripe(i) && ok;
+    }
+  }
+  size_t size = ok ? encoder.finish() : 0;
+  if (size == 0) {
+    detail::BufferPool::get().release(data);
+    return false;
+  }
+
+  replaceData(data, size, PIXFORMAT_JPEG, true);
+  return true;
+}
+
+namespace {
+
+/** @brief Growable pooled output of fmt2jpg_cb and esp_jpg_decode. */
+struct PooledOutput {
+  uint8_t* buf = nullptr;
+  size_t capacity = 0;
+  size_t size = 0;
+  bool ok = true;
+};
+
+size_t
+appendJpeg(void* arg, size_t index, const void* data, size_t len) {
+  auto out = static_cast<PooledOutput*>(arg);
+  if (index + len > out->capacity) {
+    uint8_t* larger = detail::BufferPool::get().grow(out->buf, out->size, 2 * (index + len), out->capacity);
+    if (larger == nullptr) {
+      out->ok = false;
+      return 0;
+    }
+    out->buf = larger;
+  }
+  std::memcpy(out->buf + index, data, len);
+  out->size = std::max(out->size, index + len);
+  return len;
+}
+
+struct JpegToBmp {
+  const uint8_t* jpeg;
+  size_t jpegLen;
+  uint8_t* rows; ///< first pixel row in the BMP buffer
+  size_t stride;
+  int width;
+  int height;
+};
+
+size_t
+readJpeg(void* arg, size_t index, uint8_t* buf, size_t len) {
+  auto ctx = static_cast<JpegToBmp*>(arg);
+  if (index >= ctx->jpegLen) {
+    return 0;
+  }
+  len = std::min(len, ctx->jpegLen - index);
+  // the decoder skips data by passing buf==nullptr
+  if (buf != nullptr) {
+    std::memcpy(buf, ctx->jpeg + index, len);
+  }
+  return len;
+}
+
+bool
+writeBmpRows(void* arg, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint8_t* data) {
+  auto ctx = static_cast<JpegToBmp*>(arg);
+  if (data == nullptr) {
+    return true; // start and end of decoding
+  }
+  // decoder outputs R-G-B, BMP stores B-G-R
+  for (int iy = y; iy < y + h && iy < ctx->height; ++iy) {
+    uint8_t* dst = ctx->rows + iy * ctx->stride + x * 3;
+    for (int ix = 0; ix < w; ++ix, data += 3) {
+      if (x + ix < ctx->width) {
+        dst[0] = data[2];
+        dst[1] = data[1];
+        dst[2] = data[0];
+      }
+      dst += 3;
+    }
+  }
+  return true;
+}
+
+bool
+toBmpFormat(int pixFormat, detail::BmpWriter::PixelFormat& format) {
+  switch (pixFormat) {
+    case PIXFORMAT_GRAYSCALE:
+      format = detail::BmpWriter::GRAYSCALE;
+      return true;
+    case PIXFORMAT_RGB565:
+      format = detail::BmpWriter::RGB565;
+      return true;
+    case PIXFORMAT_RGB888:
+      format = detail::BmpWriter::RGB888;
+      return true;
+    case PIXFORMAT_YUV422:
+      format = detail::BmpWriter::YUV422;
+      return true;
+    default:
+      return false;
+  }
+}
+
+} // namespace
+
+bool
+Frame::toJpeg(int quality) {
+  // one scale for both encoders: fmt2jpg takes IJG quality 1-100 like JpegStripeEncoder;
+  // convertJpegQuality() maps to the sensor's 63-0 register scale and does not apply here
+  quality = std::min(100, std::max(1, quality));
+  if (toJpegStriped(quality)) {
+    return true;
+  }
+
+  // fmt2jpg would malloc a fresh buffer per frame; the callback variant writes into the pool
+  PooledOutput out;
+  out.buf = detail::BufferPool::get().acquire(m_size / 4, out.capacity);
+  if (out.buf == nullptr) {
+    return false;
+  }
+  bool ok = fmt2jpg_cb(m_data, m_size, m_width, m_height, static_cast<pixformat_t>(m_pixFormat),
+                       quality, appendJpeg, &out);
+  if (!ok || !out.ok) {
+    detail::BufferPool::get().release(out.buf);
+    return false;
+  }
+  replaceData(out.buf, out.size, PIXFORMAT_JPEG, true);
+  return true;
+}
+
+bool
+Frame::isBmp() const {
+  return m_pixFormat == PIXFORMAT_BMP;
+}
+
+bool
+Frame::toBmp() {
+  detail::BmpWriter::PixelFormat format;
+  bool raw = toBmpFormat(m_pixFormat, format);
+  if (!raw && !isJpeg()) {
+    return false;
+  }
+
+  // JPEG is decoded straight into the rows of a 24-bit BMP
+  detail::BmpWriter bmp;
+  if (!bmp.begin(m_data, m_width, m_height, raw ? format : detail::BmpWriter::RGB888)) {
+    return false;
+  }
+  size_t capacity;
+  uint8_t* data = detail::BufferPool::get().acquire(bmp.size(), capacity);
+  if (data == nullptr) {
+    return false;
+  }
+
+  if (raw) {
+    bmp.writeTo(data);
+  } else {
+    std::memcpy(data, bmp.header(), bmp.headerSize());
+    std::memset(data + bmp.headerSize(), 0, bmp.size() - bmp.headerSize());
+    JpegToBmp ctx{m_data, m_size, data + bmp.headerSize(), bmp.rowBytes() + bmp.padding(),
+                  m_width, m_height};
+    if (esp_jpg_decode(m_size, JPG_SCALE_NONE, readJpeg, writeBmpRows, &ctx) != ESP_OK) {
+      detail::BufferPool::get().release(data);
+      return false;
+    }
+  }
+
+  replaceData(data, bmp.size(), PIXFORMAT_BMP, true);
+  return true;
+}
+
+size_t
+Frame::getBmpSize() const {
+  detail::BmpWriter::PixelFormat format;
+  detail::BmpWriter bmp;
+  if (!toBmpFormat(m_pixFormat, format) || !bmp.begin(m_data, m_width, m_height, format)) {
+    return 0;
+  }
+  return bmp.size();
+}
+
+bool
+Frame::writeBmpTo(Print& os, int timeout) {
+  return writeBmpImpl(os, timeout, nullptr);
+}
+
+bool
+Frame::writeBmpTo(Client& os, int timeout) {
+  return writeBmpImpl(os, timeout, &os);
+}
+
+bool
+Frame::writeBmpImpl(Print& os, int timeout, Client* client) {
+  detail::BmpWriter::PixelFormat format;
+  detail::BmpWriter bmp;
+  if (!toBmpFormat(m_pixFormat, format) || !bmp.begin(m_data, m_width, m_height, format)) {
+    return false;
+  }
+
+  uint8_t* scratch = nullptr;
+  size_t scratchCapacity = 0;
+  if (bmp.scratchSize() > 0) {
+    scratch = detail::BufferPool::get().acquire(bmp.scratchSize(), scratchCapacity);
+    if (scratch == nullptr) {
+      return false;
+    }
+  }
+
+  static const uint8_t zeros[3] = {0, 0, 0};
+  detail::SegmentWriter writer =
+    client == nullptr ? detail::SegmentWriter(os, timeout) : detail::SegmentWriter(*client, timeout);
+  bool ok = writer.write(bmp.header(), bmp.headerSize());
+  for (int y = 0; ok && y < bmp.rows(); ++y) {
+    ok = writer.write(bmp.row(y, scratch), bmp.rowBytes()) && writer.write(zeros, bmp.padding());
+  }
+  ok = ok && writer.flush();
+
+  detail::BufferPool::get().release(scratch);
+  return ok;
+}
+
+bool
+Frame::decodeDcLuma(uint8_t* out, size_t capacity, int& width, int& height) const {
+  if (!isJpeg()) {
+    return false;
+  }
+  // Huffman tables are too large for a task stack
+  std::unique_ptr<detail::JpegDcDecoder> decoder(new (std::nothrow) detail::JpegDcDecoder);
+  if (!decoder) {
+    return false;
+  }
+  return decoder->decode(m_data, m_size, out, capacity, width, height);
+}
+
+} // namespace esp32cam
@@ -0,0 +1,155 @@
+#ifndef ESP32CAM_FRAME_HPP
+#define ESP32CAM_FRAME_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+class Client;
+class Print;
+
+namespace esp32cam {
+
+/** @brief A frame of picture. */
+class Frame {
+public: // access
+  ~Frame();
+
+  uint8_t* data() const {
+    return m_data;
+  }
+
+  size_t size() const {
+    return m_size;
+  }
+
+  int getWidth() const {
+    return m_width;
+  }
+
+  int getHeight() const {
+    return m_height;
+  }
+
+  /**
+   * @brief Retrieve capture time reported by the camera driver.
+   * @return micros on the @c esp_timer_get_time() clock.
+   */
+  int64_t getTimestamp() const {
+    return m_timestamp;
+  }
+
+  /**
+   * @brief Write frame buffer to @p os .
+   * @param os output stream.
+   * @param timeout total time limit in millis.
+   * @retval true writing completed.
+   * @retval false writing disrupted by timeout.
+   */
+  bool writeTo(Print& os, int timeout = 10000);
+
+  /**
+   * @brief Write frame buffer to @p os .
+   * @param os output socket.
+   * @param timeout total time limit in millis.
+   * @retval true writing completed.
+   * @retval false writing disrupted by timeout or socket error.
+   */
+  bool writeTo(Client& os, int timeout = 10000);
+
+public: // conversion
+  bool isJpeg() const;
+
+  /**
+   * @brief Convert frame to JPEG.
+   * @param quality JPEG quality between 0 (worst) and 100 (best).
+   *
+   * Raw frames are encoded in two stripes of MCU rows, one on each core, with restart markers
+   * between MCU rows. Other formats, or a failed stripe encoding, fall back to @c fmt2jpg
+   * with the same quality.
+   * Output buffers come from a size-classed pool, as in @c toBmp() .
+   */
+  bool toJpeg(int quality);
+
+  bool isBmp() const;
+
+  /**
+   * @brief Convert frame to BMP.
+   *
+   * The output buffer comes from a size-classed pool and returns to it when the frame is
+   * destroyed, so converting at a steady frame rate does not fragment the heap.
+   */
+  bool toBmp();
+
+  /**
+   * @brief Retrieve size of the BMP produced by @c writeBmpTo() .
+   * @return BMP size, or 0 if the pixel format cannot be streamed as BMP.
+   */
+  size_t getBmpSize() const;
+
+  /**
+   * @brief Write frame as BMP to @p os without converting it in memory.
+   * @param os output stream.
+   * @param timeout total time limit in millis.
+   * @retval false unsupported pixel format, or writing disrupted by timeout.
+   *
+   * Grayscale and RGB888 rows are written straight from the frame buffer; RGB565 and YUV422
+   * rows are converted one at a time. JPEG frames need @c toBmp() instead.
+   */
+  bool writeBmpTo(Print& os, int timeout = 10000);
+
+  /**
+   * @brief Write frame as BMP to @p os without converting it in memory.
+   * @param os output socket.
+   * @param timeout total time limit in millis.
+   * @retval false unsupported pixel format, or writing disrupted by timeout or socket error.
+   */
+  bool writeBmpTo(Client& os, int timeout = 10000);
+
+  /**
+   * @brief Decode a 1/8-scale grayscale thumbnail from JPEG DC coefficients.
+   * @param out output buffer, one byte per 8x8 luma block, row by row.
+   * @param capacity size of @p out .
+   * @param[out] width thumbnail width, i.e. ceil(getWidth() / 8).
+   * @param[out] height thumbnail height, i.e. ceil(getHeight() / 8).
+   * @pre isJpeg()
+   *
+   * This is much cheaper than a full decode because no IDCT or color conversion is performed.
+   * Frame data is unchanged.
+   */
+  bool decodeDcLuma(uint8_t* out, size_t capacity, int& width, int& height) const;
+
+private:
+  Frame();
+
+  explicit Frame(void* fb);
+
+  bool writeToImpl(Print& os, int timeout, Client* client);
+
+  bool toJpegStriped(int quality);
+
+  bool writeBmpImpl(Print& os, int timeout, Client* client);
+
+  void releaseFb();
+
+  /** @brief Release frame data: return camera buffer, or give back converted buffer. */
+  void releaseData();
+
+  void replaceData(uint8_t* data, size_t size, int pixFormat, bool pooled);
+
+private:
+  class CameraFbT; ///< camera_fb_t
+  CameraFbT* m_fb = nullptr;
+  uint8_t* m_data = nullptr;
+  size_t m_size = 0;
+  int m_width = -1;
+  int m_height = -1;
+  int m_pixFormat = -1;
+  int64_t m_timestamp = 0;
+  bool m_pooled = false; ///< m_data comes from detail::BufferPool
+
+  friend class CameraClass;
+};
+
+} // namespace esp32cam
+
+#endif // ESP32CAM_FRAME_HPP
@@ -0,0 +1,432 @@
+#include "jpeg_dc.hpp"
+
+#include <cstring>
+
+namespace esp32cam {
+namespace detail {
+namespace {
+
+uint16_t
+readU16(const uint8_t* p) {
+  return (p[0] << 8) | p[1];
+}
+
+} // namespace
+
+bool
+JpegDcDecoder::readSize(const uint8_t* jpeg, size_t len, int& width, int& height) {
+  if (len < 4 || jpeg[0] != 0xFF || jpeg[1] != 0xD8) {
+    return false;
+  }
+  for (size_t i = 2; i + 9 < len;) {
+    if (jpeg[i] != 0xFF) {
+      return false;
+    }
+    uint8_t marker = jpeg[i + 1];
+    if (marker == 0xC0 || marker == 0xC1 || marker == 0xC2) {
+      height = (readU16(&jpeg[i + 5]) + 7) / 8;
+      width = (readU16(&jpeg[i + 7]) + 7) / 8;
+      return true;
+    }
+    i += 2 + readU16(&jpeg[i + 2]);
+  }
+  return false;
+}
+
+bool
+JpegDcDecoder::decode(const uint8_t* jpeg, size_t len, uint8_t* out, size_t capacity, int& width,
+                      int& height) {
+  m_data = jpeg;
+  m_len = len;
+  m_pos = 0;
+  m_nComps = 0;
+  m_restartInterval = 0;
+  for (int i = 0; i < 4; ++i) {
+    m_dc[i].defined = false;
+    m_ac[i].defined = false;
+  }
+  if (!parseHeaders()) {
+    return false;
+  }
+
+  width = (m_width + 7) / 8;
+  height = (m_height + 7) / 8;
+  if (static_cast<size_t>(width) * height > capacity) {
+    return false;
+  }
+  return decodeScan(out);
+}
+
+bool
+JpegDcDecoder::parseHeaders() {
+  if (m_len < 4 || m_data[0] != 0xFF || m_data[1] != 0xD8) {
+    return false;
+  }
+  m_pos = 2;
+
+  while (m_pos + 4 <= m_len) {
+    if (m_data[m_pos] != 0xFF) {
+      return false;
+    }
+    uint8_t marker = m_data[m_pos + 1];
+    if (marker == 0xFF) { // fill byte
+      ++m_pos;
+      continue;
+    }
+    size_t segLen = readU16(&m_data[m_pos + 2]);
+    const uint8_t* seg = &m_data[m_pos + 4];
+    size_t end = m_pos + 2 + segLen;
+    if (segLen < 2 || end > m_len) {
+      return false;
+    }
+
+    switch (marker) {
+      case 0xDB: { // DQT: only the DC entry of each table is needed
+        for (const uint8_t* p = seg; p < &m_data[end];) {
+          int pq = p[0] >> 4;
+          int tq = p[0] & 0x0F;
+          if (tq > 3 || p + 1 + (pq ? 128 : 64) > &m_data[end]) {
+            return false;
+          }
+          m_quantDc[tq] = pq ? readU16(&p[1]) : p[1];
+          p += 1 + (pq ? 128 : 64);
+        }
+        break;
+      }
+      case 0xC4: { // DHT
+        for (const uint8_t* p = seg; p < &m_data[end];) {
+          int tc = p[0] >> 4;
+          int th = p[0] & 0x0F;
+          if (th > 3 || tc > 1 || p + 17 > &m_data[end]) {
+            return false;
+          }
+          int total = 0;
+          for (int i = 0; i < 16; ++i) {
+            total += p[1 + i];
+          }
+          if (total > 256 || &p[17 + total] > &m_data[end]) {
+            return false;
+          }
+          if (!buildHuffman(tc == 0 ? m_dc[th] : m_ac[th], &p[1], &p[17])) {
+            return false;
+          }
+          p += 17 + total;
+        }
+        break;
+      }
+      case 0xC0:
+      case 0xC1: { // SOF0/SOF1: sequential Huffman
+        if (segLen < 8) {
+          return false;
+        }
+        m_height = readU16(&seg[1]);
+        m_width = readU16(&seg[3]);
+        m_nComps = seg[5];
+        if (seg[0] != 8 || m_width == 0 || m_height == 0 || m_nComps < 1 || m_nComps > 3 ||
+            segLen < 8 + 3 * static_cast<size_t>(m_nComps)) {
+          m_nComps = 0;
+          return false;
+        }
+        m_hMax = m_vMax = 1;
+        for (int i = 0; i < m_nComps; ++i) {
+          Component& c = m_comps[i];
+          c.id = seg[6 + 3 * i];
+          c.h = seg[7 + 3 * i] >> 4;
+          c.v = seg[7 + 3 * i] & 0x0F;
+          c.tq = seg[8 + 3 * i] & 0x03;
+          if (c.h < 1 || c.h > 4 || c.v < 1 || c.v > 4) {
+            return false;
+          }
+          m_hMax = c.h > m_hMax ? c.h : m_hMax;
+          m_vMax = c.v > m_vMax ? c.v : m_vMax;
+        }
+        break;
+      }
+      case 0xC2:
+      case 0xC3:
+      case 0xC5:
+      case 0xC6:
+      case 0xC7:
+      case 0xC9:
+      case 0xCA:
+      case 0xCB:
+      case 0xCD:
+      case 0xCE:
+      case 0xCF: // progressive, lossless, hierarchical, arithmetic
+        return false;
+      case 0xDD: { // DRI
+        if (segLen < 4) {
+          return false;
+        }
+        m_restartInterval = readU16(seg);
+        break;
+      }
+      case 0xDA: { // SOS
+        if (m_nComps == 0) {
+          return false;
+        }
+        m_nScanComps = seg[0];
+        if (m_nScanComps < 1 || m_nScanComps > m_nComps ||
+            segLen < 6 + 2 * static_cast<size_t>(m_nScanComps)) {
+          return false;
+        }
+        for (int i = 0; i < m_nScanComps; ++i) {
+          uint8_t id = seg[1 + 2 * i];
+          int index = -1;
+          for (int j = 0; j < m_nComps; ++j) {
+            if (m_comps[j].id == id) {
+              index = j;
+            }
+          }
+          if (index < 0) {
+            return false;
+          }
+          Component& c = m_comps[index];
+          c.td = (seg[2 + 2 * i] >> 4) & 0x03;
+          c.ta = seg[2 + 2 * i] & 0x03;
+          if (!m_dc[c.td].defined || !m_ac[c.ta].defined) {
+            return false; // table not defined by any DHT
+          }
+          m_scanComps[i] = index;
+        }
+        m_pos = end;
+        return true;
+      }
+      default:
+        break;
+    }
+    m_pos = end;
+  }
+  return false;
+}
+
+bool
+JpegDcDecoder::buildHuffman(Huffman& table, const uint8_t* counts, const uint8_t* symbols) {
+  std::memset(table.lookupLen, 0, sizeof(table.lookupLen));
+  table.defined = false;
+  int k = 0;
+  uint32_t code = 0;
+  for (int len = 1; len <= 16; ++len) {
+    // oversubscribed: the codes of this length would not fit in len bits
+    if (code + counts[len - 1] > (1U << len) || k + counts[len - 1] > 256) {
+      return false;
+    }
+    table.valPtr[len] = k;
+    table.minCode[len] = code;
+    for (int i = 0; i < counts[len - 1]; ++i, ++k, ++code) {
+      table.symbols[k] = symbols[k];
+      if (len <= LOOKUP_BITS) {
+        // every lookup index that starts with this code
+        int shift = LOOKUP_BITS - len;
+        for (uint32_t j = code << shift; j < ((code + 1) << shift); ++j) {
+          table.lookup[j] = symbols[k];
+          table.lookupLen[j] = len;
+        }
+      }
+    }
+    table.maxCode[len] = counts[len - 1] ? static_cast<int32_t>(code - 1) : -1;
+    code <<= 1;
+  }
+  table.maxCode[17] = 0x7FFFFFFF; // sentinel
+  table.nSymbols = k;
+  table.defined = true;
+  return true;
+}
+
+uint32_t
+JpegDcDecoder::peekBits(int n) {
+  if (n == 0 || m_nBits < 0) {
+    return 0;
+  }
+  while (m_nBits < n) {
+    uint32_t byte = 0;
+    if (!m_marker && m_pos < m_len) {
+      byte = m_data[m_pos];
+      if (byte == 0xFF) {
+        uint8_t next = m_pos + 1 < m_len ? m_data[m_pos + 1] : 0xD9;
+        if (next == 0x00) { // stuffed byte
+          m_pos += 2;
+        } else { // marker: stop here, the restart logic consumes it
+          m_marker = true;
+          byte = 0;
+        }
+      } else {
+        ++m_pos;
+      }
+    }
+    m_bits |= byte << (24 - m_nBits);
+    m_nBits += 8;
+  }
+  return m_bits >> (32 - n);
+}
+
+void
+JpegDcDecoder::skipBits(int n) {
+  if (n > m_nBits) { // more bits than peeked: only on corrupt data, checked per block
+    m_bits = 0;
+    m_nBits = -1;
+    return;
+  }
+  m_bits <<= n;
+  m_nBits -= n;
+}
+
+int
+JpegDcDecoder::decodeSymbol(const Huffman& table) {
+  uint32_t look = peekBits(LOOKUP_BITS);
+  int len = table.lookupLen[look];
+  if (len != 0) {
+    skipBits(len);
+    return table.lookup[look];
+  }
+
+  // longer codes, bit by bit (JPEG F.2.2.3)
+  uint32_t code = peekBits(16);
+  for (len = LOOKUP_BITS + 1; len <= 16; ++len) {
+    int32_t c = code >> (16 - len);
+    if (c <= table.maxCode[len]) {
+      int index = table.valPtr[len] + c - table.minCode[len];
+      if (index < 0 || index >= table.nSymbols) {
+        return -1;
+      }
+      skipBits(len);
+      return table.symbols[index];
+    }
+  }
+  return -1; // corrupt data
+}
+
+int
+JpegDcDecoder::receiveExtend(int s) {
+  if (s == 0) {
+    return 0;
+  }
+  int v = static_cast<int>(peekBits(s));
+  skipBits(s);
+  return v < (1 << (s - 1)) ? v - (1 << s) + 1 : v;
+}
+
+bool
+JpegDcDecoder::skipBlock(Component& comp, int& dc) {
+  int s = decodeSymbol(m_dc[comp.td]);
+  if (s < 0 || s > 11 || m_nBits < 0) {
+    return false;
+  }
+  comp.pred += receiveExtend(s);
+  dc = comp.pred;
+
+  // AC coefficients are not needed, only skipped
+  const Huffman& ac = m_ac[comp.ta];
+  for (int k = 1; k < 64;) {
+    int rs;
+    // fast path: a short code and its extra bits are consumed together from one refill
+    uint32_t look = peekBits(MAX_PEEK) >> (MAX_PEEK - LOOKUP_BITS);
+    int len = ac.lookupLen[look];
+    if (len != 0) {
+      rs = ac.lookup[look];
+      skipBits(len + (rs & 0x0F));
+    } else {
+      rs = decodeSymbol(ac);
+      if (rs < 0) {
+        return false;
+      }
+      peekBits(rs & 0x0F);
+      skipBits(rs & 0x0F);
+    }
+
+    if ((rs & 0x0F) == 0) {
+      if (rs != 0xF0) {
+        break; // EOB
+      }
+      k += 16; // ZRL
+      continue;
+    }
+    k += (rs >> 4) + 1;
+  }
+  return m_nBits >= 0;
+}
+
+bool
+JpegDcDecoder::restart() {
+  // discard remaining bits, then expect RSTn
+  m_bits = 0;
+  m_nBits = 0;
+  if (m_pos + 1 < m_len && m_data[m_pos] == 0xFF && (m_data[m_pos + 1] & 0xF8) == 0xD0) {
+    m_pos += 2;
+  } else {
+    return false;
+  }
+  m_marker = false;
+  for (int i = 0; i < m_nComps; ++i) {
+    m_comps[i].pred = 0;
+  }
+  return true;
+}
+
+bool
+JpegDcDecoder::decodeScan(uint8_t* out) {
+  m_bits = 0;
+  m_nBits = 0;
+  m_marker = false;
+  for (int i = 0; i < m_nComps; ++i) {
+    m_comps[i].pred = 0;
+  }
+
+  int outWidth = (m_width + 7) / 8;
+  int outHeight = (m_height + 7) / 8;
+  const Component& luma = m_comps[0];
+  int scale = m_quantDc[luma.tq];
+  if (m_scanComps[0] != 0 || luma.h != m_hMax || luma.v != m_vMax) {
+    return false; // luma must come first at full resolution
+  }
+
+  // interleaved scan: MCU of hMax x vMax blocks; single component scan: one block per MCU
+  bool interleaved = m_nScanComps > 1;
+  int mcuWidth = interleaved ? 8 * m_hMax : 8 * m_hMax / luma.h;
+  int mcuHeight = interleaved ? 8 * m_vMax : 8 * m_vMax / luma.v;
+  int mcusX = (m_width + mcuWidth - 1) / mcuWidth;
+  int mcusY = (m_height + mcuHeight - 1) / mcuHeight;
+
+  int mcusToRestart = m_restartInterval;
+  for (int my = 0; my < mcusY; ++my) {
+    for (int mx = 0; mx < mcusX; ++mx) {
+      if (m_restartInterval > 0) {
+        if (mcusToRestart == 0) {
+          if (!restart()) {
+            return false;
+          }
+          mcusToRestart = m_restartInterval;
+        }
+        --mcusToRestart;
+      }
+
+      for (int i = 0; i < m_nScanComps; ++i) {
+        Component& comp = m_comps[m_scanComps[i]];
+        int bh = interleaved ? comp.h : 1;
+        int bv = interleaved ? comp.v : 1;
+        for (int by = 0; by < bv; ++by) {
+          for (int bx = 0; bx < bh; ++bx) {
+            int dc;
+            if (!skipBlock(comp, dc)) {
+              return false;
+            }
+            if (m_scanComps[i] != 0) {
+              continue;
+            }
+            // block average = DC * Q / 8, shifted by the level offset
+            int x = mx * bh + bx;
+            int y = my * bv + by;
+            if (x < outWidth && y < outHeight) {
+              int v = ((dc * scale) >> 3) + 128;
+              out[y * outWidth + x] = v < 0 ? 0 : v > 255 ? 255 : v;
+            }
+          }
+        }
+      }
+    }
+  }
+  return true;
+}
+
+} // namespace detail
+} // namespace esp32cam
@@ -0,0 +1,97 @@
+#ifndef ESP32CAM_JPEG_DC_HPP
+#define ESP32CAM_JPEG_DC_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace esp32cam {
+namespace detail {
+
+/**
+ * @brief Decode a 1/8-scale luma image from the DC coefficients of a baseline JPEG.
+ *
+ * Each 8x8 luma block contributes one output pixel: its dequantized DC coefficient is the
+ * block average, so no IDCT is needed. AC coefficients are Huffman-decoded only to advance
+ * the bitstream. Chroma blocks are skipped.
+ * Supports baseline and extended sequential Huffman JPEG with any chroma subsampling and
+ * restart intervals, as produced by OV2640/OV3660; progressive JPEG is rejected.
+ */
+class JpegDcDecoder {
+public:
+  /**
+   * @brief Decode @p jpeg into @p out .
+   * @param out output buffer, row by row.
+   * @param capacity size of @p out ; ((width + 7) / 8) * ((height + 7) / 8) suffices.
+   * @param[out] width thumbnail width.
+   * @param[out] height thumbnail height.
+   * @return whether success.
+   */
+  bool decode(const uint8_t* jpeg, size_t len, uint8_t* out, size_t capacity, int& width,
+              int& height);
+
+  /** @brief Retrieve thumbnail dimensions from the JPEG header without decoding. */
+  static bool readSize(const uint8_t* jpeg, size_t len, int& width, int& height);
+
+private:
+  struct Huffman {
+    uint8_t lookup[512];     ///< symbol for codes up to LOOKUP_BITS
+    uint8_t lookupLen[512];  ///< code length in lookup, 0 if longer
+    int32_t maxCode[18];
+    int32_t valPtr[17];
+    uint16_t minCode[17];
+    uint8_t symbols[256];
+    int nSymbols;
+    bool defined; ///< set by a DHT in the current image
+  };
+
+  struct Component {
+    uint8_t id;
+    uint8_t h;
+    uint8_t v;
+    uint8_t tq;
+    uint8_t td;
+    uint8_t ta;
+    int pred;
+  };
+
+  bool parseHeaders();
+  bool buildHuffman(Huffman& table, const uint8_t* counts, const uint8_t* symbols);
+  bool decodeScan(uint8_t* out);
+
+  uint32_t peekBits(int n);
+  void skipBits(int n);
+  int decodeSymbol(const Huffman& table);
+  int receiveExtend(int s);
+  bool skipBlock(Component& comp, int& dc);
+  bool restart();
+
+private:
+  static constexpr int LOOKUP_BITS = 9;
+  static constexpr int MAX_PEEK = 25; ///< longest short code plus its extra bits fit
+
+  const uint8_t* m_data = nullptr;
+  size_t m_len = 0;
+  size_t m_pos = 0;
+
+  uint16_t m_quantDc[4] = {};
+  Huffman m_dc[4];
+  Huffman m_ac[4];
+  Component m_comps[4];
+  int m_nComps = 0;
+  int m_width = 0;
+  int m_height = 0;
+  int m_hMax = 1;
+  int m_vMax = 1;
+  int m_restartInterval = 0;
+  int m_scanComps[4] = {};
+  int m_nScanComps = 0;
+
+  uint32_t m_bits = 0;  ///< bit buffer, left aligned
+  int m_nBits = 0;      ///< negative after consuming more bits than available: corrupt data
+  bool m_marker = false; ///< a marker has been reached; further bits are zeros
+};
+
+} // namespace detail
+} // namespace esp32cam
+
+#endif // ESP32CAM_JPEG_DC_HPP
@@ -0,0 +1,549 @@
+#include "jpeg_encoder.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace esp32cam {
+namespace detail {
+namespace {
+
+// natural index of each zig-zag position
+const uint8_t ZIGZAG[64] = {
+  0,  1,  8,  16, 9,  2,  3,  10, 17, 24, 32, 25, 18, 11, 4,  5,  12, 19, 26, 33, 40, 48,
+  41, 34, 27, 20, 13, 6,  7,  14, 21, 28, 35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23,
+  30, 37, 44, 51, 58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63,
+};
+
+// JPEG Annex K.1 quantization tables, zig-zag order
+const uint8_t BASE_QUANT[2][64] = {
+  {
+    16, 11, 12, 14, 12,  10, 16,  14,  13,  14,  18,  17,  16,  19,  24,  40,
+    26, 24, 22, 22, 24,  49, 35,  37,  29,  40,  58,  51,  61,  60,  57,  51,
+    56, 55, 64, 72, 92,  78, 64,  68,  87,  69,  55,  56,  80,  109, 81,  87,
+    95, 98, 103, 104, 103, 62, 77, 113, 121, 112, 100, 120, 92,  101, 103, 99,
+  },
+  {
+    17, 18, 18, 24, 21, 24, 47, 26, 26, 47, 99, 66, 56, 66, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99,
+  },
+};
+
+// JPEG Annex K.3 Huffman tables: code counts per length, then symbols
+struct HuffmanSpec {
+  uint8_t counts[16];
+  uint8_t nSymbols;
+  uint8_t symbols[162];
+};
+
+const HuffmanSpec HUFFMAN_SPECS[4] = {
+  // luminance DC
+  {{0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0}, 12, {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11}},
+  // luminance AC
+  {{0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0, 0, 1, 125},
+   162,
+   {0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x41, 0x06, 0x13, 0x51, 0x61,
+    0x07, 0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xa1, 0x08, 0x23, 0x42, 0xb1, 0xc1, 0x15, 0x52,
+    0xd1, 0xf0, 0x24, 0x33, 0x62, 0x72, 0x82, 0x09, 0x0a, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x25,
+    0x26, 0x27, 0x28, 0x29, 0x2a, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45,
+    0x46, 0x47, 0x48, 0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x63, 0x64,
+    0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x83,
+    0x84, 0x85, 0x86, 0x87, 0x88, 0x89, 0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99,
+    0x9a, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6,
+    0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3,
+    0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xe1, 0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8,
+    0xe9, 0xea, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa}},
+  // chrominance DC
+  {{0, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0}, 12, {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11}},
+  // chrominance AC
+  {{0, 2, 1, 2, 4, 4, 3, 4, 7, 5, 4, 4, 0, 1, 2, 119},
+   162,
+   {0x00, 0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21, 0x31, 0x06, 0x12, 0x41, 0x51, 0x07, 0x61,
+    0x71, 0x13, 0x22, 0x32, 0x81, 0x08, 0x14, 0x42, 0x91, 0xa1, 0xb1, 0xc1, 0x09, 0x23, 0x33,
+    0x52, 0xf0, 0x15, 0x62, 0x72, 0xd1, 0x0a, 0x16, 0x24, 0x34, 0xe1, 0x25, 0xf1, 0x17, 0x18,
+    0x19, 0x1a, 0x26, 0x27, 0x28, 0x29, 0x2a, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44,
+    0x45, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x63,
+    0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a,
+    0x82, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89, 0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97,
+    0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4,
+    0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca,
+    0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7,
+    0xe8, 0xe9, 0xea, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa}},
+};
+
+/** @brief Compiled Huffman table: code and length per symbol. */
+struct HuffmanCodes {
+  uint16_t code[256];
+  uint8_t size[256];
+};
+
+HuffmanCodes g_codes[4];
+bool g_codesReady = false;
+
+void
+buildCodes() {
+  if (g_codesReady) {
+    return;
+  }
+  for (int t = 0; t < 4; ++t) {
+    const HuffmanSpec& spec = HUFFMAN_SPECS[t];
+    uint16_t code = 0;
+    int k = 0;
+    for (int len = 1; len <= 16; ++len) {
+      for (int i = 0; i < spec.counts[len - 1]; ++i, ++k, ++code) {
+        g_codes[t].code[spec.symbols[k]] = code;
+        g_codes[t].size[spec.symbols[k]] = len;
+      }
+      code <<= 1;
+    }
+  }
+  g_codesReady = true;
+}
+
+// ITU-R BT.601 full range, 16-bit fixed point
+inline void
+rgbToYcc(int r, int g, int b, int16_t& y, int16_t& cb, int16_t& cr) {
+  y = static_cast<int16_t>(((19595 * r + 38470 * g + 7471 * b + 32768) >> 16) - 128);
+  cb = static_cast<int16_t>((-11059 * r - 21709 * g + 32768 * b + 32768) >> 16);
+  cr = static_cast<int16_t>((32768 * r - 27439 * g - 5329 * b + 32768) >> 16);
+}
+
+// forward DCT, integer LL&M as in IJG jfdctint.c; output is scaled up by 8
+constexpr int CONST_BITS = 13;
+constexpr int PASS1_BITS = 2;
+constexpr int32_t FIX_0_298631336 = 2446;
+constexpr int32_t FIX_0_390180644 = 3196;
+constexpr int32_t FIX_0_541196100 = 4433;
+constexpr int32_t FIX_0_765366865 = 6270;
+constexpr int32_t FIX_0_899976223 = 7373;
+constexpr int32_t FIX_1_175875602 = 9633;
+constexpr int32_t FIX_1_501321110 = 12299;
+constexpr int32_t FIX_1_847759065 = 15137;
+constexpr int32_t FIX_1_961570560 = 16069;
+constexpr int32_t FIX_2_053119869 = 16819;
+constexpr int32_t FIX_2_562915447 = 20995;
+constexpr int32_t FIX_3_072711026 = 25172;
+
+inline int32_t
+descale(int32_t x, int n) {
+  return (x + (1 << (n - 1))) >> n;
+}
+
+void
+forwardDct(int32_t* d) {
+  for (int pass = 0; pass < 2; ++pass) {
+    int step = pass == 0 ? 1 : 8;   // element step within a row or column
+    int stride = pass == 0 ? 8 : 1; // step between rows or columns
+    int shift = pass == 0 ? CONST_BITS - PASS1_BITS : CONST_BITS + PASS1_BITS;
+    for (int i = 0; i < 8; ++i) {
+      int32_t* p = d + i * stride;
+      int32_t tmp0 = p[0] + p[7 * step];
+      int32_t tmp7 = p[0] - p[7 * step];
+      int32_t tmp1 = p[1 * step] + p[6 * step];
+      int32_t tmp6 = p[1 * step] - p[6 * step];
+      int32_t tmp2 = p[2 * step] + p[5 * step];
+      int32_t tmp5 = p[2 * step] - p[5 * step];
+      int32_t tmp3 = p[3 * step] + p[4 * step];
+      int32_t tmp4 = p[3 * step] - p[4 * step];
+
+      int32_t tmp10 = tmp0 + tmp3;
+      int32_t tmp13 = tmp0 - tmp3;
+      int32_t tmp11 = tmp1 + tmp2;
+      int32_t tmp12 = tmp1 - tmp2;
+
+      if (pass == 0) {
+        p[0] = (tmp10 + tmp11) * (1 << PASS1_BITS);
+        p[4 * step] = (tmp10 - tmp11) * (1 << PASS1_BITS);
+      } else {
+        p[0] = descale(tmp10 + tmp11, PASS1_BITS);
+        p[4 * step] = descale(tmp10 - tmp11, PASS1_BITS);
+      }
+
+      int32_t z1 = (tmp12 + tmp13) * FIX_0_541196100;
+      p[2 * step] = descale(z1 + tmp13 * FIX_0_765366865, shift);
+      p[6 * step] = descale(z1 - tmp12 * FIX_1_847759065, shift);
+
+      z1 = tmp4 + tmp7;
+      int32_t z2 = tmp5 + tmp6;
+      int32_t z3 = tmp4 + tmp6;
+      int32_t z4 = tmp5 + tmp7;
+      int32_t z5 = (z3 + z4) * FIX_1_175875602;
+
+      tmp4 *= FIX_0_298631336;
+      tmp5 *= FIX_2_053119869;
+      tmp6 *= FIX_3_072711026;
+      tmp7 *= FIX_1_501321110;
+      z1 *= -FIX_0_899976223;
+      z2 *= -FIX_2_562915447;
+      z3 = z3 * -FIX_1_961570560 + z5;
+      z4 = z4 * -FIX_0_390180644 + z5;
+
+      p[7 * step] = descale(tmp4 + z1 + z3, shift);
+      p[5 * step] = descale(tmp5 + z2 + z4, shift);
+      p[3 * step] = descale(tmp6 + z2 + z3, shift);
+      p[1 * step] = descale(tmp7 + z1 + z4, shift);
+    }
+  }
+}
+
+inline uint8_t*
+putU16(uint8_t* p, int v) {
+  p[0] = static_cast<uint8_t>(v >> 8);
+  p[1] = static_cast<uint8_t>(v);
+  return p + 2;
+}
+
+} // namespace
+
+/** @brief Huffman bit writer with byte stuffing into a bounded region. */
+struct JpegStripeEncoder::BitWriter {
+  Region& r;
+  uint32_t bits = 0; ///< pending bits, right aligned
+  int nBits = 0;
+
+  explicit BitWriter(Region& r)
+    : r(r) {}
+
+  void put(uint32_t code, int size) {
+    bits = (bits << size) | (code & ((1U << size) - 1));
+    nBits += size;
+    while (nBits >= 8) {
+      nBits -= 8;
+      emit(static_cast<uint8_t>(bits >> nBits));
+    }
+  }
+
+  void emit(uint8_t byte) {
+    if (r.end - r.pos < 2) {
+      r.ok = false;
+      return;
+    }
+    *r.pos++ = byte;
+    if (byte == 0xFF) {
+      *r.pos++ = 0x00;
+    }
+  }
+
+  /** @brief Pad to a byte boundary with 1-bits. */
+  void flush() {
+    if (nBits > 0) {
+      put(0x7F, 8 - nBits);
+    }
+    bits = 0;
+  }
+
+  void marker(uint8_t code) {
+    if (r.end - r.pos < 2) {
+      r.ok = false;
+      return;
+    }
+    *r.pos++ = 0xFF;
+    *r.pos++ = code;
+  }
+};
+
+bool
+JpegStripeEncoder::begin(const uint8_t* pixels, int width, int height, PixelFormat format,
+                         int quality, uint8_t* out, size_t capacity, int nStripes) {
+  if (pixels == nullptr || out == nullptr || width <= 0 || height <= 0 || width > 65535 ||
+      height > 65535) {
+    return false;
+  }
+  buildCodes();
+
+  m_pixels = pixels;
+  m_width = width;
+  m_height = height;
+  m_format = format;
+  m_color = format != GRAYSCALE;
+  m_mcuSize = m_color ? 16 : 8;
+  m_mcusX = (width + m_mcuSize - 1) / m_mcuSize;
+  m_mcusY = (height + m_mcuSize - 1) / m_mcuSize;
+  if (m_mcusX > 65535) {
+    return false;
+  }
+
+  // IJG quality scaling
+  quality = std::min(100, std::max(1, quality));
+  int scale = quality < 50 ? 5000 / quality : 200 - 2 * quality;
+  for (int t = 0; t < 2; ++t) {
+    for (int i = 0; i < 64; ++i) {
+      int q = (BASE_QUANT[t][i] * scale + 50) / 100;
+      q = std::min(255, std::max(1, q));
+      m_quant[t][i] = static_cast<uint8_t>(q);
+      m_divisor[t][ZIGZAG[i]] = static_cast<uint16_t>(q * 8);
+    }
+  }
+
+  m_out = out;
+  m_headerSize = writeHeaders(out);
+
+  m_nStripes = std::max(1, std::min({nStripes, m_mcusY, MAX_STRIPES}));
+  m_rowsPerStripe = (m_mcusY + m_nStripes - 1) / m_nStripes;
+  m_nStripes = (m_mcusY + m_rowsPerStripe - 1) / m_rowsPerStripe;
+
+  if (capacity < HEADER_RESERVE + 2 + 64 * m_nStripes) {
+    return false;
+  }
+  size_t regionSize = (capacity - HEADER_RESERVE - 2) / m_nStripes;
+  for (int i = 0; i < m_nStripes; ++i) {
+    Region& r = m_regions[i];
+    r.begin = r.pos = out + HEADER_RESERVE + i * regionSize;
+    r.end = r.begin + regionSize;
+    r.ok = true;
+  }
+  return true;
+}
+
+size_t
+JpegStripeEncoder::writeHeaders(uint8_t* out) {
+  uint8_t* p = out;
+  p = putU16(p, 0xFFD8); // SOI
+
+  // APP0 JFIF
+  static const uint8_t JFIF[] = {0xFF, 0xE0, 0x00, 0x10, 'J', 'F', 'I', 'F', 0x00,
+                                 0x01, 0x01, 0x00, 0x00, 0x01, 0x00, 0x01, 0x00, 0x00};
+  std::memcpy(p, JFIF, sizeof(JFIF));
+  p += sizeof(JFIF);
+
+  int nTables = m_color ? 2 : 1;
+  p = putU16(p, 0xFFDB); // DQT
+  p = putU16(p, 2 + 65 * nTables);
+  for (int t = 0; t < nTables; ++t) {
+    *p++ = static_cast<uint8_t>(t);
+    std::memcpy(p, m_quant[t], 64);
+    p += 64;
+  }
+
+  int nComps = m_color ? 3 : 1;
+  p = putU16(p, 0xFFC0); // SOF0
+  p = putU16(p, 8 + 3 * nComps);
+  *p++ = 8;
+  p = putU16(p, m_height);
+  p = putU16(p, m_width);
+  *p++ = static_cast<uint8_t>(nComps);
+  for (int c = 0; c < nComps; ++c) {
+    *p++ = static_cast<uint8_t>(c + 1);
+    *p++ = c == 0 && m_color ? 0x22 : 0x11;
+    *p++ = c == 0 ? 0 : 1;
+  }
+
+  p = putU16(p, 0xFFC4); // DHT
+  int dhtLen = 2;
+  for (int t = 0; t < 2 * nTables; ++t) {
+    dhtLen += 17 + HUFFMAN_SPECS[t].nSymbols;
+  }
+  p = putU16(p, dhtLen);
+  for (int t = 0; t < 2 * nTables; ++t) {
+    // class (DC 0, AC 1) and table index
+    *p++ = static_cast<uint8_t>(((t & 1) << 4) | (t >> 1));
+    std::memcpy(p, HUFFMAN_SPECS[t].counts, 16);
+    p += 16;
+    std::memcpy(p, HUFFMAN_SPECS[t].symbols, HUFFMAN_SPECS[t].nSymbols);
+    p += HUFFMAN_SPECS[t].nSymbols;
+  }
+
+  p = putU16(p, 0xFFDD); // DRI: one MCU row
+  p = putU16(p, 4);
+  p = putU16(p, m_mcusX);
+
+  p = putU16(p, 0xFFDA); // SOS
+  p = putU16(p, 6 + 2 * nComps);
+  *p++ = static_cast<uint8_t>(nComps);
+  for (int c = 0; c < nComps; ++c) {
+    *p++ = static_cast<uint8_t>(c + 1);
+    *p++ = c == 0 ? 0x00 : 0x11;
+  }
+  *p++ = 0;
+  *p++ = 63;
+  *p++ = 0;
+  return p - out;
+}
+
+void
+JpegStripeEncoder::loadMcu(int mcuX, int mcuY, int16_t* y, int16_t* cb, int16_t* cr) const {
+  // y: m_mcuSize x m_mcuSize samples; cb/cr: 8x8 after 2x2 averaging
+  int32_t cbSum[64];
+  int32_t crSum[64];
+  if (m_color) {
+    std::memset(cbSum, 0, sizeof(cbSum));
+    std::memset(crSum, 0, sizeof(crSum));
+  }
+
+  int x0 = mcuX * m_mcuSize;
+  int y0 = mcuY * m_mcuSize;
+  for (int dy = 0; dy < m_mcuSize; ++dy) {
+    // edge MCUs repeat the last row and column
+    int sy = std::min(y0 + dy, m_height - 1);
+    for (int dx = 0; dx < m_mcuSize; ++dx) {
+      int sx = std::min(x0 + dx, m_width - 1);
+      size_t index = static_cast<size_t>(sy) * m_width + sx;
+      int16_t ly, lcb = 0, lcr = 0;
+      switch (m_format) {
+        case GRAYSCALE:
+          ly = static_cast<int16_t>(m_pixels[index] - 128);
+          break;
+        case RGB565: {
+          const uint8_t* s = m_pixels + 2 * index;
+          int r = s[0] & 0xF8;
+          int g = ((s[0] & 0x07) << 5) | ((s[1] & 0xE0) >> 3);
+          int b = (s[1] & 0x1F) << 3;
+          rgbToYcc(r, g, b, ly, lcb, lcr);
+          break;
+        }
+        case RGB888: {
+          const uint8_t* s = m_pixels + 3 * index;
+          rgbToYcc(s[2], s[1], s[0], ly, lcb, lcr);
+          break;
+        }
+        case YUV422:
+        default: {
+          // U and V are shared by the even/odd pixel pair
+          const uint8_t* pair = m_pixels + 2 * (index & ~static_cast<size_t>(1));
+          ly = static_cast<int16_t>(m_pixels[2 * index] - 128);
+          lcb = static_cast<int16_t>(pair[1] - 128);
+          lcr = static_cast<int16_t>(pair[3] - 128);
+          break;
+        }
+      }
+      y[dy * m_mcuSize + dx] = ly;
+      if (m_color) {
+        int c = (dy >> 1) * 8 + (dx >> 1);
+        cbSum[c] += lcb;
+        crSum[c] += lcr;
+      }
+    }
+  }
+
+  if (m_color) {
+    for (int i = 0; i < 64; ++i) {
+      cb[i] = static_cast<int16_t>((cbSum[i] + 2) >> 2);
+      cr[i] = static_cast<int16_t>((crSum[i] + 2) >> 2);
+    }
+  }
+}
+
+void
+JpegStripeEncoder::encodeBlock(BitWriter& bw, const int16_t* samples, int& pred, int table) const {
+  int32_t d[64];
+  for (int i = 0; i < 64; ++i) {
+    d[i] = samples[i];
+  }
+  forwardDct(d);
+
+  const uint16_t* divisor = m_divisor[table];
+  int16_t q[64];
+  for (int i = 0; i < 64; ++i) {
+    int k = ZIGZAG[i];
+    int32_t v = d[k];
+    int32_t div = divisor[k];
+    q[i] = static_cast<int16_t>(v >= 0 ? (v + div / 2) / div : -((-v + div / 2) / div));
+  }
+
+  const HuffmanCodes& dc = g_codes[table * 2];
+  const HuffmanCodes& ac = g_codes[table * 2 + 1];
+
+  int diff = q[0] - pred;
+  pred = q[0];
+  int mag = diff < 0 ? -diff : diff;
+  int nbits = 0;
+  while (mag) {
+    ++nbits;
+    mag >>= 1;
+  }
+  bw.put(dc.code[nbits], dc.size[nbits]);
+  if (nbits) {
+    bw.put(diff < 0 ? diff - 1 : diff, nbits);
+  }
+
+  int run = 0;
+  for (int i = 1; i < 64; ++i) {
+    int v = q[i];
+    if (v == 0) {
+      ++run;
+      continue;
+    }
+    while (run > 15) {
+      bw.put(ac.code[0xF0], ac.size[0xF0]);
+      run -= 16;
+    }
+    mag = v < 0 ? -v : v;
+    nbits = 0;
+    while (mag) {
+      ++nbits;
+      mag >>= 1;
+    }
+    int symbol = (run << 4) | nbits;
+    bw.put(ac.code[symbol], ac.size[symbol]);
+    bw.put(v < 0 ? v - 1 : v, nbits);
+    run = 0;
+  }
+  if (run > 0) {
+    bw.put(ac.code[0x00], ac.size[0x00]); // EOB
+  }
+}
+
+bool
+JpegStripeEncoder::encodeStripe(int stripe) {
+  if (stripe < 0 || stripe >= m_nStripes) {
+    return false;
+  }
+  Region& r = m_regions[stripe];
+  r.pos = r.begin;
+  r.ok = true;
+  BitWriter bw(r);
+
+  int16_t y[256];
+  int16_t cb[64];
+  int16_t cr[64];
+  int16_t block[64];
+
+  int firstRow = stripe * m_rowsPerStripe;
+  int lastRow = std::min(firstRow + m_rowsPerStripe, m_mcusY);
+  for (int row = firstRow; row < lastRow && r.ok; ++row) {
+    // restart interval is one MCU row: predictors reset, RSTn closes every row but the last
+    int predY = 0, predCb = 0, predCr = 0;
+    for (int mx = 0; mx < m_mcusX; ++mx) {
+      loadMcu(mx, row, y, cb, cr);
+      if (m_color) {
+        for (int b = 0; b < 4; ++b) {
+          int bx = (b & 1) * 8;
+          int by = (b >> 1) * 8;
+          for (int i = 0; i < 8; ++i) {
+            std::memcpy(&block[i * 8], &y[(by + i) * 16 + bx], 8 * sizeof(int16_t));
+          }
+          encodeBlock(bw, block, predY, 0);
+        }
+        encodeBlock(bw, cb, predCb, 1);
+        encodeBlock(bw, cr, predCr, 1);
+      } else {
+        encodeBlock(bw, y, predY, 0);
+      }
+    }
+    bw.flush();
+    if (row + 1 < m_mcusY) {
+      bw.marker(static_cast<uint8_t>(0xD0 + (row & 7)));
+    }
+  }
+  return r.ok;
+}
+
+size_t
+JpegStripeEncoder::finish() {
+  uint8_t* p = m_out + m_headerSize;
+  for (int i = 0; i < m_nStripes; ++i) {
+    const Region& r = m_regions[i];
+    if (!r.ok) {
+      return 0;
+    }
+    size_t len = r.pos - r.begin;
+    std::memmove(p, r.begin, len);
+    p += len;
+  }
+  p = putU16(p, 0xFFD9); // EOI
+  return p - m_out;
+}
+
+} // namespace detail
+} // namespace esp32cam
@@ -0,0 +1,102 @@
+#ifndef ESP32CAM_JPEG_ENCODER_HPP
+#define ESP32CAM_JPEG_ENCODER_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace esp32cam {
+namespace detail {
+
+/**
+ * @brief Baseline JPEG encoder that splits the image into independently encoded stripes.
+ *
+ * The scan uses a restart interval of one MCU row, so every MCU row starts with fresh DC
+ * predictors and a byte-aligned bitstream. A stripe is a run of whole MCU rows; stripes share
+ * nothing but read-only tables and can be encoded concurrently, e.g. one per CPU core.
+ * Each stripe writes into its own region of a single caller-provided output buffer, and
+ * @c finish() moves the regions together behind the headers.
+ *
+ * Color images are encoded as YCbCr 4:2:0, grayscale as a single component.
+ */
+class JpegStripeEncoder {
+public:
+  enum PixelFormat {
+    GRAYSCALE, ///< 1 byte per pixel
+    RGB565,    ///< 2 bytes per pixel, big endian, as produced by the camera
+    RGB888,    ///< 3 bytes per pixel, B-G-R order, as produced by the camera
+    YUV422,    ///< 2 bytes per pixel, Y0-U-Y1-V
+  };
+
+  static constexpr int MAX_STRIPES = 4;
+
+  /**
+   * @brief Prepare encoding.
+   * @param pixels raw image, rows without padding.
+   * @param quality JPEG quality between 0 (worst) and 100 (best).
+   * @param out output buffer; it must stay valid until @c finish() .
+   * @param capacity size of @p out .
+   * @param nStripes requested number of stripes, limited by MCU rows and @c MAX_STRIPES .
+   * @return whether the parameters are acceptable.
+   */
+  bool begin(const uint8_t* pixels, int width, int height, PixelFormat format, int quality,
+             uint8_t* out, size_t capacity, int nStripes);
+
+  /** @brief Retrieve number of stripes after @c begin() . */
+  int countStripes() const {
+    return m_nStripes;
+  }
+
+  /**
+   * @brief Encode one stripe.
+   * @return whether the stripe fits in its output region.
+   *
+   * Distinct stripes may be encoded concurrently from different threads.
+   */
+  bool encodeStripe(int stripe);
+
+  /**
+   * @brief Join encoded stripes into a JPEG image at the start of the output buffer.
+   * @return JPEG size, or 0 if any stripe failed.
+   */
+  size_t finish();
+
+private:
+  struct Region {
+    uint8_t* begin;
+    uint8_t* end;
+    uint8_t* pos;
+    bool ok;
+  };
+
+  struct BitWriter;
+
+  size_t writeHeaders(uint8_t* p);
+  void loadMcu(int mcuX, int mcuY, int16_t* y, int16_t* cb, int16_t* cr) const;
+  void encodeBlock(BitWriter& bw, const int16_t* samples, int& pred, int table) const;
+
+private:
+  static constexpr size_t HEADER_RESERVE = 640;
+
+  const uint8_t* m_pixels = nullptr;
+  int m_width = 0;
+  int m_height = 0;
+  PixelFormat m_format = GRAYSCALE;
+  bool m_color = false;
+  int m_mcuSize = 8;
+  int m_mcusX = 0;
+  int m_mcusY = 0;
+
+  uint8_t m_quant[2][64];    ///< zig-zag order, as written to DQT
+  uint16_t m_divisor[2][64]; ///< natural order, quantizer scaled for the DCT gain
+
+  uint8_t* m_out = nullptr;
+  size_t m_headerSize = 0;
+  int m_nStripes = 0;
+  int m_rowsPerStripe = 0;
+  Region m_regions[MAX_STRIPES];
+};
+
+} // namespace detail
+} // namespace esp32cam
+
+#endif // ESP32CAM_JPEG_ENCODER_HPP
@@ -0,0 +1,217 @@
+#include "mjpeg.hpp"
+#include "logger.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#define MC_LOG(fmt, ...) ESP32CAM_LOG("MjpegController(%p) " fmt, this, ##__VA_ARGS__)
+
+namespace esp32cam {
+namespace detail {
+
+MjpegController::MjpegController(MjpegConfig cfg)
+  : cfg(cfg)
+  , m_nextCaptureTime(millis()) {}
+
+int
+MjpegController::decideAction() {
+  if (m_nextAction == CAPTURE) {
+    auto t = static_cast<int>(m_nextCaptureTime - millis());
+    if (t > 0) {
+      return t;
+    }
+    return CAPTURE;
+  }
+  return m_nextAction;
+}
+
+void
+MjpegController::notifyCapture() {
+  m_nextAction = RETURN;
+  m_nextCaptureTime = millis() + static_cast<unsigned long>(std::max(0, cfg.minInterval));
+  MC_LOG("notifyCapture next=%lu", m_nextCaptureTime);
+}
+
+void
+MjpegController::notifyReturn(std::shared_ptr<Frame> frame) {
+  if (frame == nullptr) {
+    MC_LOG("notifyReturn frame=nullptr");
+    notifyFail();
+    return;
+  }
+  m_frame = std::move(frame);
+  MC_LOG("notifyReturn frame=%p size=%zu dimension=%dx%d", m_frame->data(), m_frame->size(),
+         m_frame->getWidth(), m_frame->getHeight());
+  m_nextAction = SEND;
+}
+
+void
+MjpegController::notifySent(bool ok) {
+  ++m_count;
+  MC_LOG("notifySent count=%d ok=%d", m_count, static_cast<int>(ok));
+  if (!ok) {
+    notifyFail();
+    return;
+  }
+  m_frame.reset();
+  m_nextAction = cfg.maxFrames < 0 || m_count < cfg.maxFrames ? CAPTURE : STOP;
+}
+
+void
+MjpegController::notifyFail() {
+  MC_LOG("notifyFail");
+  m_frame.reset();
+  m_nextAction = STOP;
+}
+
+#define BOUNDARY "e8b8c539-047d-4777-a985-fbba6edff11e"
+
+static const char PART_TRAILER[] = "\r\n--" BOUNDARY "\r\n";
+
+MjpegHeader::MjpegHeader() {
+  m_partPrefix = snprintf(m_part, sizeof(m_part),
+                          "Content-Type: image/jpeg\r\n"
+                          "Content-Length: ");
+}
+
+void
+MjpegHeader::prepareResponseHeaders() {
+  buf = m_buf;
+  size = snprintf(m_buf, sizeof(m_buf),
+                  "HTTP/1.1 200 OK\r\n"
+                  "Content-Type: multipart/x-mixed-replace;boundary=" BOUNDARY "\r\n"
+                  "\r\n");
+}
+
+void
+MjpegHeader::prepareResponseContentType() {
+  buf = m_buf;
+  size = snprintf(m_buf, sizeof(m_buf), "multipart/x-mixed-replace;boundary=" BOUNDARY);
+}
+
+static char*
+appendDecimal(char* p, uint64_t value) {
+  char digits[20];
+  size_t nDigits = 0;
+  do {
+    digits[nDigits++] = static_cast<char>('0' + value % 10);
+    value /= 10;
+  } while (value > 0);
+
+  while (nDigits > 0) {
+    *p++ = digits[--nDigits];
+  }
+  return p;
+}
+
+static char*
+appendLiteral(char* p, const char* s, size_t len) {
+  std::memcpy(p, s, len);
+  return p + len;
+}
+
+#define APPEND_LITERAL(p, s) appendLiteral((p), (s), sizeof(s) - 1)
+
+void
+MjpegHeader::preparePartHeader(size_t contentLength) {
+  char* p = appendDecimal(m_part + m_partPrefix, contentLength);
+  p = APPEND_LITERAL(p, "\r\n\r\n");
+
+  buf = m_part;
+  size = p - m_part;
+}
+
+void
+MjpegHeader::preparePartHeader(size_t contentLength, int64_t timestamp, uint32_t sequence,
+                               int64_t sendStart) {
+  char* p = appendDecimal(m_part + m_partPrefix, contentLength);
+  p = APPEND_LITERAL(p, "\r\nX-Timestamp: ");
+  p = appendDecimal(p, static_cast<uint64_t>(std::max<int64_t>(0, timestamp)));
+  p = APPEND_LITERAL(p, "\r\nX-Sequence: ");
+  p = appendDecimal(p, sequence);
+  p = APPEND_LITERAL(p, "\r\nX-Send-Start: ");
+  p = appendDecimal(p, static_cast<uint64_t>(std::max<int64_t>(0, sendStart)));
+  p = APPEND_LITERAL(p, "\r\n\r\n");
+
+  buf = m_part;
+  size = p - m_part;
+}
+
+void
+MjpegHeader::preparePartTrailer() {
+  buf = PART_TRAILER;
+  size = sizeof(PART_TRAILER) - 1;
+}
+
+size_t
+MjpegHeader::writeTo(Print& os) {
+  return os.write(reinterpret_cast<const uint8_t*>(buf), size);
+}
+
+SegmentWriter::SegmentWriter(Print& os, int timeout)
+  : m_os(os)
+  , m_startTime(millis())
+  , m_timeout(timeout) {}
+
+SegmentWriter::SegmentWriter(Client& os, int timeout)
+  : m_os(os)
+  , m_client(&os)
+  , m_startTime(millis())
+  , m_timeout(timeout) {}
+
+bool
+SegmentWriter::write(const uint8_t* data, size_t len) {
+  if (m_len > 0) {
+    size_t n = std::min(len, MSS - m_len);
+    std::memcpy(m_buf + m_len, data, n);
+    m_len += n;
+    data += n;
+    len -= n;
+    if (m_len < MSS) {
+      return true;
+    }
+    if (!flush()) {
+      return false;
+    }
+  }
+
+  size_t direct = len - len % MSS;
+  if (direct > 0 && !writeFully(data, direct)) {
+    return false;
+  }
+
+  std::memcpy(m_buf, data + direct, len - direct);
+  m_len = len - direct;
+  return true;
+}
+
+bool
+SegmentWriter::flush() {
+  if (m_len == 0) {
+    return true;
+  }
+  bool ok = writeFully(m_buf, m_len);
+  m_len = 0;
+  return ok;
+}
+
+bool
+SegmentWriter::writeFully(const uint8_t* data, size_t len) {
+  for (size_t i = 0; i < len;) {
+    if (millis() - m_startTime > static_cast<unsigned long>(m_timeout) ||
+        (m_client != nullptr && !m_client->connected())) {
+      return false;
+    }
+    size_t n = m_os.write(&data[i], std::min(len - i, MSS));
+    ++m_segments;
+    m_bytes += n;
+    i += n;
+    if (n == 0) {
+      yield();
+    }
+  }
+  return true;
+}
+
+} // namespace detail
+} // namespace esp32cam
@@ -0,0 +1,221 @@
+#ifndef ESP32CAM_MJPEG_HPP
+#define ESP32CAM_MJPEG_HPP
+
+#include "frame.hpp"
+
+#include <memory>
+
+namespace esp32cam {
+
+/** MJPEG stream options. */
+struct MjpegConfig {
+  /**
+   * @brief Minimum interval between frame captures in millis.
+   *
+   * Negative value causes @c asyncweb::MjpegResponse to enter continuous mode.
+   */
+  int minInterval = 0;
+
+  /**
+   * @brief Maximum number of frames before disconnecting.
+   *
+   * Negative value means unlimited.
+   */
+  int maxFrames = -1;
+
+  /** @brief Time limit of writing one frame in millis. */
+  int frameTimeout = 10000;
+};
+
+namespace detail {
+
+/** @brief Control MJPEG stream timing. */
+class MjpegController {
+public:
+  explicit MjpegController(MjpegConfig cfg);
+
+  /** @brief Retrieve number of sent frames. */
+  int countSentFrames() const {
+    return m_count;
+  }
+
+  /**
+   * @brief Decide what to do now.
+   * @retval CAPTURE capture a frame.
+   * @retval RETURN return a captured frame.
+   * @retval SEND send current frame to the client.
+   * @retval STOP disconnect the client.
+   * @return if non-negative, how long to delay (millis) before the next action.
+   */
+  int decideAction();
+
+  /**
+   * @brief Notify that frame capture has started.
+   * @post decideAction()==RETURN
+   */
+  void notifyCapture();
+
+  /**
+   * @brief Notify that frame capture has completed.
+   * @param frame captured frame, possibly nullptr.
+   * @post if frame==nullptr, decideAction()==STOP; otherwise, decideAction()==SEND
+   */
+  void notifyReturn(std::shared_ptr<Frame> frame);
+
+  /** @brief Retrieve current frame. */
+  Frame* getFrame() const {
+    return m_frame.get();
+  }
+
+  /**
+   * @brief Notify that a frame is sent to the client.
+   * @param ok whether sent successfully.
+   * @post getFrame()==nullptr
+   *
+   * The caller is expected to enforce @c MjpegConfig::frameTimeout and call
+   * `notifySent(false)` in case of send timeout.
+   */
+  void notifySent(bool ok);
+
+  /**
+   * @brief Notify that an error has occurred.
+   * @post getFrame()==nullptr
+   * @post decideAction()==STOP
+   */
+  void notifyFail();
+
+public:
+  enum Action {
+    CAPTURE = -1,
+    RETURN = -2,
+    SEND = -3,
+    STOP = -4,
+  };
+
+  const MjpegConfig cfg;
+
+private:
+  std::shared_ptr<Frame> m_frame;
+  unsigned long m_nextCaptureTime;
+  int m_nextAction = CAPTURE;
+  int m_count = 0;
+};
+
+/**
+ * @brief Prepare HTTP headers related to MJPEG streaming.
+ *
+ * The part header template is formatted once at construction; @c preparePartHeader only patches
+ * the Content-Length digits and, optionally, the frame timing headers. The part trailer is a
+ * constant string.
+ */
+class MjpegHeader {
+public:
+  MjpegHeader();
+
+  /** @brief Copying is disallowed because @c buf may point into this object's own storage. */
+  MjpegHeader(const MjpegHeader&) = delete;
+  MjpegHeader& operator=(const MjpegHeader&) = delete;
+
+  void prepareResponseHeaders();
+
+  void prepareResponseContentType();
+
+  void preparePartHeader(size_t contentLength);
+
+  /**
+   * @brief Prepare part header with frame timing headers.
+   * @param contentLength frame size.
+   * @param timestamp frame capture time in micros, see @c Frame::getTimestamp() ;
+   *                  sent as @c X-Timestamp .
+   * @param sequence frame sequence number, sent as @c X-Sequence ; gaps indicate dropped frames.
+   * @param sendStart time when sending this part starts, in micros on the same clock as
+   *                  @p timestamp ; sent as @c X-Send-Start .
+   */
+  void preparePartHeader(size_t contentLength, int64_t timestamp, uint32_t sequence,
+                         int64_t sendStart);
+
+  void preparePartTrailer();
+
+  size_t writeTo(Print& os);
+
+public:
+  size_t size = 0;
+  const char* buf = m_buf;
+
+private:
+  char m_buf[120];
+  char m_part[160];
+  size_t m_partPrefix = 0;
+};
+
+/**
+ * @brief Coalesce writes into MSS-sized TCP segments.
+ *
+ * Writes shorter than one segment are staged in an internal buffer, so that a part header,
+ * the beginning of a frame, and the end of a frame with the part trailer each travel in one
+ * full-sized segment. Whole segments in the middle of a frame are written straight from the
+ * frame buffer without copying.
+ */
+class SegmentWriter {
+public:
+  /** @brief TCP maximum segment size of the lwIP stack. */
+  static constexpr size_t MSS = 1436;
+
+  /**
+   * @brief Constructor.
+   * @param os output stream.
+   * @param timeout total time limit in millis.
+   */
+  explicit SegmentWriter(Print& os, int timeout = 10000);
+
+  /**
+   * @brief Constructor.
+   * @param os output socket.
+   * @param timeout total time limit in millis.
+   */
+  explicit SegmentWriter(Client& os, int timeout = 10000);
+
+  /**
+   * @brief Append data to the output.
+   * @retval false writing disrupted by timeout or socket error.
+   */
+  bool write(const uint8_t* data, size_t len);
+
+  bool write(const char* data, size_t len) {
+    return write(reinterpret_cast<const uint8_t*>(data), len);
+  }
+
+  /**
+   * @brief Write staged data.
+   * @retval false writing disrupted by timeout or socket error.
+   */
+  bool flush();
+
+  /** @brief Retrieve number of write calls issued to the output. */
+  size_t countSegments() const {
+    return m_segments;
+  }
+
+  /** @brief Retrieve number of octets written to the output. */
+  size_t countBytes() const {
+    return m_bytes;
+  }
+
+private:
+  bool writeFully(const uint8_t* data, size_t len);
+
+private:
+  Print& m_os;
+  Client* m_client = nullptr;
+  unsigned long m_startTime;
+  int m_timeout;
+  size_t m_segments = 0;
+  size_t m_bytes = 0;
+  size_t m_len = 0;
+  uint8_t m_buf[MSS];
+};
+
+} // namespace detail
+} // namespace esp32cam
+
+#endif // ESP32CAM_MJPEG_HPP
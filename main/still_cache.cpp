@@ -0,0 +1,158 @@
+#include "still_cache.h"
+#include "config.h"
+#include "hardware.h"
+#include "src/esp32cam/camera.hpp"
+
+#define STILL_CACHE_SLOTS 2
+
+// bufory na zdjęcia bez strumienia; zdjęcia ze strumienia należą do potoku
+static CapturedFrame slots[STILL_CACHE_SLOTS];
+
+// bieżące zdjęcie (z referencją cache)
+static CapturedFrame *cached = NULL;
+static framesize_t cachedSize = FRAMESIZE_INVALID;
+static unsigned long cachedTime = 0;
+static unsigned long cachedInterruption = 0;
+
+static StillCacheStats stats;
+
+void setupStillCache()
+{
+  memset(&stats, 0, sizeof(stats));
+}
+
+// wolny bufor: nikt go nie wysyła i nie jest bieżącym zdjęciem
+static CapturedFrame *findFreeSlot()
+{
+  for (int i = 0; i < STILL_CACHE_SLOTS; i++)
+  {
+    if (slots[i].refs == 0 && &slots[i] != cached)
+      return &slots[i];
+  }
+  return NULL;
+}
+
+static void replaceCached(CapturedFrame *frame, framesize_t frameSize, unsigned long captureTime, unsigned long interruption)
+{
+  releaseFrame(cached);
+  cached = frame;
+  cachedSize = frameSize;
+  cachedTime = captureTime;
+  cachedInterruption = interruption;
+}
+
+// zmiana rozdzielczości przez kolejkę kamery, stosowana od razu - task przechwytywania
+// bez strumienia stoi, więc nic nie pobiera klatek równolegle
+static bool applyFrameSize(framesize_t frameSize)
+{
+  bool applied = false;
+  if (!esp32cam::Camera.changeResolutionAsync(esp32cam::Resolution(frameSize), STILL_DISCARD_FRAMES,
+                                              [&applied](bool ok) { applied = ok; }))
+    return false;
+  esp32cam::Camera.processPending();
+  return applied;
+}
+
+// przechwycenie bez strumienia - kopia do bufora cache i natychmiastowy zwrot bufora kamery;
+// zdjęcie w innej rozdzielczości niż sensor, po którym sensor wraca do poprzedniej
+static CapturedFrame *captureDirect(framesize_t frameSize, framesize_t sensorSize)
+{
+  CapturedFrame *slot = findFreeSlot();
+  if (!slot)
+    return NULL;
+
+  if (frameSize != sensorSize && !applyFrameSize(frameSize))
+    return NULL;
+
+  camera_fb_t *fb = getCameraFrame();
+  bool ok = false;
+  if (fb)
+  {
+    ok = storeFrame(slot, fb->buf, fb->len);
+    slot->timestamp = frameTimestamp(fb);
+    returnCameraFrame(fb);
+  }
+
+  if (frameSize != sensorSize)
+    applyFrameSize(sensorSize);
+  if (!ok)
+    return NULL;
+
+  slot->captureTime = millis();
+  slot->seq = takeFrameSeq();
+  retainFrame(slot);
+  return slot;
+}
+
+StillCacheResult acquireCachedStill(framesize_t frameSize, unsigned long maxAge, CapturedFrame *&frame,
+                                    unsigned long &age, unsigned long &interruption)
+{
+  frame = NULL;
+
+  bool streaming = isCaptureRunning();
+  framesize_t sensorSize = FRAMESIZE_INVALID;
+  if (!streaming)
+  {
+    sensor_t *s = esp_camera_sensor_get();
+    sensorSize = s->status.framesize;
+  }
+  if (frameSize == FRAMESIZE_INVALID)
+    frameSize = streaming ? STILL_FRAMESIZE : sensorSize;
+
+  stats.requests++;
+  unsigned long now = millis();
+  StillCacheResult result;
+  if (cached && cachedSize == frameSize && now - cachedTime <= maxAge)
+  {
+    result = STILL_CACHE_HIT;
+    stats.hits++;
+  }
+  else
+  {
+    CapturedFrame *fresh = NULL;
+    unsigned long freshInterruption = 0;
+    result = STILL_CACHE_MISS;
+
+    if (streaming)
+    {
+      StillStatus status = captureStill(frameSize, fresh, freshInterruption);
+      if (status == STILL_RATE_LIMITED)
+        result = cached && cachedSize == frameSize ? STILL_CACHE_STALE : STILL_CACHE_RATE_LIMITED;
+      else if (status != STILL_OK)
+        result = STILL_CACHE_FAILED;
+    }
+    else
+    {
+      fresh = captureDirect(frameSize, sensorSize);
+      if (!fresh)
+        result = STILL_CACHE_FAILED;
+    }
+
+    if (fresh)
+    {
+      stats.captures++;
+      replaceCached(fresh, frameSize, fresh->captureTime, freshInterruption);
+    }
+    else if (result == STILL_CACHE_FAILED)
+    {
+      stats.failures++;
+    }
+  }
+
+  if (result == STILL_CACHE_HIT || result == STILL_CACHE_MISS || result == STILL_CACHE_STALE)
+  {
+    retainFrame(cached);
+    frame = cached;
+    age = millis() - cachedTime;
+    interruption = result == STILL_CACHE_MISS ? cachedInterruption : 0;
+  }
+
+  return result;
+}
+
+StillCacheStats getStillCacheStats()
+{
+  StillCacheStats result = stats;
+  result.hitRate = stats.requests > 0 ? (float)stats.hits / stats.requests : 0;
+  return result;
+}
@@ -0,0 +1,42 @@
+#ifndef STILL_CACHE_H
+#define STILL_CACHE_H
+
+#include <Arduino.h>
+#include <esp_camera.h>
+
+#include "capture_pipeline.h"
+
+// Wspólne zdjęcie dla /capture i /ml/frame: żądania w oknie świeżości dostają ostatni JPEG
+// przez referencję, zamiast każde osobno wołać esp_camera_fb_get(). Wołane tylko z pętli
+// głównej (WebServer i WebSocket obsługują jedno żądanie naraz).
+enum StillCacheResult
+{
+  STILL_CACHE_HIT,          // zdjęcie z okna świeżości
+  STILL_CACHE_MISS,         // nowe przechwycenie
+  STILL_CACHE_STALE,        // zdjęcie starsze niż okno - nowe odrzucone przez limit zdjęć w strumieniu
+  STILL_CACHE_RATE_LIMITED, // limit zdjęć w strumieniu i brak wcześniejszego zdjęcia
+  STILL_CACHE_FAILED
+};
+
+struct StillCacheStats
+{
+  uint32_t requests;
+  uint32_t hits;        // żądania obsłużone z okna świeżości
+  uint32_t captures;    // przechwycenia wykonane przez cache
+  uint32_t failures;
+  float hitRate;        // hits / requests
+};
+
+void setupStillCache();
+
+// Zdjęcie nie starsze niż `maxAge` ms w rozdzielczości `frameSize`: w trakcie strumienia
+// przez captureStill, bez strumienia z przełączeniem sensora i powrotem do jego rozdzielczości.
+// FRAMESIZE_INVALID - STILL_FRAMESIZE w trakcie strumienia, bez strumienia bieżąca rozdzielczość.
+// Przy HIT/MISS/STALE `frame` ma referencję do zwolnienia przez releaseFrame(),
+// `age` to wiek zdjęcia, a `interruption` - przerwa w strumieniu (0 bez strumienia).
+StillCacheResult acquireCachedStill(framesize_t frameSize, unsigned long maxAge, CapturedFrame *&frame,
+                                    unsigned long &age, unsigned long &interruption);
+
+StillCacheStats getStillCacheStats();
+
+#endif // STILL_CACHE_H
@@ -0,0 +1,111 @@
+#include "stream_client.h"
+
+#include <errno.h>
+#include <esp_timer.h>
+#include <lwip/sockets.h>
+
+StreamClient::StreamClient(const WiFiClient &client, const MotionGateConfig &motion)
+    : m_client(client), m_motionGate(motion), m_createTime(millis())
+{
+}
+
+StreamClient::~StreamClient()
+{
+  releaseFrame(m_frame);
+}
+
+void StreamClient::offer(CapturedFrame *frame)
+{
+  if (isBusy())
+  {
+    releaseFrame(frame);
+    m_skippedFrames++;
+    return;
+  }
+
+  // nagłówek części kopiowany lokalnie, bo MjpegHeader jest współdzielony z granicą części;
+  // czas przechwycenia, numer klatki i początek wysyłki do pomiaru opóźnienia po stronie klienta
+  m_hdr.preparePartHeader(frame->len, frame->timestamp, frame->seq, esp_timer_get_time());
+  memcpy(m_header, m_hdr.buf, m_hdr.size);
+  m_headerLen = m_hdr.size;
+  m_hdr.preparePartTrailer();
+
+  m_frame = frame;
+  m_lastSeq = frame->seq;
+  m_length = m_headerLen + frame->len + m_hdr.size;
+  m_cursor = 0;
+  m_sendStart = millis();
+}
+
+void StreamClient::suppress(CapturedFrame *frame)
+{
+  m_lastSeq = frame->seq;
+  m_motionGate.suppress(frame);
+  releaseFrame(frame);
+}
+
+bool StreamClient::pump()
+{
+  int fd = m_client.fd();
+  if (fd < 0)
+    return false;
+
+  while (isBusy())
+  {
+    // nagłówek, klatka i granica jako jedna sekwencja scatter-gather
+    const uint8_t *parts[3] = {(const uint8_t *)m_header, m_frame->buf, (const uint8_t *)m_hdr.buf};
+    size_t sizes[3] = {m_headerLen, m_frame->len, m_hdr.size};
+
+    struct iovec iov[3];
+    int iovcnt = 0;
+    size_t offset = m_cursor;
+    for (int i = 0; i < 3; i++)
+    {
+      if (offset >= sizes[i])
+      {
+        offset -= sizes[i];
+        continue;
+      }
+      iov[iovcnt].iov_base = (void *)(parts[i] + offset);
+      iov[iovcnt].iov_len = sizes[i] - offset;
+      iovcnt++;
+      offset = 0;
+    }
+
+    struct msghdr msg = {};
+    msg.msg_iov = iov;
+    msg.msg_iovlen = iovcnt;
+
+    int n = sendmsg(fd, &msg, MSG_DONTWAIT);
+    if (n < 0)
+    {
+      // bufor nadawczy pełny - spróbujemy przy następnym wywołaniu
+      if (errno == EAGAIN || errno == EWOULDBLOCK)
+        return true;
+      return false;
+    }
+    if (n == 0)
+      return true;
+
+    m_cursor += n;
+    if (m_cursor >= m_length)
+      finishFrame();
+  }
+  return true;
+}
+
+void StreamClient::finishFrame()
+{
+  m_lastLag = millis() - m_frame->captureTime;
+  m_lastSendTime = millis() - m_sendStart;
+  m_lastFrameBytes = m_length;
+  if (m_lastLag > m_maxLag)
+    m_maxLag = m_lastLag;
+  if (m_sentFrames++ == 0)
+    m_firstFrameTime = max<unsigned long>(1, millis() - m_createTime);
+
+  releaseFrame(m_frame);
+  m_frame = NULL;
+  m_length = 0;
+  m_cursor = 0;
+}
@@ -0,0 +1,82 @@
+#ifndef STREAM_CLIENT_H
+#define STREAM_CLIENT_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+
+#include "capture_pipeline.h"
+#include "motion_gate.h"
+#include "src/esp32cam/mjpeg.hpp"
+
+// Klient strumienia MJPEG z nieblokującym wysyłaniem i własnym kursorem.
+// Klient trzyma referencję do klatki z puli potoku przechwytywania - bez kopiowania.
+// Klient, który nie skończył poprzedniej klatki, pomija nowe zamiast je kolejkować
+// - po zakończeniu wysyłki dostaje najnowszą.
+class StreamClient
+{
+public:
+  StreamClient(const WiFiClient &client, const MotionGateConfig &motion);
+  ~StreamClient();
+
+  StreamClient(const StreamClient &) = delete;
+  StreamClient &operator=(const StreamClient &) = delete;
+
+  WiFiClient &socket() { return m_client; }
+  bool connected() { return m_client.connected(); }
+
+  // czy klatka jest w trakcie wysyłania
+  bool isBusy() const { return m_frame != NULL; }
+
+  // numer ostatniej przekazanej klatki
+  uint32_t lastSeq() const { return m_lastSeq; }
+
+  // przekazanie klatki (z referencją) do wysłania; klient zwalnia ją po wysłaniu
+  void offer(CapturedFrame *frame);
+
+  // oznaczenie klatki pominiętej (klient zajęty)
+  void skip() { m_skippedFrames++; }
+
+  // klatka bez zmian w scenie - nie jest wysyłana, ale liczy się jako obsłużona
+  void suppress(CapturedFrame *frame);
+
+  MotionGate &motionGate() { return m_motionGate; }
+  const MotionGate &motionGate() const { return m_motionGate; }
+
+  // wysłanie tyle, ile gniazdo przyjmie bez blokowania; false przy błędzie gniazda
+  bool pump();
+
+  uint32_t sentFrames() const { return m_sentFrames; }
+  uint32_t skippedFrames() const { return m_skippedFrames; }
+  unsigned long lastLag() const { return m_lastLag; }   // przechwycenie -> koniec wysyłki (ms)
+  unsigned long lastSendTime() const { return m_lastSendTime; } // początek -> koniec wysyłki (ms)
+  size_t lastFrameBytes() const { return m_lastFrameBytes; }
+  unsigned long maxLag() const { return m_maxLag; }
+  size_t pendingBytes() const { return m_length - m_cursor; }
+  unsigned long timeToFirstFrame() const { return m_firstFrameTime; } // 0 - jeszcze brak klatki
+
+private:
+  void finishFrame();
+
+private:
+  WiFiClient m_client;
+  esp32cam::detail::MjpegHeader m_hdr;
+  MotionGate m_motionGate;
+  char m_header[160];
+  size_t m_headerLen = 0;
+  CapturedFrame *m_frame = NULL;
+  size_t m_length = 0;
+  size_t m_cursor = 0;
+  uint32_t m_lastSeq = 0;
+  unsigned long m_createTime;
+  unsigned long m_sendStart = 0;
+  unsigned long m_firstFrameTime = 0;
+
+  uint32_t m_sentFrames = 0;
+  uint32_t m_skippedFrames = 0;
+  unsigned long m_lastLag = 0;
+  unsigned long m_maxLag = 0;
+  unsigned long m_lastSendTime = 0;
+  size_t m_lastFrameBytes = 0;
+};
+
+#endif // STREAM_CLIENT_H
@@ -0,0 +1,154 @@
+#include "traffic_control.h"
+#include "config.h"
+#include <lwip/sockets.h>
+
+static portMUX_TYPE trafficMux = portMUX_INITIALIZER_UNLOCKED;
+
+static bool governorEnabled = true;
+static float wsLoopTimeAvg = 0;
+static unsigned long wsLoopTimeMax = 0;
+static float controlRttAvg = 0;
+static unsigned long controlRttLast = 0;
+static unsigned long lastPongTime = 0;
+static bool controlRttExpired = true;
+static uint32_t controlRttExpiries = 0;
+static unsigned long lastGovernorUpdate = 0;
+static uint32_t throttleEvents = 0;
+
+// token bucket dla strumienia kamery (wspólny dla wszystkich klientów strumienia)
+static uint32_t streamRateLimit = STREAM_MAX_RATE;
+static long streamTokens = 0;
+static unsigned long lastRefill = 0;
+static uint32_t streamDelayMs = 0;
+
+static void setSocketTos(WiFiClient &client, int tos)
+{
+    int fd = client.fd();
+    if (fd < 0)
+        return;
+    setsockopt(fd, IPPROTO_IP, IP_TOS, &tos, sizeof(tos));
+}
+
+void configureControlSocket(WiFiClient &client)
+{
+    // krótkie odpowiedzi sterowania wychodzą od razu, bez czekania na Nagle
+    client.setNoDelay(true);
+    setSocketTos(client, IPTOS_LOWDELAY);
+}
+
+void configureStreamSocket(WiFiClient &client)
+{
+    // strumień może łączyć segmenty - liczy się przepustowość, nie opóźnienie
+    client.setNoDelay(false);
+    setSocketTos(client, IPTOS_THROUGHPUT);
+}
+
+void reportWebSocketLoopTime(unsigned long elapsedMs)
+{
+    wsLoopTimeAvg = wsLoopTimeAvg * 0.9f + elapsedMs * 0.1f;
+    if (elapsedMs > wsLoopTimeMax)
+        wsLoopTimeMax = elapsedMs;
+}
+
+void reportControlRtt(unsigned long rttMs)
+{
+    controlRttLast = rttMs;
+    controlRttAvg = controlRttExpired ? rttMs : controlRttAvg * 0.8f + rttMs * 0.2f;
+    controlRttExpired = false;
+    lastPongTime = millis();
+}
+
+void updateTrafficGovernor()
+{
+    unsigned long now = millis();
+    if (now - lastGovernorUpdate < TRAFFIC_GOVERNOR_INTERVAL)
+        return;
+    lastGovernorUpdate = now;
+
+    // RTT zmienia się tylko z odpowiedzią pong - po rozłączeniu ostatniego sterującego klienta
+    // stara średnia trzymałaby limit strumienia na minimum, więc po CONTROL_RTT_EXPIRY wygasa
+    if (!controlRttExpired && now - lastPongTime > CONTROL_RTT_EXPIRY)
+    {
+        controlRttExpired = true;
+        controlRttAvg = 0;
+        controlRttExpiries++;
+    }
+
+    uint32_t limit = STREAM_MAX_RATE;
+    if (governorEnabled)
+    {
+        // opóźnienie sterowania w jedną stronę - połowa RTT ping/pong, w którym komunikat
+        // czeka w kolejkach za strumieniem kamery
+        float latency = controlRttAvg / 2;
+
+        // AIMD: szybkie zmniejszenie przy przekroczeniu budżetu, powolny powrót
+        limit = streamRateLimit;
+        if (latency > CONTROL_LATENCY_BUDGET)
+        {
+            limit = max<uint32_t>(STREAM_MIN_RATE, limit / 2);
+            if (limit != streamRateLimit)
+                throttleEvents++;
+        }
+        else
+        {
+            limit = min<uint32_t>(STREAM_MAX_RATE, limit + STREAM_RATE_STEP);
+        }
+    }
+
+    portENTER_CRITICAL(&trafficMux);
+    streamRateLimit = limit;
+    portEXIT_CRITICAL(&trafficMux);
+}
+
+void setTrafficGovernorEnabled(bool enabled)
+{
+    governorEnabled = enabled;
+    Serial.println(enabled ? "Regulator ruchu włączony" : "Regulator ruchu wyłączony");
+}
+
+bool isTrafficGovernorEnabled()
+{
+    return governorEnabled;
+}
+
+unsigned long acquireStreamBudget(size_t bytes)
+{
+    unsigned long wait = 0;
+    unsigned long now = millis();
+
+    portENTER_CRITICAL(&trafficMux);
+    // uzupełnienie tokenów, z limitem na jedną sekundę zapasu
+    streamTokens += (long)((uint64_t)(now - lastRefill) * streamRateLimit / 1000);
+    if (streamTokens > (long)streamRateLimit)
+        streamTokens = streamRateLimit;
+    lastRefill = now;
+
+    streamTokens -= bytes;
+    if (streamTokens < 0)
+    {
+        wait = (unsigned long)((uint64_t)(-streamTokens) * 1000 / streamRateLimit);
+        streamDelayMs += wait;
+    }
+    portEXIT_CRITICAL(&trafficMux);
+
+    return wait;
+}
+
+TrafficStats getTrafficStats(bool resetMax)
+{
+    TrafficStats stats;
+    stats.governorEnabled = governorEnabled;
+    stats.wsLoopTimeAvg = wsLoopTimeAvg;
+    stats.wsLoopTimeMax = wsLoopTimeMax;
+    stats.controlRttAvg = controlRttAvg;
+    stats.controlRttLast = controlRttLast;
+    stats.controlRttExpired = controlRttExpired;
+    stats.controlRttExpiries = controlRttExpiries;
+    stats.streamRateLimit = streamRateLimit;
+    stats.throttleEvents = throttleEvents;
+    stats.streamDelayMs = streamDelayMs;
+
+    if (resetMax)
+        wsLoopTimeMax = 0;
+    return stats;
+}
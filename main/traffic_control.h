@@ -0,0 +1,41 @@
+#ifndef TRAFFIC_CONTROL_H
+#define TRAFFIC_CONTROL_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+
+// Klasy ruchu: sterowanie (małe opóźnienie) i strumień kamery (przepustowość)
+void configureControlSocket(WiFiClient& client);
+void configureStreamSocket(WiFiClient& client);
+
+// Czas jednego wywołania webSocket.loop() - diagnostyka pętli, nie steruje regulatorem
+void reportWebSocketLoopTime(unsigned long elapsedMs);
+// RTT ping/pong WebSocket - opóźnienie sterowania widziane przez klienta
+void reportControlRtt(unsigned long rttMs);
+
+// Regulator - dławi strumień kamery, gdy opóźnienie sterowania (połowa RTT) przekracza budżet;
+// RTT bez świeżej odpowiedzi pong (CONTROL_RTT_EXPIRY) liczy się jako 0
+void updateTrafficGovernor();
+void setTrafficGovernorEnabled(bool enabled);
+bool isTrafficGovernorEnabled();
+
+// Limit przepływności strumienia - zwraca ile ms odczekać po wysłaniu `bytes` bajtów
+unsigned long acquireStreamBudget(size_t bytes);
+
+struct TrafficStats
+{
+    bool governorEnabled;
+    float wsLoopTimeAvg;             // średni czas webSocket.loop() (ms)
+    unsigned long wsLoopTimeMax;     // maksimum od ostatniego odczytu (ms)
+    float controlRttAvg;             // średnie RTT ping/pong WebSocket (ms)
+    unsigned long controlRttLast;    // ostatnie RTT (ms)
+    bool controlRttExpired;          // brak pong przez CONTROL_RTT_EXPIRY - RTT nie dławi strumienia
+    uint32_t controlRttExpiries;     // ile razy RTT wygasło
+    uint32_t streamRateLimit;        // aktualny limit strumienia (B/s)
+    uint32_t throttleEvents;         // ile razy regulator obniżył limit
+    uint32_t streamDelayMs;          // łączny czas opóźnień wprowadzonych w strumieniu
+};
+
+TrafficStats getTrafficStats(bool resetMax = true);
+
+#endif // TRAFFIC_CONTROL_H
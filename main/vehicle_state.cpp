@@ -0,0 +1,27 @@
+#include "vehicle_state.h"
+#include "config.h"
+
+VehicleState vehicle = {
+    WEB_CONTROL,  // domyślnie kontrola to manualna przez serwer web
+    SPEED_NORMAL, // domyślny tryb prędkości to normalny
+    false,
+    0,
+    0,
+    0,
+    nullptr,
+    nullptr};
+
+// Funkcja do ustawienia aktualnej prędkości silników na podstawie wybranego trybu
+int getCurrentSpeedValue()
+{
+    switch (vehicle.speedMode)
+    {
+    case SPEED_LOW:
+        return SPEED_MODE_LOW;
+    case SPEED_HIGH:
+        return SPEED_MODE_HIGH;
+    case SPEED_NORMAL:
+    default:
+        return SPEED_MODE_NORMAL;
+    }
+}
@@ -0,0 +1,43 @@
+#ifndef VEHICLE_STATE_H
+#define VEHICLE_STATE_H
+
+#include <Arduino.h>
+#include <WebServer.h>
+#include <WebSocketsServer.h>
+
+// Stan sterowania pojazdem w jednym miejscu: tryby sterowania i prędkości, jazda do przodu
+// z zatrzymaniem awaryjnym, czasy zadań cyklicznych pętli głównej i serwery, przez które
+// odpowiadają handlery. Moduły sięgają do niego przez `vehicle` zamiast osobnych zmiennych
+// globalnych, więc cały stan jest widoczny (i resetowany) razem.
+
+enum ControlMode
+{
+    WEB_CONTROL,
+    ML_CONTROL
+};
+
+enum SpeedMode
+{
+    SPEED_LOW,
+    SPEED_NORMAL,
+    SPEED_HIGH
+};
+
+struct VehicleState
+{
+    ControlMode mode;
+    SpeedMode speedMode;
+    bool movingForward;                  // checkObstacles() mierzy odległość tylko przy jeździe do przodu
+    unsigned long lastEmergencyStopTime; // millis() ostatniego zatrzymania przez czujnik, 0 - brak
+    unsigned long lastSensorTime;        // millis() ostatniej wysyłki odległości przez WebSocket
+    unsigned long lastPingTime;          // millis() ostatniego pingu sterowania
+    WebServer *server;                   // serwer strony sterowania i API
+    WebSocketsServer *webSocket;
+};
+
+extern VehicleState vehicle;
+
+// Prędkość PWM dla bieżącego trybu prędkości
+int getCurrentSpeedValue();
+
+#endif // VEHICLE_STATE_H
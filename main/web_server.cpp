@@ -1,30 +1,29 @@
 #include "web_server.h"
 #include "motor_control.h"
 #include "api_handler.h"
+#include "vehicle_state.h"
+#include "request_stats.h"
 #include <WebServer.h>
 
-// Deklaracja referencji do obiektu WebServer
-WebServer *server_ptr = nullptr;
-
 // Funkcja inicjalizująca serwer web
 void setupWebServer(WebServer &server)
 {
     // Zapisz referencję do obiektu serwera
-    server_ptr = &server;
+    vehicle.server = &server;
 
     // Definicja endpointów serwera
-    server.on("/", handleRoot);
-    server.on("/camera", handleCamera);
-    server.on("/forward", handleForward);
-    server.on("/backward", handleBackward);
-    server.on("/left", handleLeft);
-    server.on("/right", handleRight);
-    server.on("/stop", handleStop);
+    server.on("/", timedHandler<REQUEST_PAGE, handleRoot>);
+    server.on("/camera", timedHandler<REQUEST_PAGE, handleCamera>);
+    server.on("/forward", timedHandler<REQUEST_PAGE, handleForward>);
+    server.on("/backward", timedHandler<REQUEST_PAGE, handleBackward>);
+    server.on("/left", timedHandler<REQUEST_PAGE, handleLeft>);
+    server.on("/right", timedHandler<REQUEST_PAGE, handleRight>);
+    server.on("/stop", timedHandler<REQUEST_PAGE, handleStop>);
     
     // Konfiguracja endpointów API
     setupAPIEndpoints(server);
     
-    server.onNotFound(handleNotFound); // Obsługa nieznalezionych endpointów
+    server.onNotFound(timedHandler<REQUEST_PAGE, handleNotFound>); // Obsługa nieznalezionych endpointów
 
     // Uruchomienie serwera
     server.begin();
@@ -125,6 +124,10 @@ String generateHtml()
     html += "  ws.onmessage = function(event) {";
     html += "    try {";
     html += "      const data = JSON.parse(event.data);";
+    html += "      if (data.event === 'ping') {";
+    html += "        ws.send(JSON.stringify({command: 'pong', t: data.t}));";
+    html += "        return;";
+    html += "      }";
     html += "      console.log('Otrzymano:', data);";
     
     html += "      if (data.status === 'connected' && data.mode) {";
@@ -275,6 +278,7 @@ String generateCameraHtml() {
     html += "<option value='VGA'>VGA (640x480)</option>";
     html += "<option value='CIF'>CIF (400x296)</option>";
     html += "<option value='QVGA'>QVGA (320x240)</option>";
+    html += "<option value='auto'>Auto</option>";
     html += "</select>";
     html += "</div>";
     
@@ -368,18 +372,18 @@ String generateCameraHtml() {
 // Handler dla strony głównej
 void handleRoot()
 {
-    if (server_ptr)
+    if (vehicle.server)
     {
-        server_ptr->send(200, "text/html", generateHtml());
+        vehicle.server->send(200, "text/html", generateHtml());
     }
 }
 
 // Handler dla strony kamery
 void handleCamera()
 {
-    if (server_ptr)
+    if (vehicle.server)
     {
-        server_ptr->send(200, "text/html", generateCameraHtml());
+        vehicle.server->send(200, "text/html", generateCameraHtml());
     }
 }
 
@@ -387,9 +391,9 @@ void handleCamera()
 void handleForward()
 {
     moveForward();
-    if (server_ptr)
+    if (vehicle.server)
     {
-        server_ptr->send(200, "text/plain", "Jazda do przodu");
+        vehicle.server->send(200, "text/plain", "Jazda do przodu");
     }
 }
 
@@ -397,9 +401,9 @@ void handleForward()
 void handleBackward()
 {
     moveBackward();
-    if (server_ptr)
+    if (vehicle.server)
     {
-        server_ptr->send(200, "text/plain", "Jazda do tylu");
+        vehicle.server->send(200, "text/plain", "Jazda do tylu");
     }
 }
 
@@ -407,9 +411,9 @@ void handleBackward()
 void handleLeft()
 {
     turnLeft();
-    if (server_ptr)
+    if (vehicle.server)
     {
-        server_ptr->send(200, "text/plain", "Skret w lewo");
+        vehicle.server->send(200, "text/plain", "Skret w lewo");
     }
 }
 
@@ -417,9 +421,9 @@ void handleLeft()
 void handleRight()
 {
     turnRight();
-    if (server_ptr)
+    if (vehicle.server)
     {
-        server_ptr->send(200, "text/plain", "Skret w prawo");
+        vehicle.server->send(200, "text/plain", "Skret w prawo");
     }
 }
 
@@ -427,17 +431,17 @@ void handleRight()
 void handleStop()
 {
     stopMotors();
-    if (server_ptr)
+    if (vehicle.server)
     {
-        server_ptr->send(200, "text/plain", "Zatrzymano");
+        vehicle.server->send(200, "text/plain", "Zatrzymano");
     }
 }
 
 // Handler dla nieznalezionych endpointów
 void handleNotFound()
 {
-    if (server_ptr)
+    if (vehicle.server)
     {
-        server_ptr->send(404, "text/plain", "Nie znaleziono");
+        vehicle.server->send(404, "text/plain", "Nie znaleziono");
     }
 }
\ No newline at end of file
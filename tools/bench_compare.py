@@ -0,0 +1,95 @@
+#!/usr/bin/env python3
+"""Zapis i porównanie wyników mikrobenchmarków pojazdu (/api/bench).
+
+`run` pobiera wyniki z pojazdu i zapisuje je do pliku JSON (pola benchmarków jak w formacie
+Google Benchmark). `compare` zestawia dwa takie pliki - np. z dwóch wersji firmware'u - i
+wypisuje zmianę czasu każdego benchmarku; różnice powyżej progu są oznaczane.
+
+Użycie:
+    python3 tools/bench_compare.py run przed.json [--host 192.168.4.1] [--min-time 100] [--filter mjpeg]
+    python3 tools/bench_compare.py compare przed.json po.json [--threshold 5]
+"""
+
+import argparse
+import json
+import sys
+import urllib.parse
+import urllib.request
+
+
+def load(path):
+    with open(path) as f:
+        doc = json.load(f)
+    # odpowiedź API albo same dane
+    return doc.get("data", doc)
+
+
+def run(args):
+    query = {"min_time": args.min_time}
+    if args.filter:
+        query["filter"] = args.filter
+    url = "http://%s/api/bench?%s" % (args.host, urllib.parse.urlencode(query))
+    with urllib.request.urlopen(url, timeout=args.timeout) as response:
+        doc = json.load(response)
+    if not doc.get("success"):
+        sys.exit("bench: %s" % doc.get("message"))
+
+    data = doc["data"]
+    with open(args.output, "w") as f:
+        json.dump(data, f, indent=2)
+    for b in data["benchmarks"]:
+        if b.get("error_occurred"):
+            print("%-28s %s" % (b["name"], b["error_message"]))
+        else:
+            print("%-28s %12.1f ns %10d it" % (b["name"], b["real_time"], b["iterations"]))
+
+
+def compare(args):
+    before, after = load(args.before), load(args.after)
+    for side, data in (("przed", before), ("po", after)):
+        ctx = data.get("context", {})
+        print("%-6s build %s, %s MHz" % (side, ctx.get("build", "?"), ctx.get("mhz_per_cpu", "?")))
+
+    old = {b["name"]: b for b in before["benchmarks"] if not b.get("error_occurred")}
+    print("%-28s %12s %12s %8s" % ("benchmark", "przed (ns)", "po (ns)", "zmiana"))
+    regressions = 0
+    for b in after["benchmarks"]:
+        if b.get("error_occurred") or b["name"] not in old:
+            continue
+        t0, t1 = old[b["name"]]["real_time"], b["real_time"]
+        change = (t1 - t0) / t0 * 100 if t0 > 0 else 0.0
+        mark = ""
+        if change > args.threshold:
+            mark = "  wolniej"
+            regressions += 1
+        elif change < -args.threshold:
+            mark = "  szybciej"
+        print("%-28s %12.1f %12.1f %+7.1f%%%s" % (b["name"], t0, t1, change, mark))
+    return 1 if regressions else 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = parser.add_subparsers(dest="cmd", required=True)
+
+    p = sub.add_parser("run", help="pobranie wyników z pojazdu")
+    p.add_argument("output")
+    p.add_argument("--host", default="192.168.4.1")
+    p.add_argument("--min-time", type=int, default=100, help="ms na benchmark")
+    p.add_argument("--filter", default="")
+    p.add_argument("--timeout", type=float, default=60)
+
+    p = sub.add_parser("compare", help="porównanie dwóch plików wyników")
+    p.add_argument("before")
+    p.add_argument("after")
+    p.add_argument("--threshold", type=float, default=5, help="próg oznaczenia zmiany (%%)")
+
+    args = parser.parse_args()
+    if args.cmd == "run":
+        run(args)
+        return 0
+    return compare(args)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,217 @@
+#!/usr/bin/env python3
+"""Czytnik nagrań zbioru uczącego pojazdu (rec_NNNN.nvds).
+
+Plik zawiera rekordy (klatka JPEG, prędkości kół, tryb sterowania, odległość) dopasowane
+czasem przechwycenia klatki, a na końcu indeks. Plik bez indeksu (przerwane nagranie,
+zanik zasilania) jest czytany sekwencyjnie, do ostatniego całego rekordu. Format opisuje
+main/dataset_recorder.h.
+
+Polecenia:
+    info FILE            - podsumowanie nagrania
+    export FILE DIR      - klatki jako DIR/NNNNNN.jpg i DIR/records.csv
+    download NAME OUT    - pobranie nagrania z pojazdu zakresami (Range), z wznawianiem
+
+Przykład:
+    python3 tools/dataset_reader.py download rec_0001.nvds rec_0001.nvds
+    python3 tools/dataset_reader.py export rec_0001.nvds dataset/rec_0001
+"""
+
+import argparse
+import csv
+import os
+import struct
+import sys
+import urllib.error
+import urllib.request
+
+FILE_HEADER = struct.Struct("<4sHHqI12x")
+RECORD_HEADER = struct.Struct("<4sIIiqhhHBB")
+INDEX_ENTRY = struct.Struct("<IIq")
+TRAILER = struct.Struct("<4sII4x")
+
+FLAG_SPEEDS_UNCERTAIN = 0x01
+
+
+class Record:
+    __slots__ = ("offset", "seq", "timestamp", "left", "right", "distance_mm",
+                 "distance_age", "mode", "flags", "jpeg_offset", "jpeg_len")
+
+    @property
+    def distance_cm(self):
+        return self.distance_mm / 10.0 if self.distance_mm else None
+
+
+class Dataset:
+    def __init__(self, path):
+        self.path = path
+        self.file = open(path, "rb")
+        self.size = os.fstat(self.file.fileno()).st_size
+
+        head = self.file.read(FILE_HEADER.size)
+        if len(head) < FILE_HEADER.size:
+            raise ValueError("plik za krótki")
+        magic, self.version, record_size, self.start, self.interval = FILE_HEADER.unpack(head)
+        if magic != b"NVDS":
+            raise ValueError("to nie jest nagranie NVDS")
+        if self.version != 1 or record_size != RECORD_HEADER.size:
+            raise ValueError("nieobsługiwana wersja %d" % self.version)
+
+        self.indexed = False
+        self.records = self._read_index()
+        if self.records is None:
+            self.records = self._scan()
+        else:
+            self.indexed = True
+
+    def close(self):
+        self.file.close()
+
+    def _read_index(self):
+        if self.size < FILE_HEADER.size + TRAILER.size:
+            return None
+        self.file.seek(self.size - TRAILER.size)
+        magic, index_offset, count = TRAILER.unpack(self.file.read(TRAILER.size))
+        if magic != b"NVEN" or index_offset + 8 + count * INDEX_ENTRY.size + TRAILER.size != self.size:
+            return None
+
+        self.file.seek(index_offset)
+        if self.file.read(4) != b"NVIX" or struct.unpack("<I", self.file.read(4))[0] != count:
+            return None
+        data = self.file.read(count * INDEX_ENTRY.size)
+        offsets = [INDEX_ENTRY.unpack_from(data, i * INDEX_ENTRY.size)[0] for i in range(count)]
+        return [self._read_record(offset) for offset in offsets]
+
+    def _scan(self):
+        """Rekordy po kolei od nagłówka pliku; ucięty ostatni rekord jest pomijany."""
+        records = []
+        offset = FILE_HEADER.size
+        while offset + RECORD_HEADER.size <= self.size:
+            record = self._read_record(offset)
+            if record is None or record.jpeg_offset + record.jpeg_len > self.size:
+                break
+            records.append(record)
+            offset = record.jpeg_offset + record.jpeg_len + (-record.jpeg_len % 4)
+        return records
+
+    def _read_record(self, offset):
+        self.file.seek(offset)
+        head = self.file.read(RECORD_HEADER.size)
+        if len(head) < RECORD_HEADER.size:
+            return None
+        (magic, jpeg_len, seq, distance_age, timestamp, left, right,
+         distance_mm, mode, flags) = RECORD_HEADER.unpack(head)
+        if magic != b"NVFR":
+            return None
+
+        record = Record()
+        record.offset = offset
+        record.seq = seq
+        record.timestamp = timestamp
+        record.left = left
+        record.right = right
+        record.distance_mm = distance_mm
+        record.distance_age = distance_age
+        record.mode = "ml" if mode == 1 else "web"
+        record.flags = flags
+        record.jpeg_offset = offset + RECORD_HEADER.size
+        record.jpeg_len = jpeg_len
+        return record
+
+    def jpeg(self, record):
+        self.file.seek(record.jpeg_offset)
+        return self.file.read(record.jpeg_len)
+
+
+def command_info(args):
+    dataset = Dataset(args.file)
+    records = dataset.records
+    print("plik:        %s (%d B)" % (dataset.path, dataset.size))
+    print("indeks:      %s" % ("tak" if dataset.indexed else "brak - odczyt sekwencyjny"))
+    print("odstęp:      %d ms" % dataset.interval)
+    print("rekordy:     %d" % len(records))
+    if records:
+        duration = (records[-1].timestamp - records[0].timestamp) / 1e6
+        gaps = sum(1 for a, b in zip(records, records[1:]) if b.seq - a.seq > 1)
+        with_distance = sum(1 for r in records if r.distance_mm)
+        uncertain = sum(1 for r in records if r.flags & FLAG_SPEEDS_UNCERTAIN)
+        print("czas:        %.1f s (%.1f rekordów/s)" % (duration, (len(records) - 1) / duration if duration > 0 else 0))
+        print("klatki:      %d - %d, przerwy w numeracji: %d" % (records[0].seq, records[-1].seq, gaps))
+        print("odległość:   %d rekordów z pomiarem" % with_distance)
+        print("prędkości:   %d rekordów z niepewnym stanem silników" % uncertain)
+    dataset.close()
+
+
+def command_export(args):
+    dataset = Dataset(args.file)
+    os.makedirs(args.dir, exist_ok=True)
+    with open(os.path.join(args.dir, "records.csv"), "w", newline="") as out:
+        writer = csv.writer(out)
+        writer.writerow(["image", "seq", "timestamp_us", "left", "right", "mode",
+                         "distance_cm", "distance_age_ms", "speeds_uncertain"])
+        for i, record in enumerate(dataset.records):
+            image = "%06d.jpg" % i
+            with open(os.path.join(args.dir, image), "wb") as f:
+                f.write(dataset.jpeg(record))
+            distance = record.distance_cm
+            writer.writerow([image, record.seq, record.timestamp, record.left, record.right, record.mode,
+                             "" if distance is None else "%.1f" % distance,
+                             "" if distance is None else record.distance_age,
+                             1 if record.flags & FLAG_SPEEDS_UNCERTAIN else 0])
+    print("%d rekordów -> %s" % (len(dataset.records), args.dir))
+    dataset.close()
+
+
+def command_download(args):
+    """Pobieranie zakresami: pojazd obsługuje sterowanie między kolejnymi żądaniami."""
+    url = "%s/dataset/file?name=%s" % (args.host.rstrip("/"), args.name)
+    done = os.path.getsize(args.out) if os.path.exists(args.out) else 0
+    with open(args.out, "ab") as out:
+        while True:
+            request = urllib.request.Request(url, headers={"Range": "bytes=%d-%d" % (done, done + args.chunk - 1)})
+            try:
+                with urllib.request.urlopen(request, timeout=30) as response:
+                    total = int(response.headers["Content-Range"].rpartition("/")[2])
+                    data = response.read()
+            except urllib.error.HTTPError as error:
+                if error.code == 416:
+                    break  # plik już pobrany w całości
+                raise
+            out.write(data)
+            done += len(data)
+            sys.stderr.write("\r%d / %d B" % (done, total))
+            if done >= total or not data:
+                break
+    sys.stderr.write("\n")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Czytnik nagrań zbioru uczącego pojazdu")
+    sub = parser.add_subparsers(dest="command", required=True)
+
+    info = sub.add_parser("info", help="podsumowanie nagrania")
+    info.add_argument("file")
+    info.set_defaults(run=command_info)
+
+    export = sub.add_parser("export", help="klatki JPEG i records.csv")
+    export.add_argument("file")
+    export.add_argument("dir")
+    export.set_defaults(run=command_export)
+
+    download = sub.add_parser("download", help="pobranie nagrania z pojazdu")
+    download.add_argument("name", help="nazwa pliku z /dataset/list")
+    download.add_argument("out")
+    download.add_argument("--host", default="http://192.168.4.1")
+    download.add_argument("--chunk", type=int, default=256 * 1024, help="rozmiar zakresu (B)")
+    download.set_defaults(run=command_download)
+
+    args = parser.parse_args()
+    try:
+        args.run(args)
+    except (OSError, ValueError) as error:
+        sys.stderr.write("błąd: %s\n" % error)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,118 @@
+#!/usr/bin/env python3
+"""Pomiar opóźnienia strumienia MJPEG pojazdu.
+
+Odczytuje /stream i z nagłówków części (X-Timestamp, X-Sequence, X-Send-Start) liczy
+rozkład opóźnienia przechwycenie -> odbiór oraz brakujące numery klatek.
+
+Zegar pojazdu (esp_timer, µs od startu) nie jest zsynchronizowany z zegarem hosta, więc
+przesunięcie zegarów jest szacowane jako minimum (odbiór - początek wysyłki): opóźnienie
+odbioru jest liczone względem najszybciej dostarczonej klatki. Składnik na urządzeniu
+(przechwycenie -> początek wysyłki) jest dokładny.
+
+Użycie:
+    python3 tools/mjpeg_latency.py [--url http://192.168.4.1/stream] [--frames 300]
+"""
+
+import argparse
+import sys
+import time
+import urllib.request
+
+
+def read_parts(stream):
+    """Kolejne części multipart: (czas odbioru w µs, nagłówki, długość)."""
+    while True:
+        line = stream.readline()
+        if not line:
+            return
+        if not line.startswith(b"Content-Type: image/jpeg"):
+            continue
+
+        headers = {}
+        while True:
+            line = stream.readline()
+            if not line:
+                return
+            line = line.strip()
+            if not line:
+                break
+            name, _, value = line.decode("latin-1").partition(":")
+            headers[name.strip().lower()] = value.strip()
+
+        length = int(headers.get("content-length", "0"))
+        remaining = length
+        while remaining > 0:
+            chunk = stream.read(min(remaining, 65536))
+            if not chunk:
+                return
+            remaining -= len(chunk)
+        yield time.monotonic_ns() // 1000, headers, length
+
+
+def percentile(values, p):
+    if not values:
+        return 0.0
+    ordered = sorted(values)
+    index = min(len(ordered) - 1, int(round(p / 100.0 * (len(ordered) - 1))))
+    return ordered[index]
+
+
+def summarize(name, values_us):
+    ms = [v / 1000.0 for v in values_us]
+    print("%-32s p50 %7.1f  p90 %7.1f  p99 %7.1f  max %7.1f ms" % (
+        name, percentile(ms, 50), percentile(ms, 90), percentile(ms, 99), max(ms) if ms else 0.0))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("--url", default="http://192.168.4.1/stream")
+    parser.add_argument("--frames", type=int, default=300, help="liczba odebranych klatek")
+    args = parser.parse_args()
+
+    samples = []  # (odbiór, przechwycenie, początek wysyłki)
+    total_bytes = 0
+    dropped = 0
+    reordered = 0
+    last_seq = None
+    start = time.monotonic()
+
+    with urllib.request.urlopen(args.url, timeout=10) as stream:
+        for received, headers, length in read_parts(stream):
+            if "x-timestamp" not in headers:
+                sys.exit("Strumień bez nagłówków X-Timestamp/X-Sequence - za stare oprogramowanie pojazdu")
+
+            seq = int(headers["x-sequence"])
+            if last_seq is not None:
+                gap = (seq - last_seq) & 0xFFFFFFFF
+                if gap == 0 or gap > 0x7FFFFFFF:
+                    reordered += 1
+                else:
+                    dropped += gap - 1
+            last_seq = seq
+
+            samples.append((received, int(headers["x-timestamp"]), int(headers["x-send-start"])))
+            total_bytes += length
+            if len(samples) >= args.frames:
+                break
+
+    elapsed = time.monotonic() - start
+    if not samples:
+        sys.exit("Brak klatek")
+
+    offset = min(received - send_start for received, _, send_start in samples)
+    on_device = [send_start - capture for _, capture, send_start in samples]
+    transfer = [received - offset - send_start for received, _, send_start in samples]
+    glass = [received - offset - capture for received, capture, _ in samples]
+
+    received_frames = len(samples)
+    print("Klatki: %d odebrane, %d brakujące numery (%.1f%%), %d poza kolejnością" % (
+        received_frames, dropped, 100.0 * dropped / (received_frames + dropped), reordered))
+    print("Przepływność: %.1f fps, %.1f KB/s" % (received_frames / elapsed, total_bytes / 1024.0 / elapsed))
+    summarize("przechwycenie -> wysyłka", on_device)
+    summarize("wysyłka -> odbiór (+min)", transfer)
+    summarize("przechwycenie -> odbiór (+min)", glass)
+    print("(+min) - względem najszybciej dostarczonej klatki; zegary nie są zsynchronizowane")
+
+
+if __name__ == "__main__":
+    main()
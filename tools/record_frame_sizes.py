@@ -0,0 +1,89 @@
+#!/usr/bin/env python3
+"""Zapis przebiegu rozmiarów klatek dla host/rate_control_replay (regulator jakości JPEG).
+
+Wyłącza regulator na pojeździe (jpeg_target_bytes = 0), zapisuje rozmiary kolejnych klatek
+/stream przy stałej jakości do CSV (frame,bytes,quality) i przywraca poprzedni budżet.
+Przebieg opisuje złożoność sceny niezależnie od regulatora.
+
+Użycie:
+    python3 tools/record_frame_sizes.py trace.csv [--host 192.168.4.1] [--frames 600]
+"""
+
+import argparse
+import csv
+import json
+import re
+import sys
+import urllib.request
+
+
+def read_part_lengths(stream):
+    """Długości kolejnych części multipart /stream."""
+    while True:
+        line = stream.readline()
+        if not line:
+            return
+        if not line.startswith(b"Content-Type: image/jpeg"):
+            continue
+        length = 0
+        while True:
+            line = stream.readline().strip()
+            if not line:
+                break
+            name, _, value = line.decode("latin-1").partition(":")
+            if name.strip().lower() == "content-length":
+                length = int(value)
+        remaining = length
+        while remaining > 0:
+            chunk = stream.read(min(remaining, 65536))
+            if not chunk:
+                return
+            remaining -= len(chunk)
+        yield length
+
+
+def set_target(host, target):
+    request = urllib.request.Request(
+        "http://%s/api/camera/settings" % host, method="PATCH",
+        data=json.dumps({"jpeg_target_bytes": target}).encode(),
+        headers={"Content-Type": "application/json"})
+    with urllib.request.urlopen(request, timeout=10) as response:
+        response.read()
+
+
+def record(args):
+    with urllib.request.urlopen("http://%s/api/camera/settings" % args.host, timeout=10) as response:
+        previous = json.load(response)["data"]["jpeg_target_bytes"]
+
+    set_target(args.host, 0)
+    try:
+        with urllib.request.urlopen("http://%s/camera/status" % args.host, timeout=10) as response:
+            m = re.search(r"quality (\d+)", response.read().decode("utf-8", "replace"))
+        if not m:
+            sys.exit("Brak jakości JPEG w /camera/status")
+        quality = int(m.group(1))
+
+        with open(args.output, "w", newline="") as f:
+            writer = csv.writer(f)
+            writer.writerow(["frame", "bytes", "quality"])
+            with urllib.request.urlopen("http://%s/stream" % args.host, timeout=10) as stream:
+                for i, length in enumerate(read_part_lengths(stream)):
+                    writer.writerow([i, length, quality])
+                    if i + 1 >= args.frames:
+                        break
+    finally:
+        set_target(args.host, previous)
+    print("Zapisano %d klatek przy jakości %d do %s" % (args.frames, quality, args.output))
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("output")
+    parser.add_argument("--host", default="192.168.4.1")
+    parser.add_argument("--frames", type=int, default=600)
+    return record(parser.parse_args())
+
+
+if __name__ == "__main__":
+    sys.exit(main())